@@ -0,0 +1,168 @@
+#ifndef IRODS_GENQUERY_H
+#define IRODS_GENQUERY_H
+
+/*
+ * C interface of libgenquery.
+ *
+ * A context holds the options and the result of the last translation. Contexts are
+ * independent: different threads may use different contexts at the same time, but a
+ * context must not be used by two threads at once.
+ *
+ * Functions return GENQUERY_OK or one of the negative genquery_status codes. After a
+ * failure, genquery_last_error() describes the problem. No function throws.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#  define GENQUERY_API __attribute__((visibility("default")))
+#else
+#  define GENQUERY_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GENQUERY_ABI_VERSION 1
+
+typedef struct genquery_context genquery_context;
+
+enum genquery_status
+{
+    GENQUERY_OK                     =  0,
+    GENQUERY_ERROR_INVALID_ARGUMENT = -1,
+    GENQUERY_ERROR_QUERY            = -2, /* The query could not be parsed or translated. */
+    GENQUERY_ERROR_BUFFER_TOO_SMALL = -3, /* The required size was stored, retry with a larger buffer. */
+    GENQUERY_ERROR_SCHEMA           = -4,
+    GENQUERY_ERROR_INTERNAL         = -5
+};
+
+/* What was wrong with a query rejected with GENQUERY_ERROR_QUERY. */
+enum genquery_error_kind
+{
+    GENQUERY_KIND_NONE                 = 0,
+    GENQUERY_KIND_UNKNOWN_CHARACTER    = 1,
+    GENQUERY_KIND_SYNTAX_ERROR         = 2,
+    GENQUERY_KIND_UNKNOWN_COLUMN       = 3,
+    GENQUERY_KIND_UNKNOWN_TABLE        = 4,
+    GENQUERY_KIND_UNSUPPORTED_FUNCTION = 5,
+    GENQUERY_KIND_EMPTY_SELECTION      = 6,
+    GENQUERY_KIND_INTERNAL             = 7,
+    GENQUERY_KIND_LIMIT_EXCEEDED       = 8,
+    GENQUERY_KIND_TOO_EXPENSIVE        = 9, /* Rejected by the admission policy. */
+    GENQUERY_KIND_INVALID_GROUPING     = 10 /* A column is not covered by GROUP BY or DISTINCT. */
+};
+
+typedef struct genquery_diagnostic
+{
+    int kind;      /* One of genquery_error_kind. */
+    size_t offset; /* Location of the offending token within the query. */
+    size_t size;   /* Zero if the location is unknown. */
+} genquery_diagnostic;
+
+/* Queries beyond these bounds are rejected with GENQUERY_KIND_LIMIT_EXCEEDED. */
+typedef struct genquery_limits
+{
+    size_t max_depth;         /* Nesting depth of a condition expression. */
+    size_t max_nodes;         /* Number of condition expressions, operators included. */
+    size_t max_literal_bytes; /* Total size of the literals. */
+    size_t max_in_list;       /* Number of literals of a single IN list. */
+} genquery_limits;
+
+/*
+ * Queries whose estimated cost exceeds a threshold are throttled, downgraded or
+ * rejected with GENQUERY_KIND_TOO_EXPENSIVE. A threshold of 0 disables it.
+ */
+typedef struct genquery_admission_policy
+{
+    double throttle_above;
+    double downgrade_above;
+    double reject_above;
+} genquery_admission_policy;
+
+/* What the admission policy decided for a translation. */
+enum genquery_admission
+{
+    GENQUERY_ADMISSION_ACCEPT    = 0,
+    GENQUERY_ADMISSION_THROTTLE  = 1, /* Run the query at a lower priority or concurrency. */
+    GENQUERY_ADMISSION_DOWNGRADE = 2  /* Translated again with the metadata conditions in subqueries. */
+};
+
+enum genquery_flags
+{
+    GENQUERY_PARAMETERIZE = 0x1 /* Emit literals as "?" and return them as bind values. */
+};
+
+/* Returns GENQUERY_ABI_VERSION of the library. */
+GENQUERY_API int genquery_abi_version(void);
+
+/* Returns NULL if memory is exhausted. "flags" is a combination of genquery_flags. */
+GENQUERY_API genquery_context* genquery_context_create(uint32_t flags);
+GENQUERY_API void genquery_context_destroy(genquery_context* ctx);
+
+/* Replaces the limits of a context. New contexts use the defaults of the library. */
+GENQUERY_API int genquery_set_limits(genquery_context* ctx, const genquery_limits* limits);
+
+/* Replaces the admission policy of a context. New contexts admit every query. */
+GENQUERY_API int genquery_set_admission_policy(genquery_context* ctx, const genquery_admission_policy* policy);
+
+/* Sets the estimated number of rows of a table (e.g. "R_OBJT_METAMAP") for the cost model. */
+GENQUERY_API int genquery_set_table_rows(genquery_context* ctx, const char* table, double rows);
+
+/*
+ * Translates the "query_size" bytes at "query" and copies the SQL, NUL-terminated, into
+ * "sql". "*sql_size" receives the length of the SQL without the terminator, also when
+ * GENQUERY_ERROR_BUFFER_TOO_SMALL is returned. The bind values remain available until
+ * the next translation with the same context.
+ */
+GENQUERY_API int genquery_translate(genquery_context* ctx,
+                                    const char* query,
+                                    size_t query_size,
+                                    char* sql,
+                                    size_t sql_capacity,
+                                    size_t* sql_size);
+
+/*
+ * Like genquery_translate(), but copies a JSON description of how the query is
+ * translated (the output of "gql --explain") into "json" instead of the SQL.
+ */
+GENQUERY_API int genquery_explain(genquery_context* ctx,
+                                  const char* query,
+                                  size_t query_size,
+                                  char* json,
+                                  size_t json_capacity,
+                                  size_t* json_size);
+
+GENQUERY_API size_t genquery_bind_count(const genquery_context* ctx);
+
+/*
+ * Points "*value" at the bind value with the given index. The value is not
+ * NUL-terminated and stays valid until the next translation with the same context.
+ */
+GENQUERY_API int genquery_bind_value(const genquery_context* ctx, size_t index, const char** value, size_t* value_size);
+
+/* Returns a NUL-terminated description of the last failure, or "" after a success. */
+GENQUERY_API const char* genquery_last_error(const genquery_context* ctx);
+
+/*
+ * Describes why the last translation returned GENQUERY_ERROR_QUERY. The kind is
+ * GENQUERY_KIND_NONE after any other result.
+ */
+GENQUERY_API int genquery_last_diagnostic(const genquery_context* ctx, genquery_diagnostic* diagnostic);
+
+/*
+ * Stores the estimated cost of the last successful translation and the decision of the
+ * admission policy (one of genquery_admission).
+ */
+GENQUERY_API int genquery_last_cost(const genquery_context* ctx, double* cost, int* admission);
+
+/* Publishes a schema catalog built by gql_schema_compiler for all contexts. */
+GENQUERY_API int genquery_load_schema(genquery_context* ctx, const char* path);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* IRODS_GENQUERY_H */
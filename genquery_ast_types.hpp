@@ -154,10 +154,20 @@ namespace irods::experimental::api::genquery
         ConditionExpression expression;
     };
 
+    struct SortExpression {
+        SortExpression() = default;
+        SortExpression(Column column, bool ascending_order)
+            : column{std::move(column)}, ascending_order{ascending_order} {}
+        Column column;
+        bool ascending_order = true;
+    };
+
     // clang-format off
     using Selection  = boost::variant<SelectFunction, Column>;
     using Selections = std::vector<Selection>;
     using Conditions = std::vector<Condition>;
+    using GroupBy    = std::vector<Column>;
+    using OrderBy    = std::vector<SortExpression>;
     // clang-format on
 
     struct Select {
@@ -166,7 +176,9 @@ namespace irods::experimental::api::genquery
             : selections(std::move(selections)), conditions(std::move(conditions)) {}
         Selections selections;
         Conditions conditions;
-        bool no_distinct;
+        GroupBy group_by;
+        OrderBy order_by;
+        bool no_distinct = false;
     };
 } // namespace irods::experimental::api::genquery
 
@@ -0,0 +1,431 @@
+#include "genquery_avu_index.hpp"
+
+#include "genquery_kernels.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        constexpr std::size_t bitmap_words = 65536 / 64;
+
+        auto key_of(std::int64_t _id) -> std::int64_t
+        {
+            return _id >> 16;
+        } // key_of
+
+        auto low_bits(std::int64_t _id) -> std::uint16_t
+        {
+            return static_cast<std::uint16_t>(_id & 0xffff);
+        } // low_bits
+
+        auto popcount(std::uint64_t _w) -> std::uint32_t
+        {
+            return static_cast<std::uint32_t>(__builtin_popcountll(_w));
+        } // popcount
+
+        auto lowest_bit(std::uint64_t _w) -> unsigned
+        {
+            return static_cast<unsigned>(__builtin_ctzll(_w));
+        } // lowest_bit
+
+        auto test(const std::vector<std::uint64_t>& _bitmap, std::uint16_t _low) -> bool
+        {
+            return (_bitmap[_low / 64] >> (_low % 64)) & 1;
+        } // test
+
+        template <typename Chunk>
+        auto to_bitmap(Chunk& _c) -> void
+        {
+            _c.bitmap.assign(bitmap_words, 0);
+            for (auto low : _c.array) {
+                _c.bitmap[low / 64] |= std::uint64_t{1} << (low % 64);
+            }
+            _c.array = {};
+        } // to_bitmap
+
+        template <typename Chunk>
+        auto to_array(Chunk& _c) -> void
+        {
+            _c.array.clear();
+            _c.array.reserve(_c.size);
+            for (std::size_t i = 0; i < _c.bitmap.size(); ++i) {
+                for (auto w = _c.bitmap[i]; w != 0; w &= w - 1) {
+                    _c.array.push_back(static_cast<std::uint16_t>(i * 64 + lowest_bit(w)));
+                }
+            }
+            _c.bitmap = {};
+        } // to_array
+
+        // Stores a chunk in the smaller of the two forms for its size.
+        template <typename Chunk>
+        auto fit(Chunk& _c) -> void
+        {
+            if (_c.bitmap.empty() && _c.size > posting_list::max_array_size) {
+                to_bitmap(_c);
+            }
+            else if (!_c.bitmap.empty() && _c.size <= posting_list::max_array_size) {
+                to_array(_c);
+            }
+        } // fit
+
+        template <typename Chunks>
+        auto find_chunk(Chunks& _chunks, std::int64_t _key)
+        {
+            return std::lower_bound(std::begin(_chunks), std::end(_chunks), _key, [](const auto& _c, std::int64_t _k) {
+                return _c.key < _k;
+            });
+        } // find_chunk
+
+        template <typename Chunk>
+        auto intersect(const Chunk& _a, const Chunk& _b) -> Chunk
+        {
+            Chunk c{_a.key, 0, {}, {}};
+
+            if (_a.bitmap.empty() && _b.bitmap.empty()) {
+                std::set_intersection(std::begin(_a.array), std::end(_a.array),
+                                      std::begin(_b.array), std::end(_b.array),
+                                      std::back_inserter(c.array));
+            }
+            else if (_a.bitmap.empty() || _b.bitmap.empty()) {
+                const auto& array = _a.bitmap.empty() ? _a.array : _b.array;
+                const auto& bitmap = _a.bitmap.empty() ? _b.bitmap : _a.bitmap;
+
+                std::copy_if(std::begin(array), std::end(array), std::back_inserter(c.array), [&bitmap](std::uint16_t _low) {
+                    return test(bitmap, _low);
+                });
+            }
+            else {
+                c.bitmap.resize(bitmap_words);
+                for (std::size_t i = 0; i < bitmap_words; ++i) {
+                    c.bitmap[i] = _a.bitmap[i] & _b.bitmap[i];
+                    c.size += popcount(c.bitmap[i]);
+                }
+                fit(c);
+                return c;
+            }
+
+            c.size = static_cast<std::uint32_t>(c.array.size());
+            return c;
+        } // intersect
+
+        template <typename Chunk>
+        auto unite(Chunk& _a, const Chunk& _b) -> void
+        {
+            if (_a.bitmap.empty() && _b.bitmap.empty()) {
+                std::vector<std::uint16_t> array;
+                array.reserve(_a.array.size() + _b.array.size());
+                std::set_union(std::begin(_a.array), std::end(_a.array),
+                               std::begin(_b.array), std::end(_b.array),
+                               std::back_inserter(array));
+                _a.array = std::move(array);
+                _a.size = static_cast<std::uint32_t>(_a.array.size());
+                fit(_a);
+                return;
+            }
+
+            if (_a.bitmap.empty()) {
+                to_bitmap(_a);
+            }
+
+            if (_b.bitmap.empty()) {
+                for (auto low : _b.array) {
+                    _a.bitmap[low / 64] |= std::uint64_t{1} << (low % 64);
+                }
+            }
+            else {
+                for (std::size_t i = 0; i < bitmap_words; ++i) {
+                    _a.bitmap[i] |= _b.bitmap[i];
+                }
+            }
+
+            _a.size = 0;
+            for (auto w : _a.bitmap) {
+                _a.size += popcount(w);
+            }
+        } // unite
+
+        auto all(std::size_t _size) -> selection
+        {
+            selection s{_size};
+            s.set(0, _size);
+            return s;
+        } // all
+
+        // Evaluates a condition against sorted text values.
+        auto select_sorted(const ConditionExpression* _e, const std::vector<std::string>& _values) -> selection
+        {
+            if (!_e) {
+                return all(_values.size());
+            }
+
+            value_column c;
+            c.type = column_type::text;
+            c.values = &_values;
+            c.sorted = true;
+
+            return select(*_e, c);
+        } // select_sorted
+    } // anonymous namespace
+
+    bool posting_list::insert(std::int64_t _id)
+    {
+        const auto key = key_of(_id);
+        const auto low = low_bits(_id);
+        const auto c = find_chunk(_chunks, key);
+
+        if (std::end(_chunks) == c || c->key != key) {
+            _chunks.insert(c, chunk{key, 1, {low}, {}});
+            ++_size;
+            return true;
+        }
+
+        if (!c->bitmap.empty()) {
+            auto& w = c->bitmap[low / 64];
+            const auto bit = std::uint64_t{1} << (low % 64);
+
+            if (w & bit) {
+                return false;
+            }
+
+            w |= bit;
+        }
+        else {
+            const auto i = std::lower_bound(std::begin(c->array), std::end(c->array), low);
+
+            if (std::end(c->array) != i && *i == low) {
+                return false;
+            }
+
+            c->array.insert(i, low);
+        }
+
+        ++c->size;
+        ++_size;
+        fit(*c);
+
+        return true;
+    } // insert
+
+    bool posting_list::erase(std::int64_t _id)
+    {
+        const auto key = key_of(_id);
+        const auto low = low_bits(_id);
+        const auto c = find_chunk(_chunks, key);
+
+        if (std::end(_chunks) == c || c->key != key) {
+            return false;
+        }
+
+        if (!c->bitmap.empty()) {
+            auto& w = c->bitmap[low / 64];
+            const auto bit = std::uint64_t{1} << (low % 64);
+
+            if (!(w & bit)) {
+                return false;
+            }
+
+            w &= ~bit;
+        }
+        else {
+            const auto i = std::lower_bound(std::begin(c->array), std::end(c->array), low);
+
+            if (std::end(c->array) == i || *i != low) {
+                return false;
+            }
+
+            c->array.erase(i);
+        }
+
+        --_size;
+
+        if (0 == --c->size) {
+            _chunks.erase(c);
+        }
+        else {
+            fit(*c);
+        }
+
+        return true;
+    } // erase
+
+    bool posting_list::contains(std::int64_t _id) const
+    {
+        const auto key = key_of(_id);
+        const auto low = low_bits(_id);
+        const auto c = find_chunk(_chunks, key);
+
+        if (std::end(_chunks) == c || c->key != key) {
+            return false;
+        }
+
+        if (!c->bitmap.empty()) {
+            return test(c->bitmap, low);
+        }
+
+        return std::binary_search(std::begin(c->array), std::end(c->array), low);
+    } // contains
+
+    posting_list& posting_list::operator&=(const posting_list& _other)
+    {
+        std::vector<chunk> chunks;
+        std::size_t size = 0;
+
+        auto a = std::begin(_chunks);
+        auto b = std::begin(_other._chunks);
+
+        while (a != std::end(_chunks) && b != std::end(_other._chunks)) {
+            if (a->key < b->key) {
+                ++a;
+            }
+            else if (b->key < a->key) {
+                ++b;
+            }
+            else {
+                if (auto c = intersect(*a, *b); c.size > 0) {
+                    size += c.size;
+                    chunks.push_back(std::move(c));
+                }
+                ++a;
+                ++b;
+            }
+        }
+
+        _chunks = std::move(chunks);
+        _size = size;
+
+        return *this;
+    } // operator&=
+
+    posting_list& posting_list::operator|=(const posting_list& _other)
+    {
+        std::vector<chunk> chunks;
+        chunks.reserve(std::max(_chunks.size(), _other._chunks.size()));
+
+        auto a = std::begin(_chunks);
+        auto b = std::begin(_other._chunks);
+
+        while (a != std::end(_chunks) || b != std::end(_other._chunks)) {
+            if (b == std::end(_other._chunks) || (a != std::end(_chunks) && a->key < b->key)) {
+                chunks.push_back(std::move(*a++));
+            }
+            else if (a == std::end(_chunks) || b->key < a->key) {
+                chunks.push_back(*b++);
+            }
+            else {
+                unite(*a, *b++);
+                chunks.push_back(std::move(*a++));
+            }
+        }
+
+        _chunks = std::move(chunks);
+        _size = 0;
+        for (auto&& c : _chunks) {
+            _size += c.size;
+        }
+
+        return *this;
+    } // operator|=
+
+    std::vector<std::int64_t> posting_list::ids() const
+    {
+        std::vector<std::int64_t> ids;
+        ids.reserve(_size);
+
+        for (auto&& c : _chunks) {
+            const auto base = c.key * 65536;
+
+            if (c.bitmap.empty()) {
+                for (auto low : c.array) {
+                    ids.push_back(base + low);
+                }
+                continue;
+            }
+
+            for (std::size_t i = 0; i < c.bitmap.size(); ++i) {
+                for (auto w = c.bitmap[i]; w != 0; w &= w - 1) {
+                    ids.push_back(base + static_cast<std::int64_t>(i * 64 + lowest_bit(w)));
+                }
+            }
+        }
+
+        return ids;
+    } // ids
+
+    void avu_index::insert(std::int64_t _object, std::string_view _attribute, std::string_view _value)
+    {
+        auto a = std::lower_bound(std::begin(_attributes), std::end(_attributes), _attribute);
+        auto k = static_cast<std::size_t>(a - std::begin(_attributes));
+
+        if (std::end(_attributes) == a || *a != _attribute) {
+            _attributes.emplace(a, _attribute);
+            _values.emplace(std::begin(_values) + k);
+        }
+
+        auto& v = _values[k];
+        const auto i = std::lower_bound(std::begin(v.values), std::end(v.values), _value);
+        const auto j = static_cast<std::size_t>(i - std::begin(v.values));
+
+        if (std::end(v.values) == i || *i != _value) {
+            v.values.emplace(i, _value);
+            v.objects.emplace(std::begin(v.objects) + j);
+            ++_size;
+        }
+
+        v.objects[j].insert(_object);
+    } // insert
+
+    bool avu_index::erase(std::int64_t _object, std::string_view _attribute, std::string_view _value)
+    {
+        const auto a = std::lower_bound(std::begin(_attributes), std::end(_attributes), _attribute);
+
+        if (std::end(_attributes) == a || *a != _attribute) {
+            return false;
+        }
+
+        const auto k = static_cast<std::size_t>(a - std::begin(_attributes));
+        auto& v = _values[k];
+        const auto i = std::lower_bound(std::begin(v.values), std::end(v.values), _value);
+
+        if (std::end(v.values) == i || *i != _value) {
+            return false;
+        }
+
+        const auto j = static_cast<std::size_t>(i - std::begin(v.values));
+
+        if (!v.objects[j].erase(_object)) {
+            return false;
+        }
+
+        if (v.objects[j].empty()) {
+            v.values.erase(i);
+            v.objects.erase(std::begin(v.objects) + j);
+            --_size;
+        }
+
+        if (v.values.empty()) {
+            _attributes.erase(a);
+            _values.erase(std::begin(_values) + k);
+        }
+
+        return true;
+    } // erase
+
+    posting_list avu_index::objects(const ConditionExpression* _attribute, const ConditionExpression* _value) const
+    {
+        posting_list objects;
+
+        for (auto k : select_sorted(_attribute, _attributes).positions()) {
+            const auto& v = _values[k];
+
+            for (auto j : select_sorted(_value, v.values).positions()) {
+                objects |= v.objects[j];
+            }
+        }
+
+        return objects;
+    } // objects
+} // namespace irods::experimental::api::genquery
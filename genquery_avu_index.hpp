@@ -0,0 +1,99 @@
+#ifndef IRODS_GENQUERY_AVU_INDEX_HPP
+#define IRODS_GENQUERY_AVU_INDEX_HPP
+
+#include "genquery_ast_types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    // A set of object ids, compressed the way Roaring bitmaps are: the ids are split
+    // into chunks of 65536 consecutive ids, each stored as a sorted array of the low
+    // 16 bits while it holds at most 4096 ids, and as a bitmap of 65536 bits once it
+    // holds more. Sets are combined chunk by chunk.
+    class posting_list
+    {
+    public:
+        // Chunks with more ids than this are stored as bitmaps.
+        static constexpr std::size_t max_array_size = 4096;
+
+        // Adds an id. Returns whether it was absent.
+        bool insert(std::int64_t id);
+
+        // Returns whether the id was present.
+        bool erase(std::int64_t id);
+
+        bool contains(std::int64_t id) const;
+
+        std::size_t size() const noexcept { return _size; }
+        bool empty() const noexcept { return 0 == _size; }
+
+        posting_list& operator&=(const posting_list&);
+        posting_list& operator|=(const posting_list&);
+
+        // The ids, in increasing order.
+        std::vector<std::int64_t> ids() const;
+
+    private:
+        struct chunk
+        {
+            std::int64_t key;                  // The id divided by 65536.
+            std::uint32_t size;                // The number of ids.
+            std::vector<std::uint16_t> array;  // The sorted low bits, unless the chunk is a bitmap.
+            std::vector<std::uint64_t> bitmap; // 1024 words, or none.
+        };
+
+        std::vector<chunk> _chunks; // By key. None is empty.
+        std::size_t _size = 0;
+    };
+
+    // Maps the (attribute, value) pairs of the metadata of one kind of object (e.g.
+    // the AVUs of data objects) to the objects which have them, so a group of
+    // conditions on the attribute and value of one AVU is answered by combining the
+    // posting lists of the pairs which satisfy it, instead of joining R_OBJT_METAMAP
+    // and R_META_MAIN once per group.
+    //
+    // The attributes and the values of each attribute are kept sorted, so conditions
+    // on them are evaluated with the batch kernels (see genquery_kernels.hpp) and
+    // equality and prefix conditions with binary searches. Lookups may run
+    // concurrently with each other but not with updates.
+    class avu_index
+    {
+    public:
+        // Records that an object has an AVU. Units are not indexed.
+        void insert(std::int64_t object, std::string_view attribute, std::string_view value);
+
+        // Returns whether the object had the AVU.
+        bool erase(std::int64_t object, std::string_view attribute, std::string_view value);
+
+        // The number of distinct (attribute, value) pairs.
+        std::size_t size() const noexcept { return _size; }
+
+        // The objects with an AVU whose attribute satisfies "attribute" and whose value
+        // satisfies "value". A null condition is satisfied by every attribute or value.
+        posting_list objects(const ConditionExpression* attribute, const ConditionExpression* value) const;
+
+    private:
+        struct attribute_values
+        {
+            std::vector<std::string> values;   // Sorted.
+            std::vector<posting_list> objects; // Of each value.
+        };
+
+        std::vector<std::string> _attributes; // Sorted.
+        std::vector<attribute_values> _values; // Of each attribute.
+        std::size_t _size = 0;
+    };
+
+    // The indexes of a catalog, by the metadata table of the schema whose AVUs they
+    // hold (e.g. "r_data_meta_main" for META_DATA_ATTR_NAME and META_DATA_ATTR_VALUE).
+    using avu_indexes = std::map<std::string, avu_index, std::less<>>;
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_AVU_INDEX_HPP
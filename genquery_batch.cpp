@@ -0,0 +1,274 @@
+#include "genquery_batch.hpp"
+
+#include "genquery_json.hpp"
+#include "genquery_slow_log.hpp"
+#include "genquery_translation_cache.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        // clang-format off
+        constexpr std::size_t chunk_size        = 256; // Queries claimed by a worker at a time.
+        constexpr std::size_t chunks_per_worker = 4;   // Completed chunks allowed to wait for the writer.
+        // clang-format on
+
+        class input_buffer
+        {
+        public:
+            explicit input_buffer(const std::string& _path)
+                : _storage{}
+                , _mapping{nullptr}
+                , _size{}
+            {
+                if ("-" == _path) {
+                    _storage.assign(std::istreambuf_iterator<char>{std::cin}, std::istreambuf_iterator<char>{});
+                    return;
+                }
+
+                const int fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    throw std::system_error{errno, std::generic_category(), fmt::format("batch: cannot open [{}]", _path)};
+                }
+
+                struct stat st{};
+                if (::fstat(fd, &st) < 0) {
+                    const auto ec = errno;
+                    ::close(fd);
+                    throw std::system_error{ec, std::generic_category(), "batch: fstat failed"};
+                }
+
+                _size = static_cast<std::size_t>(st.st_size);
+
+                if (_size > 0) {
+                    _mapping = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (MAP_FAILED == _mapping) {
+                        const auto ec = errno;
+                        ::close(fd);
+                        throw std::system_error{ec, std::generic_category(), "batch: mmap failed"};
+                    }
+                    ::madvise(_mapping, _size, MADV_SEQUENTIAL);
+                }
+
+                ::close(fd);
+            }
+
+            ~input_buffer()
+            {
+                if (_mapping) {
+                    ::munmap(_mapping, _size);
+                }
+            }
+
+            input_buffer(const input_buffer&) = delete;
+            auto operator=(const input_buffer&) -> input_buffer& = delete;
+
+            auto data() const noexcept -> std::string_view
+            {
+                return _mapping ? std::string_view{static_cast<const char*>(_mapping), _size} : _storage;
+            }
+
+        private:
+            std::string _storage;
+            void* _mapping;
+            std::size_t _size;
+        };
+
+        auto split_queries(std::string_view _in, char _delimiter) -> std::vector<std::string_view>
+        {
+            std::vector<std::string_view> queries;
+
+            while (!_in.empty()) {
+                const auto p = std::min(_in.find(_delimiter), _in.size());
+                auto q = _in.substr(0, p);
+
+                if ('\n' == _delimiter && !q.empty() && '\r' == q.back()) {
+                    q.remove_suffix(1);
+                }
+
+                if (!q.empty()) {
+                    queries.push_back(q);
+                }
+
+                _in.remove_prefix(std::min(p + 1, _in.size()));
+            }
+
+            return queries;
+        } // split_queries
+
+        // Appends the JSON line of a query and returns whether it was translated.
+        auto translate_one(std::string_view _query, const batch_options& _opts, std::string& _out) -> bool
+        {
+            using clock = std::chrono::steady_clock;
+
+            const auto start = clock::now();
+
+            _out += "{\"query\": ";
+            json::append_string(_out, _query);
+
+            std::string fields;
+            bool ok = false;
+
+            try {
+                translation_profiler profiler{_opts.translation.slow_log};
+
+                auto select = wrapper::try_parse(_query, _opts.translation.limits, profiler.scan_time());
+                profiler.parsed();
+
+                auto t = !select      ? result<translation>{std::move(select).error()}
+                         : _opts.cache ? _opts.cache->try_translate(*select, _opts.translation)
+                                       : try_translate(*select, _opts.translation);
+
+                profiler.finish(_query, select ? &*select : nullptr, t);
+
+                if (t) {
+                    fields += ", \"sql\": ";
+                    json::append_string(fields, t->sql);
+                    fields += ", \"bind_values\": [";
+                    for (auto&& v : t->bind_values) {
+                        if (&v != &t->bind_values.front()) { fields += ", "; }
+                        json::append_string(fields, v);
+                    }
+                    fields += fmt::format("], \"cost\": {:.1f}, \"admission\": \"{}\", \"error\": null",
+                                          t->cost.cost, to_string(t->admission));
+
+                    ok = true;
+                }
+                else {
+                    fields = ", \"sql\": null, \"bind_values\": [], \"cost\": null, \"admission\": null, \"error\": ";
+                    json::append_string(fields, describe(t.error()));
+                }
+            }
+            catch (const std::exception& e) {
+                fields = ", \"sql\": null, \"bind_values\": [], \"cost\": null, \"admission\": null, \"error\": ";
+                json::append_string(fields, e.what());
+            }
+
+            const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start);
+
+            _out += fields;
+            _out += fmt::format(", \"time_us\": {}}}\n", elapsed.count());
+
+            return ok;
+        } // translate_one
+    } // anonymous namespace
+
+    batch_summary run_batch(const batch_options& _opts, std::ostream& _out)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        const input_buffer input{_opts.input};
+        const auto queries = split_queries(input.data(), _opts.nul_delimited ? '\0' : '\n');
+
+        // Planner traces would be interleaved with the JSON lines.
+        auto opts = _opts;
+        opts.translation.trace = false;
+
+        const auto chunk_count = (queries.size() + chunk_size - 1) / chunk_size;
+
+        auto threads = _opts.threads ? _opts.threads : std::max(1u, std::thread::hardware_concurrency());
+        threads = std::max<std::size_t>(1, std::min(threads, chunk_count));
+
+        struct chunk
+        {
+            std::string output;
+            std::size_t errors = 0;
+            bool done = false;
+        };
+
+        std::vector<chunk> chunks(chunk_count);
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::size_t next_chunk = 0;
+        std::size_t written = 0;
+
+        const auto max_ahead = threads * chunks_per_worker;
+
+        const auto work = [&] {
+            for (;;) {
+                std::unique_lock lock{mutex};
+
+                // Back-pressure: memory stays bounded when the output is slower than
+                // the translation.
+                cv.wait(lock, [&] { return next_chunk >= chunk_count || next_chunk < written + max_ahead; });
+
+                if (next_chunk >= chunk_count) {
+                    return;
+                }
+
+                const auto c = next_chunk++;
+                lock.unlock();
+
+                std::string output;
+                std::size_t errors = 0;
+
+                const auto end = std::min(queries.size(), (c + 1) * chunk_size);
+                for (auto i = c * chunk_size; i < end; ++i) {
+                    if (!translate_one(queries[i], opts, output)) {
+                        ++errors;
+                    }
+                }
+
+                lock.lock();
+                chunks[c].output = std::move(output);
+                chunks[c].errors = errors;
+                chunks[c].done = true;
+                cv.notify_all();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for (std::size_t i = 0; i < threads && chunk_count > 0; ++i) {
+            workers.emplace_back(work);
+        }
+
+        std::size_t errors = 0;
+
+        for (std::size_t c = 0; c < chunk_count; ++c) {
+            std::string output;
+
+            {
+                std::unique_lock lock{mutex};
+                cv.wait(lock, [&] { return chunks[c].done; });
+                output.swap(chunks[c].output);
+                errors += chunks[c].errors;
+                ++written;
+            }
+
+            cv.notify_all();
+            _out.write(output.data(), static_cast<std::streamsize>(output.size()));
+        }
+
+        for (auto&& w : workers) {
+            w.join();
+        }
+
+        _out.flush();
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        return {queries.size(), errors, workers.size(), elapsed.count()};
+    } // run_batch
+} // namespace irods::experimental::api::genquery
@@ -0,0 +1,53 @@
+#ifndef IRODS_GENQUERY_BATCH_HPP
+#define IRODS_GENQUERY_BATCH_HPP
+
+#include "genquery_sql.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace irods::experimental::api::genquery
+{
+    class translation_cache;
+
+    struct batch_options
+    {
+        // Path of the input file, or "-" for stdin. Files are memory-mapped.
+        std::string input = "-";
+
+        // Queries are separated by newlines, or by NUL bytes when set (e.g. the output
+        // of "find -print0" style tools). Empty queries are skipped.
+        bool nul_delimited = false;
+
+        // Number of worker threads. Zero means one per hardware thread.
+        std::size_t threads = 0;
+
+        options translation;
+
+        // Translations go through this cache when set. Literals are then always
+        // parameterized (see translation_cache).
+        translation_cache* cache = nullptr;
+    };
+
+    struct batch_summary
+    {
+        std::size_t queries;
+        std::size_t errors;
+        std::size_t threads;
+        double seconds;
+    };
+
+    // Translates every query of the input and writes one JSON object per query to
+    // "_out", in input order:
+    //
+    //   {"query": "...", "sql": "...", "bind_values": [...], "cost": 41.2, "admission": "accept",
+    //    "error": null, "time_us": 12}
+    //
+    // "sql", "cost" and "admission" are null and "error" holds the message when a query
+    // fails to translate.
+    batch_summary run_batch(const batch_options&, std::ostream& _out);
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_BATCH_HPP
@@ -0,0 +1,569 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "genquery_columnar.hpp"
+#include "genquery_federation.hpp"
+#include "genquery_json.hpp"
+#include "genquery_path_index.hpp"
+#include "genquery_schema.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_sqlite_catalog.hpp"
+#include "genquery_wrapper.hpp"
+
+// Usage:
+//   gql_benchmark [OPTIONS] CORPUS
+//
+// Translates each query in CORPUS (one per line) and executes the SQL against a
+// synthetic catalog in SQLite. Writes one JSON object per query to stdout:
+//
+//   {"query": "...", "sql": "...", "rows": 400, "plan": ["SEARCH ...", ...],
+//    "time_us": 812, "cost": 26.6, "error": null, "regression": null}
+//
+// "time_us" is the median over --repeat executions. With --baseline, the output of a
+// previous run is compared against: "regression" is "plan" when the query plan of a
+// query changed and "time" when it became slower than --slower-than times its
+// baseline. Queries running longer than --timeout fail.
+//
+// With --columnar, each query is also answered by evaluate() from a snapshot of the
+// catalog, and the line gets "columnar": {"rows": 400, "time_us": 95, "match": true}.
+// "match" tells whether both returned the same rows, in any order.
+//
+// With --resolve-paths, BEGINNING_OF and PARENT_OF conditions on COLL_NAME are
+// resolved to collection ids with an index of the collections (see
+// options::collection_paths). With --index-metadata, AVU conditions are answered with
+// an index of the metadata (see options::metadata).
+//
+// With --shard ZONE=PATH (repeated), each query is instead split across the catalogs
+// at the PATHs, one per zone and created as needed (see genquery_federation.hpp), and
+// the line is
+//
+//   {"query": "...", "shards": ["zoneA", "zoneB"], "rows": 400, "time_us": 812, "error": null}
+//
+// "shards" are the zones the conditions of the query did not rule out. With --print-rows,
+// the line also has the merged "result" rows.
+//
+// The exit status is 2 when a query failed, regressed or did not match.
+namespace
+{
+    namespace gq = irods::experimental::api::genquery;
+
+    struct baseline_entry
+    {
+        std::vector<std::string> plan;
+        long long time_us;
+    };
+
+    // Reads the JSON string which starts at "_pos" (the opening quote), as written by
+    // json::append_string().
+    auto read_string(const std::string& _line, std::size_t& _pos) -> std::string
+    {
+        std::string s;
+
+        for (++_pos; _pos < _line.size() && '"' != _line[_pos]; ++_pos) {
+            if ('\\' != _line[_pos] || _pos + 1 == _line.size()) {
+                s += _line[_pos];
+                continue;
+            }
+
+            switch (_line[++_pos]) {
+                case 'n': s += '\n'; break;
+                case 'r': s += '\r'; break;
+                case 't': s += '\t'; break;
+                case 'u':
+                    s += static_cast<char>(std::strtol(_line.substr(_pos + 1, 4).c_str(), nullptr, 16));
+                    _pos += 4;
+                    break;
+                default: s += _line[_pos];
+            }
+        }
+
+        ++_pos;
+        return s;
+    } // read_string
+
+    auto find_field(const std::string& _line, std::string_view _name) -> std::optional<std::size_t>
+    {
+        const auto key = fmt::format("\"{}\": ", _name);
+        const auto p = _line.find(key);
+        if (std::string::npos == p) {
+            return std::nullopt;
+        }
+        return p + key.size();
+    } // find_field
+
+    // Reads the lines written by a previous run. Only the fields compared are read.
+    auto read_baseline(const std::string& _path) -> std::map<std::string, baseline_entry>
+    {
+        std::ifstream in{_path};
+        if (!in) {
+            throw std::runtime_error{"cannot open " + _path};
+        }
+
+        std::map<std::string, baseline_entry> baseline;
+
+        for (std::string line; std::getline(in, line);) {
+            auto query = find_field(line, "query");
+            auto plan = find_field(line, "plan");
+            const auto time = find_field(line, "time_us");
+
+            if (!query || !plan || !time || '"' != line[*query] || '[' != line[*plan]) {
+                continue;
+            }
+
+            baseline_entry e{{}, std::atoll(line.c_str() + *time)};
+
+            for (auto p = *plan + 1; p < line.size() && '"' == line[p];) {
+                e.plan.push_back(read_string(line, p));
+                p = line.find_first_not_of(", ", p);
+            }
+
+            baseline.insert_or_assign(read_string(line, *query), std::move(e));
+        }
+
+        return baseline;
+    } // read_baseline
+
+    auto fetch_rows(gq::sqlite::statement& _s) -> std::vector<std::vector<std::string>>
+    {
+        std::vector<std::vector<std::string>> rows;
+
+        while (_s.step()) {
+            auto& row = rows.emplace_back();
+            for (int i = 0; i < _s.column_count(); ++i) {
+                row.emplace_back(_s.column_text(i));
+            }
+        }
+        _s.reset();
+
+        std::sort(std::begin(rows), std::end(rows));
+        return rows;
+    } // fetch_rows
+
+    // Evaluates a query from the snapshot and compares the rows with the rows of the SQL.
+    auto compare_columnar(const std::string& _query,
+                          const gq::catalog_snapshot& _snapshot,
+                          const std::vector<std::vector<std::string>>& _expected) -> std::pair<std::string, bool>
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const auto select = gq::wrapper::try_parse(_query);
+        auto r = select ? gq::evaluate(*select, _snapshot) : gq::result<gq::row_set>{select.error()};
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        if (!r) {
+            return {", \"columnar\": {\"error\": " + gq::json::quote(gq::describe(r.error())) + "}", false};
+        }
+
+        std::sort(std::begin(r->rows), std::end(r->rows));
+        const auto match = r->rows == _expected;
+
+        return {fmt::format(", \"columnar\": {{\"rows\": {}, \"time_us\": {}, \"match\": {}}}", r->rows.size(), elapsed.count(), match),
+                match};
+    } // compare_columnar
+
+    struct shard_database
+    {
+        std::string zone;
+        std::string path;
+    };
+
+    // Runs the queries of the corpus across the shards.
+    auto run_federated_corpus(std::istream& _corpus,
+                              const std::vector<shard_database>& _shards,
+                              gq::sqlite::catalog_options _catalog,
+                              bool _print_rows) -> int
+    {
+        using clock = std::chrono::steady_clock;
+
+        std::vector<gq::shard> shards;
+        std::vector<std::string> paths;
+
+        for (auto&& sd : _shards) {
+            gq::sqlite::database db{sd.path};
+
+            if (!db.has_table("R_DATA_MAIN")) {
+                const gq::schema_snapshot snapshot;
+                _catalog.zone = sd.zone;
+                const auto tables = gq::sqlite::create_catalog(db, snapshot.get(), _catalog);
+
+                std::size_t rows = 0;
+                for (auto&& t : tables) {
+                    rows += t.rows;
+                }
+
+                std::cerr << fmt::format("gql_benchmark: created the catalog of {} in {} ({} rows)\n", sd.zone, sd.path, rows);
+            }
+
+            shards.push_back({sd.zone, sd.zone, {}, {}});
+            paths.push_back(sd.path);
+        }
+
+        gq::federation_options opts;
+        opts.translation.parameterize = true;
+
+        const auto execute = gq::sqlite::shard_databases(std::move(paths));
+
+        std::size_t queries = 0;
+        std::size_t failures = 0;
+
+        for (std::string query; std::getline(_corpus, query);) {
+            if (query.empty() || '#' == query[0]) {
+                continue;
+            }
+
+            ++queries;
+
+            std::string line = "{\"query\": ";
+            gq::json::append_string(line, query);
+
+            try {
+                const auto start = clock::now();
+
+                const auto select = gq::wrapper::try_parse(query, opts.translation.limits);
+                auto q = select ? gq::federate(*select, shards, opts) : gq::result<gq::federated_query>{select.error()};
+
+                if (!q) {
+                    throw std::runtime_error{gq::describe(q.error())};
+                }
+
+                std::string result;
+                const auto rows = gq::run_federated(*q, execute, [&](gq::row _r) {
+                    if (_print_rows) {
+                        result += result.empty() ? "[" : ", [";
+                        for (auto&& v : _r) {
+                            if (&v != &_r.front()) { result += ", "; }
+                            gq::json::append_string(result, v);
+                        }
+                        result += "]";
+                    }
+                    return true;
+                });
+
+                const auto time_us = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+                line += ", \"shards\": [";
+                for (auto&& s : q->statements) {
+                    if (&s != &q->statements.front()) { line += ", "; }
+                    gq::json::append_string(line, shards[s.shard].name);
+                }
+                line += fmt::format("], \"rows\": {}, \"time_us\": {}, \"error\": null", rows, time_us);
+
+                if (_print_rows) {
+                    line += fmt::format(", \"result\": [{}]", result);
+                }
+
+                line += "}\n";
+            }
+            catch (const std::exception& e) {
+                line += ", \"shards\": [], \"rows\": null, \"time_us\": null, \"error\": ";
+                gq::json::append_string(line, e.what());
+                line += "}\n";
+                ++failures;
+            }
+
+            std::cout << line;
+        }
+
+        std::cerr << fmt::format("gql_benchmark: {} queries across {} shards, {} failed\n", queries, shards.size(), failures);
+
+        return failures ? 2 : 0;
+    } // run_federated_corpus
+
+    auto usage(const char* _program) -> int
+    {
+        std::cerr << "usage: " << _program << " [OPTIONS] CORPUS\n"
+                  << "\n"
+                  << "options:\n"
+                  << "  --db PATH                 keep the catalog in PATH and reuse it in later runs\n"
+                  << "  --schema CATALOG          a catalog built by gql_schema_compiler\n"
+                  << "  --objects N               data objects (default 100000)\n"
+                  << "  --objects-per-collection N\n"
+                  << "  --avus-per-object N, --objects-per-avu N, --acls-per-object N\n"
+                  << "  --users N, --resources N, --seed N\n"
+                  << "  --repeat N                executions per query (default 3)\n"
+                  << "  --baseline FILE           compare against the output of a previous run\n"
+                  << "  --slower-than FACTOR      time regression threshold (default 2)\n"
+                  << "  --timeout SECONDS         abandon a query after SECONDS (default 10)\n"
+                  << "  --columnar                also evaluate each query from a columnar snapshot\n"
+                  << "  --resolve-paths           resolve path conditions with an index of the collections\n"
+                  << "  --index-metadata          answer AVU conditions with an index of the metadata\n"
+                  << "  --shard ZONE=PATH         run the queries across a catalog per zone (repeated)\n"
+                  << "  --print-rows              print the rows of the federated queries\n";
+        return 1;
+    } // usage
+} // anonymous namespace
+
+int main(int _argc, char* _argv[])
+{
+    try {
+        std::string db_path = ":memory:";
+        std::optional<std::string> corpus_path;
+        std::optional<std::string> baseline_path;
+        gq::sqlite::catalog_options catalog;
+        std::size_t repeat = 3;
+        double slower_than = 2;
+        double timeout = 10;
+        bool columnar = false;
+        bool resolve_paths = false;
+        bool index_metadata = false;
+        std::vector<shard_database> shards;
+        bool print_rows = false;
+
+        for (int i = 1; i < _argc; ++i) {
+            const std::string arg = _argv[i];
+            const auto has_value = i + 1 < _argc;
+            const auto number = [&] { return std::strtoull(_argv[++i], nullptr, 10); };
+
+            if ("--db" == arg && has_value) {
+                db_path = _argv[++i];
+            }
+            else if ("--schema" == arg && has_value) {
+                gq::publish_schema(gq::schema::load(_argv[++i]));
+            }
+            else if ("--objects" == arg && has_value) {
+                catalog.data_objects = number();
+            }
+            else if ("--objects-per-collection" == arg && has_value) {
+                catalog.objects_per_collection = number();
+            }
+            else if ("--avus-per-object" == arg && has_value) {
+                catalog.avus_per_object = number();
+            }
+            else if ("--objects-per-avu" == arg && has_value) {
+                catalog.objects_per_avu = number();
+            }
+            else if ("--acls-per-object" == arg && has_value) {
+                catalog.acls_per_object = number();
+            }
+            else if ("--users" == arg && has_value) {
+                catalog.users = number();
+            }
+            else if ("--resources" == arg && has_value) {
+                catalog.resources = number();
+            }
+            else if ("--seed" == arg && has_value) {
+                catalog.seed = number();
+            }
+            else if ("--repeat" == arg && has_value) {
+                repeat = std::max<std::size_t>(1, number());
+            }
+            else if ("--baseline" == arg && has_value) {
+                baseline_path = _argv[++i];
+            }
+            else if ("--slower-than" == arg && has_value) {
+                slower_than = std::strtod(_argv[++i], nullptr);
+            }
+            else if ("--timeout" == arg && has_value) {
+                timeout = std::strtod(_argv[++i], nullptr);
+            }
+            else if ("--columnar" == arg) {
+                columnar = true;
+            }
+            else if ("--resolve-paths" == arg) {
+                resolve_paths = true;
+            }
+            else if ("--index-metadata" == arg) {
+                index_metadata = true;
+            }
+            else if ("--shard" == arg && has_value) {
+                const std::string shard = _argv[++i];
+                const auto p = shard.find('=');
+                if (std::string::npos == p || 0 == p) {
+                    return usage(_argv[0]);
+                }
+                shards.push_back({shard.substr(0, p), shard.substr(p + 1)});
+            }
+            else if ("--print-rows" == arg) {
+                print_rows = true;
+            }
+            else if (!corpus_path && (arg.empty() || arg[0] != '-')) {
+                corpus_path = arg;
+            }
+            else {
+                return usage(_argv[0]);
+            }
+        }
+
+        if (!corpus_path) {
+            return usage(_argv[0]);
+        }
+
+        std::ifstream corpus{*corpus_path};
+        if (!corpus) {
+            throw std::runtime_error{"cannot open " + *corpus_path};
+        }
+
+        if (!shards.empty()) {
+            return run_federated_corpus(corpus, shards, catalog, print_rows);
+        }
+
+        const auto baseline = baseline_path ? read_baseline(*baseline_path) : std::map<std::string, baseline_entry>{};
+
+        using clock = std::chrono::steady_clock;
+
+        gq::sqlite::database db{db_path};
+
+        if (!db.has_table("R_DATA_MAIN")) {
+            const auto start = clock::now();
+            const gq::schema_snapshot snapshot;
+            const auto tables = gq::sqlite::create_catalog(db, snapshot.get(), catalog);
+            const std::chrono::duration<double> elapsed = clock::now() - start;
+
+            std::size_t rows = 0;
+            for (auto&& t : tables) {
+                rows += t.rows;
+            }
+
+            std::cerr << fmt::format("gql_benchmark: created {} tables ({} rows) in {:.1f}s\n", tables.size(), rows, elapsed.count());
+        }
+
+        // The catalog is compared with LIKE as in PostgreSQL.
+        db.execute("pragma case_sensitive_like = on");
+
+        std::shared_ptr<const gq::catalog_snapshot> snapshot;
+        if (columnar) {
+            const auto start = clock::now();
+            snapshot = gq::sqlite::load_snapshot(db);
+            const std::chrono::duration<double> elapsed = clock::now() - start;
+            std::cerr << fmt::format("gql_benchmark: loaded the columnar snapshot in {:.1f}s\n", elapsed.count());
+        }
+
+        gq::options translation;
+        gq::path_index collection_paths;
+
+        if (resolve_paths) {
+            const gq::schema_snapshot schema;
+            collection_paths = gq::sqlite::load_collection_paths(db, schema.get());
+            translation.collection_paths = &collection_paths;
+        }
+
+        gq::avu_indexes metadata;
+
+        if (index_metadata) {
+            const auto start = clock::now();
+            const gq::schema_snapshot schema;
+            metadata = gq::sqlite::load_metadata(db, schema.get());
+            translation.metadata = &metadata;
+            const std::chrono::duration<double> elapsed = clock::now() - start;
+            std::cerr << fmt::format("gql_benchmark: indexed the metadata in {:.1f}s\n", elapsed.count());
+        }
+
+        std::size_t queries = 0;
+        std::size_t failures = 0;
+        std::size_t regressions = 0;
+        std::size_t mismatches = 0;
+
+        for (std::string query; std::getline(corpus, query);) {
+            if (query.empty() || '#' == query[0]) {
+                continue;
+            }
+
+            ++queries;
+
+            std::string line = "{\"query\": ";
+            gq::json::append_string(line, query);
+
+            // Kept for the error line when the SQL fails to execute.
+            std::optional<std::string> sql;
+
+            try {
+                const auto t = gq::try_translate(query, translation);
+                if (!t) {
+                    throw std::runtime_error{gq::describe(t.error())};
+                }
+
+                sql = t->sql;
+
+                const auto plan = gq::sqlite::query_plan(db, t->sql);
+
+                gq::sqlite::statement s{db, t->sql};
+                std::vector<long long> times;
+                std::size_t rows = 0;
+
+                for (std::size_t i = 0; i < repeat; ++i) {
+                    const auto start = clock::now();
+                    db.set_deadline(start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>{timeout}));
+
+                    rows = 0;
+                    while (s.step()) {
+                        ++rows;
+                    }
+                    s.reset();
+
+                    times.push_back(std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count());
+                }
+
+                std::string columnar_fields;
+                if (snapshot) {
+                    db.set_deadline(clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>{timeout}));
+                    auto [fields, match] = compare_columnar(query, *snapshot, fetch_rows(s));
+                    columnar_fields = std::move(fields);
+                    mismatches += match ? 0 : 1;
+                }
+
+                db.set_deadline(std::nullopt);
+
+                std::nth_element(std::begin(times), std::begin(times) + times.size() / 2, std::end(times));
+                const auto time_us = times[times.size() / 2];
+
+                const char* regression = nullptr;
+                if (const auto b = baseline.find(query); std::end(baseline) != b) {
+                    if (b->second.plan != plan) {
+                        regression = "plan";
+                    }
+                    else if (time_us > slower_than * std::max(1LL, b->second.time_us)) {
+                        regression = "time";
+                    }
+                }
+
+                line += ", \"sql\": ";
+                gq::json::append_string(line, t->sql);
+                line += fmt::format(", \"rows\": {}, \"plan\": [", rows);
+                for (auto&& p : plan) {
+                    if (&p != &plan.front()) { line += ", "; }
+                    gq::json::append_string(line, p);
+                }
+                line += fmt::format("], \"time_us\": {}, \"cost\": {:.1f}, \"error\": null, \"regression\": ", time_us, t->cost.cost);
+                line += regression ? gq::json::quote(regression) : "null";
+                line += columnar_fields;
+                line += "}\n";
+
+                if (regression) {
+                    ++regressions;
+                }
+            }
+            catch (const std::exception& e) {
+                db.set_deadline(std::nullopt);
+                line += ", \"sql\": ";
+                line += sql ? gq::json::quote(*sql) : "null";
+                line += ", \"rows\": null, \"plan\": [], \"time_us\": null, \"cost\": null, \"error\": ";
+                gq::json::append_string(line, e.what());
+                line += ", \"regression\": null}\n";
+                ++failures;
+            }
+
+            std::cout << line;
+        }
+
+        std::cerr << fmt::format("gql_benchmark: {} queries, {} failed, {} regressed", queries, failures, regressions);
+        if (snapshot) {
+            std::cerr << fmt::format(", {} did not match the columnar engine", mismatches);
+        }
+        std::cerr << '\n';
+
+        return failures || regressions || mismatches ? 2 : 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,554 @@
+#include "genquery_binary.hpp"
+
+#include <fmt/format.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        // clang-format off
+        constexpr std::uint32_t header_size       = 48;
+        constexpr std::uint32_t string_ref_size   = 8;
+        constexpr std::uint32_t selection_size    = 4 + 2 * string_ref_size;
+        constexpr std::uint32_t condition_size    = string_ref_size + 4;
+        constexpr std::uint32_t group_by_size     = string_ref_size;
+        constexpr std::uint32_t order_by_size     = string_ref_size + 4;
+        constexpr std::uint32_t expression_header = 4;
+
+        constexpr std::uint16_t flag_no_distinct  = 0x1;
+
+        // Indices of the expression types within ConditionExpression.
+        constexpr int kind_in      = 1;
+        constexpr int kind_between = 2;
+        constexpr int kind_and     = 11;
+        constexpr int kind_or      = 12;
+        constexpr int kind_not     = 13;
+        // clang-format on
+
+        auto put_u32(std::string& _b, std::uint32_t _v) -> void
+        {
+            const char bytes[] = {
+                static_cast<char>(_v & 0xff),
+                static_cast<char>((_v >> 8) & 0xff),
+                static_cast<char>((_v >> 16) & 0xff),
+                static_cast<char>((_v >> 24) & 0xff)
+            };
+            _b.append(bytes, sizeof(bytes));
+        } // put_u32
+
+        auto set_u32(std::string& _b, std::size_t _pos, std::uint32_t _v) -> void
+        {
+            std::string tmp;
+            put_u32(tmp, _v);
+            _b.replace(_pos, 4, tmp);
+        } // set_u32
+
+        auto get_u32(std::string_view _b, std::size_t _pos) -> std::uint32_t
+        {
+            if (_pos > _b.size() || _b.size() - _pos < 4) {
+                throw std::runtime_error{fmt::format("binary select: read out of bounds at offset [{}]", _pos)};
+            }
+
+            const auto* p = reinterpret_cast<const unsigned char*>(_b.data() + _pos);
+            return static_cast<std::uint32_t>(p[0]) |
+                   static_cast<std::uint32_t>(p[1]) << 8 |
+                   static_cast<std::uint32_t>(p[2]) << 16 |
+                   static_cast<std::uint32_t>(p[3]) << 24;
+        } // get_u32
+
+        auto get_string(std::string_view _b, std::size_t _pos) -> std::string_view
+        {
+            const auto strings = get_u32(_b, 12);
+            const auto offset = get_u32(_b, _pos);
+            const auto length = get_u32(_b, _pos + 4);
+
+            if (strings > _b.size() || offset > _b.size() - strings || length > _b.size() - strings - offset) {
+                throw std::runtime_error{fmt::format("binary select: string out of bounds at offset [{}]", _pos)};
+            }
+
+            return _b.substr(strings + offset, length);
+        } // get_string
+
+        class encoder
+        {
+        public:
+            auto string(const std::string& _s) -> void
+            {
+                put_u32(_records, static_cast<std::uint32_t>(_strings.size()));
+                put_u32(_records, static_cast<std::uint32_t>(_s.size()));
+                _strings += _s;
+            }
+
+            // Writes the children of an expression before the expression itself. The
+            // tree is walked in post-order with an explicit stack; "offsets" holds the
+            // offsets of the expressions written but not yet referenced by their parent.
+            auto expression(const ConditionExpression& _root) -> std::uint32_t
+            {
+                std::vector<std::pair<const ConditionExpression*, bool>> stack{{&_root, false}};
+                std::vector<std::uint32_t> offsets;
+
+                while (!stack.empty()) {
+                    const auto [e, expanded] = stack.back();
+                    const auto [first, second] = operands(*e);
+                    const std::size_t n = second ? 2 : first ? 1 : 0;
+
+                    if (n > 0 && !expanded) {
+                        stack.back().second = true;
+                        if (second) { stack.emplace_back(second, false); }
+                        stack.emplace_back(first, false);
+                        continue;
+                    }
+
+                    stack.pop_back();
+
+                    const auto offset = position();
+                    _records += static_cast<char>(e->which());
+                    _records.append(3, '\0');
+
+                    for (auto i = offsets.size() - n; i < offsets.size(); ++i) {
+                        put_u32(_records, offsets[i]);
+                    }
+                    offsets.resize(offsets.size() - n);
+
+                    if (const auto* in = boost::get<ConditionIn>(e); in) {
+                        put_u32(_records, static_cast<std::uint32_t>(in->list_of_string_literals.size()));
+                        for (auto&& l : in->list_of_string_literals) {
+                            string(l);
+                        }
+                    }
+                    else if (const auto* between = boost::get<ConditionBetween>(e); between) {
+                        string(between->low);
+                        string(between->high);
+                    }
+                    else if (0 == n) {
+                        string(literal(*e));
+                    }
+
+                    offsets.push_back(offset);
+                }
+
+                return offsets.back();
+            }
+
+            auto position() const -> std::uint32_t
+            {
+                return header_size + static_cast<std::uint32_t>(_records.size());
+            }
+
+            auto records() -> std::string& { return _records; }
+            auto strings() const -> const std::string& { return _strings; }
+
+        private:
+            struct literal_visitor : boost::static_visitor<const std::string&>
+            {
+                template <typename T>
+                auto operator()(const T& _arg) const -> const std::string& { return _arg.string_literal; }
+
+                auto operator()(const ConditionIn&) const -> const std::string& { return empty(); }
+                auto operator()(const ConditionBetween&) const -> const std::string& { return empty(); }
+                auto operator()(const ConditionOperator_And&) const -> const std::string& { return empty(); }
+                auto operator()(const ConditionOperator_Or&) const -> const std::string& { return empty(); }
+                auto operator()(const ConditionOperator_Not&) const -> const std::string& { return empty(); }
+
+                static auto empty() -> const std::string&
+                {
+                    static const std::string s;
+                    return s;
+                }
+            };
+
+            static auto literal(const ConditionExpression& _e) -> const std::string&
+            {
+                return boost::apply_visitor(literal_visitor{}, _e);
+            }
+
+            using operand_pair = std::pair<const ConditionExpression*, const ConditionExpression*>;
+
+            static auto operands(const ConditionExpression& _e) -> operand_pair
+            {
+                if (const auto* op = boost::get<ConditionOperator_And>(&_e); op) {
+                    return {&op->left, &op->right};
+                }
+
+                if (const auto* op = boost::get<ConditionOperator_Or>(&_e); op) {
+                    return {&op->left, &op->right};
+                }
+
+                if (const auto* op = boost::get<ConditionOperator_Not>(&_e); op) {
+                    return {&op->expression, nullptr};
+                }
+
+                return {nullptr, nullptr};
+            }
+
+            std::string _records;
+            std::string _strings;
+        }; // class encoder
+
+        auto decode_leaf(const binary_expression_view& _e) -> ConditionExpression
+        {
+            const auto lit = [&_e](std::size_t i) { return std::string{_e.literal(i)}; };
+
+            switch (_e.which()) {
+                case 0:  return ConditionLike{lit(0)};
+                case kind_in: {
+                    std::vector<std::string> list;
+                    list.reserve(_e.literal_count());
+                    for (std::size_t i = 0; i < _e.literal_count(); ++i) {
+                        list.push_back(lit(i));
+                    }
+                    return ConditionIn{std::move(list)};
+                }
+                case kind_between: return ConditionBetween{lit(0), lit(1)};
+                case 3:  return ConditionEqual{lit(0)};
+                case 4:  return ConditionNotEqual{lit(0)};
+                case 5:  return ConditionLessThan{lit(0)};
+                case 6:  return ConditionLessThanOrEqualTo{lit(0)};
+                case 7:  return ConditionGreaterThan{lit(0)};
+                case 8:  return ConditionGreaterThanOrEqualTo{lit(0)};
+                case 9:  return ConditionParentOf{lit(0)};
+                case 10: return ConditionBeginningOf{lit(0)};
+            }
+
+            throw std::runtime_error{fmt::format("binary select: unknown expression kind [{}]", _e.which())};
+        } // decode_leaf
+
+        // Operands may be shared by several parents within a buffer, so the size of the
+        // decoded tree is bounded by the limits rather than by the size of the buffer.
+        // The tree is built in post-order with an explicit stack.
+        auto decode_expression(const binary_expression_view& _root, const query_limits& _l, std::size_t& _nodes)
+            -> ConditionExpression
+        {
+            struct frame
+            {
+                binary_expression_view view;
+                std::size_t depth;
+                bool expanded;
+            };
+
+            std::vector<frame> stack{{_root, 1, false}};
+            std::vector<ConditionExpression> values;
+
+            while (!stack.empty()) {
+                const auto f = stack.back();
+                const auto kind = f.view.which();
+
+                if (f.depth > _l.max_depth) {
+                    throw std::runtime_error{describe(limit_exceeded("condition nesting depth", _l.max_depth))};
+                }
+
+                if (kind >= kind_and && !f.expanded) {
+                    stack.back().expanded = true;
+
+                    if (kind_not == kind) {
+                        stack.push_back({f.view.operand(), f.depth + 1, false});
+                    }
+                    else {
+                        stack.push_back({f.view.right(), f.depth + 1, false});
+                        stack.push_back({f.view.left(), f.depth + 1, false});
+                    }
+
+                    continue;
+                }
+
+                stack.pop_back();
+
+                if (++_nodes > _l.max_nodes) {
+                    throw std::runtime_error{describe(limit_exceeded("number of condition expressions", _l.max_nodes))};
+                }
+
+                if (kind_not == kind) {
+                    values.back() = ConditionOperator_Not{std::move(values.back())};
+                }
+                else if (kind_and == kind || kind_or == kind) {
+                    auto right = std::move(values.back());
+                    values.pop_back();
+                    auto& left = values.back();
+
+                    if (kind_and == kind) {
+                        left = ConditionOperator_And{std::move(left), std::move(right)};
+                    }
+                    else {
+                        left = ConditionOperator_Or{std::move(left), std::move(right)};
+                    }
+                }
+                else {
+                    values.push_back(decode_leaf(f.view));
+                }
+            }
+
+            return std::move(values.back());
+        } // decode_expression
+    } // anonymous namespace
+
+    std::string encode(const Select& _s)
+    {
+        encoder e;
+
+        std::vector<std::uint32_t> expressions;
+        expressions.reserve(_s.conditions.size());
+        for (auto&& c : _s.conditions) {
+            expressions.push_back(e.expression(c.expression));
+        }
+
+        const auto selections = e.position();
+        for (auto&& s : _s.selections) {
+            const auto* f = boost::get<SelectFunction>(&s);
+            e.records() += static_cast<char>(f ? 1 : 0);
+            e.records().append(3, '\0');
+            e.string(f ? f->name : std::string{});
+            e.string(f ? f->column.name : boost::get<Column>(s).name);
+        }
+
+        const auto conditions = e.position();
+        for (std::size_t i = 0; i < _s.conditions.size(); ++i) {
+            e.string(_s.conditions[i].column.name);
+            put_u32(e.records(), expressions[i]);
+        }
+
+        const auto group_by = e.position();
+        for (auto&& c : _s.group_by) {
+            e.string(c.name);
+        }
+
+        const auto order_by = e.position();
+        for (auto&& o : _s.order_by) {
+            e.string(o.column.name);
+            put_u32(e.records(), o.ascending_order ? 1 : 0);
+        }
+
+        const auto strings = e.position();
+
+        std::string buffer;
+        buffer.reserve(strings + e.strings().size());
+
+        put_u32(buffer, binary::magic);
+        buffer += static_cast<char>(binary::version & 0xff);
+        buffer += static_cast<char>(binary::version >> 8);
+        buffer += static_cast<char>(_s.no_distinct ? flag_no_distinct : 0);
+        buffer += '\0';
+        put_u32(buffer, 0); // total size
+        put_u32(buffer, strings);
+
+        for (auto&& [offset, count] : {std::make_tuple(selections, _s.selections.size()),
+                                       std::make_tuple(conditions, _s.conditions.size()),
+                                       std::make_tuple(group_by, _s.group_by.size()),
+                                       std::make_tuple(order_by, _s.order_by.size())})
+        {
+            put_u32(buffer, offset);
+            put_u32(buffer, static_cast<std::uint32_t>(count));
+        }
+
+        buffer += e.records();
+        buffer += e.strings();
+        set_u32(buffer, 8, static_cast<std::uint32_t>(buffer.size()));
+
+        return buffer;
+    } // encode
+
+    binary_expression_view::binary_expression_view(std::string_view buffer, std::uint32_t offset)
+        : _buffer{buffer}
+        , _offset{offset}
+        , _kind{static_cast<int>(get_u32(buffer, offset) & 0xff)}
+    {
+        if (_kind > kind_not) {
+            throw std::runtime_error{fmt::format("binary select: unknown expression kind [{}]", _kind)};
+        }
+    }
+
+    std::size_t binary_expression_view::literal_count() const
+    {
+        switch (_kind) {
+            case kind_in: {
+                const auto count = get_u32(_buffer, _offset + expression_header);
+                const auto first = _offset + expression_header + 4;
+                if (count > (_buffer.size() - first) / string_ref_size) {
+                    throw std::runtime_error{fmt::format("binary select: invalid list length [{}]", count)};
+                }
+                return count;
+            }
+            case kind_between: return 2;
+            case kind_and:
+            case kind_or:
+            case kind_not:     return 0;
+            default:           return 1;
+        }
+    }
+
+    std::string_view binary_expression_view::literal(std::size_t i) const
+    {
+        if (i >= literal_count()) {
+            throw std::out_of_range{"binary select: literal index out of range"};
+        }
+
+        const auto first = _offset + expression_header + (kind_in == _kind ? 4 : 0);
+        return get_string(_buffer, first + i * string_ref_size);
+    }
+
+    binary_expression_view binary_expression_view::child(std::size_t i) const
+    {
+        const auto offset = get_u32(_buffer, _offset + expression_header + 4 * i);
+
+        // Children always precede their parent, which rules out cycles.
+        if (offset >= _offset) {
+            throw std::runtime_error{fmt::format("binary select: invalid operand offset [{}]", offset)};
+        }
+
+        return {_buffer, offset};
+    }
+
+    binary_expression_view binary_expression_view::left() const
+    {
+        if (kind_and != _kind && kind_or != _kind) {
+            throw std::logic_error{"binary select: expression is not a binary operator"};
+        }
+
+        return child(0);
+    }
+
+    binary_expression_view binary_expression_view::right() const
+    {
+        if (kind_and != _kind && kind_or != _kind) {
+            throw std::logic_error{"binary select: expression is not a binary operator"};
+        }
+
+        return child(1);
+    }
+
+    binary_expression_view binary_expression_view::operand() const
+    {
+        if (kind_not != _kind) {
+            throw std::logic_error{"binary select: expression is not a NOT operator"};
+        }
+
+        return child(0);
+    }
+
+    binary_condition_view::binary_condition_view(std::string_view buffer, std::uint32_t offset)
+        : _buffer{buffer}
+        , _column{get_string(buffer, offset)}
+        , _expression{get_u32(buffer, offset + string_ref_size)}
+    {
+    }
+
+    binary_expression_view binary_condition_view::expression() const
+    {
+        return {_buffer, _expression};
+    }
+
+    binary_select_view::binary_select_view(std::string_view buffer)
+        : _buffer{buffer}
+    {
+        if (get_u32(buffer, 0) != binary::magic) {
+            throw std::runtime_error{"binary select: bad magic"};
+        }
+
+        const auto v = get_u32(buffer, 4);
+        if ((v & 0xffff) != binary::version) {
+            throw std::runtime_error{fmt::format("binary select: unsupported version [{}]", v & 0xffff)};
+        }
+
+        _flags = static_cast<std::uint16_t>(v >> 16);
+
+        // The buffer may be part of a larger region (e.g. a file holding several queries).
+        const auto size = get_u32(buffer, 8);
+        if (size < header_size || size > buffer.size()) {
+            throw std::runtime_error{fmt::format("binary select: invalid size [{}]", size)};
+        }
+        _buffer = buffer.substr(0, size);
+
+        const auto read_section = [this](std::uint32_t pos, std::uint32_t record_size) {
+            const section s{get_u32(_buffer, pos), get_u32(_buffer, pos + 4)};
+            if (s.offset > _buffer.size() || s.count > (_buffer.size() - s.offset) / record_size) {
+                throw std::runtime_error{"binary select: section out of bounds"};
+            }
+            return s;
+        };
+
+        _selections = read_section(16, selection_size);
+        _conditions = read_section(24, condition_size);
+        _group_by   = read_section(32, group_by_size);
+        _order_by   = read_section(40, order_by_size);
+    }
+
+    bool binary_select_view::no_distinct() const noexcept
+    {
+        return _flags & flag_no_distinct;
+    }
+
+    std::uint32_t binary_select_view::record(const section& s, std::size_t index, std::size_t record_size) const
+    {
+        if (index >= s.count) {
+            throw std::out_of_range{"binary select: record index out of range"};
+        }
+
+        return static_cast<std::uint32_t>(s.offset + index * record_size);
+    }
+
+    binary_selection_view binary_select_view::selection(std::size_t i) const
+    {
+        const auto offset = record(_selections, i, selection_size);
+        const auto is_function = (get_u32(_buffer, offset) & 0xff) != 0;
+
+        return {is_function,
+                get_string(_buffer, offset + 4),
+                get_string(_buffer, offset + 4 + string_ref_size)};
+    }
+
+    binary_condition_view binary_select_view::condition(std::size_t i) const
+    {
+        return {_buffer, record(_conditions, i, condition_size)};
+    }
+
+    std::string_view binary_select_view::group_by(std::size_t i) const
+    {
+        return get_string(_buffer, record(_group_by, i, group_by_size));
+    }
+
+    binary_sort_expression_view binary_select_view::order_by(std::size_t i) const
+    {
+        const auto offset = record(_order_by, i, order_by_size);
+        return {get_string(_buffer, offset), get_u32(_buffer, offset + string_ref_size) != 0};
+    }
+
+    Select decode(const binary_select_view& _v, const query_limits& _limits)
+    {
+        Select s;
+        std::size_t nodes = 0;
+        s.no_distinct = _v.no_distinct();
+
+        s.selections.reserve(_v.selection_count());
+        for (std::size_t i = 0; i < _v.selection_count(); ++i) {
+            const auto sel = _v.selection(i);
+            if (sel.is_function) {
+                s.selections.emplace_back(SelectFunction{std::string{sel.function}, Column{std::string{sel.column}}});
+            }
+            else {
+                s.selections.emplace_back(Column{std::string{sel.column}});
+            }
+        }
+
+        s.conditions.reserve(_v.condition_count());
+        for (std::size_t i = 0; i < _v.condition_count(); ++i) {
+            const auto c = _v.condition(i);
+            s.conditions.emplace_back(Column{std::string{c.column()}}, decode_expression(c.expression(), _limits, nodes));
+        }
+
+        for (std::size_t i = 0; i < _v.group_by_count(); ++i) {
+            s.group_by.emplace_back(std::string{_v.group_by(i)});
+        }
+
+        for (std::size_t i = 0; i < _v.order_by_count(); ++i) {
+            const auto o = _v.order_by(i);
+            s.order_by.emplace_back(Column{std::string{o.column}}, o.ascending_order);
+        }
+
+        return s;
+    } // decode
+} // namespace irods::experimental::api::genquery
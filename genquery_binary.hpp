@@ -0,0 +1,140 @@
+#ifndef IRODS_GENQUERY_BINARY_HPP
+#define IRODS_GENQUERY_BINARY_HPP
+
+#include "genquery_ast_types.hpp"
+#include "genquery_limits.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace irods::experimental::api::genquery
+{
+    // Compact binary encoding of a Select.
+    //
+    // The encoding is versioned and position-independent (all references are offsets
+    // from the start of the buffer) and is read in place, which allows it to be used
+    // directly from a memory-mapped file or a received message. All integers are
+    // little-endian.
+    //
+    //   header      magic, version, flags, size, (offset, count) of each section below
+    //   selections  { u8 kind, u8[3], str function, str column }
+    //   conditions  { str column, u32 expression }
+    //   group by    { str column }
+    //   order by    { str column, u32 ascending }
+    //   expressions { u8 kind, u8[3], payload }, children always precede their parent
+    //   strings     raw bytes referenced by "str" (u32 offset, u32 length)
+    //
+    // The kind of an expression is the index of its type in ConditionExpression.
+    namespace binary
+    {
+        constexpr std::uint32_t magic = 0x42415147; // "GQAB"
+        constexpr std::uint16_t version = 1;
+    } // namespace binary
+
+    std::string encode(const Select&);
+
+    class binary_expression_view
+    {
+    public:
+        binary_expression_view(std::string_view buffer, std::uint32_t offset);
+
+        // Index of the expression type within ConditionExpression.
+        int which() const noexcept { return _kind; }
+
+        // Literals of the leaf expressions. ConditionBetween has two (low, high),
+        // ConditionIn has one per list element and all others have one.
+        std::size_t literal_count() const;
+        std::string_view literal(std::size_t) const;
+
+        // Operands of ConditionOperator_And and ConditionOperator_Or.
+        binary_expression_view left() const;
+        binary_expression_view right() const;
+
+        // Operand of ConditionOperator_Not.
+        binary_expression_view operand() const;
+
+    private:
+        binary_expression_view child(std::size_t) const;
+
+        std::string_view _buffer;
+        std::uint32_t _offset;
+        int _kind;
+    };
+
+    struct binary_selection_view
+    {
+        bool is_function;
+        std::string_view function; // Empty unless "is_function" is true.
+        std::string_view column;
+    };
+
+    class binary_condition_view
+    {
+    public:
+        binary_condition_view(std::string_view buffer, std::uint32_t offset);
+
+        std::string_view column() const noexcept { return _column; }
+        binary_expression_view expression() const;
+
+    private:
+        std::string_view _buffer;
+        std::string_view _column;
+        std::uint32_t _expression;
+    };
+
+    struct binary_sort_expression_view
+    {
+        std::string_view column;
+        bool ascending_order;
+    };
+
+    // Read-only view of an encoded Select. The view does not own the buffer.
+    // Malformed buffers are detected on access and reported via std::runtime_error.
+    class binary_select_view
+    {
+    public:
+        explicit binary_select_view(std::string_view buffer);
+
+        bool no_distinct() const noexcept;
+
+        std::size_t selection_count() const noexcept { return _selections.count; }
+        binary_selection_view selection(std::size_t) const;
+
+        std::size_t condition_count() const noexcept { return _conditions.count; }
+        binary_condition_view condition(std::size_t) const;
+
+        std::size_t group_by_count() const noexcept { return _group_by.count; }
+        std::string_view group_by(std::size_t) const;
+
+        std::size_t order_by_count() const noexcept { return _order_by.count; }
+        binary_sort_expression_view order_by(std::size_t) const;
+
+        std::string_view buffer() const noexcept { return _buffer; }
+
+    private:
+        struct section
+        {
+            std::uint32_t offset;
+            std::uint32_t count;
+        };
+
+        std::uint32_t record(const section&, std::size_t index, std::size_t record_size) const;
+
+        std::string_view _buffer;
+        std::uint16_t _flags;
+        section _selections;
+        section _conditions;
+        section _group_by;
+        section _order_by;
+    };
+
+    // Builds the Select of a view, e.g. to translate it: the generator works on the AST
+    // types only, so a view saves the parse of a query but not the construction of its
+    // AST. Throws std::runtime_error if the conditions exceed the nesting depth or the
+    // number of expressions allowed by the limits.
+    Select decode(const binary_select_view&, const query_limits& = {});
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_BINARY_HPP
@@ -0,0 +1,314 @@
+#include "genquery.h"
+
+#include "genquery_diagnostic.hpp"
+#include "genquery_explain.hpp"
+#include "genquery_schema.hpp"
+#include "genquery_sql.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <string>
+#include <string_view>
+
+namespace gq = irods::experimental::api::genquery;
+
+static_assert(GENQUERY_KIND_SYNTAX_ERROR == static_cast<int>(gq::error_code::syntax_error));
+static_assert(GENQUERY_KIND_INTERNAL == static_cast<int>(gq::error_code::internal));
+static_assert(GENQUERY_KIND_LIMIT_EXCEEDED == static_cast<int>(gq::error_code::limit_exceeded));
+static_assert(GENQUERY_KIND_TOO_EXPENSIVE == static_cast<int>(gq::error_code::too_expensive));
+static_assert(GENQUERY_KIND_INVALID_GROUPING == static_cast<int>(gq::error_code::invalid_grouping));
+static_assert(GENQUERY_ADMISSION_DOWNGRADE == static_cast<int>(gq::admission_decision::downgrade));
+
+// The translator allocates the SQL and the bind values of every translation. They are
+// copied into the strings of the context, which keep their capacity across translations
+// (see keep_result()), so the memory held by a context stops growing once it has seen its
+// largest query.
+struct genquery_context
+{
+    gq::options options;
+    gq::translation result;
+    std::size_t bind_count{}; // Leading elements of "result.bind_values" in use.
+    gq::diagnostic diagnostic;
+    std::string error;
+    std::string explanation;
+};
+
+namespace
+{
+    auto fail(genquery_context* _ctx, int _status, const char* _message) noexcept -> int
+    {
+        try {
+            _ctx->error.assign(_message);
+        }
+        catch (...) {
+            _ctx->error.clear();
+        }
+
+        return _status;
+    } // fail
+
+    // Copies a translation into the context. Assigning into the strings of the context
+    // reuses their storage, where moving the translation in would replace it. Bind values
+    // beyond the count of the translation are kept for later ones.
+    auto keep_result(genquery_context* _ctx, const gq::translation& _t) -> void
+    {
+        auto& values = _ctx->result.bind_values;
+
+        if (values.size() < _t.bind_values.size()) {
+            values.resize(_t.bind_values.size());
+        }
+
+        for (std::size_t i = 0; i < _t.bind_values.size(); ++i) {
+            values[i].assign(_t.bind_values[i]);
+        }
+
+        _ctx->result.sql.assign(_t.sql);
+        _ctx->result.bind_layout.assign(std::begin(_t.bind_layout), std::end(_t.bind_layout));
+        _ctx->result.bind_counts.assign(std::begin(_t.bind_counts), std::end(_t.bind_counts));
+        _ctx->result.cost = _t.cost;
+        _ctx->result.admission = _t.admission;
+        _ctx->bind_count = _t.bind_values.size();
+    } // keep_result
+
+    // Translates a query with the options of a context, and copies the SQL, or the
+    // explanation of the translation, into the buffer of the caller.
+    auto translate(genquery_context* _ctx,
+                   const char* _query,
+                   std::size_t _query_size,
+                   char* _out,
+                   std::size_t _out_capacity,
+                   std::size_t* _out_size,
+                   bool _explain) noexcept -> int
+    {
+        if (!_ctx) {
+            return GENQUERY_ERROR_INVALID_ARGUMENT;
+        }
+
+        _ctx->error.clear();
+        _ctx->diagnostic.code = gq::error_code::none;
+        _ctx->bind_count = 0;
+        _ctx->result.cost.cost = 0;
+        _ctx->result.admission = gq::admission_decision::accept;
+        _ctx->explanation.clear();
+
+        if (!_query || !_out_size || (!_out && _out_capacity > 0)) {
+            return fail(_ctx, GENQUERY_ERROR_INVALID_ARGUMENT, "invalid argument");
+        }
+
+        try {
+            const std::string_view query{_query, _query_size};
+
+            if (_explain) {
+                auto e = gq::explain(query, _ctx->options);
+
+                if (!e) {
+                    _ctx->diagnostic = std::move(e).error();
+                    _ctx->error = gq::describe(_ctx->diagnostic);
+                    return GENQUERY_ERROR_QUERY;
+                }
+
+                const auto json = gq::to_json(*e);
+                _ctx->explanation.assign(json);
+                keep_result(_ctx, e->result);
+            }
+            else {
+                auto t = gq::try_translate(query, _ctx->options);
+
+                if (!t) {
+                    _ctx->diagnostic = std::move(t).error();
+                    _ctx->error = gq::describe(_ctx->diagnostic);
+                    return GENQUERY_ERROR_QUERY;
+                }
+
+                keep_result(_ctx, *t);
+            }
+        }
+        catch (const std::bad_alloc&) {
+            return fail(_ctx, GENQUERY_ERROR_INTERNAL, "out of memory");
+        }
+        catch (const std::exception& e) {
+            return fail(_ctx, GENQUERY_ERROR_INTERNAL, e.what());
+        }
+        catch (...) {
+            return fail(_ctx, GENQUERY_ERROR_INTERNAL, "unknown error");
+        }
+
+        const auto& text = _explain ? _ctx->explanation : _ctx->result.sql;
+
+        *_out_size = text.size();
+
+        if (_out_capacity <= text.size()) {
+            return fail(_ctx, GENQUERY_ERROR_BUFFER_TOO_SMALL, "buffer too small");
+        }
+
+        std::memcpy(_out, text.data(), text.size());
+        _out[text.size()] = '\0';
+
+        return GENQUERY_OK;
+    } // translate
+} // anonymous namespace
+
+extern "C" {
+
+int genquery_abi_version(void)
+{
+    return GENQUERY_ABI_VERSION;
+}
+
+genquery_context* genquery_context_create(uint32_t flags)
+{
+    auto* ctx = new (std::nothrow) genquery_context{};
+
+    if (ctx) {
+        ctx->options.parameterize = (flags & GENQUERY_PARAMETERIZE) != 0;
+    }
+
+    return ctx;
+}
+
+void genquery_context_destroy(genquery_context* ctx)
+{
+    delete ctx;
+}
+
+int genquery_set_limits(genquery_context* ctx, const genquery_limits* limits)
+{
+    if (!ctx || !limits) {
+        return GENQUERY_ERROR_INVALID_ARGUMENT;
+    }
+
+    ctx->options.limits.max_depth = limits->max_depth;
+    ctx->options.limits.max_nodes = limits->max_nodes;
+    ctx->options.limits.max_literal_bytes = limits->max_literal_bytes;
+    ctx->options.limits.max_in_list = limits->max_in_list;
+
+    return GENQUERY_OK;
+}
+
+int genquery_set_admission_policy(genquery_context* ctx, const genquery_admission_policy* policy)
+{
+    if (!ctx || !policy) {
+        return GENQUERY_ERROR_INVALID_ARGUMENT;
+    }
+
+    const auto threshold = [](double _t) {
+        return _t > 0 ? _t : std::numeric_limits<double>::infinity();
+    };
+
+    ctx->options.admission.throttle_above = threshold(policy->throttle_above);
+    ctx->options.admission.downgrade_above = threshold(policy->downgrade_above);
+    ctx->options.admission.reject_above = threshold(policy->reject_above);
+
+    return GENQUERY_OK;
+}
+
+int genquery_set_table_rows(genquery_context* ctx, const char* table, double rows)
+{
+    if (!ctx || !table || !(rows >= 0)) {
+        return GENQUERY_ERROR_INVALID_ARGUMENT;
+    }
+
+    try {
+        ctx->options.costs.table_rows.insert_or_assign(table, rows);
+    }
+    catch (...) {
+        return fail(ctx, GENQUERY_ERROR_INTERNAL, "out of memory");
+    }
+
+    return GENQUERY_OK;
+}
+
+int genquery_translate(genquery_context* ctx,
+                       const char* query,
+                       size_t query_size,
+                       char* sql,
+                       size_t sql_capacity,
+                       size_t* sql_size)
+{
+    return translate(ctx, query, query_size, sql, sql_capacity, sql_size, false);
+}
+
+int genquery_explain(genquery_context* ctx,
+                     const char* query,
+                     size_t query_size,
+                     char* json,
+                     size_t json_capacity,
+                     size_t* json_size)
+{
+    return translate(ctx, query, query_size, json, json_capacity, json_size, true);
+}
+
+size_t genquery_bind_count(const genquery_context* ctx)
+{
+    return ctx ? ctx->bind_count : 0;
+}
+
+int genquery_bind_value(const genquery_context* ctx, size_t index, const char** value, size_t* value_size)
+{
+    if (!ctx || !value || !value_size || index >= ctx->bind_count) {
+        return GENQUERY_ERROR_INVALID_ARGUMENT;
+    }
+
+    const auto& v = ctx->result.bind_values[index];
+    *value = v.data();
+    *value_size = v.size();
+
+    return GENQUERY_OK;
+}
+
+const char* genquery_last_error(const genquery_context* ctx)
+{
+    return ctx ? ctx->error.c_str() : "invalid argument";
+}
+
+int genquery_last_diagnostic(const genquery_context* ctx, genquery_diagnostic* diagnostic)
+{
+    if (!ctx || !diagnostic) {
+        return GENQUERY_ERROR_INVALID_ARGUMENT;
+    }
+
+    diagnostic->kind = static_cast<int>(ctx->diagnostic.code);
+    diagnostic->offset = ctx->diagnostic.offset;
+    diagnostic->size = ctx->diagnostic.size;
+
+    return GENQUERY_OK;
+}
+
+int genquery_last_cost(const genquery_context* ctx, double* cost, int* admission)
+{
+    if (!ctx || !cost || !admission) {
+        return GENQUERY_ERROR_INVALID_ARGUMENT;
+    }
+
+    *cost = ctx->result.cost.cost;
+    *admission = static_cast<int>(ctx->result.admission);
+
+    return GENQUERY_OK;
+}
+
+int genquery_load_schema(genquery_context* ctx, const char* path)
+{
+    if (!ctx || !path) {
+        return GENQUERY_ERROR_INVALID_ARGUMENT;
+    }
+
+    ctx->error.clear();
+
+    try {
+        gq::publish_schema(gq::schema::load(path));
+    }
+    catch (const std::exception& e) {
+        return fail(ctx, GENQUERY_ERROR_SCHEMA, e.what());
+    }
+    catch (...) {
+        return fail(ctx, GENQUERY_ERROR_INTERNAL, "unknown error");
+    }
+
+    return GENQUERY_OK;
+}
+
+} // extern "C"
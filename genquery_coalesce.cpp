@@ -0,0 +1,256 @@
+#include "genquery_coalesce.hpp"
+
+#include "genquery_kernels.hpp"
+#include "genquery_normalize.hpp"
+#include "genquery_schema.hpp"
+#include "genquery_stream_insertion.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <sstream>
+#include <tuple>
+#include <utility>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        // Stands in for the literal which is allowed to differ between the requests of
+        // a statement. It cannot appear in a literal produced by the scanner.
+        const std::string varying_literal{"\x01"};
+
+        auto shape_of(Select _s, std::size_t _condition) -> std::string
+        {
+            _s.conditions[_condition].expression = ConditionEqual{varying_literal};
+
+            std::ostringstream oss;
+            std::ostream& os = oss;
+            os << _s << (_s.no_distinct ? " no-distinct" : "");
+            return oss.str();
+        } // shape_of
+
+        auto equality_literal(const Condition& _c) -> const std::string*
+        {
+            if (const auto* e = boost::get<ConditionEqual>(&_c.expression); e) {
+                return &e->string_literal;
+            }
+
+            return nullptr;
+        } // equality_literal
+
+        // Each condition on a metadata column gets its own instance of the metadata
+        // tables (see avu_strategy), which the discriminator appended to the selections
+        // would not be bound to. A column of several conditions would also not tell which
+        // of them a row matched.
+        auto may_vary(const schema& _s, const Conditions& _conditions, std::size_t _condition) -> bool
+        {
+            const auto& column = _conditions[_condition].column;
+
+            const auto same_column = std::count_if(std::begin(_conditions), std::end(_conditions), [&column](const Condition& c) {
+                return c.column.name == column.name;
+            });
+
+            if (same_column > 1) {
+                return false;
+            }
+
+            const auto c = _s.column(column.name);
+            const auto t = c ? _s.table(c->table) : std::nullopt;
+
+            return !t || (t->alias.rfind("R_META_MAIN ", 0) != 0 && t->alias.rfind("R_OBJT_METAMAP ", 0) != 0);
+        } // may_vary
+
+        auto has_aggregate(const Selections& _s) -> bool
+        {
+            return std::any_of(std::begin(_s), std::end(_s), [](const Selection& s) {
+                return boost::get<SelectFunction>(&s) != nullptr;
+            });
+        } // has_aggregate
+
+        // The form in which the database returns a value of a column, e.g. 10 for the
+        // literal '010' of an integer column.
+        auto canonical_value(column_type _type, const std::string& _value) -> std::string
+        {
+            if (column_type::integer == _type) {
+                if (const auto n = parse_number(_value); n && n->integral) {
+                    return std::to_string(n->i);
+                }
+            }
+
+            return _value;
+        } // canonical_value
+
+        struct candidate
+        {
+            std::string shape;
+            std::size_t condition;
+        };
+
+        auto make_statement(const schema& _schema,
+                            const std::vector<Select>& _batch,
+                            const std::vector<std::size_t>& _requests,
+                            std::size_t _condition,
+                            const options& _opts) -> coalesced_statement
+        {
+            coalesced_statement stmt;
+            stmt.requests = _requests;
+
+            Select fused = _batch[_requests.front()];
+            const auto column = fused.conditions[_condition].column;
+
+            if (const auto c = _schema.column(column.name); c) {
+                stmt.discriminator_type = c->type;
+            }
+
+            std::vector<std::string> literals;
+
+            for (auto&& r : _requests) {
+                const auto& literal = *equality_literal(_batch[r].conditions[_condition]);
+
+                if (std::find(std::begin(literals), std::end(literals), literal) == std::end(literals)) {
+                    literals.push_back(literal);
+                }
+
+                stmt.requests_by_literal[canonical_value(stmt.discriminator_type, unescape_literal(literal))].push_back(r);
+            }
+
+            fused.conditions[_condition].expression = ConditionIn{std::move(literals)};
+
+            const auto iter = std::find_if(std::begin(fused.selections), std::end(fused.selections), [&column](const Selection& s) {
+                const auto* c = boost::get<Column>(&s);
+                return c && c->name == column.name;
+            });
+
+            if (iter != std::end(fused.selections)) {
+                stmt.discriminator = std::distance(std::begin(fused.selections), iter);
+            }
+            else {
+                stmt.discriminator = fused.selections.size();
+                stmt.discriminator_added = true;
+                fused.selections.push_back(column);
+            }
+
+            stmt.sql = sql(fused, _opts);
+
+            return stmt;
+        } // make_statement
+
+        auto find_requests(const coalesced_statement& _stmt, const std::string& _value) -> const std::vector<std::size_t>*
+        {
+            const auto iter = _stmt.requests_by_literal.find(canonical_value(_stmt.discriminator_type, _value));
+            return iter == std::end(_stmt.requests_by_literal) ? nullptr : &iter->second;
+        } // find_requests
+    } // anonymous namespace
+
+    std::vector<coalesced_statement> coalesce(const std::vector<Select>& _batch, const options& _opts)
+    {
+        // Every equality condition of a request is a candidate for the varying literal.
+        // Each request joins the candidate shape shared by the most requests.
+        std::vector<std::vector<candidate>> candidates(_batch.size());
+        std::map<std::string, std::size_t> shape_counts;
+
+        // A row limit would apply to all the requests of a statement together, and the
+        // rows of a case-insensitive comparison do not tell which literal they matched.
+        const auto fusable = !_opts.case_insensitive && 0 == _opts.row_limit;
+
+        const schema_snapshot snapshot;
+
+        for (std::size_t r = 0; r < _batch.size() && fusable; ++r) {
+            const auto& conditions = _batch[r].conditions;
+
+            // The discriminator would become a group of the aggregates, so a literal
+            // without rows would lose the row of its empty aggregate (e.g. COUNT = 0).
+            if (has_aggregate(_batch[r].selections) || !_batch[r].group_by.empty()) {
+                continue;
+            }
+
+            for (std::size_t c = 0; c < conditions.size(); ++c) {
+                if (equality_literal(conditions[c]) && may_vary(snapshot.get(), conditions, c)) {
+                    auto shape = shape_of(_batch[r], c);
+                    ++shape_counts[shape];
+                    candidates[r].push_back({std::move(shape), c});
+                }
+            }
+        }
+
+        std::vector<std::string> shapes;
+        std::map<std::string, std::tuple<std::size_t, std::vector<std::size_t>>> groups;
+        std::vector<std::size_t> singles;
+
+        for (std::size_t r = 0; r < _batch.size(); ++r) {
+            const auto best = std::max_element(std::begin(candidates[r]), std::end(candidates[r]),
+                [&shape_counts](const candidate& a, const candidate& b) {
+                    return shape_counts[a.shape] < shape_counts[b.shape];
+                });
+
+            if (best == std::end(candidates[r]) || shape_counts[best->shape] < 2) {
+                singles.push_back(r);
+                continue;
+            }
+
+            auto [iter, inserted] = groups.try_emplace(best->shape, best->condition, std::vector<std::size_t>{});
+            std::get<1>(iter->second).push_back(r);
+
+            if (inserted) {
+                shapes.push_back(best->shape);
+            }
+        }
+
+        std::vector<coalesced_statement> statements;
+
+        // Groups are emitted in order of their first request.
+        for (auto&& shape : shapes) {
+            const auto& [condition, requests] = groups[shape];
+
+            if (requests.size() > 1) {
+                statements.push_back(make_statement(snapshot.get(), _batch, requests, condition, _opts));
+            }
+            else {
+                singles.push_back(requests.front());
+            }
+        }
+
+        for (auto&& r : singles) {
+            coalesced_statement stmt;
+            stmt.sql = sql(_batch[r], _opts);
+            stmt.requests.push_back(r);
+            statements.push_back(std::move(stmt));
+        }
+
+        return statements;
+    } // coalesce
+
+    std::map<std::size_t, std::vector<row>> demultiplex(const coalesced_statement& _stmt, std::vector<row> _rows)
+    {
+        std::map<std::size_t, std::vector<row>> ret;
+
+        for (auto&& r : _stmt.requests) {
+            ret[r];
+        }
+
+        if (coalesced_statement::no_discriminator == _stmt.discriminator) {
+            ret[_stmt.requests.front()] = std::move(_rows);
+            return ret;
+        }
+
+        for (auto&& r : _rows) {
+            const auto* requests = find_requests(_stmt, r.at(_stmt.discriminator));
+
+            if (!requests) {
+                continue;
+            }
+
+            if (_stmt.discriminator_added) {
+                r.erase(std::begin(r) + _stmt.discriminator);
+            }
+
+            // Identical requests receive their own copy of the rows.
+            for (std::size_t i = 1; i < requests->size(); ++i) {
+                ret[(*requests)[i]].push_back(r);
+            }
+            ret[requests->front()].push_back(std::move(r));
+        }
+
+        return ret;
+    } // demultiplex
+} // namespace irods::experimental::api::genquery
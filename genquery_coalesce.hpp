@@ -0,0 +1,63 @@
+#ifndef IRODS_GENQUERY_COALESCE_HPP
+#define IRODS_GENQUERY_COALESCE_HPP
+
+#include "genquery_ast_types.hpp"
+#include "genquery_schema.hpp"
+#include "genquery_sql.hpp"
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    // A single SQL statement which answers one or more GenQuery requests of a batch.
+    //
+    // Requests which have the same shape and differ only in the literal of one equality
+    // condition (e.g. "DATA_NAME = 'x'") are fused into a single statement which uses
+    // an IN condition instead. The column of that condition (the discriminator) is part
+    // of every result row and tells which request a row belongs to.
+    //
+    // The literal may not vary in a condition on a metadata column (e.g.
+    // META_DATA_ATTR_VALUE) or on a column with several conditions. Requests with
+    // aggregates or a GROUP BY are translated on their own, as are all the requests of a
+    // batch translated with options::case_insensitive or options::row_limit.
+    struct coalesced_statement
+    {
+        static constexpr std::size_t no_discriminator = static_cast<std::size_t>(-1);
+
+        std::string sql;
+
+        // Indices of the requests (within the batch) answered by this statement.
+        std::vector<std::size_t> requests;
+
+        // Position of the discriminator within a result row. Equal to "no_discriminator"
+        // when the statement answers a single request unchanged.
+        std::size_t discriminator = no_discriminator;
+
+        // True if the discriminator was appended to the selections of the requests. It is
+        // removed from the rows handed back to the requests.
+        bool discriminator_added = false;
+
+        // The type of the discriminator column in the schema.
+        column_type discriminator_type = column_type::text;
+
+        // Maps the value of the discriminator column, in the form the database returns it
+        // (e.g. 10 for the literal '010' of an integer column), to the requests which
+        // asked for it.
+        std::map<std::string, std::vector<std::size_t>> requests_by_literal;
+    };
+
+    using row = std::vector<std::string>;
+
+    // Groups the requests of a batch into as few statements as possible. Every request
+    // is answered by exactly one of the returned statements.
+    std::vector<coalesced_statement> coalesce(const std::vector<Select>&, const options& = {});
+
+    // Distributes the rows returned for a statement to the requests it answers.
+    // The result maps the index of a request (within the batch) to its rows.
+    std::map<std::size_t, std::vector<row>> demultiplex(const coalesced_statement&, std::vector<row>);
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_COALESCE_HPP
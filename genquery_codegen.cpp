@@ -0,0 +1,370 @@
+#include "genquery_codegen.hpp"
+
+#include "genquery_normalize.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cctype>
+#include <istream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        // Starts the literals which stand for parameters, followed by the index of the
+        // parameter. The scanner accepts any character within a literal.
+        constexpr char parameter_marker = '\x01';
+
+        auto is_identifier_start(char _c) -> bool
+        {
+            return std::isalpha(static_cast<unsigned char>(_c)) || '_' == _c;
+        } // is_identifier_start
+
+        auto is_identifier_char(char _c) -> bool
+        {
+            return std::isalnum(static_cast<unsigned char>(_c)) || '_' == _c;
+        } // is_identifier_char
+
+        auto identifier_at(std::string_view _s, std::size_t _pos) -> std::string_view
+        {
+            if (_pos >= _s.size() || !is_identifier_start(_s[_pos])) {
+                return {};
+            }
+
+            auto end = _pos + 1;
+            while (end < _s.size() && is_identifier_char(_s[end])) {
+                ++end;
+            }
+
+            return _s.substr(_pos, end - _pos);
+        } // identifier_at
+
+        // Replaces the parameters of a template with literals which name them.
+        auto substitute_parameters(query_template& _t, std::string_view _source) -> void
+        {
+            const auto fail = [&](std::string_view _what) {
+                throw std::runtime_error{fmt::format("{}:{}: query [{}]: {}", _source, _t.line, _t.name, _what)};
+            };
+
+            const std::string_view text = _t.text;
+
+            for (std::size_t i = 0; i < text.size();) {
+                if ('\'' == text[i]) {
+                    // Literals are copied as they are, '' included.
+                    auto end = i + 1;
+                    while (end < text.size() && ('\'' != text[end] || (end + 1 < text.size() && '\'' == text[end + 1]))) {
+                        end += '\'' == text[end] ? 2 : 1;
+                    }
+                    _t.query.append(text, i, end + 1 - i);
+                    i = end + 1;
+                    continue;
+                }
+
+                if (':' != text[i]) {
+                    _t.query += text[i++];
+                    continue;
+                }
+
+                const auto name = identifier_at(text, i + 1);
+                if (name.empty()) {
+                    fail(fmt::format("expected a parameter name at column {}", i + 1));
+                }
+                i += 1 + name.size();
+
+                std::optional<parameter_type> type;
+                if (i < text.size() && ':' == text[i]) {
+                    const auto t = identifier_at(text, i + 1);
+                    if ("text" == t) {
+                        type = parameter_type::text;
+                    }
+                    else if ("int" == t) {
+                        type = parameter_type::integer;
+                    }
+                    else {
+                        fail(fmt::format("unknown type [{}] of parameter [{}]", t, name));
+                    }
+                    i += 1 + t.size();
+                }
+
+                auto p = std::find_if(std::begin(_t.parameters), std::end(_t.parameters), [name](auto&& _p) {
+                    return _p.name == name;
+                });
+
+                if (std::end(_t.parameters) == p) {
+                    p = _t.parameters.insert(p, query_parameter{std::string{name}, type.value_or(parameter_type::text)});
+                }
+                else if (type && *type != p->type) {
+                    fail(fmt::format("parameter [{}] is used with different types", name));
+                }
+
+                _t.query += fmt::format("'{}{}'", parameter_marker, p - std::begin(_t.parameters));
+            }
+        } // substitute_parameters
+
+        // A C++ string literal of "_s".
+        auto cpp_string(std::string_view _s) -> std::string
+        {
+            std::string out{"\""};
+
+            for (const char c : _s) {
+                const auto u = static_cast<unsigned char>(c);
+
+                if ('"' == c || '\\' == c) {
+                    out += '\\';
+                    out += c;
+                }
+                else if (u < 0x20 || 0x7f == u) {
+                    // Octal escapes end after three digits, unlike hexadecimal ones.
+                    out += fmt::format("\\{:03o}", u);
+                }
+                else {
+                    out += c;
+                }
+            }
+
+            out += '"';
+            return out;
+        } // cpp_string
+
+        auto cpp_type(parameter_type _type) -> std::string_view
+        {
+            return parameter_type::integer == _type ? "std::int64_t" : "std::string_view";
+        } // cpp_type
+
+        // The expression of the bind value of a literal of a template.
+        auto value_expression(const query_template& _t, const std::string& _literal) -> std::string
+        {
+            if (_literal.empty() || parameter_marker != _literal.front()) {
+                return cpp_string(unescape_literal(_literal));
+            }
+
+            const auto& p = _t.parameters.at(std::stoul(_literal.substr(1)));
+
+            if (parameter_type::integer == p.type) {
+                return fmt::format("std::to_string({})", p.name);
+            }
+
+            return fmt::format("std::string{{{}}}", p.name);
+        } // value_expression
+
+        auto is_parameter(const std::string& _literal) -> bool
+        {
+            return !_literal.empty() && parameter_marker == _literal.front();
+        } // is_parameter
+
+        // e.g. "app::queries" and "src/fixed.gq" give "APP_QUERIES_FIXED_GQ_HPP".
+        auto include_guard(std::string_view _namespace, std::string_view _source) -> std::string
+        {
+            if (const auto slash = _source.find_last_of('/'); std::string_view::npos != slash) {
+                _source.remove_prefix(slash + 1);
+            }
+
+            auto guard = fmt::format("{}_{}_HPP", _namespace, _source);
+
+            std::string ret;
+
+            // Identifiers with "__" are reserved, e.g. those of "a::b".
+            for (const auto c : guard) {
+                if (is_identifier_char(c)) {
+                    ret += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+                }
+                else if (ret.empty() || '_' != ret.back()) {
+                    ret += '_';
+                }
+            }
+
+            return ret;
+        } // include_guard
+    } // anonymous namespace
+
+    std::vector<query_template> read_templates(std::istream& _in, std::string_view _source)
+    {
+        std::vector<query_template> templates;
+        std::size_t line_number = 0;
+
+        for (std::string line; std::getline(_in, line);) {
+            ++line_number;
+
+            if (!line.empty() && '\r' == line.back()) {
+                line.pop_back();
+            }
+
+            const auto first = line.find_first_not_of(" \t");
+
+            if (std::string::npos == first || '#' == line[first]) {
+                continue;
+            }
+
+            if (first > 0) {
+                if (templates.empty()) {
+                    throw std::runtime_error{fmt::format("{}:{}: continuation line without a query", _source, line_number)};
+                }
+                templates.back().text += ' ';
+                templates.back().text.append(line, first);
+                continue;
+            }
+
+            const auto name = identifier_at(line, 0);
+            const auto eq = line.find_first_not_of(" \t", name.size());
+
+            if (name.empty() || std::string::npos == eq || '=' != line[eq]) {
+                throw std::runtime_error{fmt::format("{}:{}: expected NAME = QUERY", _source, line_number)};
+            }
+
+            const auto duplicate = std::any_of(std::begin(templates), std::end(templates), [name](auto&& _t) {
+                return _t.name == name;
+            });
+
+            if (duplicate) {
+                throw std::runtime_error{fmt::format("{}:{}: query [{}] is defined more than once", _source, line_number, name)};
+            }
+
+            auto& t = templates.emplace_back();
+            t.name = name;
+            t.line = line_number;
+
+            const auto text = line.find_first_not_of(" \t", eq + 1);
+            if (std::string::npos != text) {
+                t.text = line.substr(text);
+            }
+        }
+
+        for (auto&& t : templates) {
+            substitute_parameters(t, _source);
+        }
+
+        return templates;
+    } // read_templates
+
+    std::string emit_cpp(const std::vector<query_template>& _templates, const codegen_options& _opts)
+    {
+        const auto translate = _opts.translate ? _opts.translate : [](const Select& _s, const options& _o) {
+            return try_translate(_s, _o);
+        };
+
+        // Indexes resolve conditions with the values of the literals, which are not
+        // known until the queries run.
+        auto o = _opts.translation;
+        o.parameterize = true;
+        o.collection_paths = nullptr;
+        o.metadata = nullptr;
+        o.trace = false;
+        o.explain = nullptr;
+
+        std::string structs;
+        bool uses_dialect = false;
+
+        for (auto&& t : _templates) {
+            const auto fail = [&](const diagnostic& _d) {
+                return std::runtime_error{fmt::format("{}:{}: query [{}]: {}", _opts.source, t.line, t.name, describe(_d))};
+            };
+
+            const auto select = wrapper::try_parse(t.query, o.limits);
+            if (!select) {
+                throw fail(select.error());
+            }
+
+            const auto tr = translate(*select, o);
+            if (!tr) {
+                throw fail(tr.error());
+            }
+
+            const auto refs = literals(*select);
+
+            std::vector<std::string> values;
+            values.reserve(tr->bind_layout.size());
+
+            for (std::size_t i = 0; i < tr->bind_layout.size(); ++i) {
+                const auto first = tr->bind_layout[i];
+                const auto count = tr->bind_counts.empty() ? 1 : tr->bind_counts[i];
+
+                if (1 == count) {
+                    values.push_back(value_expression(t, *refs.at(first)));
+                    continue;
+                }
+
+                // An IN list bound as one array. Lists without parameters are bound as
+                // translated.
+                const auto list = std::begin(refs) + first;
+
+                if (std::none_of(list, list + count, [](auto* _l) { return is_parameter(*_l); })) {
+                    values.push_back(cpp_string(tr->bind_values[i]));
+                    continue;
+                }
+
+                std::vector<std::string> elements;
+                std::transform(list, list + count, std::back_inserter(elements), [&t](auto* _l) {
+                    return value_expression(t, *_l);
+                });
+
+                values.push_back(fmt::format("irods::experimental::api::genquery::dialect::{}::array({{{}}})",
+                                             _opts.dialect,
+                                             fmt::join(elements, ", ")));
+                uses_dialect = true;
+            }
+
+            std::vector<std::string> parameters;
+            for (auto&& p : t.parameters) {
+                parameters.push_back(fmt::format("{} {}", cpp_type(p.type), p.name));
+            }
+
+            structs += fmt::format("\n"
+                                   "    // {}\n"
+                                   "    struct {}\n"
+                                   "    {{\n"
+                                   "        static constexpr std::string_view sql = {};\n"
+                                   "\n"
+                                   "        // The values of the placeholders of \"sql\", in order.\n"
+                                   "        static std::array<std::string, {}> bind({})\n"
+                                   "        {{\n",
+                                   t.text,
+                                   t.name,
+                                   cpp_string(tr->sql),
+                                   values.size(),
+                                   fmt::join(parameters, ", "));
+
+            if (values.empty()) {
+                structs += "            return {};\n";
+            }
+            else {
+                structs += fmt::format("            return {{{{\n"
+                                       "                {}\n"
+                                       "            }}}};\n",
+                                       fmt::join(values, ",\n                "));
+            }
+
+            structs += "        }\n"
+                       "    };\n";
+        }
+
+        const auto guard = include_guard(_opts.namespace_name, _opts.source);
+
+        return fmt::format("// Generated by gql --emit-cpp from {}. Do not edit.\n"
+                           "#ifndef {}\n"
+                           "#define {}\n"
+                           "\n"
+                           "{}"
+                           "#include <array>\n"
+                           "#include <cstdint>\n"
+                           "#include <string>\n"
+                           "#include <string_view>\n"
+                           "\n"
+                           "namespace {}\n"
+                           "{{{}}} // namespace {}\n"
+                           "\n"
+                           "#endif // {}\n",
+                           _opts.source,
+                           guard,
+                           guard,
+                           uses_dialect ? "#include \"genquery_dialect.hpp\"\n\n" : "",
+                           _opts.namespace_name,
+                           structs,
+                           _opts.namespace_name,
+                           guard);
+    } // emit_cpp
+} // namespace irods::experimental::api::genquery
@@ -0,0 +1,93 @@
+#ifndef IRODS_GENQUERY_CODEGEN_HPP
+#define IRODS_GENQUERY_CODEGEN_HPP
+
+#include "genquery_sql.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Ahead-of-time translation of the fixed queries of an application (see gql --emit-cpp
+// and genquery_compile_queries() in CMakeLists.txt).
+//
+// A template file holds one named query per line, e.g.
+//
+//   # The data objects of a collection above a size.
+//   large_data_objects = select DATA_NAME, DATA_SIZE where COLL_NAME = :collection and DATA_SIZE > :min_size:int
+//
+// Lines which start with whitespace continue the query of the previous line, and lines
+// which start with '#' are comments. Parameters are written in place of literals as
+// ":name" or ":name:type", where the type is "text" (the default) or "int". A parameter
+// may appear more than once.
+//
+// emit_cpp() translates each query and generates a header with a struct per query:
+//
+//   struct large_data_objects
+//   {
+//       static constexpr std::string_view sql = "SELECT ...";
+//       static std::array<std::string, 2> bind(std::string_view collection, std::int64_t min_size);
+//   };
+//
+// bind() returns the values of the placeholders of "sql", in order, with the literals
+// of the template in place. Queries which do not translate (e.g. because a column was
+// removed from the schema) fail the generation, and so the build.
+namespace irods::experimental::api::genquery
+{
+    enum class parameter_type
+    {
+        text,   // std::string_view
+        integer // std::int64_t
+    };
+
+    struct query_parameter
+    {
+        std::string name;
+        parameter_type type = parameter_type::text;
+    };
+
+    struct query_template
+    {
+        std::string name;
+
+        // The query as written, and as parsed, i.e. with each parameter replaced by a
+        // literal which names it.
+        std::string text;
+        std::string query;
+
+        std::vector<query_parameter> parameters;
+
+        // The line of the template file the query starts on.
+        std::size_t line = 0;
+    };
+
+    struct codegen_options
+    {
+        // The name of the template file, for messages and the comment and include guard
+        // of the header.
+        std::string source = "queries";
+
+        // The namespace of the generated structs.
+        std::string namespace_name = "genquery_queries";
+
+        // Literals are always parameterized.
+        options translation;
+
+        // The dialect the queries are translated to (see genquery_dialect.hpp), and the
+        // function which translates to it (try_translate() when empty). The array() of the
+        // dialect builds the bind values of IN lists with parameters when it binds lists as
+        // arrays.
+        std::string dialect = "generic";
+        std::function<result<genquery::translation>(const Select&, const options&)> translate;
+    };
+
+    // Throws std::runtime_error, naming the line, if the file is malformed.
+    std::vector<query_template> read_templates(std::istream&, std::string_view source);
+
+    // Throws std::runtime_error, naming the query, if a query does not translate.
+    std::string emit_cpp(const std::vector<query_template>&, const codegen_options&);
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_CODEGEN_HPP
@@ -0,0 +1,990 @@
+#include "genquery_columnar.hpp"
+
+#include "genquery_path_index.hpp"
+#include "genquery_schema.hpp"
+#include "genquery_sql.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        // A total order which agrees with compare(), for sorting dictionaries.
+        auto value_less(column_type _t, std::string_view _a, std::string_view _b) -> bool
+        {
+            const auto c = compare(_t, _a, _b);
+            return c != 0 ? c < 0 : _a < _b;
+        } // value_less
+
+        // The codes of "_to" whose values occur in "_from" at the given rows.
+        auto translate_codes(const dictionary_column& _from, const std::vector<std::uint32_t>& _rows, const dictionary_column& _to)
+            -> selection
+        {
+            selection seen{_from.dictionary().size()};
+            for (const auto r : _rows) {
+                seen.set(_from.code(r));
+            }
+
+            selection m{_to.dictionary().size()};
+            for (const auto i : seen.positions()) {
+                if (const auto code = _to.find(_from.dictionary()[i]); code) {
+                    m.set(*code);
+                }
+            }
+
+            return m;
+        } // translate_codes
+
+        // An equality between columns of two tables, parsed from a link clause. The
+        // tables are in the order of the link definition.
+        struct link_key
+        {
+            std::string table1;
+            std::string column1;
+            std::string table2;
+            std::string column2;
+        };
+
+        // Link clauses which are not a single equality between the linked tables (e.g.
+        // the ticket links) cannot be used as join keys and are ignored.
+        auto parse_link(const link_definition& _l) -> std::optional<link_key>
+        {
+            const auto clause = _l.clause;
+            const auto eq = clause.find(" = ");
+
+            if (std::string_view::npos == eq || clause.find(" AND ") != std::string_view::npos) {
+                return std::nullopt;
+            }
+
+            const auto split = [](std::string_view _side) -> std::optional<std::pair<std::string_view, std::string_view>> {
+                const auto dot = _side.find('.');
+                if (std::string_view::npos == dot || _side.find('.', dot + 1) != std::string_view::npos) {
+                    return std::nullopt;
+                }
+                return std::make_pair(_side.substr(0, dot), _side.substr(dot + 1));
+            };
+
+            auto lhs = split(clause.substr(0, eq));
+            auto rhs = split(clause.substr(eq + 3));
+
+            if (!lhs || !rhs) {
+                return std::nullopt;
+            }
+
+            if (lhs->first != _l.table1) {
+                std::swap(lhs, rhs);
+            }
+
+            if (lhs->first != _l.table1 || rhs->first != _l.table2) {
+                return std::nullopt;
+            }
+
+            return link_key{std::string{lhs->first}, std::string{lhs->second}, std::string{rhs->first}, std::string{rhs->second}};
+        } // parse_link
+
+        auto has_path_condition(const ConditionExpression& _e) -> bool
+        {
+            std::vector<const ConditionExpression*> stack{&_e};
+
+            while (!stack.empty()) {
+                const auto& e = *stack.back();
+                stack.pop_back();
+
+                if (const auto* op = boost::get<ConditionOperator_And>(&e); op) {
+                    stack.insert(std::end(stack), {&op->left, &op->right});
+                }
+                else if (const auto* op = boost::get<ConditionOperator_Or>(&e); op) {
+                    stack.insert(std::end(stack), {&op->left, &op->right});
+                }
+                else if (const auto* op = boost::get<ConditionOperator_Not>(&e); op) {
+                    stack.push_back(&op->expression);
+                }
+                else if (boost::get<ConditionBeginningOf>(&e) || boost::get<ConditionParentOf>(&e)) {
+                    return true;
+                }
+            }
+
+            return false;
+        } // has_path_condition
+
+        struct too_many_rows
+        {
+        };
+
+        class evaluator
+        {
+        public:
+            evaluator(const schema& _s, const catalog_snapshot& _snapshot, const evaluation_options& _opts)
+                : _schema{_s}
+                , _snapshot{_snapshot}
+                , _opts{_opts}
+            {
+                for (std::size_t i = 0; i < _s.link_count(); ++i) {
+                    if (auto k = parse_link(_s.link(i)); k) {
+                        _links.push_back(std::move(*k));
+                    }
+                }
+            }
+
+            auto run(const Select& _s) -> row_set
+            {
+                plan(_s);
+                filter();
+                join();
+                return project(_s);
+            }
+
+        private:
+            struct bound_column
+            {
+                std::size_t table; // Index into _tables.
+                const dictionary_column* data;
+            };
+
+            struct filter_term
+            {
+                const dictionary_column* column;
+                selection match; // By code.
+            };
+
+            struct plan_table
+            {
+                std::string name; // e.g. r_data_meta_main
+                const columnar_table* data;
+                std::vector<const Condition*> conditions;
+                std::vector<filter_term> terms;
+                std::vector<std::uint32_t> rows; // The rows which pass the filter.
+            };
+
+            // Conditions on one instance of a metadata table which restrict the object
+            // table to the objects having an AVU that satisfies all of them.
+            struct avu_group
+            {
+                std::string meta_table;
+                std::string metamap_table;
+                std::string object_table;
+                const link_key* meta_link;
+                const link_key* object_link;
+                std::vector<const Condition*> conditions;
+            };
+
+            struct edge
+            {
+                std::size_t parent;
+                std::size_t child;
+                const link_key* link;
+            };
+
+            auto physical_table(std::string_view _table) const -> std::string
+            {
+                const auto t = _schema.table(_table);
+                if (!t) {
+                    throw std::runtime_error{fmt::format("failed to find table [{}]", _table)};
+                }
+                return std::string{t->alias.substr(0, t->alias.find(' '))};
+            }
+
+            auto snapshot_table(std::string_view _table) const -> const columnar_table&
+            {
+                const auto physical = physical_table(_table);
+                const auto* t = _snapshot.table(physical);
+                if (!t) {
+                    throw std::runtime_error{fmt::format("table [{}] is not part of the snapshot", physical)};
+                }
+                return *t;
+            }
+
+            auto snapshot_column(std::string_view _table, std::string_view _column) const -> const dictionary_column&
+            {
+                const auto& t = snapshot_table(_table);
+                const auto c = t.columns.find(_column);
+                if (std::end(t.columns) == c) {
+                    throw std::runtime_error{fmt::format("column [{}.{}] is not part of the snapshot", physical_table(_table), _column)};
+                }
+                return c->second;
+            }
+
+            // The logical table (e.g. r_data_meta_main) and column of a GenQuery column.
+            auto resolve(const Column& _c) const -> std::pair<std::string, std::string>
+            {
+                const auto c = _schema.column(_c.name);
+                return {std::string{c->table}, std::string{c->column}};
+            }
+
+            auto table_index(const std::string& _name) -> std::size_t
+            {
+                const auto i = std::find_if(std::begin(_tables), std::end(_tables), [&_name](auto& _t) { return _t.name == _name; });
+                if (std::end(_tables) != i) {
+                    return static_cast<std::size_t>(i - std::begin(_tables));
+                }
+
+                _tables.push_back({_name, &snapshot_table(_name), {}, {}, {}});
+                return _tables.size() - 1;
+            }
+
+            auto bind(const Column& _c) -> bound_column
+            {
+                const auto [table, column] = resolve(_c);
+                const auto& data = snapshot_column(table, column);
+                return {table_index(table), &data};
+            }
+
+            // The only link whose second table is "_table", as find_avu_links() requires.
+            auto unique_link_to(const std::string& _table) const -> const link_key*
+            {
+                const link_key* found{};
+                for (auto&& l : _links) {
+                    if (l.table2 == _table) {
+                        if (found) {
+                            return nullptr;
+                        }
+                        found = &l;
+                    }
+                }
+                return found;
+            }
+
+            auto is_meta_table(const std::string& _table) const -> bool
+            {
+                return "R_META_MAIN" == physical_table(_table);
+            }
+
+            // Pairs AVU conditions with instances of metadata tables the way the
+            // translator does (see collect_avu_groups() in genquery_sql.cpp).
+            auto collect_avu_groups(const Select& _s, const std::vector<std::string>& _selected)
+                -> std::vector<const Condition*>
+            {
+                std::map<std::pair<std::string, std::size_t>, std::size_t> group_index;
+                std::map<std::string, std::size_t> column_counter;
+                std::vector<const Condition*> joined;
+
+                for (auto&& c : _s.conditions) {
+                    const auto table = resolve(c.column).first;
+
+                    if (!is_meta_table(table)) {
+                        joined.push_back(&c);
+                        continue;
+                    }
+
+                    const auto n = column_counter[c.column.name]++;
+                    const auto selected = std::find(std::begin(_selected), std::end(_selected), table) != std::end(_selected);
+
+                    if (0 == n && selected) {
+                        joined.push_back(&c);
+                        continue;
+                    }
+
+                    const auto key = std::make_pair(table, n);
+
+                    if (const auto i = group_index.find(key); std::end(group_index) != i) {
+                        _groups[i->second].conditions.push_back(&c);
+                        continue;
+                    }
+
+                    avu_group g;
+                    g.meta_table = table;
+                    g.meta_link = unique_link_to(table);
+                    if (g.meta_link) {
+                        g.metamap_table = g.meta_link->table1;
+                        g.object_link = unique_link_to(g.metamap_table);
+                    }
+
+                    if (!g.meta_link || !g.object_link) {
+                        joined.push_back(&c);
+                        continue;
+                    }
+
+                    g.object_table = g.object_link->table1;
+                    g.conditions.push_back(&c);
+                    group_index.emplace(key, _groups.size());
+                    _groups.push_back(std::move(g));
+                }
+
+                return joined;
+            }
+
+            // Connects the tables of the query through the link graph. Each table not yet
+            // connected is reached by the shortest path from the connected ones.
+            auto link_tables(const std::vector<std::string>& _required) -> void
+            {
+                for (auto&& t : _required) {
+                    table_index(t);
+                }
+
+                std::vector<std::string> connected{_required.front()};
+
+                const auto is_connected = [&connected](const std::string& _t) {
+                    return std::find(std::begin(connected), std::end(connected), _t) != std::end(connected);
+                };
+
+                for (auto&& target : _required) {
+                    if (is_connected(target)) {
+                        continue;
+                    }
+
+                    // Breadth-first search from the target to the connected tables.
+                    std::map<std::string, const link_key*> via{{target, nullptr}};
+                    std::vector<std::string> queue{target};
+                    std::optional<std::string> reached;
+
+                    for (std::size_t q = 0; q < queue.size() && !reached; ++q) {
+                        const auto current = queue[q];
+
+                        for (auto&& l : _links) {
+                            if (l.table1 != current && l.table2 != current) {
+                                continue;
+                            }
+
+                            const auto& next = l.table1 == current ? l.table2 : l.table1;
+
+                            if (via.count(next)) {
+                                continue;
+                            }
+
+                            via.emplace(next, &l);
+
+                            if (is_connected(next)) {
+                                reached = next;
+                                break;
+                            }
+
+                            queue.push_back(next);
+                        }
+                    }
+
+                    if (!reached) {
+                        throw std::runtime_error{fmt::format("no link between table [{}] and table [{}]", target, _required.front())};
+                    }
+
+                    // Walks back from the connected table to the target.
+                    for (auto t = *reached; t != target;) {
+                        const auto* l = via.at(t);
+                        const auto& prev = l->table1 == t ? l->table2 : l->table1;
+
+                        _edges.push_back({table_index(t), table_index(prev), l});
+                        connected.push_back(prev);
+                        t = prev;
+                    }
+                }
+            }
+
+            auto plan(const Select& _s) -> void
+            {
+                std::vector<std::string> selected;
+
+                for (auto&& selection : _s.selections) {
+                    const auto* c = boost::get<Column>(&selection);
+                    const auto& column = c ? *c : boost::get<SelectFunction>(selection).column;
+                    selected.push_back(resolve(column).first);
+                }
+
+                const auto joined = collect_avu_groups(_s, selected);
+
+                auto required = selected;
+
+                for (const auto* c : joined) {
+                    required.push_back(resolve(c->column).first);
+                }
+
+                for (auto&& c : _s.group_by) {
+                    required.push_back(resolve(c).first);
+                }
+
+                for (auto&& e : _s.order_by) {
+                    required.push_back(resolve(e.column).first);
+                }
+
+                for (auto&& g : _groups) {
+                    required.push_back(g.object_table);
+                }
+
+                link_tables(required);
+
+                for (const auto* c : joined) {
+                    _tables[table_index(resolve(c->column).first)].conditions.push_back(c);
+                }
+            }
+
+            auto filter() -> void
+            {
+                for (auto&& t : _tables) {
+                    for (const auto* c : t.conditions) {
+                        const auto& column = snapshot_column(t.name, resolve(c->column).second);
+                        t.terms.push_back({&column, match(column, c->expression)});
+                    }
+                }
+
+                // Each group becomes a filter on the key of the object table, through the
+                // metadata table and the map from metadata to objects.
+                for (auto&& g : _groups) {
+                    plan_table meta{g.meta_table, &snapshot_table(g.meta_table), g.conditions, {}, {}};
+
+                    for (const auto* c : g.conditions) {
+                        const auto& column = snapshot_column(g.meta_table, resolve(c->column).second);
+                        meta.terms.push_back({&column, match(column, c->expression)});
+                    }
+
+                    select_rows(meta);
+
+                    const auto key = [](const link_key& _l, const std::string& _t) {
+                        return _l.table1 == _t ? _l.column1 : _l.column2;
+                    };
+
+                    const auto& meta_key = snapshot_column(g.meta_table, key(*g.meta_link, g.meta_table));
+                    const auto& metamap_meta_key = snapshot_column(g.metamap_table, key(*g.meta_link, g.metamap_table));
+
+                    plan_table metamap{g.metamap_table, &snapshot_table(g.metamap_table), {}, {}, {}};
+                    metamap.terms.push_back({&metamap_meta_key, translate_codes(meta_key, meta.rows, metamap_meta_key)});
+                    select_rows(metamap);
+
+                    const auto& metamap_object_key = snapshot_column(g.metamap_table, key(*g.object_link, g.metamap_table));
+                    const auto& object_key = snapshot_column(g.object_table, key(*g.object_link, g.object_table));
+
+                    _tables[table_index(g.object_table)].terms.push_back(
+                        {&object_key, translate_codes(metamap_object_key, metamap.rows, object_key)});
+                }
+
+                for (auto&& t : _tables) {
+                    select_rows(t);
+                }
+            }
+
+            static auto match(const dictionary_column& _c, const ConditionExpression& _e) -> selection
+            {
+                const auto* paths = has_path_condition(_e) ? &_c.paths() : nullptr;
+                return select(_e, {_c.type(), &_c.dictionary(), true, &_c.integers(), paths});
+            }
+
+            static auto select_rows(plan_table& _t) -> void
+            {
+                selection rows{_t.data->rows, true};
+
+                for (auto&& f : _t.terms) {
+                    rows &= select_codes(f.column->codes(), f.match);
+                }
+
+                _t.rows = rows.positions();
+            }
+
+            // Joins the tables along the edges of the link tree, starting with the table
+            // with the fewest rows left by the filters. The joined rows are kept as one
+            // vector of row numbers per table.
+            auto join() -> void
+            {
+                const auto root = static_cast<std::size_t>(
+                    std::min_element(std::begin(_tables), std::end(_tables), [](auto& _a, auto& _b) {
+                        return _a.rows.size() < _b.rows.size();
+                    }) - std::begin(_tables));
+
+                _joined.assign(_tables.size(), {});
+                _joined[root] = _tables[root].rows;
+                _rows = _tables[root].rows.size();
+
+                std::vector<bool> done(_tables.size(), false);
+                done[root] = true;
+
+                for (bool progress = true; progress;) {
+                    progress = false;
+
+                    for (auto&& e : _edges) {
+                        if (done[e.parent] == done[e.child]) {
+                            continue;
+                        }
+
+                        const auto from = done[e.parent] ? e.parent : e.child;
+                        const auto to = done[e.parent] ? e.child : e.parent;
+
+                        hash_join(from, to, *e.link, done);
+                        done[to] = true;
+                        progress = true;
+                    }
+                }
+            }
+
+            auto hash_join(std::size_t _from, std::size_t _to, const link_key& _l, const std::vector<bool>& _done) -> void
+            {
+                const auto& from = _tables[_from];
+                const auto& to = _tables[_to];
+
+                const auto column_of = [&_l](const plan_table& _t) -> const std::string& {
+                    return _l.table1 == _t.name ? _l.column1 : _l.column2;
+                };
+
+                const auto& from_key = snapshot_column(from.name, column_of(from));
+                const auto& to_key = snapshot_column(to.name, column_of(to));
+
+                // Build: the filtered rows of the new table, bucketed by key code.
+                const auto codes = to_key.dictionary().size();
+                std::vector<std::uint32_t> offsets(codes + 1, 0);
+                for (const auto r : to.rows) {
+                    ++offsets[to_key.code(r) + 1];
+                }
+                std::partial_sum(std::begin(offsets), std::end(offsets), std::begin(offsets));
+
+                std::vector<std::uint32_t> buckets(to.rows.size());
+                auto fill = offsets;
+                for (const auto r : to.rows) {
+                    buckets[fill[to_key.code(r)]++] = r;
+                }
+
+                // Probe: the key codes of the joined table, translated to the codes of the
+                // new table by value on first use.
+                constexpr auto unknown = ~std::uint32_t{0};
+                constexpr auto absent = unknown - 1;
+                std::vector<std::uint32_t> translated(from_key.dictionary().size(), unknown);
+
+                std::vector<std::vector<std::uint32_t>> joined(_tables.size());
+                std::vector<std::size_t> present;
+                for (std::size_t t = 0; t < _tables.size(); ++t) {
+                    if (_done[t]) {
+                        present.push_back(t);
+                    }
+                }
+
+                std::size_t rows = 0;
+
+                for (std::size_t i = 0; i < _rows; ++i) {
+                    const auto code = from_key.code(_joined[_from][i]);
+
+                    if (unknown == translated[code]) {
+                        const auto c = to_key.find(from_key.dictionary()[code]);
+                        translated[code] = c ? *c : absent;
+                    }
+
+                    if (absent == translated[code]) {
+                        continue;
+                    }
+
+                    for (auto b = offsets[translated[code]]; b < offsets[translated[code] + 1]; ++b) {
+                        if (++rows > _opts.max_rows) {
+                            throw too_many_rows{};
+                        }
+
+                        for (const auto t : present) {
+                            joined[t].push_back(_joined[t][i]);
+                        }
+                        joined[_to].push_back(buckets[b]);
+                    }
+                }
+
+                _joined = std::move(joined);
+                _rows = rows;
+            }
+
+            auto value(const bound_column& _c, std::size_t _row) const -> std::string_view
+            {
+                return _c.data->value(_joined[_c.table][_row]);
+            }
+
+            auto project(const Select& _s) -> row_set;
+
+            const schema& _schema;
+            const catalog_snapshot& _snapshot;
+            const evaluation_options& _opts;
+
+            std::vector<link_key> _links;
+            std::vector<plan_table> _tables;
+            std::vector<edge> _edges;
+            std::vector<avu_group> _groups;
+
+            // The joined rows: the row number of each table, per joined row.
+            std::vector<std::vector<std::uint32_t>> _joined;
+            std::size_t _rows = 0;
+        };
+
+        auto to_upper(std::string _s) -> std::string
+        {
+            std::transform(std::begin(_s), std::end(_s), std::begin(_s), [](unsigned char _c) { return std::toupper(_c); });
+            return _s;
+        } // to_upper
+
+        // Formats like the database does: integral sums as integers, averages as reals.
+        auto format_real(double _d) -> std::string
+        {
+            auto s = fmt::format("{}", _d);
+            if (s.find_first_of(".eEn") == std::string::npos) {
+                s += ".0";
+            }
+            return s;
+        } // format_real
+
+        struct aggregate
+        {
+            explicit aggregate(std::string _function)
+                : function{std::move(_function)}
+            {
+            }
+
+            std::string function;
+            std::size_t count = 0;
+            bool integral = true;
+            std::int64_t integer_sum = 0;
+            double sum = 0;
+            std::optional<std::string> extreme; // MIN or MAX
+        };
+
+        // Like the database, aggregates skip null values, which are stored as empty strings.
+        auto accumulate(aggregate& _a, column_type _t, std::string_view _v) -> void
+        {
+            if (_v.empty()) {
+                return;
+            }
+
+            ++_a.count;
+
+            if ("SUM" == _a.function || "AVG" == _a.function) {
+                const auto n = parse_number(_v);
+                const auto x = n ? *n : number{true, 0, 0};
+                _a.integral = _a.integral && x.integral;
+                _a.integer_sum += x.i;
+                _a.sum += x.d;
+            }
+            else if ("MIN" == _a.function || "MAX" == _a.function) {
+                const auto c = _a.extreme ? compare(_t, _v, *_a.extreme) : 0;
+                if (!_a.extreme || ("MIN" == _a.function ? c < 0 : c > 0)) {
+                    _a.extreme = std::string{_v};
+                }
+            }
+        } // accumulate
+
+        auto result_of(const aggregate& _a) -> std::string
+        {
+            if ("COUNT" == _a.function) {
+                return std::to_string(_a.count);
+            }
+
+            if (0 == _a.count) {
+                return {};
+            }
+
+            if ("SUM" == _a.function) {
+                return _a.integral ? std::to_string(_a.integer_sum) : format_real(_a.sum);
+            }
+
+            if ("AVG" == _a.function) {
+                return format_real(_a.sum / static_cast<double>(_a.count));
+            }
+
+            return *_a.extreme;
+        } // result_of
+    } // anonymous namespace
+
+    auto evaluator::project(const Select& _s) -> row_set
+    {
+        row_set out;
+
+        std::vector<bound_column> selected;
+        std::vector<std::string> functions; // Empty for plain columns.
+        bool has_aggregate = false;
+
+        for (auto&& selection : _s.selections) {
+            if (const auto* c = boost::get<Column>(&selection); c) {
+                selected.push_back(bind(*c));
+                functions.emplace_back();
+                out.columns.push_back(c->name);
+            }
+            else {
+                const auto& f = boost::get<SelectFunction>(selection);
+                selected.push_back(bind(f.column));
+                functions.push_back(to_upper(f.name));
+                out.columns.push_back(fmt::format("{}({})", functions.back(), f.column.name));
+                has_aggregate = true;
+            }
+        }
+
+        std::vector<bound_column> sort_columns;
+        for (auto&& e : _s.order_by) {
+            sort_columns.push_back(bind(e.column));
+        }
+
+        // Output rows with their sort keys.
+        std::vector<std::pair<std::vector<std::string>, std::vector<std::string>>> rows;
+
+        const auto sort_key = [&](std::size_t _row) {
+            std::vector<std::string> key;
+            for (auto&& c : sort_columns) {
+                key.emplace_back(value(c, _row));
+            }
+            return key;
+        };
+
+        if (has_aggregate) {
+            // Plain columns form the group key, unless GROUP BY says otherwise.
+            std::vector<bound_column> group_columns;
+            if (_s.group_by.empty()) {
+                for (std::size_t i = 0; i < selected.size(); ++i) {
+                    if (functions[i].empty()) {
+                        group_columns.push_back(selected[i]);
+                    }
+                }
+            }
+            else {
+                for (auto&& c : _s.group_by) {
+                    group_columns.push_back(bind(c));
+                }
+            }
+
+            struct group
+            {
+                std::size_t first_row;
+                std::vector<aggregate> aggregates;
+            };
+
+            std::map<std::vector<std::uint32_t>, group> groups;
+
+            for (std::size_t r = 0; r < _rows; ++r) {
+                std::vector<std::uint32_t> key;
+                for (auto&& c : group_columns) {
+                    key.push_back(c.data->code(_joined[c.table][r]));
+                }
+
+                auto [g, inserted] = groups.try_emplace(std::move(key));
+                if (inserted) {
+                    g->second.first_row = r;
+                    for (auto&& f : functions) {
+                        g->second.aggregates.emplace_back(f);
+                    }
+                }
+
+                for (std::size_t i = 0; i < selected.size(); ++i) {
+                    if (!functions[i].empty()) {
+                        accumulate(g->second.aggregates[i], selected[i].data->type(), value(selected[i], r));
+                    }
+                }
+            }
+
+            // Without a GROUP BY, aggregates over no rows still produce a row.
+            if (groups.empty() && group_columns.empty()) {
+                std::vector<std::string> row;
+                for (auto&& f : functions) {
+                    row.push_back(result_of(aggregate{f}));
+                }
+                rows.emplace_back(std::move(row), std::vector<std::string>(sort_columns.size()));
+            }
+
+            for (auto&& [key, g] : groups) {
+                std::vector<std::string> row;
+                for (std::size_t i = 0; i < selected.size(); ++i) {
+                    row.push_back(functions[i].empty() ? std::string{value(selected[i], g.first_row)}
+                                                       : result_of(g.aggregates[i]));
+                }
+                rows.emplace_back(std::move(row), sort_key(g.first_row));
+            }
+        }
+        else {
+            rows.reserve(_rows);
+
+            for (std::size_t r = 0; r < _rows; ++r) {
+                std::vector<std::string> row;
+                for (auto&& c : selected) {
+                    row.emplace_back(value(c, r));
+                }
+                rows.emplace_back(std::move(row), sort_key(r));
+            }
+        }
+
+        if (!_s.no_distinct) {
+            std::unordered_set<std::string> seen;
+            std::string key;
+
+            const auto end = std::remove_if(std::begin(rows), std::end(rows), [&](auto& _r) {
+                key.clear();
+                for (auto&& v : _r.first) {
+                    key += v;
+                    key += '\0';
+                }
+                return !seen.insert(key).second;
+            });
+
+            rows.erase(end, std::end(rows));
+        }
+
+        if (!_s.order_by.empty()) {
+            std::stable_sort(std::begin(rows), std::end(rows), [&](auto& _a, auto& _b) {
+                for (std::size_t i = 0; i < sort_columns.size(); ++i) {
+                    const auto c = compare(sort_columns[i].data->type(), _a.second[i], _b.second[i]);
+                    if (c != 0) {
+                        return _s.order_by[i].ascending_order ? c < 0 : c > 0;
+                    }
+                }
+                return false;
+            });
+        }
+
+        out.rows.reserve(rows.size());
+        for (auto&& r : rows) {
+            out.rows.push_back(std::move(r.first));
+        }
+
+        return out;
+    } // evaluator::project
+
+    dictionary_column::dictionary_column(column_type _type, std::vector<std::string> _dictionary, std::vector<std::uint32_t> _codes)
+        : _type{_type}
+        , _dictionary{std::move(_dictionary)}
+        , _codes{std::move(_codes)}
+        , _paths{std::make_shared<lazy_paths>()}
+    {
+        // Numbers sort first, so the integers are a prefix of the dictionary.
+        if (column_type::integer == _type) {
+            for (auto&& v : this->_dictionary) {
+                const auto n = parse_number(v);
+                if (!n || !n->integral) {
+                    break;
+                }
+                _integers.push_back(n->i);
+            }
+        }
+    }
+
+    struct dictionary_column::lazy_paths
+    {
+        std::once_flag built;
+        path_index index;
+    };
+
+    const path_index& dictionary_column::paths() const
+    {
+        std::call_once(_paths->built, [this] {
+            for (std::size_t i = 0; i < _dictionary.size(); ++i) {
+                _paths->index.insert(_dictionary[i], static_cast<std::int64_t>(i));
+            }
+        });
+
+        return _paths->index;
+    } // paths
+
+    std::optional<std::uint32_t> dictionary_column::find(std::string_view _value) const
+    {
+        const auto i = std::lower_bound(std::begin(_dictionary), std::end(_dictionary), _value, [this](const std::string& _a, std::string_view _b) {
+            return value_less(_type, _a, _b);
+        });
+
+        if (std::end(_dictionary) == i || *i != _value) {
+            return std::nullopt;
+        }
+
+        return static_cast<std::uint32_t>(i - std::begin(_dictionary));
+    } // find
+
+    const columnar_table* catalog_snapshot::table(std::string_view _name) const
+    {
+        const auto i = _tables.find(_name);
+        return std::end(_tables) == i ? nullptr : &i->second;
+    } // table
+
+    void catalog_snapshot_builder::add_table(std::string _name, std::vector<column_spec> _columns)
+    {
+        pending_table t;
+        for (auto&& c : _columns) {
+            t.columns.push_back({std::move(c), {}, {}, {}});
+        }
+
+        _tables.insert_or_assign(std::move(_name), std::move(t));
+    } // add_table
+
+    void catalog_snapshot_builder::add_row(std::string_view _table, const std::vector<std::string_view>& _values)
+    {
+        const auto i = _tables.find(_table);
+
+        if (std::end(_tables) == i) {
+            throw std::invalid_argument{fmt::format("snapshot: unknown table [{}]", _table)};
+        }
+
+        auto& t = i->second;
+
+        if (_values.size() != t.columns.size()) {
+            throw std::invalid_argument{fmt::format("snapshot: table [{}] has {} columns", _table, t.columns.size())};
+        }
+
+        for (std::size_t c = 0; c < _values.size(); ++c) {
+            auto& column = t.columns[c];
+            auto code = column.index.find(_values[c]);
+
+            if (std::end(column.index) == code) {
+                const std::string_view stored = column.values.emplace_back(_values[c]);
+                code = column.index.emplace(stored, static_cast<std::uint32_t>(column.values.size() - 1)).first;
+            }
+
+            column.codes.push_back(code->second);
+        }
+
+        ++t.rows;
+    } // add_row
+
+    std::shared_ptr<const catalog_snapshot> catalog_snapshot_builder::build()
+    {
+        auto snapshot = std::make_shared<catalog_snapshot>();
+
+        for (auto&& [name, t] : _tables) {
+            columnar_table table;
+            table.rows = t.rows;
+
+            for (auto&& c : t.columns) {
+                const auto type = c.spec.type;
+
+                // Sorts the dictionary, so that codes compare like values.
+                std::vector<std::uint32_t> order(c.values.size());
+                std::iota(std::begin(order), std::end(order), 0);
+                std::sort(std::begin(order), std::end(order), [&c, type](auto _a, auto _b) {
+                    return value_less(type, c.values[_a], c.values[_b]);
+                });
+
+                std::vector<std::string> dictionary;
+                std::vector<std::uint32_t> recode(order.size());
+                dictionary.reserve(order.size());
+
+                for (std::uint32_t i = 0; i < order.size(); ++i) {
+                    recode[order[i]] = i;
+                    dictionary.push_back(std::move(c.values[order[i]]));
+                }
+
+                for (auto& code : c.codes) {
+                    code = recode[code];
+                }
+
+                table.columns.emplace(c.spec.name, dictionary_column{type, std::move(dictionary), std::move(c.codes)});
+            }
+
+            snapshot->_tables.emplace(name, std::move(table));
+        }
+
+        _tables.clear();
+
+        return snapshot;
+    } // build
+
+    result<row_set> evaluate(const Select& _s, const catalog_snapshot& _snapshot, const evaluation_options& _opts)
+    {
+        // Validation and evaluation see the same schema.
+        const schema_snapshot snapshot;
+
+        if (auto d = validate(_s, _opts.limits); d) {
+            return std::move(*d);
+        }
+
+        try {
+            evaluator e{snapshot.get(), _snapshot, _opts};
+            return e.run(_s);
+        }
+        catch (const too_many_rows&) {
+            return limit_exceeded("number of joined rows", _opts.max_rows);
+        }
+        catch (const std::bad_alloc&) {
+            throw;
+        }
+        catch (const std::exception& e) {
+            return diagnostic{error_code::internal, 0, 0, {}, e.what()};
+        }
+    } // evaluate
+} // namespace irods::experimental::api::genquery
@@ -0,0 +1,141 @@
+#ifndef IRODS_GENQUERY_COLUMNAR_HPP
+#define IRODS_GENQUERY_COLUMNAR_HPP
+
+#include "genquery_ast_types.hpp"
+#include "genquery_diagnostic.hpp"
+#include "genquery_kernels.hpp"
+#include "genquery_limits.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    // A column stored as codes into a sorted dictionary of its distinct values, so
+    // the codes of a column compare like its values.
+    class dictionary_column
+    {
+    public:
+        dictionary_column(column_type, std::vector<std::string> dictionary, std::vector<std::uint32_t> codes);
+
+        column_type type() const noexcept { return _type; }
+        std::size_t size() const noexcept { return _codes.size(); }
+
+        std::uint32_t code(std::size_t row) const noexcept { return _codes[row]; }
+        std::string_view value(std::size_t row) const noexcept { return _dictionary[_codes[row]]; }
+
+        const std::vector<std::string>& dictionary() const noexcept { return _dictionary; }
+        const std::vector<std::uint32_t>& codes() const noexcept { return _codes; }
+
+        // For integer columns, the leading values of the dictionary which are integers.
+        const std::vector<std::int64_t>& integers() const noexcept { return _integers; }
+
+        // The code of a value, if any row has it.
+        std::optional<std::uint32_t> find(std::string_view) const;
+
+        // The values as paths, with their codes as ids. Built on first use.
+        const path_index& paths() const;
+
+    private:
+        struct lazy_paths;
+
+        column_type _type;
+        std::vector<std::string> _dictionary;
+        std::vector<std::uint32_t> _codes;
+        std::vector<std::int64_t> _integers;
+        std::shared_ptr<lazy_paths> _paths;
+    };
+
+    struct columnar_table
+    {
+        std::size_t rows = 0;
+        std::map<std::string, dictionary_column, std::less<>> columns;
+    };
+
+    // An immutable copy of the catalog tables, by physical table name (e.g.
+    // R_META_MAIN), which queries are evaluated against without a database.
+    class catalog_snapshot
+    {
+    public:
+        const columnar_table* table(std::string_view name) const;
+
+        const std::map<std::string, columnar_table, std::less<>>& tables() const noexcept { return _tables; }
+
+    private:
+        friend class catalog_snapshot_builder;
+
+        std::map<std::string, columnar_table, std::less<>> _tables;
+    };
+
+    class catalog_snapshot_builder
+    {
+    public:
+        struct column_spec
+        {
+            std::string name;
+            column_type type = column_type::text;
+        };
+
+        // Declares a table. The values passed to add_row() are in the order of "columns".
+        void add_table(std::string name, std::vector<column_spec> columns);
+
+        // Null values are passed as empty strings.
+        void add_row(std::string_view table, const std::vector<std::string_view>& values);
+
+        std::shared_ptr<const catalog_snapshot> build();
+
+    private:
+        struct pending_column
+        {
+            column_spec spec;
+            std::deque<std::string> values; // Stable storage for the keys of "index".
+            std::unordered_map<std::string_view, std::uint32_t> index;
+            std::vector<std::uint32_t> codes;
+        };
+
+        struct pending_table
+        {
+            std::size_t rows = 0;
+            std::vector<pending_column> columns;
+        };
+
+        std::map<std::string, pending_table, std::less<>> _tables;
+    };
+
+    struct row_set
+    {
+        // The selections, e.g. "DATA_NAME" or "COUNT(DATA_ID)".
+        std::vector<std::string> columns;
+
+        // Null values (e.g. the SUM of no rows) are empty strings.
+        std::vector<std::vector<std::string>> rows;
+    };
+
+    struct evaluation_options
+    {
+        query_limits limits;
+
+        // Bounds the rows produced by the joins, which are materialized.
+        std::size_t max_rows = std::size_t{1} << 24;
+    };
+
+    // Answers a query from a snapshot, with the rows the SQL of translate() returns.
+    //
+    // Columns resolve through the active schema, the tables of the query are joined
+    // with hash joins on the keys of its link clauses, and each AVU group (see
+    // avu_strategy) restricts the object table to the objects which have a matching
+    // AVU, as with avu_strategy::exists. BEGINNING_OF matches a collection and its
+    // descendants and PARENT_OF matches a collection and its ancestors. Rows are
+    // unordered unless the query has an ORDER BY clause.
+    result<row_set> evaluate(const Select&, const catalog_snapshot&, const evaluation_options& = {});
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_COLUMNAR_HPP
@@ -0,0 +1,140 @@
+#include "genquery_cost.hpp"
+
+#include "genquery_schema.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        constexpr std::string_view meta_table = "R_META_MAIN";
+
+        // The table a table definition refers to, e.g. R_META_MAIN for
+        // "R_META_MAIN r_data_meta_main".
+        auto physical_table(const schema& _s, std::string_view _table) -> std::string_view
+        {
+            const auto t = _s.table(_table);
+
+            if (!t) {
+                return _table;
+            }
+
+            return t->alias.substr(0, t->alias.find(' '));
+        } // physical_table
+
+        auto lookup(const cost_model& _m, std::string_view _table) -> double
+        {
+            return std::log2(2 + _m.rows(_table));
+        } // lookup
+
+        auto is_leading_wildcard(const std::string& _literal) -> bool
+        {
+            return !_literal.empty() && ('%' == _literal[0] || '_' == _literal[0]);
+        } // is_leading_wildcard
+    } // anonymous namespace
+
+    auto cost_model::rows(std::string_view table) const -> double
+    {
+        const auto iter = table_rows.find(table);
+        return iter == std::end(table_rows) ? default_table_rows : iter->second;
+    } // cost_model::rows
+
+    void estimate_cost(const Select& _s, const cost_model& _m, cost_estimate& _e)
+    {
+        const schema_snapshot snapshot;
+        const auto& s = snapshot.get();
+
+        _e.joins = _e.tables.empty() ? 0 : static_cast<std::uint32_t>(_e.tables.size() - 1);
+        _e.avu_joins = static_cast<std::uint32_t>(std::count(std::begin(_e.tables), std::end(_e.tables), meta_table));
+        _e.non_sargable = 0;
+        _e.in_list_literals = 0;
+
+        double joined = 0;
+        for (auto&& t : _e.tables) {
+            joined += lookup(_m, t);
+        }
+
+        _e.cost = std::pow(_m.avu_fanout, _e.avu_joins) * joined;
+
+        for (auto&& t : _e.subquery_tables) {
+            _e.cost += lookup(_m, t);
+        }
+
+        // Pairs of expression and whether it is negated.
+        std::vector<std::pair<const ConditionExpression*, bool>> stack;
+
+        for (auto&& c : _s.conditions) {
+            const auto column = s.column(c.column.name);
+            const auto table = column ? physical_table(s, column->table) : std::string_view{};
+
+            stack.emplace_back(&c.expression, false);
+
+            while (!stack.empty()) {
+                const auto [e, negated] = stack.back();
+                stack.pop_back();
+
+                if (const auto* op = boost::get<ConditionOperator_And>(e); op) {
+                    stack.emplace_back(&op->right, negated);
+                    stack.emplace_back(&op->left, negated);
+                    continue;
+                }
+
+                if (const auto* op = boost::get<ConditionOperator_Or>(e); op) {
+                    stack.emplace_back(&op->right, negated);
+                    stack.emplace_back(&op->left, negated);
+                    continue;
+                }
+
+                if (const auto* op = boost::get<ConditionOperator_Not>(e); op) {
+                    stack.emplace_back(&op->expression, true);
+                    continue;
+                }
+
+                if (const auto* in = boost::get<ConditionIn>(e); in && !in->list_of_string_literals.empty()) {
+                    const auto n = in->list_of_string_literals.size();
+                    _e.in_list_literals += static_cast<std::uint32_t>(n);
+                    _e.cost += static_cast<double>(n - 1) * lookup(_m, table);
+                }
+
+                const auto* like = boost::get<ConditionLike>(e);
+
+                if (negated || boost::get<ConditionNotEqual>(e) || (like && is_leading_wildcard(like->string_literal))) {
+                    ++_e.non_sargable;
+                    _e.cost += _m.rows(table);
+                }
+            }
+        }
+    } // estimate_cost
+
+    admission_decision decide_admission(double _cost, const admission_policy& _p)
+    {
+        if (_cost > _p.reject_above) {
+            return admission_decision::reject;
+        }
+
+        if (_cost > _p.downgrade_above) {
+            return admission_decision::downgrade;
+        }
+
+        if (_cost > _p.throttle_above) {
+            return admission_decision::throttle;
+        }
+
+        return admission_decision::accept;
+    } // decide_admission
+
+    const char* to_string(admission_decision _d)
+    {
+        switch (_d) {
+            case admission_decision::accept:    return "accept";
+            case admission_decision::throttle:  return "throttle";
+            case admission_decision::downgrade: return "downgrade";
+            case admission_decision::reject:    return "reject";
+        }
+
+        return "unknown";
+    } // to_string
+} // namespace irods::experimental::api::genquery
@@ -0,0 +1,85 @@
+#ifndef IRODS_GENQUERY_COST_HPP
+#define IRODS_GENQUERY_COST_HPP
+
+#include "genquery_ast_types.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    // Estimates how expensive the SQL of a query is for the database, in relative units
+    // of row visits. The model assumes that every predicate is served by an index, so a
+    // table costs log2(rows) per lookup, except for non-sargable predicates, which scan
+    // their table. Each instance of R_META_MAIN in the FROM clause multiplies the rows
+    // the joins produce by "avu_fanout".
+    //
+    //   cost = avu_fanout ^ avu_joins * sum(lookup(t) for each FROM table t)
+    //        + sum(lookup(t) for each table t of an AVU subquery)
+    //        + sum(rows(t) for each non-sargable predicate on table t)
+    //        + sum((n - 1) * lookup(t) for each IN list of n literals on table t)
+    struct cost_model
+    {
+        // Estimated number of rows of each table, by table name (e.g. R_OBJT_METAMAP).
+        // Tables which are not listed have "default_table_rows" rows.
+        std::map<std::string, double, std::less<>> table_rows;
+        double default_table_rows = 10000;
+
+        // Rows of a join multiplied by each metadata self-join (i.e. AVUs per object).
+        double avu_fanout = 4;
+
+        auto rows(std::string_view table) const -> double;
+    };
+
+    struct cost_estimate
+    {
+        double cost = 0;
+
+        // Filled in by the translation: the table of each entry of the FROM clause, and
+        // the tables of the AVU subqueries (see avu_strategy).
+        std::vector<std::string> tables;
+        std::vector<std::string> subquery_tables;
+
+        std::uint32_t joins = 0;        // Entries of the FROM clause beyond the first.
+        std::uint32_t avu_joins = 0;    // Instances of R_META_MAIN in the FROM clause.
+        std::uint32_t non_sargable = 0; // Leading-wildcard LIKE, != and negated predicates.
+        std::uint32_t in_list_literals = 0;
+    };
+
+    // Computes the counts and the cost of an estimate whose tables are set.
+    void estimate_cost(const Select&, const cost_model&, cost_estimate&);
+
+    // What to do with a query, by estimated cost. Each threshold applies to costs above
+    // it. The defaults admit every query.
+    //
+    //   throttle  the query is admitted, and the caller should run it at a lower
+    //             priority or concurrency.
+    //   downgrade the query is translated again with every AVU group in a subquery,
+    //             which avoids the fan-out of metadata self-joins.
+    //   reject    the query is refused with error_code::too_expensive.
+    enum class admission_decision
+    {
+        accept,
+        throttle,
+        downgrade,
+        reject
+    };
+
+    struct admission_policy
+    {
+        double throttle_above = std::numeric_limits<double>::infinity();
+        double downgrade_above = std::numeric_limits<double>::infinity();
+        double reject_above = std::numeric_limits<double>::infinity();
+    };
+
+    admission_decision decide_admission(double cost, const admission_policy&);
+
+    const char* to_string(admission_decision);
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_COST_HPP
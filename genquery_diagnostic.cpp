@@ -0,0 +1,48 @@
+#include "genquery_diagnostic.hpp"
+
+#include <fmt/format.h>
+
+namespace irods::experimental::api::genquery
+{
+    std::string describe(const diagnostic& _d)
+    {
+        switch (_d.code) {
+            case error_code::none:
+                return {};
+
+            case error_code::unknown_character:
+                return fmt::format("unknown character [{}] at offset {}", _d.identifier, _d.offset);
+
+            case error_code::syntax_error:
+                if (_d.identifier.empty()) {
+                    return fmt::format("{} at offset {}", _d.detail, _d.offset);
+                }
+                return fmt::format("{} at offset {} near [{}]", _d.detail, _d.offset, _d.identifier);
+
+            case error_code::unknown_column:
+                return fmt::format("failed to find column named [{}]", _d.identifier);
+
+            case error_code::unknown_table:
+                return fmt::format("failed to find table [{}] of column [{}]", _d.detail, _d.identifier);
+
+            case error_code::unsupported_function:
+                return fmt::format("unsupported function [{}]", _d.identifier);
+
+            case error_code::empty_selection:
+                return "selections are empty";
+
+            case error_code::limit_exceeded:
+                if (_d.size > 0) {
+                    return fmt::format("{} at offset {}", _d.detail, _d.offset);
+                }
+                break;
+
+            case error_code::too_expensive:
+            case error_code::invalid_grouping:
+            case error_code::internal:
+                break;
+        }
+
+        return _d.detail;
+    } // describe
+} // namespace irods::experimental::api::genquery
@@ -0,0 +1,82 @@
+#ifndef IRODS_GENQUERY_DIAGNOSTIC_HPP
+#define IRODS_GENQUERY_DIAGNOSTIC_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <variant>
+
+namespace irods::experimental::api::genquery
+{
+    // The values are part of the C interface (see genquery_error_kind in genquery.h).
+    enum class error_code : std::uint8_t
+    {
+        none = 0,
+        unknown_character,    // The scanner found a character which starts no token.
+        syntax_error,         // The parser rejected a token.
+        unknown_column,       // A column is not part of the schema.
+        unknown_table,        // A column belongs to a table which is not part of the schema.
+        unsupported_function, // A selection uses a function other than an aggregate function.
+        empty_selection,      // Nothing is selected.
+        internal,             // Translation failed for a reason not covered above.
+        limit_exceeded,       // The query exceeds one of the query_limits.
+        too_expensive,        // The estimated cost of the query exceeds the admission policy.
+        invalid_grouping      // A column is selected or ordered by without being grouped by,
+                              // or ordered by without being selected from a DISTINCT query.
+    };
+
+    // Describes why a query was rejected.
+    //
+    // "offset" and "size" delimit the offending token within the query text. Both are
+    // zero when the location is unknown (e.g. a query which was not parsed from text).
+    // "identifier" is the offending token, column or function name. "detail" holds
+    // additional text, such as the tokens the parser expected.
+    struct diagnostic
+    {
+        error_code code = error_code::none;
+        std::uint32_t offset = 0;
+        std::uint32_t size = 0;
+        std::string identifier;
+        std::string detail;
+    };
+
+    // Returns a message for humans, e.g. "failed to find column named [X]".
+    std::string describe(const diagnostic&);
+
+    // Holds either a value or the diagnostic explaining why there is none.
+    template <typename T>
+    class result
+    {
+    public:
+        result(T _value)
+            : _v{std::in_place_index<0>, std::move(_value)}
+        {
+        }
+
+        result(diagnostic _d)
+            : _v{std::in_place_index<1>, std::move(_d)}
+        {
+        }
+
+        bool has_value() const noexcept { return _v.index() == 0; }
+        explicit operator bool() const noexcept { return has_value(); }
+
+        T& value() & { return std::get<0>(_v); }
+        const T& value() const& { return std::get<0>(_v); }
+        T&& value() && { return std::get<0>(std::move(_v)); }
+
+        T& operator*() & { return value(); }
+        const T& operator*() const& { return value(); }
+        T* operator->() { return &value(); }
+        const T* operator->() const { return &value(); }
+
+        diagnostic& error() & { return std::get<1>(_v); }
+        const diagnostic& error() const& { return std::get<1>(_v); }
+        diagnostic&& error() && { return std::get<1>(std::move(_v)); }
+
+    private:
+        std::variant<T, diagnostic> _v;
+    };
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_DIAGNOSTIC_HPP
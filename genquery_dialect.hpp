@@ -0,0 +1,179 @@
+#ifndef IRODS_GENQUERY_DIALECT_HPP
+#define IRODS_GENQUERY_DIALECT_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+// The SQL dialects the translator emits (see translate<Dialect>()). A dialect is a
+// policy class whose static members spell the constructs which differ between
+// databases, so the translator is specialized for each database at compile time:
+//
+//   name                  the name of the dialect, e.g. for command line options
+//   quote(out, literal)   appends a literal, given with the escaping of the query text
+//                         (i.e. '' for a single quote)
+//   placeholder(out, n)   appends the placeholder of the nth bind value, from 1
+//   array_binds           whether parameterized IN lists are bound as one array, in
+//                         which case any(out, placeholder) appends the comparison with
+//                         it and array(values) returns its bind value
+//   like_escape           the ESCAPE clause of LIKE patterns escaped with '\'
+//   fold(out, operand)    appends an operand of a case-insensitive comparison, in a
+//                         form an expression index can serve
+//   select(out, distinct, ordered_joins)
+//                         appends SELECT [DISTINCT], with a hint to join the tables in
+//                         the order of the FROM clause if "ordered_joins" is set
+//   limit(out, rows)      appends the clause returning at most "rows" rows
+namespace irods::experimental::api::genquery::dialect
+{
+    // The dialect of translate() without a dialect: "?" placeholders and LIMIT, which
+    // SQLite, PostgreSQL (through most drivers) and MySQL accept.
+    struct generic
+    {
+        static constexpr std::string_view name = "generic";
+
+        static void quote(std::string& _out, std::string_view _literal)
+        {
+            _out += '\'';
+            _out += _literal;
+            _out += '\'';
+        }
+
+        static void placeholder(std::string& _out, std::size_t) { _out += '?'; }
+
+        static constexpr bool array_binds = false;
+
+        static constexpr std::string_view like_escape = "ESCAPE '\\'";
+
+        static void fold(std::string& _out, std::string_view _operand)
+        {
+            fmt::format_to(std::back_inserter(_out), "LOWER({})", _operand);
+        }
+
+        static void select(std::string& _out, bool _distinct, bool)
+        {
+            _out += _distinct ? "SELECT DISTINCT " : "SELECT ";
+        }
+
+        static void limit(std::string& _out, std::size_t _rows)
+        {
+            fmt::format_to(std::back_inserter(_out), " LIMIT {}", _rows);
+        }
+    };
+
+    // Numbered placeholders, and IN lists bound as a single text[] value, so a query
+    // has the same text, and prepared statement, for every length of its lists.
+    // PostgreSQL has no join hints (join_collapse_limit = 1 orders the joins instead).
+    struct postgresql : generic
+    {
+        static constexpr std::string_view name = "postgresql";
+
+        static void placeholder(std::string& _out, std::size_t _n)
+        {
+            fmt::format_to(std::back_inserter(_out), "${}", _n);
+        }
+
+        static constexpr bool array_binds = true;
+
+        static void any(std::string& _out, std::string_view _placeholder)
+        {
+            fmt::format_to(std::back_inserter(_out), " = ANY({})", _placeholder);
+        }
+
+        // An array in the text format, e.g. {"a","b \"c\""}.
+        static std::string array(const std::vector<std::string>& _values)
+        {
+            std::string out{"{"};
+
+            for (auto&& v : _values) {
+                out += &v == &_values.front() ? "\"" : ",\"";
+                for (const auto c : v) {
+                    if ('"' == c || '\\' == c) {
+                        out += '\\';
+                    }
+                    out += c;
+                }
+                out += '"';
+            }
+
+            out += '}';
+            return out;
+        }
+    };
+
+    // MySQL reads '\' as an escape character within literals (unless the server runs
+    // with NO_BACKSLASH_ESCAPES), so backslashes are doubled, those of the ESCAPE
+    // clause included. Its default collations compare case-insensitively, so such
+    // comparisons are left as they are and keep using the indexes of the columns.
+    struct mysql : generic
+    {
+        static constexpr std::string_view name = "mysql";
+
+        static void quote(std::string& _out, std::string_view _literal)
+        {
+            _out += '\'';
+            for (const auto c : _literal) {
+                if ('\\' == c) {
+                    _out += '\\';
+                }
+                _out += c;
+            }
+            _out += '\'';
+        }
+
+        static constexpr std::string_view like_escape = "ESCAPE '\\\\'";
+
+        static void fold(std::string& _out, std::string_view _operand) { _out += _operand; }
+
+        static void select(std::string& _out, bool _distinct, bool _ordered_joins)
+        {
+            _out += _distinct ? "SELECT DISTINCT " : "SELECT ";
+            if (_ordered_joins) {
+                _out += "STRAIGHT_JOIN ";
+            }
+        }
+    };
+
+    // Numbered bind variables, FETCH FIRST (12c) instead of LIMIT, and a hint for the
+    // join order.
+    struct oracle : generic
+    {
+        static constexpr std::string_view name = "oracle";
+
+        static void placeholder(std::string& _out, std::size_t _n)
+        {
+            fmt::format_to(std::back_inserter(_out), ":{}", _n);
+        }
+
+        static void fold(std::string& _out, std::string_view _operand)
+        {
+            fmt::format_to(std::back_inserter(_out), "UPPER({})", _operand);
+        }
+
+        // Hints must follow SELECT immediately.
+        static void select(std::string& _out, bool _distinct, bool _ordered_joins)
+        {
+            _out += _ordered_joins ? "SELECT /*+ ORDERED */ " : "SELECT ";
+            if (_distinct) {
+                _out += "DISTINCT ";
+            }
+        }
+
+        static void limit(std::string& _out, std::size_t _rows)
+        {
+            fmt::format_to(std::back_inserter(_out), " FETCH FIRST {} ROWS ONLY", _rows);
+        }
+    };
+
+    // SQLite reads the generic dialect. It joins the tables in the order of the FROM
+    // clause only for CROSS JOIN, which the translator does not emit.
+    struct sqlite : generic
+    {
+        static constexpr std::string_view name = "sqlite";
+    };
+} // namespace irods::experimental::api::genquery::dialect
+
+#endif // IRODS_GENQUERY_DIALECT_HPP
@@ -0,0 +1,153 @@
+#include "genquery_explain.hpp"
+
+#include "genquery_json.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <utility>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        using clock_type = std::chrono::steady_clock;
+
+        auto microseconds_since(clock_type::time_point _start) -> double
+        {
+            return std::chrono::duration<double, std::micro>(clock_type::now() - _start).count();
+        } // microseconds_since
+
+        auto append_strings(std::string& _out, const std::vector<std::string>& _v) -> void
+        {
+            _out += '[';
+            for (auto&& s : _v) {
+                if (&s != &_v.front()) { _out += ", "; }
+                json::append_string(_out, s);
+            }
+            _out += ']';
+        } // append_strings
+    } // anonymous namespace
+
+    result<explanation> explain(const Select& _s, const options& _opts)
+    {
+        explanation e;
+
+        auto o = _opts;
+        o.explain = &e;
+
+        const auto start = clock_type::now();
+        auto t = try_translate(_s, o);
+        const auto total = microseconds_since(start);
+
+        if (!t) {
+            return std::move(t).error();
+        }
+
+        e.phases.push_back({"total", total});
+        e.result = std::move(*t);
+
+        return e;
+    } // explain
+
+    result<explanation> explain(std::string_view _query, const options& _opts)
+    {
+        const auto start = clock_type::now();
+        auto select = wrapper::try_parse(_query, _opts.limits);
+        const auto parse = microseconds_since(start);
+
+        if (!select) {
+            return std::move(select).error();
+        }
+
+        auto e = explain(*select, _opts);
+
+        if (e) {
+            e->phases.insert(std::begin(e->phases), {"parse", parse});
+            e->phases.back().microseconds += parse;
+        }
+
+        return e;
+    } // explain
+
+    std::string to_json(const explanation& _e)
+    {
+        const auto& t = _e.result;
+
+        std::string out = "{\"sql\": ";
+        json::append_string(out, t.sql);
+        out += ", \"bind_values\": ";
+        append_strings(out, t.bind_values);
+
+        out += ", \"columns\": [";
+        for (auto&& c : _e.columns) {
+            if (&c != &_e.columns.front()) { out += ", "; }
+            out += "{\"name\": ";
+            json::append_string(out, c.name);
+            out += ", \"table\": ";
+            json::append_string(out, c.table);
+            out += ", \"column\": ";
+            json::append_string(out, c.column);
+            out += '}';
+        }
+        out += ']';
+
+        out += ", \"tables\": ";
+        append_strings(out, _e.tables);
+        out += fmt::format(", \"avu_strategy\": \"{}\", \"avu_groups\": {}, \"indexed_avu_groups\": {}",
+                           to_string(_e.strategy), _e.avu_groups, _e.indexed_avu_groups);
+
+        out += ", \"visited\": ";
+        append_strings(out, _e.visited);
+
+        out += ", \"links\": [";
+        for (auto&& l : _e.links) {
+            if (&l != &_e.links.front()) { out += ", "; }
+            out += "{\"table1\": ";
+            json::append_string(out, l.table1);
+            out += ", \"table2\": ";
+            json::append_string(out, l.table2);
+            out += ", \"clause\": ";
+            json::append_string(out, l.clause);
+            out += '}';
+        }
+        out += ']';
+
+        out += ", \"from\": ";
+        append_strings(out, _e.from);
+        out += ", \"where\": ";
+        append_strings(out, _e.where);
+
+        out += ", \"phases_us\": {";
+        for (auto&& p : _e.phases) {
+            if (&p != &_e.phases.front()) { out += ", "; }
+            json::append_string(out, p.name);
+            out += fmt::format(": {:.1f}", p.microseconds);
+        }
+        out += '}';
+
+        out += fmt::format(", \"cost\": {{\"estimate\": {:.1f}, \"joins\": {}, \"avu_joins\": {}, \"non_sargable\": {}, "
+                           "\"in_list_literals\": {}, \"admission\": \"{}\"}}}}",
+                           t.cost.cost,
+                           t.cost.joins,
+                           t.cost.avu_joins,
+                           t.cost.non_sargable,
+                           t.cost.in_list_literals,
+                           to_string(t.admission));
+
+        return out;
+    } // to_json
+
+    const char* to_string(avu_strategy _s)
+    {
+        switch (_s) {
+            case avu_strategy::automatic: return "automatic";
+            case avu_strategy::join:      return "join";
+            case avu_strategy::exists:    return "exists";
+            case avu_strategy::intersect: return "intersect";
+        }
+
+        return "unknown";
+    } // to_string
+} // namespace irods::experimental::api::genquery
@@ -0,0 +1,90 @@
+#ifndef IRODS_GENQUERY_EXPLAIN_HPP
+#define IRODS_GENQUERY_EXPLAIN_HPP
+
+#include "genquery_ast_types.hpp"
+#include "genquery_diagnostic.hpp"
+#include "genquery_sql.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    // How a query was translated. Filled in by the translator when options::explain
+    // points to it, so it describes the decisions behind the SQL rather than the SQL.
+    struct explanation
+    {
+        struct resolved_column
+        {
+            std::string name;   // e.g. DATA_NAME
+            std::string table;  // e.g. R_DATA_MAIN
+            std::string column; // e.g. data_name
+        };
+
+        // A link clause added by compute_table_linkage(), from the table being linked
+        // to the table it was linked with.
+        struct link
+        {
+            std::string table1;
+            std::string table2;
+            std::string clause;
+        };
+
+        struct phase
+        {
+            std::string name;
+            double microseconds;
+        };
+
+        std::vector<resolved_column> columns;
+
+        // The tables required by the selections, conditions, GROUP BY and ORDER BY,
+        // before linkage.
+        std::vector<std::string> tables;
+
+        avu_strategy strategy = avu_strategy::join;
+        std::size_t avu_groups = 0;
+
+        // The AVU groups answered with options::metadata instead.
+        std::size_t indexed_avu_groups = 0;
+
+        // The tables visited by compute_table_linkage(), in order, and the links it
+        // chose.
+        std::vector<std::string> visited;
+        std::vector<link> links;
+
+        // The FROM entries and WHERE clauses after annotate_redundant_table_aliases()
+        // numbered the repeated table aliases (e.g. "r_data_meta_main_1").
+        std::vector<std::string> from;
+        std::vector<std::string> where;
+
+        std::vector<phase> phases;
+
+        translation result;
+    };
+
+    // Translates a query like try_translate(), and records how. The translation cache
+    // is not used, since a cached translation has no planner decisions to report.
+    result<explanation> explain(const Select&, const options&);
+
+    // Also records the time spent parsing the query.
+    result<explanation> explain(std::string_view query, const options&);
+
+    // Returns the explanation as a JSON object:
+    //
+    //   {"sql": "...", "bind_values": [...],
+    //    "columns": [{"name": "DATA_NAME", "table": "R_DATA_MAIN", "column": "data_name"}, ...],
+    //    "tables": [...], "avu_strategy": "join", "avu_groups": 0,
+    //    "indexed_avu_groups": 0,
+    //    "visited": [...], "links": [{"table1": "...", "table2": "...", "clause": "..."}, ...],
+    //    "from": [...], "where": [...],
+    //    "phases_us": {"parse": 4.1, "selections": 2.0, ...},
+    //    "cost": {"estimate": 26.6, "joins": 1, "avu_joins": 0, "non_sargable": 0,
+    //             "in_list_literals": 0, "admission": "accept"}}
+    std::string to_json(const explanation&);
+
+    const char* to_string(avu_strategy);
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_EXPLAIN_HPP
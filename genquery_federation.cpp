@@ -0,0 +1,672 @@
+#include "genquery_federation.hpp"
+
+#include "genquery_normalize.hpp"
+#include "genquery_schema.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string_view>
+#include <thread>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        auto starts_with(std::string_view _s, std::string_view _prefix) -> bool
+        {
+            return _s.substr(0, _prefix.size()) == _prefix;
+        } // starts_with
+
+        // Holds if "_path" is "_root" or a path below it (as within() of genquery_sql.cpp).
+        auto within(std::string_view _path, std::string_view _root) -> bool
+        {
+            if (_path == _root) {
+                return true;
+            }
+
+            return !_root.empty() && starts_with(_path, _root) && ('/' == _root.back() || '/' == _path[_root.size()]);
+        } // within
+
+        // Whether some collection of the shard, i.e. one of "_roots" or a collection below
+        // it, starts with "_prefix".
+        auto below_prefix(const std::vector<std::string>& _roots, std::string_view _prefix) -> bool
+        {
+            return std::any_of(std::begin(_roots), std::end(_roots), [_prefix](std::string_view _r) {
+                return starts_with(_r, _prefix) || within(_prefix, _r);
+            });
+        } // below_prefix
+
+        auto below_any(const std::vector<std::string>& _roots, std::string_view _path) -> bool
+        {
+            return std::any_of(std::begin(_roots), std::end(_roots), [_path](std::string_view _r) {
+                return within(_path, _r);
+            });
+        } // below_any
+
+        // Whether a condition on COLL_NAME may hold for a collection of the shard. Only
+        // conditions which rule out all of them return false.
+        auto may_hold(const ConditionExpression& _e, const std::vector<std::string>& _roots) -> bool
+        {
+            if (const auto* x = boost::get<ConditionEqual>(&_e); x) {
+                return below_any(_roots, unescape_literal(x->string_literal));
+            }
+
+            if (const auto* x = boost::get<ConditionIn>(&_e); x) {
+                return std::any_of(std::begin(x->list_of_string_literals), std::end(x->list_of_string_literals), [&_roots](auto&& _l) {
+                    return below_any(_roots, unescape_literal(_l));
+                });
+            }
+
+            if (const auto* x = boost::get<ConditionLike>(&_e); x) {
+                // The text before the first wildcard, which every match starts with.
+                const auto pattern = unescape_literal(x->string_literal);
+                std::string prefix;
+
+                for (std::size_t i = 0; i < pattern.size(); ++i) {
+                    if ('%' == pattern[i] || '_' == pattern[i]) {
+                        return below_prefix(_roots, prefix);
+                    }
+
+                    if ('\\' == pattern[i] && i + 1 < pattern.size()) {
+                        ++i;
+                    }
+
+                    prefix += pattern[i];
+                }
+
+                return below_any(_roots, prefix);
+            }
+
+            if (const auto* x = boost::get<ConditionBeginningOf>(&_e); x) {
+                const auto path = unescape_literal(x->string_literal);
+                return std::any_of(std::begin(_roots), std::end(_roots), [&path](std::string_view _r) {
+                    return within(path, _r) || within(_r, path);
+                });
+            }
+
+            if (const auto* x = boost::get<ConditionParentOf>(&_e); x) {
+                // The collections above one which is not in the shard are not in it either.
+                return below_any(_roots, unescape_literal(x->string_literal));
+            }
+
+            if (const auto* x = boost::get<ConditionOperator_And>(&_e); x) {
+                return may_hold(x->left, _roots) && may_hold(x->right, _roots);
+            }
+
+            if (const auto* x = boost::get<ConditionOperator_Or>(&_e); x) {
+                return may_hold(x->left, _roots) || may_hold(x->right, _roots);
+            }
+
+            return true;
+        } // may_hold
+
+        auto targets(const Select& _select, const shard& _shard, const options& _opts) -> bool
+        {
+            if (_opts.case_insensitive) {
+                return true;
+            }
+
+            const std::vector<std::string> zone{_shard.zone};
+            const std::vector<std::string> default_collections{"/" + _shard.zone};
+            const auto& collections = _shard.collections.empty() ? default_collections : _shard.collections;
+
+            for (auto&& c : _select.conditions) {
+                if ("ZONE_NAME" == c.column.name) {
+                    if (0 == select(c.expression, value_column{column_type::text, &zone}).count()) {
+                        return false;
+                    }
+                }
+                else if ("COLL_NAME" == c.column.name && !may_hold(c.expression, collections)) {
+                    return false;
+                }
+            }
+
+            return true;
+        } // targets
+
+        auto to_upper(std::string _s) -> std::string
+        {
+            std::transform(std::begin(_s), std::end(_s), std::begin(_s), [](unsigned char _c) {
+                return std::toupper(_c);
+            });
+
+            return _s;
+        } // to_upper
+
+        auto merge_function_of(const SelectFunction& _f) -> std::optional<merge_function>
+        {
+            const auto name = to_upper(_f.name);
+
+            // clang-format off
+            if ("COUNT" == name) { return merge_function::count; }
+            if ("SUM" == name)   { return merge_function::sum; }
+            if ("MIN" == name)   { return merge_function::min; }
+            if ("MAX" == name)   { return merge_function::max; }
+            if ("AVG" == name)   { return merge_function::avg; }
+            // clang-format on
+
+            // Rejected by the translation.
+            return std::nullopt;
+        } // merge_function_of
+
+        auto cannot_merge(std::string _detail) -> diagnostic
+        {
+            diagnostic d;
+            d.code = error_code::internal;
+            d.detail = std::move(_detail);
+            return d;
+        } // cannot_merge
+
+        // The position of the plain selection of "_name", if any.
+        auto position_of(const Selections& _s, std::string_view _name) -> std::optional<std::size_t>
+        {
+            for (std::size_t i = 0; i < _s.size(); ++i) {
+                if (const auto* c = boost::get<Column>(&_s[i]); c && c->name == _name) {
+                    return i;
+                }
+            }
+
+            return std::nullopt;
+        } // position_of
+
+        auto type_of(const schema& _schema, const federation_options& _opts, std::string_view _column) -> column_type
+        {
+            if (const auto iter = _opts.column_types.find(_column); iter != std::end(_opts.column_types)) {
+                return iter->second;
+            }
+
+            const auto c = _schema.column(_column);
+            return c ? c->type : column_type::text;
+        } // type_of
+
+        // Orders rows by the sort keys of a query.
+        struct row_order
+        {
+            const std::vector<federated_query::sort_key>* keys;
+
+            auto operator()(const row& _a, const row& _b) const -> bool
+            {
+                for (auto&& k : *keys) {
+                    if (const auto c = compare(k.type, _a[k.position], _b[k.position]); 0 != c) {
+                        return k.ascending ? c < 0 : c > 0;
+                    }
+                }
+
+                return false;
+            }
+        };
+
+        // A sum of the values of a column, exact while they are all integers.
+        struct sum
+        {
+            bool any = false;
+            bool integral = true;
+            std::int64_t i = 0;
+            double d = 0;
+
+            auto add(std::string_view _value) -> void
+            {
+                // Null values (the SUM of no rows) are empty.
+                const auto n = parse_number(_value);
+                if (!n) {
+                    return;
+                }
+
+                any = true;
+                integral = integral && n->integral && !__builtin_add_overflow(i, n->i, &i);
+                d += n->d;
+            }
+
+            auto text() const -> std::string
+            {
+                if (!any) {
+                    return {};
+                }
+
+                return integral ? std::to_string(i) : fmt::format("{}", d);
+            }
+        };
+
+        // The rows of the shards with the same group, combined.
+        struct group
+        {
+            row values;
+            std::vector<sum> sums;
+        };
+
+        auto combine(const federated_query& _q, group& _g, row&& _r) -> void
+        {
+            if (_g.values.empty()) {
+                _g.values = std::move(_r);
+                _g.sums.resize(_g.values.size());
+
+                for (std::size_t i = 0; i < _g.values.size(); ++i) {
+                    _g.sums[i].add(_g.values[i]);
+                }
+
+                return;
+            }
+
+            for (std::size_t i = 0; i < _r.size(); ++i) {
+                const auto& m = _q.aggregation[i];
+
+                switch (m.function) {
+                    case merge_function::group:
+                        break;
+
+                    case merge_function::count:
+                    case merge_function::sum:
+                    case merge_function::avg:
+                        _g.sums[i].add(_r[i]);
+                        break;
+
+                    case merge_function::min:
+                    case merge_function::max:
+                        if (_r[i].empty()) {
+                            break;
+                        }
+
+                        if (const auto c = compare(m.type, _r[i], _g.values[i]);
+                            _g.values[i].empty() || (merge_function::min == m.function ? c < 0 : c > 0))
+                        {
+                            _g.values[i] = std::move(_r[i]);
+                        }
+                        break;
+                }
+            }
+        } // combine
+
+        auto finish(const federated_query& _q, group& _g) -> row
+        {
+            for (std::size_t i = 0; i < _g.values.size(); ++i) {
+                const auto& m = _q.aggregation[i];
+
+                if (merge_function::count == m.function || merge_function::sum == m.function) {
+                    _g.values[i] = merge_function::count == m.function && !_g.sums[i].any ? "0" : _g.sums[i].text();
+                }
+                else if (merge_function::avg == m.function) {
+                    const auto& s = _g.sums[i];
+                    const auto& n = _g.sums[m.count_position];
+                    _g.values[i] = s.any && n.any && n.d > 0 ? fmt::format("{}", s.d / n.d) : std::string{};
+                }
+            }
+
+            return std::move(_g.values);
+        } // finish
+
+        // The rows of the statements on their way to the merge. The statements wait for
+        // the merge when their buffer is full, and the merge for the statements when the
+        // buffer it needs is empty.
+        class exchange
+        {
+        public:
+            exchange(std::size_t _statements, std::size_t _buffered_rows)
+                : _streams(_statements)
+                , _buffered_rows{std::max<std::size_t>(1, _buffered_rows)}
+            {
+            }
+
+            // Called by statement "_i". Returns false once the merge needs no more rows.
+            auto push(std::size_t _i, row&& _r) -> bool
+            {
+                std::unique_lock lock{_mutex};
+                _space.wait(lock, [&] { return _stop || _streams[_i].rows.size() < _buffered_rows; });
+
+                if (_stop) {
+                    return false;
+                }
+
+                _streams[_i].rows.push_back(std::move(_r));
+                _ready.notify_all();
+
+                return true;
+            }
+
+            auto done(std::size_t _i, std::exception_ptr _error) -> void
+            {
+                std::lock_guard lock{_mutex};
+
+                _streams[_i].done = true;
+
+                if (_error && !_error_of_statement) {
+                    _error_of_statement = std::move(_error);
+                    _stop = true;
+                    _space.notify_all();
+                }
+
+                _ready.notify_all();
+            }
+
+            auto stop() -> void
+            {
+                std::lock_guard lock{_mutex};
+                _stop = true;
+                _space.notify_all();
+            }
+
+            // The next row of statement "_i", or nothing if it has no more or a statement
+            // failed.
+            auto pop(std::size_t _i) -> std::optional<row>
+            {
+                std::unique_lock lock{_mutex};
+                _ready.wait(lock, [&] { return _error_of_statement || !_streams[_i].rows.empty() || _streams[_i].done; });
+
+                return take(_i);
+            }
+
+            // The next row of any statement, or nothing if they have no more or a
+            // statement failed.
+            auto pop_any() -> std::optional<row>
+            {
+                std::unique_lock lock{_mutex};
+
+                for (;;) {
+                    if (_error_of_statement) {
+                        return std::nullopt;
+                    }
+
+                    bool all_done = true;
+
+                    for (std::size_t i = 0; i < _streams.size(); ++i) {
+                        if (!_streams[i].rows.empty()) {
+                            return take(i);
+                        }
+
+                        all_done = all_done && _streams[i].done;
+                    }
+
+                    if (all_done) {
+                        return std::nullopt;
+                    }
+
+                    _ready.wait(lock);
+                }
+            }
+
+            auto error() -> std::exception_ptr
+            {
+                std::lock_guard lock{_mutex};
+                return _error_of_statement;
+            }
+
+        private:
+            struct stream
+            {
+                std::deque<row> rows;
+                bool done = false;
+            };
+
+            auto take(std::size_t _i) -> std::optional<row>
+            {
+                if (_error_of_statement || _streams[_i].rows.empty()) {
+                    return std::nullopt;
+                }
+
+                auto r = std::move(_streams[_i].rows.front());
+                _streams[_i].rows.pop_front();
+                _space.notify_all();
+
+                return r;
+            }
+
+            std::mutex _mutex;
+            std::condition_variable _ready;
+            std::condition_variable _space;
+            std::vector<stream> _streams;
+            std::size_t _buffered_rows;
+            bool _stop = false;
+            std::exception_ptr _error_of_statement;
+        };
+    } // anonymous namespace
+
+    result<federated_query> federate(const Select& select, const std::vector<shard>& shards, const federation_options& opts)
+    {
+        const schema_snapshot snapshot;
+
+        federated_query q;
+        q.distinct = !select.no_distinct;
+        q.row_limit = opts.translation.row_limit;
+
+        Select s = select;
+        q.columns = s.selections.size();
+
+        const auto aggregates = std::any_of(std::begin(s.selections), std::end(s.selections), [](auto&& _s) {
+            return nullptr != boost::get<SelectFunction>(&_s);
+        });
+
+        if (aggregates) {
+            q.aggregation.resize(q.columns);
+
+            for (std::size_t i = 0; i < q.columns; ++i) {
+                auto* f = boost::get<SelectFunction>(&s.selections[i]);
+                const auto function = f ? merge_function_of(*f) : std::nullopt;
+
+                if (!function) {
+                    continue;
+                }
+
+                q.aggregation[i] = {*function, type_of(snapshot.get(), opts, f->column.name), 0};
+
+                if (merge_function::avg == *function) {
+                    q.aggregation[i].count_position = s.selections.size();
+                    q.aggregation.push_back({merge_function::count, column_type::integer, 0});
+
+                    auto column = f->column;
+                    f->name = "SUM";
+                    s.selections.emplace_back(SelectFunction{"COUNT", std::move(column)});
+                }
+            }
+
+            // Groups which are not selected still tell the rows of a shard apart.
+            for (auto&& c : s.group_by) {
+                if (!position_of(s.selections, c.name)) {
+                    s.selections.emplace_back(c);
+                    q.aggregation.push_back({merge_function::group, column_type::integer, 0});
+                }
+            }
+        }
+
+        const auto selected = s.selections.size();
+
+        for (auto&& e : s.order_by) {
+            auto position = position_of(s.selections, e.column.name);
+
+            if (!position) {
+                if (aggregates) {
+                    return cannot_merge(fmt::format("cannot merge the shards of a query ordered by [{}], which is neither "
+                                                    "selected nor grouped by",
+                                                    e.column.name));
+                }
+
+                position = s.selections.size();
+                s.selections.emplace_back(e.column);
+            }
+
+            q.order.push_back({*position, e.ascending_order, type_of(snapshot.get(), opts, e.column.name)});
+        }
+
+        auto o = opts.translation;
+
+        // Every shard may contribute to every group, and the columns added for the order
+        // may make the rows of a shard distinct which are not once they are removed.
+        if (aggregates || (q.distinct && s.selections.size() > selected)) {
+            o.row_limit = 0;
+        }
+
+        for (std::size_t i = 0; i < shards.size(); ++i) {
+            if (!targets(select, shards[i], opts.translation)) {
+                continue;
+            }
+
+            auto t = shards[i].translate ? shards[i].translate(s, o) : try_translate(s, o);
+
+            if (!t) {
+                return std::move(t).error();
+            }
+
+            q.statements.push_back({i, std::move(t).value()});
+        }
+
+        return q;
+    } // federate
+
+    std::size_t run_federated(const federated_query& q,
+                              const shard_executor& execute,
+                              const std::function<bool(row)>& sink,
+                              std::size_t buffered_rows)
+    {
+        exchange x{q.statements.size(), buffered_rows};
+        std::vector<std::thread> threads;
+
+        // Stops and waits for the statements, however the merge ends.
+        struct join_on_exit
+        {
+            exchange& x;
+            std::vector<std::thread>& threads;
+
+            ~join_on_exit()
+            {
+                x.stop();
+                for (auto&& t : threads) {
+                    t.join();
+                }
+            }
+        } join_on_exit{x, threads};
+
+        for (std::size_t i = 0; i < q.statements.size(); ++i) {
+            threads.emplace_back([&x, &q, &execute, i] {
+                std::exception_ptr error;
+
+                try {
+                    execute(q.statements[i].shard, q.statements[i].sql, [&x, i](row _r) { return x.push(i, std::move(_r)); });
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+
+                x.done(i, std::move(error));
+            });
+        }
+
+        std::size_t rows = 0;
+        std::set<row> seen;
+
+        // Returns false once no more rows are needed.
+        const auto emit = [&](row&& _r) {
+            _r.resize(q.columns);
+
+            if (q.distinct && !seen.insert(_r).second) {
+                return true;
+            }
+
+            ++rows;
+
+            return sink(std::move(_r)) && (0 == q.row_limit || rows < q.row_limit);
+        };
+
+        if (!q.aggregation.empty()) {
+            std::map<row, group> groups;
+
+            while (auto r = x.pop_any()) {
+                row key;
+
+                for (std::size_t i = 0; i < r->size(); ++i) {
+                    if (merge_function::group == q.aggregation[i].function) {
+                        key.push_back((*r)[i]);
+                    }
+                }
+
+                combine(q, groups[std::move(key)], std::move(*r));
+            }
+
+            if (const auto error = x.error(); error) {
+                std::rethrow_exception(error);
+            }
+
+            std::vector<row> merged;
+            for (auto&& [key, g] : groups) {
+                merged.push_back(finish(q, g));
+            }
+
+            // Aggregates without groups have a row even if no shard has one.
+            if (merged.empty() && std::none_of(std::begin(q.aggregation), std::end(q.aggregation), [](auto&& _m) {
+                    return merge_function::group == _m.function;
+                }))
+            {
+                group g;
+                g.values.resize(q.aggregation.size());
+                g.sums.resize(q.aggregation.size());
+                merged.push_back(finish(q, g));
+            }
+
+            std::stable_sort(std::begin(merged), std::end(merged), row_order{&q.order});
+
+            for (auto&& r : merged) {
+                if (!emit(std::move(r))) {
+                    break;
+                }
+            }
+
+            return rows;
+        }
+
+        if (q.order.empty()) {
+            while (auto r = x.pop_any()) {
+                if (!emit(std::move(*r))) {
+                    break;
+                }
+            }
+        }
+        else {
+            // A k-way merge of the ordered rows of the statements. Ties are taken from the
+            // earlier statement first.
+            std::vector<std::optional<row>> heads(q.statements.size());
+            std::vector<std::size_t> heap;
+
+            const row_order less{&q.order};
+            const auto later = [&](std::size_t _a, std::size_t _b) {
+                return less(*heads[_b], *heads[_a]) || (!less(*heads[_a], *heads[_b]) && _a > _b);
+            };
+
+            for (std::size_t i = 0; i < heads.size(); ++i) {
+                if ((heads[i] = x.pop(i))) {
+                    heap.push_back(i);
+                }
+            }
+
+            std::make_heap(std::begin(heap), std::end(heap), later);
+
+            while (!heap.empty()) {
+                std::pop_heap(std::begin(heap), std::end(heap), later);
+                const auto i = heap.back();
+
+                if (!emit(std::move(*heads[i]))) {
+                    break;
+                }
+
+                if ((heads[i] = x.pop(i))) {
+                    std::push_heap(std::begin(heap), std::end(heap), later);
+                }
+                else {
+                    heap.pop_back();
+                }
+            }
+        }
+
+        if (const auto error = x.error(); error) {
+            std::rethrow_exception(error);
+        }
+
+        return rows;
+    } // run_federated
+} // namespace irods::experimental::api::genquery
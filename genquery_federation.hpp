@@ -0,0 +1,134 @@
+#ifndef IRODS_GENQUERY_FEDERATION_HPP
+#define IRODS_GENQUERY_FEDERATION_HPP
+
+#include "genquery_ast_types.hpp"
+#include "genquery_diagnostic.hpp"
+#include "genquery_kernels.hpp"
+#include "genquery_sql.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    using row = std::vector<std::string>;
+
+    // A catalog database holding part of the catalog, e.g. the catalog of one zone.
+    struct shard
+    {
+        std::string name;
+
+        // The zone of the catalog (ZONE_NAME).
+        std::string zone;
+
+        // The collections of the catalog (COLL_NAME), which hold the collections below
+        // them. "/<zone>" when empty.
+        std::vector<std::string> collections;
+
+        // Translates the queries for the database of the shard, e.g. one of the
+        // try_translate<Dialect>() instances. try_translate() when empty.
+        std::function<result<translation>(const Select&, const options&)> translate;
+    };
+
+    struct federation_options
+    {
+        options translation;
+
+        // How the merge compares the values of a column (e.g. "DATA_SIZE") which orders
+        // the rows or is aggregated by MIN or MAX (see compare()). Unlisted columns have
+        // the type of the schema, and columns unknown to it compare as text.
+        std::map<std::string, column_type, std::less<>> column_types;
+    };
+
+    // How the values of a column from several shards are combined when the query
+    // aggregates. The rows of the shards with the same values in the "group" columns
+    // become one row.
+    enum class merge_function
+    {
+        group,
+        count, // The counts are added up.
+        sum,
+        min,
+        max,
+        avg // The shards return SUM and COUNT of the column instead.
+    };
+
+    // A query split into a statement per shard and the way their rows are merged.
+    struct federated_query
+    {
+        struct statement
+        {
+            // The index of the shard (see federate()).
+            std::size_t shard;
+            translation sql;
+        };
+
+        struct sort_key
+        {
+            std::size_t position;
+            bool ascending;
+            column_type type;
+        };
+
+        struct merged_column
+        {
+            merge_function function = merge_function::group;
+            column_type type = column_type::integer;
+
+            // For merge_function::avg, the position of the COUNT of the column.
+            std::size_t count_position = 0;
+        };
+
+        // The shards the conditions of the query do not rule out, in the order given.
+        std::vector<statement> statements;
+
+        // The rows of the shards hold the selections of the query followed by the
+        // columns only needed by the merge, i.e. the ORDER BY and GROUP BY columns which
+        // are not selected and the counts of AVG. Only the first "columns" are returned.
+        std::size_t columns = 0;
+
+        std::vector<sort_key> order;
+
+        // A column per column of the rows of the shards when the query aggregates, empty
+        // otherwise.
+        std::vector<merged_column> aggregation;
+
+        bool distinct = true;
+
+        // The number of rows returned, unless zero. The statements return at most as many
+        // when that is enough for the merge.
+        std::size_t row_limit = 0;
+    };
+
+    // Splits a query across shards. A shard is skipped when a condition on ZONE_NAME or
+    // COLL_NAME rules out its zone or every one of its collections; conditions which
+    // might hold (e.g. NOT, or comparisons by order, which depend on the collation of
+    // the database) keep it. Nothing is skipped for options::case_insensitive.
+    //
+    // Aggregates are combined across shards (see merge_function). ORDER BY columns of an
+    // aggregating query must be selected or grouped by.
+    result<federated_query> federate(const Select&, const std::vector<shard>&, const federation_options& = {});
+
+    // Runs a statement of a federated query on the database of the shard with the given
+    // index, handing the rows to "sink" in order, until they run out or "sink" returns
+    // false.
+    using shard_executor = std::function<void(std::size_t shard, const translation&, const std::function<bool(row)>& sink)>;
+
+    // Runs the statements of a federated query concurrently, one thread per statement,
+    // and hands the merged rows to "sink" until they run out, "sink" returns false or
+    // the row limit is reached. The remaining statements are then abandoned.
+    //
+    // Ordered rows are merged as they arrive, each statement running at most
+    // "buffered_rows" rows ahead of the merge. Aggregates are combined once every
+    // statement is done. An exception thrown by "execute" is rethrown once every
+    // statement has stopped. Returns the number of rows handed to "sink".
+    std::size_t run_federated(const federated_query&,
+                              const shard_executor& execute,
+                              const std::function<bool(row)>& sink,
+                              std::size_t buffered_rows = 256);
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_FEDERATION_HPP
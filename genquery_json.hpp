@@ -0,0 +1,48 @@
+#ifndef IRODS_GENQUERY_JSON_HPP
+#define IRODS_GENQUERY_JSON_HPP
+
+#include <string>
+#include <string_view>
+
+namespace irods::experimental::api::genquery::json
+{
+    // Appends "_s" as a quoted JSON string. Bytes outside of the ASCII range are copied
+    // as is, so the output is valid JSON as long as the input is valid UTF-8.
+    inline auto append_string(std::string& _out, std::string_view _s) -> void
+    {
+        constexpr char hex[] = "0123456789abcdef";
+
+        _out += '"';
+
+        for (const char c : _s) {
+            switch (c) {
+                case '"':  _out += "\\\""; break;
+                case '\\': _out += "\\\\"; break;
+                case '\n': _out += "\\n";  break;
+                case '\r': _out += "\\r";  break;
+                case '\t': _out += "\\t";  break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        _out += "\\u00";
+                        _out += hex[(c >> 4) & 0xf];
+                        _out += hex[c & 0xf];
+                    }
+                    else {
+                        _out += c;
+                    }
+            }
+        }
+
+        _out += '"';
+    } // append_string
+
+    inline auto quote(std::string_view _s) -> std::string
+    {
+        std::string out;
+        out.reserve(_s.size() + 2);
+        append_string(out, _s);
+        return out;
+    } // quote
+} // namespace irods::experimental::api::genquery::json
+
+#endif // IRODS_GENQUERY_JSON_HPP
@@ -0,0 +1,835 @@
+#include "genquery_kernels.hpp"
+
+#include "genquery_normalize.hpp"
+#include "genquery_path_index.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_set>
+#include <utility>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        // Lists up to this size are matched by comparing with each literal; longer ones
+        // are looked up in a hash set.
+        constexpr std::size_t max_linear_in_list = 16;
+
+        template <typename T>
+        auto sign(T _a, T _b) -> int
+        {
+            return (_b < _a) - (_a < _b);
+        } // sign
+
+        auto satisfies(int _sign, comparison _op) -> bool
+        {
+            switch (_op) {
+                case comparison::equal:            return 0 == _sign;
+                case comparison::not_equal:        return 0 != _sign;
+                case comparison::less:             return _sign < 0;
+                case comparison::less_or_equal:    return _sign <= 0;
+                case comparison::greater:          return _sign > 0;
+                case comparison::greater_or_equal: return _sign >= 0;
+            }
+
+            return false;
+        } // satisfies
+
+        auto popcount(std::uint64_t _w) -> std::size_t
+        {
+            return static_cast<std::size_t>(__builtin_popcountll(_w));
+        } // popcount
+
+        auto lowest_bit(std::uint64_t _w) -> unsigned
+        {
+            return static_cast<unsigned>(__builtin_ctzll(_w));
+        } // lowest_bit
+
+#ifdef __AVX2__
+        auto load(const std::int64_t* _p) -> __m256i
+        {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_p));
+        } // load
+
+        // One bit per lane of a comparison result.
+        auto lanes(__m256i _m) -> std::uint64_t
+        {
+            return static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(_m)));
+        } // lanes
+
+        auto compare_lanes(__m256i _v, comparison _op, __m256i _literal) -> std::uint64_t
+        {
+            switch (_op) {
+                case comparison::equal:            return lanes(_mm256_cmpeq_epi64(_v, _literal));
+                case comparison::not_equal:        return lanes(_mm256_cmpeq_epi64(_v, _literal)) ^ 0xf;
+                case comparison::less:             return lanes(_mm256_cmpgt_epi64(_literal, _v));
+                case comparison::less_or_equal:    return lanes(_mm256_cmpgt_epi64(_v, _literal)) ^ 0xf;
+                case comparison::greater:          return lanes(_mm256_cmpgt_epi64(_v, _literal));
+                case comparison::greater_or_equal: return lanes(_mm256_cmpgt_epi64(_literal, _v)) ^ 0xf;
+            }
+
+            return 0;
+        } // compare_lanes
+
+        // Compares the first and last bytes of the needle at 32 positions at a time and
+        // the rest only where both match.
+        auto contains(std::string_view _haystack, std::string_view _needle) -> bool
+        {
+            if (_needle.size() < 2 || _haystack.size() < _needle.size() + 32) {
+                return _haystack.find(_needle) != std::string_view::npos;
+            }
+
+            const auto first = _mm256_set1_epi8(_needle.front());
+            const auto last = _mm256_set1_epi8(_needle.back());
+            const auto starts = _haystack.size() - _needle.size() + 1;
+
+            std::size_t i = 0;
+            for (; i + 32 <= starts; i += 32) {
+                const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_haystack.data() + i));
+                const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_haystack.data() + i + _needle.size() - 1));
+                auto mask = static_cast<std::uint32_t>(
+                    _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+
+                while (mask != 0) {
+                    const auto p = i + lowest_bit(mask);
+                    if (0 == std::memcmp(_haystack.data() + p + 1, _needle.data() + 1, _needle.size() - 2)) {
+                        return true;
+                    }
+                    mask &= mask - 1;
+                }
+            }
+
+            return _haystack.substr(i).find(_needle) != std::string_view::npos;
+        } // contains
+#else
+        auto contains(std::string_view _haystack, std::string_view _needle) -> bool
+        {
+            return _haystack.find(_needle) != std::string_view::npos;
+        } // contains
+#endif
+
+        auto starts_with(std::string_view _s, std::string_view _prefix) -> bool
+        {
+            return _s.size() >= _prefix.size() && _s.compare(0, _prefix.size(), _prefix) == 0;
+        } // starts_with
+
+        auto ends_with(std::string_view _s, std::string_view _suffix) -> bool
+        {
+            return _s.size() >= _suffix.size() && _s.compare(_s.size() - _suffix.size(), _suffix.size(), _suffix) == 0;
+        } // ends_with
+
+        auto like(std::string_view _value, std::string_view _pattern) -> bool
+        {
+            constexpr auto none = std::string_view::npos;
+
+            std::size_t v = 0;
+            std::size_t p = 0;
+            std::size_t retry_p = none;
+            std::size_t retry_v = 0;
+
+            while (v < _value.size()) {
+                if (p < _pattern.size()) {
+                    if ('%' == _pattern[p]) {
+                        retry_p = ++p;
+                        retry_v = v;
+                        continue;
+                    }
+
+                    const auto escaped = '\\' == _pattern[p] && p + 1 < _pattern.size();
+                    const auto c = _pattern[escaped ? p + 1 : p];
+
+                    if ((!escaped && '_' == c) || c == _value[v]) {
+                        p += escaped ? 2 : 1;
+                        ++v;
+                        continue;
+                    }
+                }
+
+                // Lets the last '%' absorb one more byte.
+                if (none == retry_p) {
+                    return false;
+                }
+
+                p = retry_p;
+                v = ++retry_v;
+            }
+
+            while (p < _pattern.size() && '%' == _pattern[p]) {
+                ++p;
+            }
+
+            return p == _pattern.size();
+        } // like
+
+        template <typename Predicate>
+        auto select_each(const std::vector<std::string>& _values, std::size_t _first, selection& _out, Predicate _p) -> void
+        {
+            for (auto i = _first; i < _values.size(); ++i) {
+                if (_p(std::string_view{_values[i]})) {
+                    _out.set(i);
+                }
+            }
+        } // select_each
+
+        auto set_all(selection& _out, const std::vector<std::int64_t>& _positions) -> void
+        {
+            for (const auto p : _positions) {
+                _out.set(static_cast<std::size_t>(p));
+            }
+        } // set_all
+
+        class leaf_evaluator
+        {
+        public:
+            explicit leaf_evaluator(const value_column& _c)
+                : _c{_c}
+                , _values{*_c.values}
+            {
+            }
+
+            auto operator()(const ConditionExpression& _e) const -> selection
+            {
+                if (const auto* x = boost::get<ConditionEqual>(&_e); x) {
+                    return compared(unescape_literal(x->string_literal), comparison::equal);
+                }
+                if (const auto* x = boost::get<ConditionNotEqual>(&_e); x) {
+                    return compared(unescape_literal(x->string_literal), comparison::not_equal);
+                }
+                if (const auto* x = boost::get<ConditionLessThan>(&_e); x) {
+                    return compared(unescape_literal(x->string_literal), comparison::less);
+                }
+                if (const auto* x = boost::get<ConditionLessThanOrEqualTo>(&_e); x) {
+                    return compared(unescape_literal(x->string_literal), comparison::less_or_equal);
+                }
+                if (const auto* x = boost::get<ConditionGreaterThan>(&_e); x) {
+                    return compared(unescape_literal(x->string_literal), comparison::greater);
+                }
+                if (const auto* x = boost::get<ConditionGreaterThanOrEqualTo>(&_e); x) {
+                    return compared(unescape_literal(x->string_literal), comparison::greater_or_equal);
+                }
+                if (const auto* x = boost::get<ConditionBetween>(&_e); x) {
+                    return between(unescape_literal(x->low), unescape_literal(x->high));
+                }
+                if (const auto* x = boost::get<ConditionIn>(&_e); x) {
+                    std::vector<std::string> literals;
+                    literals.reserve(x->list_of_string_literals.size());
+                    for (auto&& l : x->list_of_string_literals) {
+                        literals.push_back(unescape_literal(l));
+                    }
+                    return in(literals);
+                }
+                if (const auto* x = boost::get<ConditionLike>(&_e); x) {
+                    return matching(like_pattern{unescape_literal(x->string_literal)});
+                }
+
+                selection out{_values.size()};
+
+                if (const auto* x = boost::get<ConditionBeginningOf>(&_e); x) {
+                    const auto root = unescape_literal(x->string_literal);
+                    if (_c.paths) {
+                        set_all(out, _c.paths->beginning_of(root));
+                    }
+                    else {
+                        select_each(_values, 0, out, [&root](std::string_view _v) { return is_within(_v, root); });
+                    }
+                }
+                else if (const auto* x = boost::get<ConditionParentOf>(&_e); x) {
+                    const auto path = unescape_literal(x->string_literal);
+                    if (_c.paths) {
+                        set_all(out, _c.paths->parent_of(path));
+                    }
+                    else {
+                        select_each(_values, 0, out, [&path](std::string_view _v) { return is_within(path, _v); });
+                    }
+                }
+
+                return out;
+            }
+
+        private:
+            // The first value not ordered before the literal, and the first value ordered
+            // after it.
+            auto bounds(std::string_view _literal) const -> std::pair<std::size_t, std::size_t>
+            {
+                const auto b = std::begin(_values);
+                const auto lower = std::partition_point(b, std::end(_values), [&](const std::string& _v) {
+                    return compare(_c.type, _v, _literal) < 0;
+                });
+                const auto upper = std::partition_point(lower, std::end(_values), [&](const std::string& _v) {
+                    return compare(_c.type, _v, _literal) == 0;
+                });
+
+                return {static_cast<std::size_t>(lower - b), static_cast<std::size_t>(upper - b)};
+            }
+
+            // The integer literal, when the integer kernels can compare with it.
+            auto integer_literal(std::string_view _literal) const -> std::optional<std::int64_t>
+            {
+                if (column_type::integer != _c.type || !_c.integers) {
+                    return std::nullopt;
+                }
+
+                if (const auto n = parse_number(_literal); n && n->integral) {
+                    return n->i;
+                }
+
+                return std::nullopt;
+            }
+
+            auto integer_count() const -> std::size_t
+            {
+                return _c.integers ? std::min(_c.integers->size(), _values.size()) : 0;
+            }
+
+            // Extends a selection of the integer prefix of the column over all of it.
+            auto widen(const selection& _prefix) const -> selection
+            {
+                selection out{_values.size()};
+                std::copy(std::begin(_prefix.words()), std::end(_prefix.words()), std::begin(out.words()));
+                return out;
+            }
+
+            auto compared(const std::string& _literal, comparison _op) const -> selection
+            {
+                const auto n = _values.size();
+
+                if (_c.sorted) {
+                    const auto [lower, upper] = bounds(_literal);
+
+                    selection out{n};
+                    switch (_op) {
+                        case comparison::equal:            out.set(lower, upper); break;
+                        case comparison::not_equal:        out.set(0, lower); out.set(upper, n); break;
+                        case comparison::less:             out.set(0, lower); break;
+                        case comparison::less_or_equal:    out.set(0, upper); break;
+                        case comparison::greater:          out.set(upper, n); break;
+                        case comparison::greater_or_equal: out.set(lower, n); break;
+                    }
+                    return out;
+                }
+
+                std::size_t first = 0;
+                selection out{n};
+
+                if (const auto literal = integer_literal(_literal); literal) {
+                    first = integer_count();
+                    out = widen(select_compare(_c.integers->data(), first, _op, *literal));
+                }
+                else if (column_type::text == _c.type && comparison::equal == _op) {
+                    select_each(_values, 0, out, [&_literal](std::string_view _v) { return _v == _literal; });
+                    return out;
+                }
+
+                select_each(_values, first, out, [&](std::string_view _v) { return satisfies(compare(_c.type, _v, _literal), _op); });
+
+                return out;
+            }
+
+            auto between(const std::string& _low, const std::string& _high) const -> selection
+            {
+                const auto n = _values.size();
+
+                if (_c.sorted) {
+                    selection out{n};
+                    const auto lower = bounds(_low).first;
+                    const auto upper = bounds(_high).second;
+                    if (lower < upper) {
+                        out.set(lower, upper);
+                    }
+                    return out;
+                }
+
+                std::size_t first = 0;
+                selection out{n};
+
+                const auto low = integer_literal(_low);
+                const auto high = integer_literal(_high);
+
+                if (low && high) {
+                    first = integer_count();
+                    out = widen(select_between(_c.integers->data(), first, *low, *high));
+                }
+
+                select_each(_values, first, out, [&](std::string_view _v) {
+                    return compare(_c.type, _v, _low) >= 0 && compare(_c.type, _v, _high) <= 0;
+                });
+
+                return out;
+            }
+
+            auto in(const std::vector<std::string>& _literals) const -> selection
+            {
+                const auto n = _values.size();
+
+                if (_c.sorted) {
+                    selection out{n};
+                    for (auto&& l : _literals) {
+                        const auto [lower, upper] = bounds(l);
+                        out.set(lower, upper);
+                    }
+                    return out;
+                }
+
+                if (column_type::text == _c.type) {
+                    return select_in(_values, _literals);
+                }
+
+                std::vector<std::int64_t> integers;
+                for (auto&& l : _literals) {
+                    if (const auto i = integer_literal(l); i) {
+                        integers.push_back(*i);
+                    }
+                }
+
+                std::size_t first = 0;
+                selection out{n};
+
+                if (!integers.empty() && integers.size() == _literals.size()) {
+                    first = integer_count();
+                    out = widen(select_in(_c.integers->data(), first, integers));
+                }
+
+                select_each(_values, first, out, [&](std::string_view _v) {
+                    return std::any_of(std::begin(_literals), std::end(_literals), [&](const std::string& _l) {
+                        return 0 == compare(_c.type, _v, _l);
+                    });
+                });
+
+                return out;
+            }
+
+            auto matching(const like_pattern& _p) const -> selection
+            {
+                if (!_c.sorted || column_type::text != _c.type) {
+                    return select_like(_values, _p);
+                }
+
+                if (like_pattern::kind::exact == _p.shape()) {
+                    return compared(_p.text(), comparison::equal);
+                }
+
+                // The values with a prefix are adjacent in a sorted column.
+                if (like_pattern::kind::prefix == _p.shape()) {
+                    const auto b = std::begin(_values);
+                    const auto lower = std::lower_bound(b, std::end(_values), _p.text());
+                    const auto upper = std::partition_point(lower, std::end(_values), [&_p](const std::string& _v) {
+                        return starts_with(_v, _p.text());
+                    });
+
+                    selection out{_values.size()};
+                    out.set(static_cast<std::size_t>(lower - b), static_cast<std::size_t>(upper - b));
+                    return out;
+                }
+
+                return select_like(_values, _p);
+            }
+
+            const value_column& _c;
+            const std::vector<std::string>& _values;
+        };
+    } // anonymous namespace
+
+    std::optional<number> parse_number(std::string_view _s)
+    {
+        if (_s.empty()) {
+            return std::nullopt;
+        }
+
+        const auto* end = _s.data() + _s.size();
+
+        std::int64_t i{};
+        if (const auto [p, ec] = std::from_chars(_s.data(), end, i); std::errc{} == ec && end == p) {
+            return number{true, i, static_cast<double>(i)};
+        }
+
+        if (std::isspace(static_cast<unsigned char>(_s.front()))) {
+            return std::nullopt;
+        }
+
+        const std::string s{_s};
+        char* p{};
+        const auto d = std::strtod(s.c_str(), &p);
+
+        if (p != s.c_str() + s.size()) {
+            return std::nullopt;
+        }
+
+        return number{false, 0, d};
+    } // parse_number
+
+    int compare(column_type _t, std::string_view _a, std::string_view _b)
+    {
+        if (column_type::integer == _t) {
+            const auto a = parse_number(_a);
+            const auto b = parse_number(_b);
+
+            if (a && b) {
+                return a->integral && b->integral ? sign(a->i, b->i) : sign(a->d, b->d);
+            }
+
+            // Numbers sort before text.
+            if (a || b) {
+                return a ? -1 : 1;
+            }
+        }
+
+        return sign(_a.compare(_b), 0);
+    } // compare
+
+    selection::selection(std::size_t _size, bool _value)
+        : _size{_size}
+        , _words((_size + 63) / 64, _value ? ~std::uint64_t{0} : 0)
+    {
+        trim();
+    }
+
+    std::size_t selection::count() const noexcept
+    {
+        std::size_t n = 0;
+        for (const auto w : _words) {
+            n += popcount(w);
+        }
+        return n;
+    } // count
+
+    void selection::set(std::size_t _first, std::size_t _last) noexcept
+    {
+        if (_first >= _last) {
+            return;
+        }
+
+        const auto mask_from = [](std::size_t _bit) { return ~std::uint64_t{0} << (_bit % 64); };
+
+        const auto first_word = _first / 64;
+        const auto last_word = (_last - 1) / 64;
+        const auto last_mask = ~std::uint64_t{0} >> (63 - (_last - 1) % 64);
+
+        if (first_word == last_word) {
+            _words[first_word] |= mask_from(_first) & last_mask;
+            return;
+        }
+
+        _words[first_word] |= mask_from(_first);
+        std::fill(std::begin(_words) + first_word + 1, std::begin(_words) + last_word, ~std::uint64_t{0});
+        _words[last_word] |= last_mask;
+    } // set
+
+    selection& selection::operator&=(const selection& _other) noexcept
+    {
+        for (std::size_t i = 0; i < _words.size(); ++i) {
+            _words[i] &= _other._words[i];
+        }
+        return *this;
+    } // operator&=
+
+    selection& selection::operator|=(const selection& _other) noexcept
+    {
+        for (std::size_t i = 0; i < _words.size(); ++i) {
+            _words[i] |= _other._words[i];
+        }
+        return *this;
+    } // operator|=
+
+    void selection::flip() noexcept
+    {
+        for (auto& w : _words) {
+            w = ~w;
+        }
+        trim();
+    } // flip
+
+    std::vector<std::uint32_t> selection::positions() const
+    {
+        std::vector<std::uint32_t> p;
+        p.reserve(count());
+
+        for (std::size_t i = 0; i < _words.size(); ++i) {
+            for (auto w = _words[i]; w != 0; w &= w - 1) {
+                p.push_back(static_cast<std::uint32_t>(i * 64 + lowest_bit(w)));
+            }
+        }
+
+        return p;
+    } // positions
+
+    void selection::trim() noexcept
+    {
+        if (const auto tail = _size % 64; tail != 0) {
+            _words.back() &= ~std::uint64_t{0} >> (64 - tail);
+        }
+    } // trim
+
+    like_pattern::like_pattern(std::string_view _pattern)
+        : _kind{kind::general}
+        , _pattern{_pattern}
+    {
+        // Strips the wildcards at either end. The pattern is specialized if what is
+        // left has no wildcards.
+        const auto leading = !_pattern.empty() && '%' == _pattern.front();
+        auto inner = _pattern.substr(leading ? std::min(_pattern.find_first_not_of('%'), _pattern.size()) : 0);
+
+        auto trailing = false;
+        while (!inner.empty() && '%' == inner.back()) {
+            // An escaped '%' is text.
+            std::size_t backslashes = 0;
+            while (backslashes + 1 < inner.size() && '\\' == inner[inner.size() - 2 - backslashes]) {
+                ++backslashes;
+            }
+
+            if (backslashes % 2 != 0) {
+                break;
+            }
+
+            inner.remove_suffix(1);
+            trailing = true;
+        }
+
+        std::string text;
+        for (std::size_t i = 0; i < inner.size(); ++i) {
+            if ('%' == inner[i] || '_' == inner[i]) {
+                return;
+            }
+
+            if ('\\' == inner[i] && i + 1 < inner.size()) {
+                ++i;
+            }
+
+            text += inner[i];
+        }
+
+        _text = std::move(text);
+
+        if (_pattern.empty() || (!leading && !trailing)) {
+            _kind = kind::exact;
+        }
+        else if (leading && trailing) {
+            _kind = kind::contains;
+        }
+        else if (_text.empty()) {
+            // A lone '%' matches everything.
+            _kind = kind::contains;
+        }
+        else {
+            _kind = leading ? kind::suffix : kind::prefix;
+        }
+    } // like_pattern::like_pattern
+
+    bool like_pattern::matches(std::string_view _value) const
+    {
+        switch (_kind) {
+            case kind::exact:    return _value == _text;
+            case kind::prefix:   return starts_with(_value, _text);
+            case kind::suffix:   return ends_with(_value, _text);
+            case kind::contains: return contains(_value, _text);
+            case kind::general:  return like(_value, _pattern);
+        }
+
+        return false;
+    } // like_pattern::matches
+
+    selection select_compare(const std::int64_t* _values, std::size_t _size, comparison _op, std::int64_t _literal)
+    {
+        selection out{_size};
+        std::size_t i = 0;
+
+#ifdef __AVX2__
+        const auto literal = _mm256_set1_epi64x(_literal);
+        for (; i + 4 <= _size; i += 4) {
+            out.words()[i / 64] |= compare_lanes(load(_values + i), _op, literal) << (i % 64);
+        }
+#endif
+
+        for (; i < _size; ++i) {
+            if (satisfies(sign(_values[i], _literal), _op)) {
+                out.set(i);
+            }
+        }
+
+        return out;
+    } // select_compare
+
+    selection select_between(const std::int64_t* _values, std::size_t _size, std::int64_t _low, std::int64_t _high)
+    {
+        selection out{_size};
+        std::size_t i = 0;
+
+#ifdef __AVX2__
+        const auto low = _mm256_set1_epi64x(_low);
+        const auto high = _mm256_set1_epi64x(_high);
+        for (; i + 4 <= _size; i += 4) {
+            const auto v = load(_values + i);
+            const auto outside = _mm256_or_si256(_mm256_cmpgt_epi64(low, v), _mm256_cmpgt_epi64(v, high));
+            out.words()[i / 64] |= (lanes(outside) ^ 0xf) << (i % 64);
+        }
+#endif
+
+        for (; i < _size; ++i) {
+            if (_low <= _values[i] && _values[i] <= _high) {
+                out.set(i);
+            }
+        }
+
+        return out;
+    } // select_between
+
+    selection select_in(const std::int64_t* _values, std::size_t _size, const std::vector<std::int64_t>& _literals)
+    {
+        selection out{_size};
+
+        if (_literals.size() > max_linear_in_list) {
+            const std::unordered_set<std::int64_t> set(std::begin(_literals), std::end(_literals));
+            for (std::size_t i = 0; i < _size; ++i) {
+                if (set.count(_values[i]) > 0) {
+                    out.set(i);
+                }
+            }
+            return out;
+        }
+
+        std::size_t i = 0;
+
+#ifdef __AVX2__
+        __m256i literals[max_linear_in_list];
+        for (std::size_t l = 0; l < _literals.size(); ++l) {
+            literals[l] = _mm256_set1_epi64x(_literals[l]);
+        }
+
+        for (; i + 4 <= _size; i += 4) {
+            const auto v = load(_values + i);
+            auto m = _mm256_setzero_si256();
+            for (std::size_t l = 0; l < _literals.size(); ++l) {
+                m = _mm256_or_si256(m, _mm256_cmpeq_epi64(v, literals[l]));
+            }
+            out.words()[i / 64] |= lanes(m) << (i % 64);
+        }
+#endif
+
+        for (; i < _size; ++i) {
+            if (std::find(std::begin(_literals), std::end(_literals), _values[i]) != std::end(_literals)) {
+                out.set(i);
+            }
+        }
+
+        return out;
+    } // select_in
+
+    selection select_like(const std::vector<std::string>& _values, const like_pattern& _p)
+    {
+        selection out{_values.size()};
+        select_each(_values, 0, out, [&_p](std::string_view _v) { return _p.matches(_v); });
+        return out;
+    } // select_like
+
+    selection select_in(const std::vector<std::string>& _values, const std::vector<std::string>& _literals)
+    {
+        selection out{_values.size()};
+
+        if (_literals.size() > max_linear_in_list) {
+            const std::unordered_set<std::string_view> set(std::begin(_literals), std::end(_literals));
+            select_each(_values, 0, out, [&set](std::string_view _v) { return set.count(_v) > 0; });
+        }
+        else {
+            select_each(_values, 0, out, [&_literals](std::string_view _v) {
+                return std::find(std::begin(_literals), std::end(_literals), _v) != std::end(_literals);
+            });
+        }
+
+        return out;
+    } // select_in
+
+    selection select_codes(const std::vector<std::uint32_t>& _codes, const selection& _codes_selected)
+    {
+        selection out{_codes.size()};
+        std::size_t i = 0;
+
+#ifdef __AVX2__
+        // Gathers the 32-bit half of the bitmap holding each code's bit.
+        const auto* bits = reinterpret_cast<const int*>(_codes_selected.words().data());
+        const auto low_five = _mm256_set1_epi32(31);
+        const auto one = _mm256_set1_epi32(1);
+
+        for (; i + 8 <= _codes.size(); i += 8) {
+            const auto codes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_codes.data() + i));
+            const auto halves = _mm256_i32gather_epi32(bits, _mm256_srli_epi32(codes, 5), 4);
+            const auto bit = _mm256_and_si256(_mm256_srlv_epi32(halves, _mm256_and_si256(codes, low_five)), one);
+            const auto mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(bit, 31)));
+            out.words()[i / 64] |= static_cast<std::uint64_t>(mask) << (i % 64);
+        }
+#endif
+
+        for (; i < _codes.size(); ++i) {
+            if (_codes_selected.test(_codes[i])) {
+                out.set(i);
+            }
+        }
+
+        return out;
+    } // select_codes
+
+    selection select(const ConditionExpression& _e, const value_column& _c)
+    {
+        struct frame
+        {
+            const ConditionExpression* expression;
+            bool operands_done;
+        };
+
+        const leaf_evaluator leaf{_c};
+
+        // The tree is walked with an explicit stack, like the other walkers of condition
+        // trees.
+        std::vector<frame> stack{{&_e, false}};
+        std::vector<selection> values;
+
+        const auto combine = [&values](auto _op) {
+            auto right = std::move(values.back());
+            values.pop_back();
+            _op(values.back(), right);
+        };
+
+        while (!stack.empty()) {
+            const auto f = stack.back();
+            stack.pop_back();
+
+            const auto& e = *f.expression;
+
+            if (const auto* op = boost::get<ConditionOperator_And>(&e); op) {
+                if (f.operands_done) {
+                    combine([](selection& _l, const selection& _r) { _l &= _r; });
+                }
+                else {
+                    stack.insert(std::end(stack), {{&e, true}, {&op->right, false}, {&op->left, false}});
+                }
+            }
+            else if (const auto* op = boost::get<ConditionOperator_Or>(&e); op) {
+                if (f.operands_done) {
+                    combine([](selection& _l, const selection& _r) { _l |= _r; });
+                }
+                else {
+                    stack.insert(std::end(stack), {{&e, true}, {&op->right, false}, {&op->left, false}});
+                }
+            }
+            else if (const auto* op = boost::get<ConditionOperator_Not>(&e); op) {
+                if (f.operands_done) {
+                    values.back().flip();
+                }
+                else {
+                    stack.insert(std::end(stack), {{&e, true}, {&op->expression, false}});
+                }
+            }
+            else {
+                values.push_back(leaf(e));
+            }
+        }
+
+        return std::move(values.back());
+    } // select
+} // namespace irods::experimental::api::genquery
@@ -0,0 +1,147 @@
+#ifndef IRODS_GENQUERY_KERNELS_HPP
+#define IRODS_GENQUERY_KERNELS_HPP
+
+#include "genquery_ast_types.hpp"
+#include "genquery_schema.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    class path_index;
+
+    // A value read as a number, the way the database converts text to numbers.
+    struct number
+    {
+        bool integral;
+        std::int64_t i;
+        double d;
+    };
+
+    std::optional<number> parse_number(std::string_view);
+
+    // Compares a value of a column with a literal (or another value of the column).
+    // Returns a negative number, zero or a positive number.
+    int compare(column_type, std::string_view, std::string_view);
+
+    // A set of positions (e.g. rows, or codes of a dictionary) as a bitmap.
+    class selection
+    {
+    public:
+        explicit selection(std::size_t size = 0, bool value = false);
+
+        std::size_t size() const noexcept { return _size; }
+
+        // The number of positions in the set.
+        std::size_t count() const noexcept;
+
+        bool test(std::size_t i) const noexcept { return (_words[i / 64] >> (i % 64)) & 1; }
+        void set(std::size_t i) noexcept { _words[i / 64] |= std::uint64_t{1} << (i % 64); }
+
+        // Adds the positions [first, last).
+        void set(std::size_t first, std::size_t last) noexcept;
+
+        // Set operations. The operands must have the same size.
+        selection& operator&=(const selection&) noexcept;
+        selection& operator|=(const selection&) noexcept;
+        void flip() noexcept;
+
+        // The positions in the set, in increasing order.
+        std::vector<std::uint32_t> positions() const;
+
+        const std::vector<std::uint64_t>& words() const noexcept { return _words; }
+        std::vector<std::uint64_t>& words() noexcept { return _words; }
+
+    private:
+        // Keeps the bits past the end clear, so that count() and positions() need not
+        // mask the last word.
+        void trim() noexcept;
+
+        std::size_t _size;
+        std::vector<std::uint64_t> _words;
+    };
+
+    enum class comparison
+    {
+        equal,
+        not_equal,
+        less,
+        less_or_equal,
+        greater,
+        greater_or_equal
+    };
+
+    // A LIKE pattern, compiled into the cheapest matcher for its shape: patterns such
+    // as 'abc', 'abc%', '%abc' and '%abc%' are matched with a single comparison or
+    // substring search, others with a general matcher. '%' matches any sequence of
+    // bytes, '_' matches one byte and '\' escapes the next character.
+    class like_pattern
+    {
+    public:
+        enum class kind
+        {
+            exact,
+            prefix,
+            suffix,
+            contains,
+            general
+        };
+
+        explicit like_pattern(std::string_view pattern);
+
+        kind shape() const noexcept { return _kind; }
+
+        // The text matched by the specialized matchers, without wildcards or escapes.
+        const std::string& text() const noexcept { return _text; }
+
+        bool matches(std::string_view) const;
+
+    private:
+        kind _kind;
+        std::string _text; // The pattern without wildcards, for the specialized matchers.
+        std::string _pattern;
+    };
+
+    // Batch kernels. Each returns the positions of the values which satisfy the
+    // predicate. Integer kernels use AVX2 when it is enabled at compile time.
+    selection select_compare(const std::int64_t* values, std::size_t size, comparison, std::int64_t literal);
+    selection select_between(const std::int64_t* values, std::size_t size, std::int64_t low, std::int64_t high);
+    selection select_in(const std::int64_t* values, std::size_t size, const std::vector<std::int64_t>& literals);
+
+    selection select_like(const std::vector<std::string>& values, const like_pattern&);
+    selection select_in(const std::vector<std::string>& values, const std::vector<std::string>& literals);
+
+    // The rows whose code is in "codes_selected", i.e. a condition on the values of a
+    // dictionary-encoded column applied to its rows.
+    selection select_codes(const std::vector<std::uint32_t>& codes, const selection& codes_selected);
+
+    // Values a condition is evaluated against, e.g. the dictionary of a column or a
+    // column of a result set.
+    struct value_column
+    {
+        column_type type = column_type::text;
+        const std::vector<std::string>* values = nullptr;
+
+        // Whether the values are distinct and ordered by compare(), as a dictionary is.
+        // Comparisons on sorted values are answered with binary searches.
+        bool sorted = false;
+
+        // Optional. For integer columns, the leading values which are integers, parsed.
+        // Comparisons with integers use the integer kernels for these values.
+        const std::vector<std::int64_t>* integers = nullptr;
+
+        // Optional. Maps the values to their positions, for BEGINNING_OF and PARENT_OF.
+        const path_index* paths = nullptr;
+    };
+
+    // Evaluates a condition tree against each value of a column. The leaves are
+    // evaluated with the batch kernels and combined with set operations.
+    selection select(const ConditionExpression&, const value_column&);
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_KERNELS_HPP
@@ -0,0 +1,85 @@
+#include "genquery_limits.hpp"
+
+#include <fmt/format.h>
+
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    diagnostic limit_exceeded(const char* what, std::size_t limit)
+    {
+        return {error_code::limit_exceeded, 0, 0, {}, fmt::format("{} exceeds the limit of {}", what, limit)};
+    } // limit_exceeded
+
+    std::optional<diagnostic> check_limits(const Select& _s, const query_limits& _l)
+    {
+        std::size_t nodes = 0;
+        std::size_t bytes = 0;
+
+        // Pairs of expression and depth. The walk must not recurse, as the depth of the
+        // tree is what is being checked.
+        std::vector<std::pair<const ConditionExpression*, std::size_t>> stack;
+
+        for (auto&& c : _s.conditions) {
+            stack.emplace_back(&c.expression, 1);
+
+            while (!stack.empty()) {
+                const auto [e, depth] = stack.back();
+                stack.pop_back();
+
+                if (depth > _l.max_depth) {
+                    return limit_exceeded("condition nesting depth", _l.max_depth);
+                }
+
+                if (++nodes > _l.max_nodes) {
+                    return limit_exceeded("number of condition expressions", _l.max_nodes);
+                }
+
+                if (const auto* op = boost::get<ConditionOperator_And>(e); op) {
+                    stack.emplace_back(&op->right, depth + 1);
+                    stack.emplace_back(&op->left, depth + 1);
+                }
+                else if (const auto* op = boost::get<ConditionOperator_Or>(e); op) {
+                    stack.emplace_back(&op->right, depth + 1);
+                    stack.emplace_back(&op->left, depth + 1);
+                }
+                else if (const auto* op = boost::get<ConditionOperator_Not>(e); op) {
+                    stack.emplace_back(&op->expression, depth + 1);
+                }
+                else if (const auto* in = boost::get<ConditionIn>(e); in) {
+                    if (in->list_of_string_literals.size() > _l.max_in_list) {
+                        return limit_exceeded("length of an IN list", _l.max_in_list);
+                    }
+
+                    for (auto&& l : in->list_of_string_literals) {
+                        bytes += l.size();
+                    }
+                }
+                else if (const auto* between = boost::get<ConditionBetween>(e); between) {
+                    bytes += between->low.size() + between->high.size();
+                }
+                else {
+                    boost::apply_visitor([&bytes](const auto& _leaf) {
+                        using T = std::decay_t<decltype(_leaf)>;
+                        if constexpr (!std::is_same_v<T, ConditionIn> &&
+                                      !std::is_same_v<T, ConditionBetween> &&
+                                      !std::is_same_v<T, ConditionOperator_And> &&
+                                      !std::is_same_v<T, ConditionOperator_Or> &&
+                                      !std::is_same_v<T, ConditionOperator_Not>)
+                        {
+                            bytes += _leaf.string_literal.size();
+                        }
+                    }, *e);
+                }
+
+                if (bytes > _l.max_literal_bytes) {
+                    return limit_exceeded("total size of literals", _l.max_literal_bytes);
+                }
+            }
+        }
+
+        return std::nullopt;
+    } // check_limits
+} // namespace irods::experimental::api::genquery
@@ -0,0 +1,36 @@
+#ifndef IRODS_GENQUERY_LIMITS_HPP
+#define IRODS_GENQUERY_LIMITS_HPP
+
+#include "genquery_ast_types.hpp"
+#include "genquery_diagnostic.hpp"
+
+#include <cstddef>
+#include <optional>
+
+namespace irods::experimental::api::genquery
+{
+    // Bounds on the size of a query. A query beyond them is rejected before it is
+    // translated, which bounds the time and memory a single query can take. The parser
+    // stops as soon as a limit is exceeded.
+    struct query_limits
+    {
+        // Nesting depth of a condition expression (e.g. "not not = 'x'" has depth 3).
+        std::size_t max_depth = 256;
+
+        // Number of condition expressions, operators included, across all conditions.
+        std::size_t max_nodes = 4096;
+
+        // Total size of the literals in bytes.
+        std::size_t max_literal_bytes = 1 << 20;
+
+        // Number of literals of a single IN list.
+        std::size_t max_in_list = 10000;
+    };
+
+    // Returns a diagnostic (error_code::limit_exceeded) for the first limit exceeded.
+    std::optional<diagnostic> check_limits(const Select&, const query_limits&);
+
+    diagnostic limit_exceeded(const char* what, std::size_t limit);
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_LIMITS_HPP
@@ -0,0 +1,171 @@
+#include "genquery_normalize.hpp"
+
+#include "genquery_stream_insertion.hpp"
+
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        template <typename T>
+        constexpr bool is_leaf = !std::is_same_v<T, ConditionIn> &&
+                                 !std::is_same_v<T, ConditionBetween> &&
+                                 !std::is_same_v<T, ConditionOperator_And> &&
+                                 !std::is_same_v<T, ConditionOperator_Or> &&
+                                 !std::is_same_v<T, ConditionOperator_Not>;
+
+        // Calls "_f" for each literal of an expression in canonical order.
+        // "Expression" is either ConditionExpression or const ConditionExpression.
+        template <typename Expression, typename F>
+        auto for_each_literal(Expression& _e, F& _f) -> void
+        {
+            // Depth-first with an explicit stack; the right operand is pushed first so
+            // that the left one is visited first.
+            std::vector<Expression*> stack{&_e};
+
+            while (!stack.empty()) {
+                auto& e = *stack.back();
+                stack.pop_back();
+
+                if (auto* in = boost::get<ConditionIn>(&e); in) {
+                    for (auto&& l : in->list_of_string_literals) { _f(l); }
+                }
+                else if (auto* between = boost::get<ConditionBetween>(&e); between) {
+                    _f(between->low);
+                    _f(between->high);
+                }
+                else if (auto* op = boost::get<ConditionOperator_And>(&e); op) {
+                    stack.push_back(&op->right);
+                    stack.push_back(&op->left);
+                }
+                else if (auto* op = boost::get<ConditionOperator_Or>(&e); op) {
+                    stack.push_back(&op->right);
+                    stack.push_back(&op->left);
+                }
+                else if (auto* op = boost::get<ConditionOperator_Not>(&e); op) {
+                    stack.push_back(&op->expression);
+                }
+                else {
+                    boost::apply_visitor([&_f](auto& _leaf) {
+                        if constexpr (is_leaf<std::remove_const_t<std::remove_reference_t<decltype(_leaf)>>>) {
+                            _f(_leaf.string_literal);
+                        }
+                    }, e);
+                }
+            }
+        } // for_each_literal
+
+        // A sink for the operators of genquery_stream_insertion.hpp which hashes the text
+        // they write, with "?" in place of each literal. Literals are the strings written
+        // between the quotes of the operators, which are always written as C strings.
+        class shape_hasher
+        {
+        public:
+            auto operator<<(const char* _s) -> shape_hasher&
+            {
+                for (; *_s; ++_s) {
+                    if ('\'' == *_s) {
+                        _in_literal = !_in_literal;
+                    }
+                    add(*_s);
+                }
+                return *this;
+            }
+
+            auto operator<<(const std::string& _s) -> shape_hasher&
+            {
+                if (_in_literal) {
+                    add('?');
+                    return *this;
+                }
+
+                for (const auto c : _s) {
+                    add(c);
+                }
+                return *this;
+            }
+
+            auto operator<<(const Selection& _s) -> shape_hasher&
+            {
+                boost::apply_visitor([this](const auto& _v) { *this << _v; }, _s);
+                return *this;
+            }
+
+            auto value() const noexcept -> std::uint64_t { return _hash; }
+
+        private:
+            auto add(char _c) noexcept -> void
+            {
+                _hash = (_hash ^ static_cast<unsigned char>(_c)) * 1099511628211ull;
+            }
+
+            std::uint64_t _hash = 14695981039346656037ull;
+            bool _in_literal = false;
+        };
+    } // anonymous namespace
+
+    std::vector<const std::string*> literals(const Select& _s)
+    {
+        std::vector<const std::string*> ret;
+
+        auto collect = [&ret](const std::string& l) { ret.push_back(&l); };
+
+        for (auto&& c : _s.conditions) {
+            for_each_literal(c.expression, collect);
+        }
+
+        return ret;
+    } // literals
+
+    std::string normalize(const Select& _select)
+    {
+        auto s = _select;
+        auto replace = [](std::string& l) { l = "?"; };
+
+        for (auto&& c : s.conditions) {
+            for_each_literal(c.expression, replace);
+        }
+
+        std::ostringstream oss;
+        std::ostream& os = oss;
+
+        if (s.no_distinct) {
+            os << "no-distinct ";
+        }
+
+        os << s;
+
+        return oss.str();
+    } // normalize
+
+    std::uint64_t fingerprint(const Select& _select)
+    {
+        shape_hasher h;
+
+        if (_select.no_distinct) {
+            h << "no-distinct ";
+        }
+
+        h << _select;
+
+        return h.value();
+    } // fingerprint
+
+    std::string unescape_literal(std::string_view _literal)
+    {
+        std::string ret;
+        ret.reserve(_literal.size());
+
+        for (std::size_t i = 0; i < _literal.size(); ++i) {
+            ret += _literal[i];
+            if ('\'' == _literal[i] && i + 1 < _literal.size() && '\'' == _literal[i + 1]) {
+                ++i;
+            }
+        }
+
+        return ret;
+    } // unescape_literal
+} // namespace irods::experimental::api::genquery
@@ -0,0 +1,31 @@
+#ifndef IRODS_GENQUERY_NORMALIZE_HPP
+#define IRODS_GENQUERY_NORMALIZE_HPP
+
+#include "genquery_ast_types.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    // Returns the literals of a query in canonical order: conditions in order, operator
+    // trees depth-first (left operand before right operand), IN-lists and BETWEEN bounds
+    // in order. The pointers refer to the strings within the query.
+    std::vector<const std::string*> literals(const Select&);
+
+    // Returns the text of a query with every literal replaced by "?". Queries with the
+    // same normalized text translate to the same SQL, up to the bind values.
+    std::string normalize(const Select&);
+
+    // Hash of the shape of a query, i.e. FNV-1a of normalize(), computed without building
+    // the text. Queries of the same shape translate to the same SQL, up to bind values.
+    std::uint64_t fingerprint(const Select&);
+
+    // Literals keep the escaping of the query text (i.e. '' for a single quote). Returns
+    // the value the literal stands for.
+    std::string unescape_literal(std::string_view);
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_NORMALIZE_HPP
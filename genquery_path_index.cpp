@@ -0,0 +1,261 @@
+#include "genquery_path_index.hpp"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace irods::experimental::api::genquery
+{
+    // Every node except the root has an id or at least two children, so the tree has
+    // at most twice as many nodes as paths.
+    struct path_index::node
+    {
+        std::string label; // The bytes between the parent and this node.
+        std::optional<std::int64_t> id;
+        std::map<unsigned char, std::unique_ptr<node>> children; // By the first byte of their label.
+    };
+
+    namespace
+    {
+        auto first_byte(std::string_view _s) -> unsigned char
+        {
+            return static_cast<unsigned char>(_s.front());
+        } // first_byte
+
+        // Whether the label of a child continues "_s" at "_offset".
+        template <typename Node>
+        auto continues(const Node& _child, std::string_view _s, std::size_t _offset) -> bool
+        {
+            return _s.compare(_offset, _child.label.size(), _child.label) == 0;
+        } // continues
+
+        // The ids of a node and the nodes below it, in path order.
+        template <typename Node>
+        auto collect(const Node* _n, std::vector<std::int64_t>& _ids) -> void
+        {
+            std::vector<const Node*> stack{_n};
+
+            while (!stack.empty()) {
+                const auto* n = stack.back();
+                stack.pop_back();
+
+                if (n->id) {
+                    _ids.push_back(*n->id);
+                }
+
+                for (auto i = n->children.rbegin(); i != n->children.rend(); ++i) {
+                    stack.push_back(i->second.get());
+                }
+            }
+        } // collect
+    } // anonymous namespace
+
+    bool is_within(std::string_view _path, std::string_view _root)
+    {
+        if (_root.empty() || _path.compare(0, _root.size(), _root) != 0) {
+            return _root == _path;
+        }
+
+        return _path.size() == _root.size() || '/' == _root.back() || '/' == _path[_root.size()];
+    } // is_within
+
+    path_index::path_index()
+        : _root{std::make_unique<node>()}
+    {
+    }
+
+    path_index::~path_index() = default;
+
+    path_index::path_index(path_index&&) noexcept = default;
+
+    auto path_index::operator=(path_index&&) noexcept -> path_index& = default;
+
+    void path_index::insert(std::string_view _path, std::int64_t _id)
+    {
+        auto* n = _root.get();
+        std::size_t d = 0;
+
+        while (d < _path.size()) {
+            const auto rest = _path.substr(d);
+            auto& slot = n->children[first_byte(rest)];
+
+            if (!slot) {
+                slot = std::make_unique<node>(node{std::string{rest}, _id, {}});
+                ++_size;
+                return;
+            }
+
+            std::size_t common = 0;
+            while (common < slot->label.size() && common < rest.size() && slot->label[common] == rest[common]) {
+                ++common;
+            }
+
+            // Splits the edge where the path leaves it.
+            if (common < slot->label.size()) {
+                auto middle = std::make_unique<node>(node{slot->label.substr(0, common), std::nullopt, {}});
+                slot->label.erase(0, common);
+                const auto key = first_byte(slot->label);
+                middle->children.emplace(key, std::move(slot));
+                slot = std::move(middle);
+            }
+
+            n = slot.get();
+            d += common;
+        }
+
+        if (!n->id) {
+            ++_size;
+        }
+
+        n->id = _id;
+    } // insert
+
+    bool path_index::erase(std::string_view _path)
+    {
+        std::vector<node*> chain{_root.get()};
+
+        for (std::size_t d = 0; d < _path.size();) {
+            const auto& children = chain.back()->children;
+            const auto i = children.find(first_byte(_path.substr(d)));
+
+            if (std::end(children) == i || !continues(*i->second, _path, d)) {
+                return false;
+            }
+
+            d += i->second->label.size();
+            chain.push_back(i->second.get());
+        }
+
+        if (!chain.back()->id) {
+            return false;
+        }
+
+        chain.back()->id.reset();
+        --_size;
+
+        // Removes the nodes left without a purpose and merges those left with a single
+        // child into it.
+        for (auto k = chain.size() - 1; k > 0; --k) {
+            auto* n = chain[k];
+
+            if (n->id) {
+                break;
+            }
+
+            if (n->children.empty()) {
+                chain[k - 1]->children.erase(first_byte(n->label));
+                continue;
+            }
+
+            if (n->children.size() == 1) {
+                auto child = std::move(std::begin(n->children)->second);
+                n->label += child->label;
+                n->id = child->id;
+                n->children = std::move(child->children);
+            }
+
+            break;
+        }
+
+        return true;
+    } // erase
+
+    std::optional<std::int64_t> path_index::find(std::string_view _path) const
+    {
+        const node* n = _root.get();
+
+        for (std::size_t d = 0; d < _path.size();) {
+            const auto i = n->children.find(first_byte(_path.substr(d)));
+
+            if (std::end(n->children) == i || !continues(*i->second, _path, d)) {
+                return std::nullopt;
+            }
+
+            d += i->second->label.size();
+            n = i->second.get();
+        }
+
+        return n->id;
+    } // find
+
+    std::vector<std::int64_t> path_index::beginning_of(std::string_view _root_path) const
+    {
+        std::vector<std::int64_t> ids;
+
+        if (_root_path.empty() || '/' != _root_path.back()) {
+            if (const auto id = find(_root_path); id) {
+                ids.push_back(*id);
+            }
+
+            if (_root_path.empty()) {
+                return ids;
+            }
+        }
+
+        // The paths below the root are the paths which start with it and a '/'. They
+        // are the subtree of the node whose edge the prefix ends on.
+        const auto below = [&_root_path] {
+            std::string p{_root_path};
+            if ('/' != p.back()) {
+                p += '/';
+            }
+            return p;
+        }();
+
+        const node* n = _root.get();
+
+        for (std::size_t d = 0; d < below.size();) {
+            const auto i = n->children.find(static_cast<unsigned char>(below[d]));
+
+            if (std::end(n->children) == i) {
+                return ids;
+            }
+
+            const auto& label = i->second->label;
+            const auto k = std::min(label.size(), below.size() - d);
+
+            if (label.compare(0, k, below, d, k) != 0) {
+                return ids;
+            }
+
+            d += k;
+            n = i->second.get();
+        }
+
+        collect(n, ids);
+
+        return ids;
+    } // beginning_of
+
+    std::vector<std::int64_t> path_index::parent_of(std::string_view _path) const
+    {
+        std::vector<std::int64_t> ids;
+
+        // Every path on the way to "_path" is a prefix of it, and a parent of it if the
+        // prefix ends at a '/'.
+        const node* n = _root.get();
+        std::size_t d = 0;
+
+        while (true) {
+            if (n->id && is_within(_path, _path.substr(0, d))) {
+                ids.push_back(*n->id);
+            }
+
+            if (d == _path.size()) {
+                break;
+            }
+
+            const auto i = n->children.find(first_byte(_path.substr(d)));
+
+            if (std::end(n->children) == i || !continues(*i->second, _path, d)) {
+                break;
+            }
+
+            d += i->second->label.size();
+            n = i->second.get();
+        }
+
+        return ids;
+    } // parent_of
+} // namespace irods::experimental::api::genquery
@@ -0,0 +1,59 @@
+#ifndef IRODS_GENQUERY_PATH_INDEX_HPP
+#define IRODS_GENQUERY_PATH_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    // Whether "path" is "root" or a path below it, i.e. whether "path BEGINNING_OF root"
+    // and "root PARENT_OF path" hold. A root ending with '/' (e.g. "/") is a parent of
+    // every path it is a prefix of.
+    bool is_within(std::string_view path, std::string_view root);
+
+    // Maps collection paths (e.g. the COLL_NAME of each COLL_ID) to ids and answers
+    // BEGINNING_OF and PARENT_OF in time proportional to the length of the path and
+    // the number of results, instead of comparing every path.
+    //
+    // The paths are kept in a radix tree whose edges are labelled with byte strings,
+    // so the paths below a collection form a subtree and the collections above a path
+    // lie on the way to it from the root. Paths can be added and removed at any time.
+    // Lookups may run concurrently with each other but not with updates.
+    class path_index
+    {
+    public:
+        path_index();
+        ~path_index();
+
+        path_index(path_index&&) noexcept;
+        auto operator=(path_index&&) noexcept -> path_index&;
+
+        // Adds a path, or changes its id if it is present.
+        void insert(std::string_view path, std::int64_t id);
+
+        // Returns whether the path was present.
+        bool erase(std::string_view path);
+
+        std::optional<std::int64_t> find(std::string_view path) const;
+
+        std::size_t size() const noexcept { return _size; }
+
+        // The ids of "root" and of the paths below it, in path order.
+        std::vector<std::int64_t> beginning_of(std::string_view root) const;
+
+        // The ids of "path" and of the paths above it, from the top down.
+        std::vector<std::int64_t> parent_of(std::string_view path) const;
+
+    private:
+        struct node;
+
+        std::unique_ptr<node> _root;
+        std::size_t _size = 0;
+    };
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_PATH_INDEX_HPP
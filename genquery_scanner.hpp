@@ -12,6 +12,8 @@
 
 #include "parser.hpp" //genquery_parser_bison_generated.hpp" // defines irods::experimental::api::genquery::Parser::symbol_type
 
+#include <chrono>
+
 namespace irods::experimental::api::genquery
 {
     class wrapper;
@@ -23,6 +25,23 @@ namespace irods::experimental::api::genquery
         virtual ~scanner() {}
         virtual Parser::symbol_type get_next_token();
 
+        // The token source of the parser. Adds the time spent scanning to "scan_time"
+        // when set.
+        Parser::symbol_type next_token()
+        {
+            if (!scan_time) {
+                return get_next_token();
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            auto token = get_next_token();
+            *scan_time += std::chrono::steady_clock::now() - start;
+
+            return token;
+        }
+
+        std::chrono::steady_clock::duration* scan_time = nullptr;
+
     private:
         wrapper& _wrapper;
     };
@@ -0,0 +1,557 @@
+#include "genquery_schema.hpp"
+
+#include "table_column_key_maps.hpp"
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <cerrno>
+#include <istream>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        // clang-format off
+        constexpr std::size_t header_size     = 36;
+        constexpr std::size_t string_ref_size = 8;
+        constexpr std::size_t table_size      = 2 * string_ref_size + 4;
+        constexpr std::size_t column_size     = 3 * string_ref_size + 4;
+        constexpr std::size_t link_size       = 3 * string_ref_size;
+        // clang-format on
+
+        auto put_u32(std::string& _b, std::uint32_t _v) -> void
+        {
+            for (int i = 0; i < 4; ++i) {
+                _b += static_cast<char>((_v >> (8 * i)) & 0xff);
+            }
+        } // put_u32
+
+        auto get_u32(std::string_view _b, std::size_t _pos) -> std::uint32_t
+        {
+            const auto* p = reinterpret_cast<const unsigned char*>(_b.data() + _pos);
+            return static_cast<std::uint32_t>(p[0]) |
+                   static_cast<std::uint32_t>(p[1]) << 8 |
+                   static_cast<std::uint32_t>(p[2]) << 16 |
+                   static_cast<std::uint32_t>(p[3]) << 24;
+        } // get_u32
+
+        // Binary search over a section of records which start with their name.
+        template <typename Name>
+        auto find_record(std::uint32_t _offset, std::uint32_t _count, std::size_t _record_size, std::string_view _name, Name _name_of)
+            -> std::optional<std::size_t>
+        {
+            std::size_t lo = 0;
+            std::size_t hi = _count;
+
+            while (lo < hi) {
+                const auto mid = lo + (hi - lo) / 2;
+                const auto pos = _offset + mid * _record_size;
+                const auto c = _name_of(pos).compare(_name);
+
+                if (0 == c) {
+                    return pos;
+                }
+
+                if (c < 0) {
+                    lo = mid + 1;
+                }
+                else {
+                    hi = mid;
+                }
+            }
+
+            return std::nullopt;
+        } // find_record
+
+        // Read-copy-update state. A reader announces itself in the counter of the
+        // current epoch before loading the schema pointer. A writer publishes the new
+        // pointer, then flips the epoch twice and waits for the counter of the epoch it
+        // left behind to drain each time. Afterwards no reader can hold the old pointer.
+        std::atomic<const schema*> current_schema{nullptr};
+        std::atomic<unsigned> current_epoch{0};
+        std::atomic<std::uint64_t> active_readers[2]{};
+
+        // The schema of the outermost snapshot of the calling thread.
+        thread_local const schema* thread_schema{};
+
+        std::mutex writer_mutex;
+        std::shared_ptr<const schema> published_schema;
+
+        auto publish_builtin_schema() -> void
+        {
+            auto s = schema::builtin();
+
+            std::lock_guard lock{writer_mutex};
+
+            if (!published_schema) {
+                current_schema.store(s.get());
+                published_schema = std::move(s);
+            }
+        } // publish_builtin_schema
+    } // anonymous namespace
+
+    schema::schema(std::string storage, void* mapping, std::size_t mapping_size)
+        : _storage{std::move(storage)}
+        , _mapping{mapping}
+        , _mapping_size{mapping_size}
+        , _buffer{_mapping ? std::string_view{static_cast<const char*>(_mapping), _mapping_size} : std::string_view{_storage}}
+        , _tables{}
+        , _columns{}
+        , _links{}
+        , _fingerprint{}
+    {
+    }
+
+    schema::~schema()
+    {
+        if (_mapping) {
+            ::munmap(_mapping, _mapping_size);
+        }
+    }
+
+    std::shared_ptr<const schema> schema::load(const std::string& path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error{errno, std::generic_category(), fmt::format("schema: cannot open [{}]", path)};
+        }
+
+        struct stat st{};
+        if (::fstat(fd, &st) < 0) {
+            const auto ec = errno;
+            ::close(fd);
+            throw std::system_error{ec, std::generic_category(), "schema: fstat failed"};
+        }
+
+        const auto size = static_cast<std::size_t>(st.st_size);
+        if (size < header_size) {
+            ::close(fd);
+            throw std::runtime_error{fmt::format("schema: [{}] is not a schema catalog", path)};
+        }
+
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        const auto ec = errno;
+        ::close(fd);
+
+        if (MAP_FAILED == mapping) {
+            throw std::system_error{ec, std::generic_category(), "schema: mmap failed"};
+        }
+
+        std::shared_ptr<schema> s{new schema{{}, mapping, size}};
+        s->validate();
+
+        return s;
+    } // load
+
+    std::shared_ptr<const schema> schema::from_buffer(std::string buffer)
+    {
+        std::shared_ptr<schema> s{new schema{std::move(buffer), nullptr, 0}};
+        s->validate();
+
+        return s;
+    } // from_buffer
+
+    std::shared_ptr<const schema> schema::builtin()
+    {
+        schema_compiler c;
+        c.add_builtin();
+
+        return from_buffer(c.compile());
+    } // builtin
+
+    // Checks the whole catalog once so that lookups can read it without bounds checks.
+    void schema::validate()
+    {
+        const auto size = _buffer.size();
+
+        if (size < header_size || get_u32(_buffer, 0) != schema_catalog::magic) {
+            throw std::runtime_error{"schema: not a schema catalog"};
+        }
+
+        if ((get_u32(_buffer, 4) & 0xffff) != schema_catalog::version) {
+            throw std::runtime_error{"schema: unsupported catalog version"};
+        }
+
+        if (get_u32(_buffer, 8) != size) {
+            throw std::runtime_error{"schema: catalog is truncated"};
+        }
+
+        const auto read_section = [&](std::size_t _pos, std::size_t _record_size, const char* _name) {
+            const section s{get_u32(_buffer, _pos), get_u32(_buffer, _pos + 4)};
+
+            if (s.offset < header_size || s.offset > size || s.count > (size - s.offset) / _record_size) {
+                throw std::runtime_error{fmt::format("schema: {} section out of bounds", _name)};
+            }
+
+            return s;
+        };
+
+        _tables = read_section(12, table_size, "tables");
+        _columns = read_section(20, column_size, "columns");
+        _links = read_section(28, link_size, "links");
+
+        const auto check_strings = [&](const section& _s, std::size_t _record_size, int _n, bool _sorted) {
+            std::string_view previous;
+
+            for (std::size_t i = 0; i < _s.count; ++i) {
+                const auto pos = _s.offset + i * _record_size;
+
+                for (int j = 0; j < _n; ++j) {
+                    const std::size_t offset = get_u32(_buffer, pos + j * string_ref_size);
+                    const std::size_t length = get_u32(_buffer, pos + j * string_ref_size + 4);
+
+                    if (offset > size || length > size - offset) {
+                        throw std::runtime_error{"schema: string out of bounds"};
+                    }
+                }
+
+                if (_sorted) {
+                    const auto name = string(pos);
+                    if (i > 0 && !(previous < name)) {
+                        throw std::runtime_error{"schema: names are not sorted"};
+                    }
+                    previous = name;
+                }
+            }
+        };
+
+        check_strings(_tables, table_size, 2, true);
+        check_strings(_columns, column_size, 3, true);
+        check_strings(_links, link_size, 3, false);
+
+        // FNV-1a
+        _fingerprint = 14695981039346656037ull;
+        for (unsigned char c : _buffer) {
+            _fingerprint = (_fingerprint ^ c) * 1099511628211ull;
+        }
+    } // validate
+
+    std::string_view schema::string(std::size_t pos) const
+    {
+        return _buffer.substr(get_u32(_buffer, pos), get_u32(_buffer, pos + 4));
+    } // string
+
+    std::optional<table_definition> schema::table(std::string_view name) const
+    {
+        const auto pos = find_record(_tables.offset, _tables.count, table_size, name, [this](auto _p) { return string(_p); });
+
+        if (!pos) {
+            return std::nullopt;
+        }
+
+        return table_definition{string(*pos),
+                                string(*pos + string_ref_size),
+                                static_cast<int>(get_u32(_buffer, *pos + 2 * string_ref_size))};
+    } // table
+
+    std::optional<column_definition> schema::column(std::string_view name) const
+    {
+        const auto pos = find_record(_columns.offset, _columns.count, column_size, name, [this](auto _p) { return string(_p); });
+
+        if (!pos) {
+            return std::nullopt;
+        }
+
+        return column_at_position(*pos);
+    } // column
+
+    table_definition schema::table_at(std::size_t i) const
+    {
+        if (i >= _tables.count) {
+            throw std::out_of_range{"schema: table index out of range"};
+        }
+
+        const auto pos = _tables.offset + i * table_size;
+
+        return table_definition{string(pos),
+                                string(pos + string_ref_size),
+                                static_cast<int>(get_u32(_buffer, pos + 2 * string_ref_size))};
+    } // table_at
+
+    column_definition schema::column_at(std::size_t i) const
+    {
+        if (i >= _columns.count) {
+            throw std::out_of_range{"schema: column index out of range"};
+        }
+
+        return column_at_position(_columns.offset + i * column_size);
+    } // column_at
+
+    column_definition schema::column_at_position(std::size_t pos) const
+    {
+        const auto flags = get_u32(_buffer, pos + 3 * string_ref_size);
+
+        return column_definition{string(pos),
+                                 string(pos + string_ref_size),
+                                 string(pos + 2 * string_ref_size),
+                                 (flags & schema_catalog::not_null) != 0,
+                                 (flags & schema_catalog::integer) != 0 ? column_type::integer : column_type::text};
+    } // column_at_position
+
+    link_definition schema::link(std::size_t i) const
+    {
+        if (i >= _links.count) {
+            throw std::out_of_range{"schema: link index out of range"};
+        }
+
+        const auto pos = _links.offset + i * link_size;
+
+        return link_definition{string(pos), string(pos + string_ref_size), string(pos + 2 * string_ref_size)};
+    } // link
+
+    std::optional<std::string> schema::linked_column(const column_definition& c, std::string_view table) const
+    {
+        if (c.table == table) {
+            return std::string{c.column};
+        }
+
+        const auto qualified = fmt::format("{}.{}", c.table, c.column);
+
+        for (std::size_t i = 0; i < _links.count; ++i) {
+            const auto l = link(i);
+
+            if (!(l.table1 == table && l.table2 == c.table) && !(l.table1 == c.table && l.table2 == table)) {
+                continue;
+            }
+
+            const auto eq = l.clause.find(" = ");
+            if (std::string_view::npos == eq || l.clause.find(" AND ") != std::string_view::npos) {
+                continue;
+            }
+
+            auto lhs = l.clause.substr(0, eq);
+            auto rhs = l.clause.substr(eq + 3);
+
+            if (rhs == qualified) {
+                std::swap(lhs, rhs);
+            }
+
+            if (lhs == qualified && rhs.size() > table.size() && rhs.substr(0, table.size()) == table && '.' == rhs[table.size()]) {
+                return std::string{rhs.substr(table.size() + 1)};
+            }
+        }
+
+        return std::nullopt;
+    } // linked_column
+
+    void schema_compiler::add_builtin()
+    {
+        // Keeps the first definition of a name, as the std::map tables this catalog
+        // replaced did.
+        for (auto&& [name, t] : table_alias_cycler_map) {
+            _tables.try_emplace(std::string{name}, std::string{std::get<0>(t)}, std::get<1>(t));
+        }
+
+        for (auto&& [name, c] : column_table_alias_map) {
+            _columns.try_emplace(std::string{name}, std::string{std::get<0>(c)}, std::string{std::get<1>(c)}, 0);
+        }
+
+        const auto add_flag = [this](auto&& _names, std::uint32_t _flag) {
+            for (auto&& name : _names) {
+                if (const auto iter = _columns.find(name); iter != std::end(_columns)) {
+                    std::get<2>(iter->second) |= _flag;
+                }
+            }
+        };
+
+        add_flag(not_null_columns, schema_catalog::not_null);
+        add_flag(integer_columns, schema_catalog::integer);
+
+        for (auto&& [t1, t2, clause] : foreign_key_link_map) {
+            _links.emplace_back(t1, t2, clause);
+        }
+    } // add_builtin
+
+    void schema_compiler::add_definitions(std::istream& in)
+    {
+        std::string line;
+
+        for (int line_number = 1; std::getline(in, line); ++line_number) {
+            if (line.empty() || '#' == line[0]) {
+                continue;
+            }
+
+            std::vector<std::string> fields;
+
+            for (std::string::size_type p = 0;;) {
+                const auto d = line.find('|', p);
+                fields.push_back(line.substr(p, d - p));
+                if (std::string::npos == d) {
+                    break;
+                }
+                p = d + 1;
+            }
+
+            const auto is_column = "column" == fields[0];
+
+            if (fields.size() != 4 && !(is_column && fields.size() > 4)) {
+                throw std::runtime_error{fmt::format("schema definitions: line [{}]: expected 4 fields", line_number)};
+            }
+
+            if ("table" == fields[0]) {
+                int cycle_flag{};
+
+                try {
+                    cycle_flag = std::stoi(fields[3]);
+                }
+                catch (const std::exception&) {
+                    throw std::runtime_error{fmt::format("schema definitions: line [{}]: invalid cycle flag", line_number)};
+                }
+
+                add_table(std::move(fields[1]), std::move(fields[2]), cycle_flag);
+            }
+            else if (is_column) {
+                std::uint32_t flags = 0;
+
+                for (std::size_t i = 4; i < fields.size(); ++i) {
+                    if ("not_null" == fields[i]) {
+                        flags |= schema_catalog::not_null;
+                    }
+                    else if ("integer" == fields[i]) {
+                        flags |= schema_catalog::integer;
+                    }
+                    else {
+                        throw std::runtime_error{fmt::format("schema definitions: line [{}]: unknown column flag [{}]", line_number, fields[i])};
+                    }
+                }
+
+                add_column(std::move(fields[1]), std::move(fields[2]), std::move(fields[3]), flags);
+            }
+            else if ("link" == fields[0]) {
+                add_link(std::move(fields[1]), std::move(fields[2]), std::move(fields[3]));
+            }
+            else {
+                throw std::runtime_error{fmt::format("schema definitions: line [{}]: unknown definition [{}]", line_number, fields[0])};
+            }
+        }
+    } // add_definitions
+
+    void schema_compiler::add_table(std::string name, std::string alias, int cycle_flag)
+    {
+        _tables.insert_or_assign(std::move(name), std::make_tuple(std::move(alias), cycle_flag));
+    } // add_table
+
+    void schema_compiler::add_column(std::string name, std::string table, std::string column, std::uint32_t flags)
+    {
+        _columns.insert_or_assign(std::move(name), std::make_tuple(std::move(table), std::move(column), flags));
+    } // add_column
+
+    void schema_compiler::add_link(std::string table1, std::string table2, std::string clause)
+    {
+        _links.emplace_back(std::move(table1), std::move(table2), std::move(clause));
+    } // add_link
+
+    std::string schema_compiler::compile() const
+    {
+        std::string records;
+        std::string strings;
+
+        const auto tables_offset = header_size;
+        const auto columns_offset = tables_offset + _tables.size() * table_size;
+        const auto links_offset = columns_offset + _columns.size() * column_size;
+        const auto strings_offset = links_offset + _links.size() * link_size;
+
+        const auto put_string = [&](std::string_view _s) {
+            put_u32(records, static_cast<std::uint32_t>(strings_offset + strings.size()));
+            put_u32(records, static_cast<std::uint32_t>(_s.size()));
+            strings += _s;
+        };
+
+        for (auto&& [name, t] : _tables) {
+            put_string(name);
+            put_string(std::get<0>(t));
+            put_u32(records, static_cast<std::uint32_t>(std::get<1>(t)));
+        }
+
+        for (auto&& [name, c] : _columns) {
+            put_string(name);
+            put_string(std::get<0>(c));
+            put_string(std::get<1>(c));
+            put_u32(records, std::get<2>(c));
+        }
+
+        for (auto&& [t1, t2, clause] : _links) {
+            put_string(t1);
+            put_string(t2);
+            put_string(clause);
+        }
+
+        std::string catalog;
+        catalog.reserve(strings_offset + strings.size());
+
+        put_u32(catalog, schema_catalog::magic);
+        put_u32(catalog, schema_catalog::version);
+        put_u32(catalog, static_cast<std::uint32_t>(strings_offset + strings.size()));
+        put_u32(catalog, static_cast<std::uint32_t>(tables_offset));
+        put_u32(catalog, static_cast<std::uint32_t>(_tables.size()));
+        put_u32(catalog, static_cast<std::uint32_t>(columns_offset));
+        put_u32(catalog, static_cast<std::uint32_t>(_columns.size()));
+        put_u32(catalog, static_cast<std::uint32_t>(links_offset));
+        put_u32(catalog, static_cast<std::uint32_t>(_links.size()));
+
+        catalog += records;
+        catalog += strings;
+
+        return catalog;
+    } // compile
+
+    void publish_schema(std::shared_ptr<const schema> s)
+    {
+        if (!s) {
+            throw std::invalid_argument{"schema: cannot publish a null schema"};
+        }
+
+        std::lock_guard lock{writer_mutex};
+
+        current_schema.store(s.get());
+
+        for (int i = 0; i < 2; ++i) {
+            const auto previous = current_epoch.fetch_add(1) & 1;
+            while (active_readers[previous].load() != 0) {
+                std::this_thread::yield();
+            }
+        }
+
+        published_schema = std::move(s);
+    } // publish_schema
+
+    schema_snapshot::schema_snapshot()
+    {
+        if (thread_schema) {
+            _slot = nested;
+            _schema = thread_schema;
+            return;
+        }
+
+        if (!current_schema.load()) {
+            publish_builtin_schema();
+        }
+
+        _slot = current_epoch.load() & 1;
+        active_readers[_slot].fetch_add(1);
+        _schema = current_schema.load();
+
+        thread_schema = _schema;
+    }
+
+    schema_snapshot::~schema_snapshot()
+    {
+        if (nested == _slot) {
+            return;
+        }
+
+        thread_schema = nullptr;
+        active_readers[_slot].fetch_sub(1, std::memory_order_release);
+    }
+} // namespace irods::experimental::api::genquery
@@ -0,0 +1,190 @@
+#ifndef IRODS_GENQUERY_SCHEMA_HPP
+#define IRODS_GENQUERY_SCHEMA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    // Compiled schema catalog: the tables, columns and foreign key links used to
+    // translate queries.
+    //
+    // The catalog is read in place, so it can be memory-mapped from a file produced by
+    // gql_schema_compiler. All integers are little-endian and "str" is a (u32 offset,
+    // u32 length) pair relative to the start of the catalog.
+    //
+    //   header   magic, version, size, (offset, count) of each section below
+    //   tables   { str name, str alias, i32 cycle flag }, sorted by name
+    //   columns  { str name, str table, str column, u32 flags }, sorted by name
+    //   links    { str table1, str table2, str clause }, in definition order
+    //   strings  raw bytes referenced by "str"
+    namespace schema_catalog
+    {
+        constexpr std::uint32_t magic = 0x43535147; // "GQSC"
+        constexpr std::uint16_t version = 3;
+
+        // Flags of a column.
+        constexpr std::uint32_t not_null = 1; // the column never holds NULL (e.g. a primary key)
+        constexpr std::uint32_t integer  = 2; // the column holds integers; otherwise text
+    } // namespace schema_catalog
+
+    // How the values of a column compare. Integer columns compare numerically with
+    // literals which are numbers and sort before literals which are not, as in SQLite.
+    enum class column_type
+    {
+        text,
+        integer
+    };
+
+    struct table_definition
+    {
+        std::string_view name;
+        std::string_view alias; // e.g. "R_META_MAIN r_data_meta_main"
+        int cycle_flag;
+    };
+
+    struct column_definition
+    {
+        std::string_view name;
+        std::string_view table;
+        std::string_view column;
+        bool not_null;
+        column_type type;
+    };
+
+    struct link_definition
+    {
+        std::string_view table1;
+        std::string_view table2;
+        std::string_view clause;
+    };
+
+    class schema
+    {
+    public:
+        // Memory-maps a catalog file.
+        static std::shared_ptr<const schema> load(const std::string& path);
+
+        static std::shared_ptr<const schema> from_buffer(std::string buffer);
+
+        // The catalog of the tables defined in table_column_key_maps.hpp.
+        static std::shared_ptr<const schema> builtin();
+
+        ~schema();
+
+        schema(const schema&) = delete;
+        auto operator=(const schema&) -> schema& = delete;
+
+        std::optional<table_definition> table(std::string_view name) const;
+        std::optional<column_definition> column(std::string_view name) const;
+
+        // Definitions by index, in catalog order.
+        std::size_t table_count() const noexcept { return _tables.count; }
+        table_definition table_at(std::size_t) const;
+
+        std::size_t column_count() const noexcept { return _columns.count; }
+        column_definition column_at(std::size_t) const;
+
+        std::size_t link_count() const noexcept { return _links.count; }
+        link_definition link(std::size_t) const;
+
+        // The column of "table" which holds the values of a column, i.e. the column
+        // itself or the column it is equal to by a link between the tables (e.g.
+        // R_COLL_MAIN.coll_id for COLL_ID, which is defined on R_DATA_MAIN).
+        std::optional<std::string> linked_column(const column_definition&, std::string_view table) const;
+
+        std::string_view buffer() const noexcept { return _buffer; }
+
+        // Hash of the catalog. Schemas with the same fingerprint translate alike.
+        std::uint64_t fingerprint() const noexcept { return _fingerprint; }
+
+    private:
+        struct section
+        {
+            std::uint32_t offset;
+            std::uint32_t count;
+        };
+
+        schema(std::string storage, void* mapping, std::size_t mapping_size);
+
+        void validate();
+        std::string_view string(std::size_t pos) const;
+        column_definition column_at_position(std::size_t pos) const;
+
+        std::string _storage;
+        void* _mapping;
+        std::size_t _mapping_size;
+        std::string_view _buffer;
+        section _tables;
+        section _columns;
+        section _links;
+        std::uint64_t _fingerprint;
+    };
+
+    // Produces catalogs. Definitions added later replace earlier definitions of the
+    // same table or column.
+    class schema_compiler
+    {
+    public:
+        void add_builtin();
+
+        // Reads definitions, one per line, with fields separated by '|':
+        //
+        //   table|NAME|ALIAS|CYCLE_FLAG
+        //   column|NAME|TABLE|COLUMN[|FLAG...]
+        //   link|TABLE1|TABLE2|CLAUSE
+        //
+        // The flags of a column are "not_null" and "integer" (see schema_catalog).
+        // Empty lines and lines starting with '#' are ignored.
+        void add_definitions(std::istream&);
+
+        void add_table(std::string name, std::string alias, int cycle_flag);
+        void add_column(std::string name, std::string table, std::string column, std::uint32_t flags = 0);
+        void add_link(std::string table1, std::string table2, std::string clause);
+
+        std::string compile() const;
+
+    private:
+        std::map<std::string, std::tuple<std::string, int>, std::less<>> _tables;
+        std::map<std::string, std::tuple<std::string, std::string, std::uint32_t>, std::less<>> _columns;
+        std::vector<std::tuple<std::string, std::string, std::string>> _links;
+    };
+
+    // Publishes a schema for all translations which start afterwards (read-copy-update).
+    //
+    // Readers never block. The call blocks until every translation which could still
+    // observe the previous schema has finished, then releases the previous schema. Must
+    // not be called by a thread which holds a schema_snapshot.
+    void publish_schema(std::shared_ptr<const schema>);
+
+    // Read-side critical section. The schema returned by get() remains valid for the
+    // lifetime of the snapshot. Snapshots nested on the same thread see the schema of
+    // the outermost one. The built-in schema is published on first use.
+    class schema_snapshot
+    {
+    public:
+        schema_snapshot();
+        ~schema_snapshot();
+
+        schema_snapshot(const schema_snapshot&) = delete;
+        auto operator=(const schema_snapshot&) -> schema_snapshot& = delete;
+
+        const schema& get() const noexcept { return *_schema; }
+
+    private:
+        static constexpr unsigned nested = ~0u;
+
+        unsigned _slot;
+        const schema* _schema;
+    };
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_SCHEMA_HPP
@@ -0,0 +1,60 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "genquery_schema.hpp"
+
+// Usage:
+//   gql_schema_compiler OUTPUT [DEFINITIONS...]
+//
+// Compiles the built-in tables plus the site-specific definitions in each DEFINITIONS
+// file (see schema_compiler::add_definitions) into a schema catalog. The catalog is
+// written next to OUTPUT and then renamed over it, so a process mapping the previous
+// catalog is not affected.
+int main(int _argc, char* _argv[])
+{
+    if (_argc < 2) {
+        std::cerr << "usage: " << _argv[0] << " OUTPUT [DEFINITIONS...]\n";
+        return 1;
+    }
+
+    try {
+        namespace gq = irods::experimental::api::genquery;
+
+        gq::schema_compiler compiler;
+        compiler.add_builtin();
+
+        for (int i = 2; i < _argc; ++i) {
+            std::ifstream in{_argv[i]};
+            if (!in) {
+                throw std::runtime_error{std::string{"cannot open "} + _argv[i]};
+            }
+            compiler.add_definitions(in);
+        }
+
+        const auto catalog = compiler.compile();
+
+        // Verifies the catalog before replacing the previous one.
+        gq::schema::from_buffer(catalog);
+
+        const std::string output = _argv[1];
+        const auto tmp = output + ".tmp";
+
+        {
+            std::ofstream out{tmp, std::ios::binary | std::ios::trunc};
+            out.write(catalog.data(), static_cast<std::streamsize>(catalog.size()));
+            if (!out.flush()) {
+                throw std::runtime_error{"cannot write " + tmp};
+            }
+        }
+
+        if (std::rename(tmp.c_str(), output.c_str()) != 0) {
+            throw std::runtime_error{"cannot rename " + tmp + " to " + output};
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << '\n';
+        return 1;
+    }
+}
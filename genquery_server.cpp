@@ -0,0 +1,789 @@
+#include "genquery_server.hpp"
+
+#include "genquery_translation_cache.hpp"
+#include "genquery_workload.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        // clang-format off
+        constexpr std::uint64_t listen_tag  = 0;
+        constexpr std::uint64_t metrics_tag = 1;
+        constexpr std::uint64_t event_tag   = 2;
+        constexpr std::uint64_t first_connection_tag = 16;
+        // clang-format on
+
+        auto put_u32(std::string& _b, std::uint32_t _v) -> void
+        {
+            for (int i = 0; i < 4; ++i) {
+                _b += static_cast<char>((_v >> (8 * i)) & 0xff);
+            }
+        } // put_u32
+
+        auto get_u32(std::string_view _b, std::size_t _pos) -> std::uint32_t
+        {
+            if (_pos > _b.size() || _b.size() - _pos < 4) {
+                throw std::runtime_error{"translation server: truncated frame"};
+            }
+
+            const auto* p = reinterpret_cast<const unsigned char*>(_b.data() + _pos);
+            return static_cast<std::uint32_t>(p[0]) |
+                   static_cast<std::uint32_t>(p[1]) << 8 |
+                   static_cast<std::uint32_t>(p[2]) << 16 |
+                   static_cast<std::uint32_t>(p[3]) << 24;
+        } // get_u32
+
+        [[noreturn]] auto throw_system_error(const char* _what) -> void
+        {
+            throw std::system_error{errno, std::generic_category(), fmt::format("translation server: {}", _what)};
+        } // throw_system_error
+
+        auto make_address(const std::string& _path) -> sockaddr_un
+        {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+
+            if (_path.size() >= sizeof(addr.sun_path)) {
+                throw std::runtime_error{fmt::format("translation server: socket path is too long [{}]", _path)};
+            }
+
+            std::memcpy(addr.sun_path, _path.c_str(), _path.size() + 1);
+
+            return addr;
+        } // make_address
+
+        auto listen_on(const std::string& _path) -> int
+        {
+            const auto addr = make_address(_path);
+
+            const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                throw_system_error("socket failed");
+            }
+
+            // A socket file left behind by a previous instance.
+            ::unlink(_path.c_str());
+
+            if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+                const auto ec = errno;
+                ::close(fd);
+                throw std::system_error{ec, std::generic_category(), fmt::format("translation server: cannot listen on [{}]", _path)};
+            }
+
+            return fd;
+        } // listen_on
+
+        auto response_frame(const translation& _t) -> std::string
+        {
+            std::string payload;
+            payload += static_cast<char>(protocol::status_ok);
+            put_u32(payload, static_cast<std::uint32_t>(_t.sql.size()));
+            payload += _t.sql;
+            put_u32(payload, static_cast<std::uint32_t>(_t.bind_values.size()));
+            for (auto&& v : _t.bind_values) {
+                put_u32(payload, static_cast<std::uint32_t>(v.size()));
+                payload += v;
+            }
+
+            std::string frame;
+            put_u32(frame, static_cast<std::uint32_t>(payload.size()));
+            return frame + payload;
+        } // response_frame
+
+        auto error_frame(std::string_view _message) -> std::string
+        {
+            std::string frame;
+            put_u32(frame, static_cast<std::uint32_t>(_message.size() + 1));
+            frame += static_cast<char>(protocol::status_error);
+            frame += _message;
+            return frame;
+        } // error_frame
+    } // anonymous namespace
+
+    struct server::impl
+    {
+        struct job
+        {
+            std::uint64_t connection;
+            std::uint64_t sequence;
+            std::string query;
+        };
+
+        struct completion
+        {
+            std::uint64_t connection;
+            std::uint64_t sequence;
+            std::string frame;
+        };
+
+        struct connection
+        {
+            int fd;
+            std::string in;
+            std::string out;
+            std::uint64_t next_sequence = 0;  // Assigned to the next request.
+            std::uint64_t next_response = 0;  // Sequence of the next response to write.
+            std::map<std::uint64_t, std::string> completed; // Responses which must wait for earlier ones.
+            std::size_t pending = 0;          // Requests without a response in "out".
+            std::uint32_t events = 0;         // Registered epoll events.
+            bool input_closed = false;
+            bool metrics = false;             // Receives a snapshot of the metrics, then is closed.
+        };
+
+        struct metrics
+        {
+            std::atomic<std::uint64_t> connections_accepted{};
+            std::atomic<std::uint64_t> connections_active{};
+            std::atomic<std::uint64_t> requests{};
+            std::atomic<std::uint64_t> request_errors{};
+            std::atomic<std::uint64_t> bytes_received{};
+            std::atomic<std::uint64_t> bytes_sent{};
+            std::atomic<std::uint64_t> backpressure_pauses{};
+            std::atomic<std::uint64_t> protocol_errors{};
+            std::atomic<std::uint64_t> translation_time_us{};
+            std::atomic<std::uint64_t> queue_depth{};
+            std::atomic<std::uint64_t> admission_throttled{};
+            std::atomic<std::uint64_t> admission_downgraded{};
+            std::atomic<std::uint64_t> admission_rejected{};
+        };
+
+        server& srv;
+        const server_options& opts;
+        int epoll_fd = -1;
+        int listen_fd = -1;
+        int metrics_fd = -1;
+
+        std::unordered_map<std::uint64_t, connection> connections;
+        std::uint64_t next_connection_tag = first_connection_tag;
+
+        std::mutex mutex;
+        std::condition_variable jobs_available;
+        std::deque<job> jobs;
+        std::vector<completion> completions;
+        bool shutting_down = false;
+        std::vector<std::thread> workers;
+
+        metrics stats;
+
+        impl(server& _srv, const server_options& _opts)
+            : srv{_srv}
+            , opts{_opts}
+        {
+        }
+
+        ~impl()
+        {
+            {
+                std::lock_guard lock{mutex};
+                shutting_down = true;
+            }
+            jobs_available.notify_all();
+
+            for (auto&& w : workers) {
+                w.join();
+            }
+
+            for (auto&& [tag, c] : connections) {
+                ::close(c.fd);
+            }
+
+            for (const int fd : {listen_fd, metrics_fd, epoll_fd}) {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+
+            ::unlink(opts.socket_path.c_str());
+            if (!opts.metrics_socket_path.empty()) {
+                ::unlink(opts.metrics_socket_path.c_str());
+            }
+        }
+
+        auto watch(int _fd, std::uint64_t _tag, std::uint32_t _events, int _op = EPOLL_CTL_ADD) -> void
+        {
+            epoll_event ev{};
+            ev.events = _events;
+            ev.data.u64 = _tag;
+
+            if (::epoll_ctl(epoll_fd, _op, _fd, &ev) < 0) {
+                throw_system_error("epoll_ctl failed");
+            }
+        } // watch
+
+        auto start() -> void
+        {
+            epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+            if (epoll_fd < 0) {
+                throw_system_error("epoll_create1 failed");
+            }
+
+            listen_fd = listen_on(opts.socket_path);
+            watch(listen_fd, listen_tag, EPOLLIN);
+
+            if (!opts.metrics_socket_path.empty()) {
+                metrics_fd = listen_on(opts.metrics_socket_path);
+                watch(metrics_fd, metrics_tag, EPOLLIN);
+            }
+
+            watch(srv._event_fd, event_tag, EPOLLIN);
+
+            auto n = opts.workers ? opts.workers : std::max(1u, std::thread::hardware_concurrency());
+            for (std::size_t i = 0; i < n; ++i) {
+                workers.emplace_back([this] { work(); });
+            }
+        } // start
+
+        auto work() -> void
+        {
+            for (;;) {
+                job j;
+
+                {
+                    std::unique_lock lock{mutex};
+                    jobs_available.wait(lock, [this] { return shutting_down || !jobs.empty(); });
+
+                    if (shutting_down) {
+                        return;
+                    }
+
+                    j = std::move(jobs.front());
+                    jobs.pop_front();
+                    --stats.queue_depth;
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                std::string frame;
+
+                try {
+                    translation_profiler profiler{opts.translation.slow_log};
+
+                    auto select = wrapper::try_parse(j.query, opts.translation.limits, profiler.scan_time());
+                    profiler.parsed();
+
+                    auto t = !select     ? result<translation>{std::move(select).error()}
+                             : opts.cache ? opts.cache->try_translate(*select, opts.translation)
+                                          : try_translate(*select, opts.translation);
+
+                    profiler.finish(j.query, select ? &*select : nullptr, t);
+
+                    if (t) {
+                        frame = response_frame(*t);
+
+                        if (admission_decision::throttle == t->admission) {
+                            ++stats.admission_throttled;
+                        }
+                        else if (admission_decision::downgrade == t->admission) {
+                            ++stats.admission_downgraded;
+                        }
+                    }
+                    else {
+                        ++stats.request_errors;
+                        frame = error_frame(describe(t.error()));
+
+                        if (error_code::too_expensive == t.error().code) {
+                            ++stats.admission_rejected;
+                        }
+                    }
+                }
+                catch (const std::exception& e) {
+                    ++stats.request_errors;
+                    frame = error_frame(e.what());
+                }
+
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                stats.translation_time_us += std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+
+                {
+                    std::lock_guard lock{mutex};
+                    completions.push_back({j.connection, j.sequence, std::move(frame)});
+                }
+
+                const std::uint64_t one = 1;
+                [[maybe_unused]] const auto r = ::write(srv._event_fd, &one, sizeof(one));
+            }
+        } // work
+
+        auto accept_connections() -> void
+        {
+            for (;;) {
+                const int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) {
+                    return;
+                }
+
+                const auto tag = next_connection_tag++;
+                auto& c = connections[tag];
+                c.fd = fd;
+                c.events = EPOLLIN;
+                watch(fd, tag, c.events);
+
+                ++stats.connections_accepted;
+                ++stats.connections_active;
+            }
+        } // accept_connections
+
+        auto metrics_text() const -> std::string
+        {
+            auto text = fmt::format("connections_accepted {}\n"
+                                    "connections_active {}\n"
+                                    "requests {}\n"
+                                    "request_errors {}\n"
+                                    "protocol_errors {}\n"
+                                    "bytes_received {}\n"
+                                    "bytes_sent {}\n"
+                                    "backpressure_pauses {}\n"
+                                    "queue_depth {}\n"
+                                    "translation_time_us {}\n"
+                                    "admission_throttled {}\n"
+                                    "admission_downgraded {}\n"
+                                    "admission_rejected {}\n",
+                                    stats.connections_accepted.load(),
+                                    stats.connections_active.load(),
+                                    stats.requests.load(),
+                                    stats.request_errors.load(),
+                                    stats.protocol_errors.load(),
+                                    stats.bytes_received.load(),
+                                    stats.bytes_sent.load(),
+                                    stats.backpressure_pauses.load(),
+                                    stats.queue_depth.load(),
+                                    stats.translation_time_us.load(),
+                                    stats.admission_throttled.load(),
+                                    stats.admission_downgraded.load(),
+                                    stats.admission_rejected.load());
+
+            if (opts.translation.slow_log) {
+                text += fmt::format("slow_translations_dropped {}\n", opts.translation.slow_log->dropped());
+            }
+
+            if (opts.translation.workload) {
+                for (auto&& shape : opts.translation.workload->top(opts.metrics_shapes)) {
+                    text += fmt::format("shape {}\n", to_json(shape));
+                }
+            }
+
+            return text;
+        } // metrics_text
+
+        // The snapshot is written like responses are, so a client which does not read it
+        // does not block the event loop.
+        auto serve_metrics() -> void
+        {
+            for (;;) {
+                const int fd = ::accept4(metrics_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) {
+                    return;
+                }
+
+                const auto tag = next_connection_tag++;
+                auto& c = connections[tag];
+                c.fd = fd;
+                c.out = metrics_text();
+                c.input_closed = true;
+                c.metrics = true;
+                watch(fd, tag, c.events);
+
+                service(tag, c, false);
+            }
+        } // serve_metrics
+
+        auto close_connection(std::uint64_t _tag) -> void
+        {
+            const auto iter = connections.find(_tag);
+            if (iter == std::end(connections)) {
+                return;
+            }
+
+            if (!iter->second.metrics) {
+                --stats.connections_active;
+            }
+
+            ::close(iter->second.fd);
+            connections.erase(iter);
+        } // close_connection
+
+        auto saturated(const connection& _c) const -> bool
+        {
+            return _c.pending >= opts.max_pending_requests || _c.out.size() >= opts.max_output_buffer;
+        } // saturated
+
+        // Submits the complete frames in the input buffer, unless the connection is saturated.
+        auto submit_requests(std::uint64_t _tag, connection& _c) -> bool
+        {
+            std::size_t pos = 0;
+            std::vector<job> batch;
+
+            while (!saturated(_c) && _c.in.size() - pos >= 4) {
+                const auto size = get_u32(_c.in, pos);
+
+                if (size > opts.max_request_size) {
+                    ++stats.protocol_errors;
+                    return false;
+                }
+
+                if (_c.in.size() - pos - 4 < size) {
+                    break;
+                }
+
+                batch.push_back({_tag, _c.next_sequence++, _c.in.substr(pos + 4, size)});
+                ++_c.pending;
+                pos += 4 + size;
+            }
+
+            _c.in.erase(0, pos);
+
+            if (!batch.empty()) {
+                stats.requests += batch.size();
+                stats.queue_depth += batch.size();
+
+                {
+                    std::lock_guard lock{mutex};
+                    std::move(std::begin(batch), std::end(batch), std::back_inserter(jobs));
+                }
+
+                jobs_available.notify_all();
+            }
+
+            return true;
+        } // submit_requests
+
+        auto update_events(std::uint64_t _tag, connection& _c) -> void
+        {
+            std::uint32_t events = 0;
+
+            if (!_c.input_closed) {
+                if (saturated(_c)) {
+                    if (_c.events & EPOLLIN) {
+                        ++stats.backpressure_pauses;
+                    }
+                }
+                else {
+                    events |= EPOLLIN;
+                }
+            }
+
+            if (!_c.out.empty()) {
+                events |= EPOLLOUT;
+            }
+
+            if (events != _c.events) {
+                _c.events = events;
+                watch(_c.fd, _tag, events, EPOLL_CTL_MOD);
+            }
+        } // update_events
+
+        // Returns false if the connection must be closed.
+        auto flush(connection& _c) -> bool
+        {
+            while (!_c.out.empty()) {
+                const auto n = ::send(_c.fd, _c.out.data(), _c.out.size(), MSG_NOSIGNAL);
+
+                if (n < 0) {
+                    return EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno;
+                }
+
+                if (!_c.metrics) {
+                    stats.bytes_sent += n;
+                }
+
+                _c.out.erase(0, static_cast<std::size_t>(n));
+            }
+
+            return true;
+        } // flush
+
+        // Reads, submits, writes and updates the epoll registration of a connection.
+        auto service(std::uint64_t _tag, connection& _c, bool _readable) -> void
+        {
+            if (_readable && !_c.input_closed) {
+                char buffer[64 * 1024];
+
+                while (!saturated(_c)) {
+                    const auto n = ::recv(_c.fd, buffer, sizeof(buffer), 0);
+
+                    if (n > 0) {
+                        stats.bytes_received += n;
+                        _c.in.append(buffer, static_cast<std::size_t>(n));
+
+                        if (!submit_requests(_tag, _c)) {
+                            close_connection(_tag);
+                            return;
+                        }
+
+                        continue;
+                    }
+
+                    if (0 == n) {
+                        _c.input_closed = true;
+                    }
+                    else if (EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno) {
+                        close_connection(_tag);
+                        return;
+                    }
+
+                    break;
+                }
+            }
+
+            // Frames buffered while the connection was saturated.
+            if (!submit_requests(_tag, _c) || !flush(_c)) {
+                close_connection(_tag);
+                return;
+            }
+
+            if (_c.input_closed && 0 == _c.pending && _c.out.empty()) {
+                close_connection(_tag);
+                return;
+            }
+
+            update_events(_tag, _c);
+        } // service
+
+        auto collect_completions() -> void
+        {
+            std::uint64_t count;
+            [[maybe_unused]] const auto r = ::read(srv._event_fd, &count, sizeof(count));
+
+            std::vector<completion> done;
+
+            {
+                std::lock_guard lock{mutex};
+                done.swap(completions);
+            }
+
+            std::vector<std::uint64_t> touched;
+
+            for (auto&& d : done) {
+                const auto iter = connections.find(d.connection);
+
+                // The client disconnected before the response was ready.
+                if (iter == std::end(connections)) {
+                    continue;
+                }
+
+                auto& c = iter->second;
+                c.completed.emplace(d.sequence, std::move(d.frame));
+
+                for (auto it = c.completed.begin(); it != c.completed.end() && it->first == c.next_response;) {
+                    c.out += it->second;
+                    it = c.completed.erase(it);
+                    ++c.next_response;
+                    --c.pending;
+                }
+
+                touched.push_back(d.connection);
+            }
+
+            std::sort(std::begin(touched), std::end(touched));
+            touched.erase(std::unique(std::begin(touched), std::end(touched)), std::end(touched));
+
+            for (const auto tag : touched) {
+                if (const auto iter = connections.find(tag); iter != std::end(connections)) {
+                    service(tag, iter->second, false);
+                }
+            }
+        } // collect_completions
+
+        auto loop() -> void
+        {
+            epoll_event events[64];
+
+            while (!srv._stop) {
+                const int n = ::epoll_wait(epoll_fd, events, 64, -1);
+
+                if (n < 0) {
+                    if (EINTR == errno) {
+                        continue;
+                    }
+                    throw_system_error("epoll_wait failed");
+                }
+
+                for (int i = 0; i < n; ++i) {
+                    const auto tag = events[i].data.u64;
+
+                    if (listen_tag == tag) {
+                        accept_connections();
+                    }
+                    else if (metrics_tag == tag) {
+                        serve_metrics();
+                    }
+                    else if (event_tag == tag) {
+                        collect_completions();
+
+                        if (srv._reload.exchange(false) && opts.reload) {
+                            opts.reload();
+                        }
+
+                        if (opts.translation.slow_log && opts.slow_translations) {
+                            if (auto entries = opts.translation.slow_log->drain(); !entries.empty()) {
+                                opts.slow_translations(std::move(entries));
+                            }
+                        }
+                    }
+                    else if (const auto iter = connections.find(tag); iter != std::end(connections)) {
+                        // EPOLLHUP: the client is gone, its responses cannot be delivered.
+                        if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                            close_connection(tag);
+                            continue;
+                        }
+
+                        service(tag, iter->second, events[i].events & EPOLLIN);
+                    }
+                }
+            }
+        } // loop
+    };
+
+    server::server(server_options _opts)
+        : _options{std::move(_opts)}
+        , _event_fd{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)}
+        , _stop{false}
+        , _reload{false}
+    {
+        if (_event_fd < 0) {
+            throw_system_error("eventfd failed");
+        }
+    }
+
+    server::~server()
+    {
+        ::close(_event_fd);
+    }
+
+    void server::run()
+    {
+        impl i{*this, _options};
+        i.start();
+        i.loop();
+    } // run
+
+    void server::stop() noexcept
+    {
+        _stop = true;
+        const std::uint64_t one = 1;
+        [[maybe_unused]] const auto r = ::write(_event_fd, &one, sizeof(one));
+    } // stop
+
+    void server::request_reload() noexcept
+    {
+        _reload = true;
+        const std::uint64_t one = 1;
+        [[maybe_unused]] const auto r = ::write(_event_fd, &one, sizeof(one));
+    } // request_reload
+
+    client::client(const std::string& socket_path)
+        : _fd{::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)}
+    {
+        if (_fd < 0) {
+            throw_system_error("socket failed");
+        }
+
+        const auto addr = make_address(socket_path);
+
+        if (::connect(_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
+            const auto ec = errno;
+            ::close(_fd);
+            throw std::system_error{ec, std::generic_category(), fmt::format("translation client: cannot connect to [{}]", socket_path)};
+        }
+    }
+
+    client::~client()
+    {
+        ::close(_fd);
+    }
+
+    void client::send(std::string_view query)
+    {
+        std::string frame;
+        put_u32(frame, static_cast<std::uint32_t>(query.size()));
+        frame += query;
+
+        for (std::size_t n = 0; n < frame.size();) {
+            const auto r = ::send(_fd, frame.data() + n, frame.size() - n, MSG_NOSIGNAL);
+            if (r < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                throw_system_error("send failed");
+            }
+            n += static_cast<std::size_t>(r);
+        }
+    } // send
+
+    translation client::receive()
+    {
+        const auto read_exactly = [this](std::size_t _n) {
+            std::string b(_n, '\0');
+
+            for (std::size_t n = 0; n < _n;) {
+                const auto r = ::recv(_fd, b.data() + n, _n - n, 0);
+                if (r < 0 && EINTR == errno) {
+                    continue;
+                }
+                if (r <= 0) {
+                    throw std::runtime_error{"translation client: connection closed"};
+                }
+                n += static_cast<std::size_t>(r);
+            }
+
+            return b;
+        };
+
+        const auto payload = read_exactly(get_u32(read_exactly(4), 0));
+
+        if (payload.empty()) {
+            throw std::runtime_error{"translation client: empty response"};
+        }
+
+        if (protocol::status_ok != static_cast<std::uint8_t>(payload[0])) {
+            throw std::runtime_error{payload.substr(1)};
+        }
+
+        translation t;
+        std::size_t pos = 1;
+
+        const auto read_string = [&] {
+            const auto size = get_u32(payload, pos);
+            if (payload.size() - pos - 4 < size) {
+                throw std::runtime_error{"translation server: truncated frame"};
+            }
+            pos += 4 + size;
+            return payload.substr(pos - size, size);
+        };
+
+        t.sql = read_string();
+
+        const auto count = get_u32(payload, pos);
+        pos += 4;
+
+        for (std::uint32_t i = 0; i < count; ++i) {
+            t.bind_values.push_back(read_string());
+        }
+
+        return t;
+    } // receive
+} // namespace irods::experimental::api::genquery
@@ -0,0 +1,125 @@
+#ifndef IRODS_GENQUERY_SERVER_HPP
+#define IRODS_GENQUERY_SERVER_HPP
+
+#include "genquery_slow_log.hpp"
+#include "genquery_sql.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    class translation_cache;
+
+    // Translation server protocol (Unix domain stream socket).
+    //
+    // Every message is a frame: u32 payload size (little-endian) followed by the payload.
+    // A request payload is the text of a GenQuery. The response payload is
+    //
+    //   u8 status = 0, u32 sql size, sql, u32 bind count, { u32 size, value } ...
+    //   u8 status = 1, error message
+    //
+    // Clients may send any number of requests without waiting (pipelining). Responses
+    // are returned in request order. A connection which sends a frame larger than
+    // server_options::max_request_size is closed.
+    namespace protocol
+    {
+        constexpr std::uint8_t status_ok = 0;
+        constexpr std::uint8_t status_error = 1;
+    } // namespace protocol
+
+    struct server_options
+    {
+        std::string socket_path;
+
+        // Serves a text snapshot of the metrics to every connection, then closes it.
+        // Disabled when empty.
+        std::string metrics_socket_path;
+
+        // The number of query shapes in the snapshot, by decreasing count, when
+        // translation.workload is set. Each is a line "shape" followed by its JSON (see
+        // genquery_workload.hpp).
+        std::size_t metrics_shapes = 20;
+
+        // Number of translation threads. Zero means one per hardware thread.
+        std::size_t workers = 0;
+
+        // Back-pressure: a connection is not read while it has this many requests in
+        // flight, or this many bytes of responses which the client has not read yet.
+        std::size_t max_pending_requests = 128;
+        std::size_t max_output_buffer = 4 << 20;
+
+        std::size_t max_request_size = 1 << 20;
+
+        options translation;
+
+        // Translations go through this cache when set (see translation_cache).
+        translation_cache* cache = nullptr;
+
+        // Invoked on the event loop thread after request_reload().
+        std::function<void()> reload;
+
+        // Invoked on the event loop thread with the entries of translation.slow_log, when
+        // set, as translations complete.
+        std::function<void(std::vector<slow_translation>)> slow_translations;
+    };
+
+    class server
+    {
+    public:
+        explicit server(server_options);
+        ~server();
+
+        server(const server&) = delete;
+        auto operator=(const server&) -> server& = delete;
+
+        // Serves until stop() is called.
+        void run();
+
+        // May be called from any thread or from a signal handler.
+        void stop() noexcept;
+        void request_reload() noexcept;
+
+    private:
+        struct impl;
+
+        server_options _options;
+        int _event_fd;
+        std::atomic<bool> _stop;
+        std::atomic<bool> _reload;
+    };
+
+    // Blocking client of the translation server.
+    class client
+    {
+    public:
+        explicit client(const std::string& socket_path);
+        ~client();
+
+        client(const client&) = delete;
+        auto operator=(const client&) -> client& = delete;
+
+        // Sends a request without waiting for its response.
+        void send(std::string_view query);
+
+        // Receives the response of the oldest request not yet received. Throws
+        // std::runtime_error if the server reported an error.
+        translation receive();
+
+        translation translate(std::string_view query)
+        {
+            send(query);
+            return receive();
+        }
+
+    private:
+        int _fd;
+    };
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_SERVER_HPP
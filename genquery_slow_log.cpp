@@ -0,0 +1,235 @@
+#include "genquery_slow_log.hpp"
+
+#include "genquery_json.hpp"
+#include "genquery_normalize.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_stream_insertion.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <ctime>
+#include <sstream>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        thread_local translation_profile* active_profile{};
+
+        auto microseconds(std::chrono::steady_clock::duration _d) -> double
+        {
+            return std::chrono::duration<double, std::micro>{_d}.count();
+        } // microseconds
+
+        auto round_up_to_power_of_two(std::size_t _n) -> std::size_t
+        {
+            std::size_t p = 1;
+            while (p < _n) {
+                p *= 2;
+            }
+            return p;
+        } // round_up_to_power_of_two
+
+        // ISO 8601 in UTC, with milliseconds.
+        auto format_time(std::chrono::system_clock::time_point _t) -> std::string
+        {
+            const auto seconds = std::chrono::system_clock::to_time_t(_t);
+            const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(_t.time_since_epoch()).count() % 1000;
+
+            std::tm tm{};
+            ::gmtime_r(&seconds, &tm);
+
+            char buffer[32];
+            std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &tm);
+
+            return fmt::format("{}.{:03}Z", buffer, ms);
+        } // format_time
+    } // anonymous namespace
+
+    slow_translation_log::slow_translation_log(std::chrono::microseconds threshold, std::size_t capacity)
+        : _threshold{threshold}
+        , _slots{}
+        , _mask{round_up_to_power_of_two(std::max<std::size_t>(capacity, 2)) - 1}
+        , _push_position{}
+        , _pop_position{}
+        , _dropped{}
+    {
+        _slots = std::make_unique<slot[]>(_mask + 1);
+
+        for (std::size_t i = 0; i <= _mask; ++i) {
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool slow_translation_log::push(slow_translation&& entry)
+    {
+        auto pos = _push_position.load(std::memory_order_relaxed);
+
+        for (;;) {
+            auto& s = _slots[pos & _mask];
+            const auto seq = s.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+            if (0 == diff) {
+                // The slot is free for this position. Claim it, or retry with the position
+                // another producer left.
+                if (_push_position.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    s.entry = std::move(entry);
+                    s.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                // The slot still holds the entry of the previous lap.
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else {
+                pos = _push_position.load(std::memory_order_relaxed);
+            }
+        }
+    } // push
+
+    std::vector<slow_translation> slow_translation_log::drain()
+    {
+        std::vector<slow_translation> entries;
+        auto pos = _pop_position.load(std::memory_order_relaxed);
+
+        for (;;) {
+            auto& s = _slots[pos & _mask];
+            const auto seq = s.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+
+            if (0 == diff) {
+                if (_pop_position.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    entries.push_back(std::move(s.entry));
+                    s.entry = {};
+                    s.sequence.store(pos + _mask + 1, std::memory_order_release);
+                    ++pos;
+                }
+            }
+            else if (diff < 0) {
+                // Empty, or the next entry is still being written.
+                return entries;
+            }
+            else {
+                pos = _pop_position.load(std::memory_order_relaxed);
+            }
+        }
+    } // drain
+
+    translation_profiler::translation_profiler(slow_translation_log* log)
+        : _log{active_profile ? nullptr : log}
+        , _profile{}
+        , _start{}
+        , _scan_time{}
+    {
+        if (_log) {
+            active_profile = &_profile;
+            _start = std::chrono::steady_clock::now();
+        }
+    }
+
+    translation_profiler::~translation_profiler()
+    {
+        if (_log) {
+            active_profile = nullptr;
+        }
+    }
+
+    void translation_profiler::parsed() noexcept
+    {
+        if (!_log) {
+            return;
+        }
+
+        _profile.scan_us = microseconds(_scan_time);
+        _profile.parse_us = microseconds(std::chrono::steady_clock::now() - _start) - _profile.scan_us;
+    } // parsed
+
+    void translation_profiler::finish(std::string_view query, const Select* select, const result<translation>& t)
+    {
+        if (!_log) {
+            return;
+        }
+
+        const auto elapsed = std::chrono::steady_clock::now() - _start;
+
+        if (elapsed < _log->threshold()) {
+            return;
+        }
+
+        slow_translation e;
+        e.time = std::chrono::system_clock::now();
+        e.profile = _profile;
+        e.profile.total_us = microseconds(elapsed);
+
+        if (select) {
+            e.fingerprint = fingerprint(*select);
+        }
+
+        if (!query.empty() || !select) {
+            e.query = query;
+        }
+        else {
+            std::ostringstream oss;
+            std::ostream& os = oss;
+
+            if (select->no_distinct) {
+                os << "no-distinct ";
+            }
+
+            os << *select;
+            e.query = oss.str();
+        }
+
+        if (t) {
+            e.sql_size = t->sql.size();
+            e.bind_count = t->bind_values.size();
+        }
+        else {
+            e.error = describe(t.error());
+        }
+
+        _log->push(std::move(e));
+    } // finish
+
+    translation_profile* translation_profiler::current() noexcept
+    {
+        return active_profile;
+    } // current
+
+    std::string to_json(const slow_translation& _e)
+    {
+        const auto& p = _e.profile;
+
+        std::string out = fmt::format("{{\"time\": \"{}\", \"query\": ", format_time(_e.time));
+        json::append_string(out, _e.query);
+        out += fmt::format(", \"fingerprint\": \"{:016x}\", \"phases_us\": {{\"scan\": {:.1f}, \"parse\": {:.1f}, "
+                           "\"resolution\": {:.1f}, \"linkage\": {:.1f}, \"annotation\": {:.1f}, \"emission\": {:.1f}, "
+                           "\"total\": {:.1f}}}, \"linkage_depth\": {}, \"sql_size\": {}, \"bind_count\": {}, \"error\": ",
+                           _e.fingerprint,
+                           p.scan_us,
+                           p.parse_us,
+                           p.resolution_us,
+                           p.linkage_us,
+                           p.annotation_us,
+                           p.emission_us,
+                           p.total_us,
+                           p.linkage_depth,
+                           _e.sql_size,
+                           _e.bind_count);
+
+        if (_e.error.empty()) {
+            out += "null";
+        }
+        else {
+            json::append_string(out, _e.error);
+        }
+
+        out += '}';
+        return out;
+    } // to_json
+} // namespace irods::experimental::api::genquery
@@ -0,0 +1,151 @@
+#ifndef IRODS_GENQUERY_SLOW_LOG_HPP
+#define IRODS_GENQUERY_SLOW_LOG_HPP
+
+#include "genquery_ast_types.hpp"
+#include "genquery_diagnostic.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    struct translation;
+
+    // Where the time of a translation went, in microseconds. Scanning is part of
+    // parsing, so "parse_us" excludes "scan_us". Both are zero for queries which were
+    // not parsed from text.
+    struct translation_profile
+    {
+        double scan_us = 0;
+        double parse_us = 0;
+        double resolution_us = 0; // Resolving the columns of the selections and conditions.
+        double linkage_us = 0;    // compute_table_linkage().
+        double annotation_us = 0; // annotate_redundant_table_aliases().
+        double emission_us = 0;   // Assembling the statement and estimating its cost.
+        double total_us = 0;
+
+        // The deepest recursion of compute_table_linkage().
+        std::size_t linkage_depth = 0;
+    };
+
+    struct slow_translation
+    {
+        std::chrono::system_clock::time_point time;
+
+        // The text of the query, as received or as written by the operators of
+        // genquery_stream_insertion.hpp, and its fingerprint (zero if it did not parse).
+        std::string query;
+        std::uint64_t fingerprint = 0;
+
+        translation_profile profile;
+
+        // The size of the SQL and the number of bind values, or the reason the query did
+        // not translate (see describe()).
+        std::size_t sql_size = 0;
+        std::size_t bind_count = 0;
+        std::string error;
+    };
+
+    // Collects the translations which take at least a threshold (see options::slow_log).
+    //
+    // Entries are kept in a bounded ring buffer which translating threads write without
+    // locking, each claiming a slot with a compare-and-swap (Vyukov's bounded queue).
+    // Entries which find the buffer full are dropped and counted. The buffer is emptied
+    // by drain(), e.g. periodically by the server or after a batch by gql.
+    class slow_translation_log
+    {
+    public:
+        // "capacity" is rounded up to a power of two.
+        explicit slow_translation_log(std::chrono::microseconds threshold, std::size_t capacity = 1024);
+
+        slow_translation_log(const slow_translation_log&) = delete;
+        auto operator=(const slow_translation_log&) -> slow_translation_log& = delete;
+
+        std::chrono::microseconds threshold() const noexcept { return _threshold; }
+
+        // Returns false if the buffer is full.
+        bool push(slow_translation&&);
+
+        // Removes the entries from the buffer, oldest first.
+        std::vector<slow_translation> drain();
+
+        // The number of entries which found the buffer full.
+        std::uint64_t dropped() const noexcept { return _dropped.load(std::memory_order_relaxed); }
+
+    private:
+        struct slot
+        {
+            // Equal to the position of the next push into the slot while it is free,
+            // and to that position plus one while it holds an entry.
+            std::atomic<std::size_t> sequence;
+            slow_translation entry;
+        };
+
+        std::chrono::microseconds _threshold;
+        std::unique_ptr<slot[]> _slots;
+        std::size_t _mask;
+
+        // Written by producers and consumers respectively, kept apart to avoid false
+        // sharing.
+        alignas(64) std::atomic<std::size_t> _push_position;
+        alignas(64) std::atomic<std::size_t> _pop_position;
+        alignas(64) std::atomic<std::uint64_t> _dropped;
+    };
+
+    // Measures a translation, from parsing to emission, and records it in a log if it
+    // takes at least the threshold of the log. While a profiler is active, the
+    // translations of its thread add the time of their phases to its profile; nested
+    // profilers are inactive, so the outermost one records the translation once.
+    //
+    //   translation_profiler profiler{opts.slow_log};
+    //   auto select = wrapper::try_parse(query, opts.limits, profiler.scan_time());
+    //   profiler.parsed();
+    //   ...
+    //   profiler.finish(query, select ? &*select : nullptr, t);
+    class translation_profiler
+    {
+    public:
+        // Inactive if "log" is null or another profiler is active on the thread.
+        explicit translation_profiler(slow_translation_log* log);
+        ~translation_profiler();
+
+        translation_profiler(const translation_profiler&) = delete;
+        auto operator=(const translation_profiler&) -> translation_profiler& = delete;
+
+        bool active() const noexcept { return nullptr != _log; }
+
+        // Where the parser adds the time spent scanning (see wrapper::try_parse()), or null
+        // if inactive.
+        std::chrono::steady_clock::duration* scan_time() noexcept { return _log ? &_scan_time : nullptr; }
+
+        // Ends the parse phase, which started when the profiler was created.
+        void parsed() noexcept;
+
+        // Records the translation if it was slow. "query" is the text the query was
+        // parsed from; when empty, the text is written from "select".
+        void finish(std::string_view query, const Select* select, const result<translation>&);
+
+        // The profile of the active profiler of the thread, if any.
+        static translation_profile* current() noexcept;
+
+    private:
+        slow_translation_log* _log;
+        translation_profile _profile;
+        std::chrono::steady_clock::time_point _start;
+        std::chrono::steady_clock::duration _scan_time;
+    };
+
+    // e.g. {"time": "2024-05-01T12:00:00.123Z", "query": "select ...", "fingerprint": "9c2f...",
+    //       "phases_us": {"scan": 3.1, "parse": 9.8, "resolution": 12.0, "linkage": 840.2,
+    //                     "annotation": 2.2, "emission": 14.9, "total": 882.2},
+    //       "linkage_depth": 9, "sql_size": 1204, "bind_count": 0, "error": null}
+    std::string to_json(const slow_translation&);
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_SLOW_LOG_HPP
@@ -1,34 +1,40 @@
 #include "genquery_ast_types.hpp"
+#include "genquery_explain.hpp"
+#include "genquery_normalize.hpp"
+#include "genquery_path_index.hpp"
+#include "genquery_schema.hpp"
+#include "genquery_slow_log.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_workload.hpp"
+#include "genquery_wrapper.hpp"
 
-#include "table_column_key_maps.hpp"
 //#include "irods_logger.hpp"
 //#include "irods_exception.hpp"
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <new>
+#include <optional>
+#include <set>
 #include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
 
 namespace irods::experimental::api::genquery
 {
     //using log = irods::experimental::log;
 
-    template <typename Iterable>
-    std::string
-    to_string(Iterable const& iterable) {
-#if 0
-        std::string v{"("};
-        for (auto&& element : iterable) {
-            v += fmt::format("'{}', ", element);
-        }
-        v.erase(v.find_last_of(","));
-        v += ") ";
-        return v;
-#else
-        return fmt::format("({}) ", fmt::join(iterable, ", "));
-#endif
-    }
-
     struct sql_visitor: public boost::static_visitor<std::string> {
         template <typename T>
         std::string operator()(const T& arg) const {
@@ -36,13 +42,230 @@ namespace irods::experimental::api::genquery
         }
     };
 
-    auto no_distinct_flag = false;
+    // The generator state is per thread, so independent queries can be translated
+    // concurrently.
+    thread_local auto no_distinct_flag = false;
+
+    // The schema of the translation in progress. See schema_snapshot.
+    thread_local const schema* active_schema{};
+
+    thread_local std::vector<std::string> columns;
+    thread_local std::vector<std::string> tables;
+    thread_local std::vector<std::string> from_aliases;
+    thread_local std::vector<std::string> where_clauses;
+    thread_local std::vector<std::string> processed_tables;
+
+    // The first "condition_clause_count" entries of "where_clauses" come from the
+    // conditions of the query. The remaining entries are link clauses.
+    thread_local std::size_t condition_clause_count{};
+
+    // When not empty, compute_table_linkage() only follows links between these tables
+    // (see counted_column()).
+    thread_local std::vector<std::string> linkable_tables;
+
+    // The current and deepest recursion of compute_table_linkage().
+    thread_local std::size_t linkage_depth{};
+    thread_local std::size_t max_linkage_depth{};
+
+    // Prints the decisions of the planner (see options::trace).
+    thread_local bool trace_enabled{};
+
+    template <typename... Args>
+    auto trace(fmt::format_string<Args...> _format, Args&&... _args) -> void
+    {
+        if (trace_enabled) {
+            fmt::print(_format, std::forward<Args>(_args)...);
+        }
+    } // trace
+
+    // Records the decisions of the translation in progress (see options::explain).
+    thread_local explanation* active_explanation{};
+
+    // Measures the phases of a translation for the explanation and the profile of the
+    // thread (see translation_profiler), if there are any.
+    class phase_clock
+    {
+    public:
+        phase_clock()
+            : _profile{translation_profiler::current()}
+        {
+            if (active_explanation || _profile) {
+                _start = std::chrono::steady_clock::now();
+            }
+        }
+
+        // Ends the current phase, which adds to "_field" of the profile, and starts the
+        // next one.
+        auto lap(const char* _name, double translation_profile::*_field) -> void
+        {
+            if (!active_explanation && !_profile) {
+                return;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            const std::chrono::duration<double, std::micro> elapsed = now - _start;
+
+            if (active_explanation) {
+                active_explanation->phases.push_back({_name, elapsed.count()});
+            }
+
+            if (_profile) {
+                _profile->*_field += elapsed.count();
+            }
+
+            _start = now;
+        } // lap
+
+    private:
+        translation_profile* _profile;
+        std::chrono::steady_clock::time_point _start;
+    };
+
+    // When literals are parameterized, each literal is emitted as a marker holding its
+    // ordinal within literals(select). The markers are replaced with placeholders once
+    // the statement is complete, so the bind values follow the order of the final text.
+    thread_local bool parameterize_literals{};
+    thread_local std::vector<const std::string*> literal_refs;
+    thread_local std::unordered_map<const std::string*, std::uint32_t> literal_ordinals;
+
+    // Resolves path conditions on COLL_NAME to collection ids (see
+    // options::collection_paths).
+    thread_local const path_index* active_collection_paths{};
+    thread_local std::size_t max_resolved_paths{};
+
+    // Compares text case-insensitively (see options::case_insensitive). "fold_case" is
+    // set for each condition, as only conditions on text columns are folded.
+    thread_local bool case_insensitive{};
+    thread_local bool fold_case{};
+
+    constexpr char literal_marker_begin = '\x02';
+    constexpr char literal_marker_end   = '\x03';
+
+    auto reset_generator_state() -> void
+    {
+        columns.clear();
+        tables.clear();
+        from_aliases.clear();
+        where_clauses.clear();
+        processed_tables.clear();
+        condition_clause_count = 0;
+        linkable_tables.clear();
+        linkage_depth = 0;
+        max_linkage_depth = 0;
+        literal_refs.clear();
+        literal_ordinals.clear();
+    } // reset_generator_state
+
+    auto literal_ordinal(const std::string& _l) -> std::uint32_t
+    {
+        const auto iter = literal_ordinals.find(&_l);
+
+        if (iter == std::end(literal_ordinals)) {
+            throw std::logic_error{"literal does not belong to the query being translated"};
+        }
+
+        return iter->second;
+    } // literal_ordinal
+
+    template <typename Dialect>
+    auto literal(const std::string& _l) -> std::string
+    {
+        if (!parameterize_literals) {
+            std::string ret;
+            Dialect::quote(ret, _l);
+            return ret;
+        }
+
+        return fmt::format("{}{}{}", literal_marker_begin, literal_ordinal(_l), literal_marker_end);
+    } // literal
+
+    // A marker of the literals of an IN list, bound as one array. The literals of a
+    // list have consecutive ordinals.
+    auto literal_array(const std::vector<std::string>& _list) -> std::string
+    {
+        return fmt::format("{}{}*{}{}", literal_marker_begin, literal_ordinal(_list.front()), _list.size(), literal_marker_end);
+    } // literal_array
+
+    // The operand of a comparison which ignores case, if the comparison does.
+    template <typename Dialect>
+    auto folded(std::string _operand) -> std::string
+    {
+        if (!fold_case) {
+            return _operand;
+        }
+
+        std::string ret;
+        Dialect::fold(ret, _operand);
+        return ret;
+    } // folded
+
+    template <typename Dialect>
+    auto bind_literals(const std::string& _sql, translation& _t) -> void
+    {
+        _t.sql.reserve(_sql.size());
+
+        for (std::string::size_type p = 0; p < _sql.size();) {
+            const auto b = _sql.find(literal_marker_begin, p);
+
+            if (std::string::npos == b) {
+                _t.sql.append(_sql, p);
+                break;
+            }
+
+            const auto e = _sql.find(literal_marker_end, b);
+            const auto marker = _sql.substr(b + 1, e - b - 1);
+            const auto star = marker.find('*');
+            const auto ordinal = static_cast<std::uint32_t>(std::stoul(marker.substr(0, star)));
+
+            _t.sql.append(_sql, p, b - p);
+            Dialect::placeholder(_t.sql, _t.bind_values.size() + 1);
+
+            if (std::string::npos == star) {
+                _t.bind_values.push_back(unescape_literal(*literal_refs[ordinal]));
+                _t.bind_counts.push_back(1);
+            }
+            else if constexpr (Dialect::array_binds) {
+                const auto count = static_cast<std::uint32_t>(std::stoul(marker.substr(star + 1)));
+
+                std::vector<std::string> values;
+                for (auto i = ordinal; i < ordinal + count; ++i) {
+                    values.push_back(unescape_literal(*literal_refs[i]));
+                }
+
+                _t.bind_values.push_back(Dialect::array(values));
+                _t.bind_counts.push_back(count);
+            }
+
+            _t.bind_layout.push_back(ordinal);
+
+            p = e + 1;
+        }
+
+        // Layouts of single literals are implied.
+        if (std::all_of(std::begin(_t.bind_counts), std::end(_t.bind_counts), [](auto _n) { return 1 == _n; })) {
+            _t.bind_counts.clear();
+        }
+    } // bind_literals
+
+    auto without_literal_markers(const std::string& _clause) -> std::string
+    {
+        std::string ret;
+
+        for (std::string::size_type p = 0; p < _clause.size();) {
+            const auto b = _clause.find(literal_marker_begin, p);
+
+            if (std::string::npos == b) {
+                ret.append(_clause, p);
+                break;
+            }
+
+            ret.append(_clause, p, b - p);
+            ret += '?';
+            p = _clause.find(literal_marker_end, b) + 1;
+        }
 
-    std::vector<std::string> columns;
-    std::vector<std::string> tables;
-    std::vector<std::string> from_aliases;
-    std::vector<std::string> where_clauses;
-    std::vector<std::string> processed_tables;
+        return ret;
+    } // without_literal_markers
 
     auto table_is_not_present(
           const std::vector<std::string>& _tbls
@@ -56,21 +279,36 @@ namespace irods::experimental::api::genquery
         // only allow redundant metadata related tables
         if(_t.find("META") != std::string::npos || table_is_not_present(tables, _t)) {
             //log::api::info("adding table {}", _t);
-            fmt::print("adding table [{}] ...\n", _t);
+            trace("adding table [{}] ...\n", _t);
             tables.push_back(_t);
         }
     } // add_table_if_applicable
 
-    std::string
-    sql(const Column& column) {
-        const auto iter = column_table_alias_map.find(column.name);
+    auto resolve_column(const Column& _c) -> std::tuple<std::string, std::string>
+    {
+        const auto c = active_schema->column(_c.name);
 
-        if (iter == std::end(column_table_alias_map)) {
-            throw std::runtime_error{fmt::format("failed to find column named [{}]", column.name)};
+        if (!c) {
+            throw std::runtime_error{fmt::format("failed to find column named [{}]", _c.name)};
+        }
+
+        if (active_explanation) {
+            auto& resolved = active_explanation->columns;
+            const auto known = std::any_of(std::begin(resolved), std::end(resolved), [&_c](const auto& _r) {
+                return _r.name == _c.name;
+            });
+
+            if (!known) {
+                resolved.push_back({_c.name, std::string{c->table}, std::string{c->column}});
+            }
         }
 
-        const auto& tbl = std::get<0>(iter->second);
-        const auto& col = std::get<1>(iter->second);
+        return {std::string{c->table}, std::string{c->column}};
+    } // resolve_column
+
+    std::string
+    sql(const Column& column) {
+        const auto& [tbl, col] = resolve_column(column);
 
         add_table_if_applicable(tbl);
         columns.push_back(col);
@@ -78,13 +316,42 @@ namespace irods::experimental::api::genquery
         return fmt::format("{}.{}", tbl, col);
     }
 
-    static std::uint8_t emit_second_paren{};
+    // GROUP BY and ORDER BY refer to columns which are (usually) already part of the
+    // query. Unlike sql(const Column&), this never introduces another instance of a
+    // redundant metadata table, so the reference binds to the first instance.
+    auto resolve_column_reference(const Column& _c) -> std::string
+    {
+        const auto& [tbl, col] = resolve_column(_c);
+
+        if (table_is_not_present(tables, tbl)) {
+            add_table_if_applicable(tbl);
+        }
+
+        return fmt::format("{}.{}", tbl, col);
+    } // resolve_column_reference
+
+    // Aggregate functions which are pushed down to the database.
+    constexpr std::array<std::string_view, 5> aggregate_functions{"COUNT", "SUM", "MIN", "MAX", "AVG"};
+
+    auto to_upper(std::string _s) -> std::string
+    {
+        std::transform(std::begin(_s), std::end(_s), std::begin(_s), [](unsigned char _c) {
+            return std::toupper(_c);
+        });
+
+        return _s;
+    } // to_upper
 
     std::string
     sql(const SelectFunction& select_function) {
-        auto ret = fmt::format("{}(", select_function.name);
-        emit_second_paren = 1;
-        return ret;
+        const auto name = to_upper(select_function.name);
+        const auto end = std::end(aggregate_functions);
+
+        if (std::find(std::begin(aggregate_functions), end, name) == end) {
+            throw std::runtime_error{fmt::format("unsupported function [{}]", select_function.name)};
+        }
+
+        return fmt::format("{}({})", name, sql(select_function.column));
     }
 
     std::string
@@ -97,180 +364,399 @@ namespace irods::experimental::api::genquery
 
         std::string ret;
         for (auto&& selection : selections) {
-            auto sel = boost::apply_visitor(sql_visitor{}, selection);
-            ret.append(sel);
-
-            if(emit_second_paren >= 2) {
-                ret += "), ";
-                emit_second_paren = 0;
-            }
-            else if(emit_second_paren > 0) {
-                ++emit_second_paren;
-            }
-            else {
-                ret += ", ";
-            }
+            if (!ret.empty()) { ret += ", "; }
+            ret += boost::apply_visitor(sql_visitor{}, selection);
         } // for selection
 
-
         if(ret.empty()) {
             throw std::runtime_error{"selection string is empty"};
         }
 
-        if(std::string::npos != ret.find_last_of(",")) {
-            ret.erase(ret.find_last_of(","));
-        }
-
         return ret;
     }
 
-    std::string
-    sql(const ConditionOperator_Or& op_or) {
-        std::string ret{};
-        ret += boost::apply_visitor(sql_visitor(), op_or.left);
-        ret += " || ";
-        ret += boost::apply_visitor(sql_visitor(), op_or.right);
-
-        return ret;
-    }
-
-    std::string
-    sql(const ConditionOperator_And& op_and) {
-        std::string ret = boost::apply_visitor(sql_visitor(), op_and.left);
-        ret += " && ";
-        ret += boost::apply_visitor(sql_visitor(), op_and.right);
+    // When aggregates are mixed with plain columns and no GROUP BY clause was given,
+    // the plain columns become the grouping key (i.e. the only valid SQL for the query).
+    auto implicit_group_by(const Selections& _s) -> GroupBy
+    {
+        GroupBy group_by;
+        bool has_aggregate = false;
 
-        return ret;
-    }
+        for (auto&& selection : _s) {
+            if (const auto* column = boost::get<Column>(&selection); column) {
+                group_by.push_back(*column);
+            }
+            else {
+                has_aggregate = true;
+            }
+        }
 
-    std::string
-    sql(const ConditionOperator_Not& op_not) {
-        std::string ret{" NOT "};
-        ret += boost::apply_visitor(sql_visitor(), op_not.expression);
+        if (!has_aggregate) {
+            group_by.clear();
+        }
 
-        return ret;
-    }
+        return group_by;
+    } // implicit_group_by
 
+    template <typename Dialect>
     std::string
     sql(const ConditionNotEqual& not_equal) {
         std::string ret{" != "};
-        ret += "'";
-        ret += not_equal.string_literal;
-        ret += "'";
+        ret += folded<Dialect>(literal<Dialect>(not_equal.string_literal));
 
         return ret;
     }
 
+    template <typename Dialect>
     std::string
     sql(const ConditionEqual& equal) {
         std::string ret{" = "};
-        ret += "'";
-        ret += equal.string_literal;
-        ret += "'";
+        ret += folded<Dialect>(literal<Dialect>(equal.string_literal));
 
         return ret;
     }
 
+    template <typename Dialect>
     std::string
     sql(const ConditionLessThan& less_than) {
         std::string ret{" < "};
-        ret += "'";
-        ret += less_than.string_literal;
-        ret += "'";
+        ret += literal<Dialect>(less_than.string_literal);
 
         return ret;
     }
 
+    template <typename Dialect>
     std::string
     sql(const ConditionLessThanOrEqualTo& less_than_or_equal_to) {
         std::string ret{" <= "};
-        ret += "'";
-        ret += less_than_or_equal_to.string_literal;
-        ret += "'";
+        ret += literal<Dialect>(less_than_or_equal_to.string_literal);
 
         return ret;
     }
 
+    template <typename Dialect>
     std::string
     sql(const ConditionGreaterThan& greater_than) {
         std::string ret{" > "};
-        ret += "'";
-        ret += greater_than.string_literal;
-        ret += "'";
+        ret += literal<Dialect>(greater_than.string_literal);
 
         return ret;
     }
 
+    template <typename Dialect>
     std::string
     sql(const ConditionGreaterThanOrEqualTo& greater_than_or_equal_to) {
         std::string ret{" >= "};
-        ret += greater_than_or_equal_to.string_literal;
+        ret += literal<Dialect>(greater_than_or_equal_to.string_literal);
+
         return ret;
     }
 
+    template <typename Dialect>
     std::string
     sql(const ConditionBetween& between) {
-        std::string ret{" BETWEEN '"};
-        ret += between.low;
-        ret += "' AND '";
-        ret += between.high;
-        ret += "'";
+        std::string ret{" BETWEEN "};
+        ret += literal<Dialect>(between.low);
+        ret += " AND ";
+        ret += literal<Dialect>(between.high);
         return ret;
     }
 
+    template <typename Dialect>
     std::string
     sql(const ConditionIn& in) {
-        std::string ret{" IN "};
-        ret += to_string(in.list_of_string_literals);
+        const auto& list = in.list_of_string_literals;
+
+        if constexpr (Dialect::array_binds) {
+            if (parameterize_literals && !fold_case && !list.empty() &&
+                literal_ordinal(list.back()) - literal_ordinal(list.front()) + 1 == list.size())
+            {
+                std::string ret;
+                Dialect::any(ret, literal_array(list));
+                return ret;
+            }
+        }
+
+        std::string ret{" IN ("};
+
+        for (auto&& l : list) {
+            if (&l != &list.front()) { ret += ", "; }
+            ret += folded<Dialect>(literal<Dialect>(l));
+        }
+
+        ret += ")";
         return ret;
     }
 
+    template <typename Dialect>
     std::string
     sql(const ConditionLike& like) {
-        std::string ret{" LIKE '"};
-        ret += like.string_literal;
-        ret += "'";
+        std::string ret{" LIKE "};
+        ret += folded<Dialect>(literal<Dialect>(like.string_literal));
         return ret;
     }
 
-    std::string
-    sql(const ConditionParentOf& parent_of) {
-        std::string ret{"parent_of"};
-        ret += parent_of.string_literal;
+    auto like_escape(std::string_view _s) -> std::string
+    {
+        std::string ret;
+        for (const auto c : _s) {
+            if ('%' == c || '_' == c || '\\' == c) {
+                ret += '\\';
+            }
+            ret += c;
+        }
         return ret;
-    }
+    } // like_escape
+
+    // The paths "_path" is within (see is_within()), from the top down: each prefix
+    // which ends before or at a '/', and the path itself.
+    auto enclosing_paths(std::string_view _path) -> std::vector<std::string_view>
+    {
+        std::vector<std::string_view> paths;
+
+        const auto add = [&paths](std::string_view _p) {
+            if (paths.empty() || paths.back() != _p) {
+                paths.push_back(_p);
+            }
+        };
+
+        for (std::size_t i = 0; i < _path.size(); ++i) {
+            if ('/' == _path[i]) {
+                if (i > 0) {
+                    add(_path.substr(0, i));
+                }
+                add(_path.substr(0, i + 1));
+            }
+        }
+
+        add(_path);
+
+        return paths;
+    } // enclosing_paths
+
+    // Holds if "_path" is "_root" or a path below it, for operands whose values are not
+    // known until the statement is executed.
+    auto within(std::string_view _path, std::string_view _root) -> std::string
+    {
+        return fmt::format("({0} = {1} OR (LENGTH({1}) > 0 AND SUBSTR({0}, 1, LENGTH({1})) = {1} AND "
+                           "(SUBSTR({1}, LENGTH({1}), 1) = '/' OR SUBSTR({0}, LENGTH({1}) + 1, 1) = '/')))",
+                           _path, _root);
+    } // within
+
+    // BEGINNING_OF matches a collection and the collections below it, and PARENT_OF a
+    // collection and the collections above it. With a path index, they are resolved to
+    // the ids of the matching collections ("_id_column" is set). Otherwise literals
+    // become a LIKE pattern or a list of the enclosing paths, and placeholders are
+    // compared with SUBSTR, since the database cannot derive a pattern from them.
+    template <typename Dialect>
+    auto path_condition(const ConditionExpression& _e, std::string_view _column, std::string_view _id_column) -> std::string
+    {
+        const auto* beginning_of = boost::get<ConditionBeginningOf>(&_e);
+        const auto& l = beginning_of ? beginning_of->string_literal : boost::get<ConditionParentOf>(_e).string_literal;
+
+        if (!_id_column.empty()) {
+            const auto path = unescape_literal(l);
+            const auto ids = beginning_of ? active_collection_paths->beginning_of(path)
+                                          : active_collection_paths->parent_of(path);
+
+            if (ids.empty()) {
+                return "0 = 1";
+            }
+
+            if (ids.size() <= max_resolved_paths) {
+                return fmt::format("{} IN ({})", _id_column, fmt::join(ids, ", "));
+            }
+        }
+
+        if (parameterize_literals) {
+            return beginning_of ? within(_column, literal<Dialect>(l)) : within(literal<Dialect>(l), _column);
+        }
+
+        std::string ret{_column};
+
+        if (beginning_of) {
+            if (l.empty()) {
+                return ret + " = ''";
+            }
+
+            if ('/' == l.back()) {
+                ret += " LIKE ";
+                Dialect::quote(ret, like_escape(l) + '%');
+                return fmt::format("{} {}", ret, Dialect::like_escape);
+            }
+
+            ret = fmt::format("({} = ", _column);
+            Dialect::quote(ret, l);
+            ret += fmt::format(" OR {} LIKE ", _column);
+            Dialect::quote(ret, like_escape(l) + "/%");
+            return fmt::format("{} {})", ret, Dialect::like_escape);
+        }
+
+        ret += " IN (";
+        for (auto&& p : enclosing_paths(l)) {
+            if (ret.back() != '(') { ret += ", "; }
+            Dialect::quote(ret, p);
+        }
+        ret += ")";
+
+        return ret;
+    } // path_condition
 
+    // Every comparison of a condition applies to the column of the condition, so the
+    // column is repeated for each one (e.g. "(R_DATA_MAIN.data_name = 'a' OR
+    // R_DATA_MAIN.data_name = 'b')"). The tree is walked with an explicit stack to keep
+    // the native stack flat for deeply nested expressions.
+    template <typename Dialect>
     std::string
-    sql(const ConditionBeginningOf& beginning_of) {
-        std::string ret{"beginning_of"};
-        ret += beginning_of.string_literal;
+    sql(const ConditionExpression& expression, std::string_view column, std::string_view id_column = {}) {
+        using item = std::variant<const ConditionExpression*, std::string_view>;
+
+        std::string ret;
+        std::vector<item> stack{&expression};
+
+        while (!stack.empty()) {
+            const auto top = stack.back();
+            stack.pop_back();
+
+            if (const auto* text = std::get_if<std::string_view>(&top); text) {
+                ret += *text;
+                continue;
+            }
+
+            const auto& e = *std::get<const ConditionExpression*>(top);
+
+            if (const auto* op = boost::get<ConditionOperator_And>(&e); op) {
+                ret += "(";
+                stack.insert(std::end(stack), {")", &op->right, " AND ", &op->left});
+            }
+            else if (const auto* op = boost::get<ConditionOperator_Or>(&e); op) {
+                ret += "(";
+                stack.insert(std::end(stack), {")", &op->right, " OR ", &op->left});
+            }
+            else if (const auto* op = boost::get<ConditionOperator_Not>(&e); op) {
+                ret += "NOT (";
+                stack.insert(std::end(stack), {")", &op->expression});
+            }
+            else if (boost::get<ConditionBeginningOf>(&e) || boost::get<ConditionParentOf>(&e)) {
+                ret += path_condition<Dialect>(e, column, id_column);
+            }
+            else {
+                const auto compares_text = boost::get<ConditionEqual>(&e) || boost::get<ConditionNotEqual>(&e) ||
+                                           boost::get<ConditionIn>(&e) || boost::get<ConditionLike>(&e);
+
+                ret += compares_text ? folded<Dialect>(std::string{column}) : std::string{column};
+                ret += boost::apply_visitor([](const auto& _leaf) -> std::string {
+                    using T = std::decay_t<decltype(_leaf)>;
+                    if constexpr (std::is_same_v<T, ConditionOperator_And> ||
+                                  std::is_same_v<T, ConditionOperator_Or> ||
+                                  std::is_same_v<T, ConditionOperator_Not> ||
+                                  std::is_same_v<T, ConditionBeginningOf> ||
+                                  std::is_same_v<T, ConditionParentOf>)
+                    {
+                        return {};
+                    }
+                    else {
+                        return sql<Dialect>(_leaf);
+                    }
+                }, e);
+            }
+        }
+
         return ret;
     }
 
+    // Whether the comparisons of a condition on the column ignore case. Integer columns
+    // are compared as they are: LOWER() of one is an error in PostgreSQL, and would keep
+    // the database from using an index on the column in any case.
+    auto folds_case(const Column& _column) -> bool
+    {
+        if (!case_insensitive) {
+            return false;
+        }
+
+        const auto c = active_schema->column(_column.name);
+        return c && column_type::text == c->type;
+    } // folds_case
+
+    template <typename Dialect>
     std::string
     sql(const Condition& condition) {
-        std::string ret{sql(condition.column)};
-        ret += boost::apply_visitor(sql_visitor(), condition.expression);
-        return ret;
+        const auto column = sql(condition.column);
+
+        fold_case = folds_case(condition.column);
+
+        // The ids are compared in the table of the collection names. The index holds the
+        // names as they are, so it does not answer conditions which ignore case.
+        if (active_collection_paths && !fold_case && "COLL_NAME" == condition.column.name) {
+            const auto name_table = std::get<0>(resolve_column(condition.column));
+
+            if (const auto id = active_schema->column("COLL_ID"); id) {
+                if (const auto id_column = active_schema->linked_column(*id, name_table); id_column) {
+                    return sql<Dialect>(condition.expression, column, fmt::format("{}.{}", name_table, *id_column));
+                }
+            }
+        }
+
+        return sql<Dialect>(condition.expression, column);
     }
 
+    // Conditions listed in "_skip" are emitted elsewhere (see avu_strategy).
+    template <typename Dialect>
     std::string
-    sql(const Conditions& conditions) {
+    sql(const Conditions& conditions, const std::vector<const Condition*>& _skip = {}) {
         std::string ret{};
 
         size_t i{};
         for (auto&& condition: conditions) {
-            auto cond = sql(condition);
+            if (std::find(std::begin(_skip), std::end(_skip), &condition) != std::end(_skip)) {
+                ++i;
+                continue;
+            }
+
+            if (!ret.empty()) { ret += " AND "; }
+
+            auto cond = sql<Dialect>(condition);
 
             where_clauses.push_back(cond);
 
             ret += cond;
 
-            if(i < conditions.size()-1) { ret += " AND "; }
-
             ++i;
         }
 
+        condition_clause_count = where_clauses.size();
+
+        return ret;
+    }
+
+    std::string
+    sql(const GroupBy& group_by) {
+        std::string ret{};
+
+        for (auto&& column : group_by) {
+            if (!ret.empty()) { ret += ", "; }
+            ret += resolve_column_reference(column);
+        }
+
+        return ret;
+    }
+
+    std::string
+    sql(const SortExpression& sort_expression) {
+        std::string ret{resolve_column_reference(sort_expression.column)};
+        ret += sort_expression.ascending_order ? " ASC" : " DESC";
+        return ret;
+    }
+
+    std::string
+    sql(const OrderBy& order_by) {
+        std::string ret{};
+
+        for (auto&& sort_expression : order_by) {
+            if (!ret.empty()) { ret += ", "; }
+            ret += sql(sort_expression);
+        }
+
         return ret;
     }
 
@@ -278,14 +764,20 @@ namespace irods::experimental::api::genquery
     using link_type = std::tuple<const std::string, const std::string>;
     using link_vector_type = std::vector<link_type>;
 
+    auto is_linkable(std::string_view _t) -> bool
+    {
+        return linkable_tables.empty() ||
+               std::find(std::begin(linkable_tables), std::end(linkable_tables), _t) != std::end(linkable_tables);
+    } // is_linkable
+
     auto find_fklinks_for_table1(const std::string& _src) -> link_vector_type
     {
         std::vector<std::tuple<const std::string, const std::string>> v{};
 
-        for(const auto& t : foreign_key_link_map) {
-            const auto& t1 = std::get<0>(t);
-            if(t1 == _src) {
-                v.push_back(std::make_tuple(std::get<1>(t), std::get<2>(t)));
+        for(std::size_t i = 0; i < active_schema->link_count(); ++i) {
+            const auto l = active_schema->link(i);
+            if(l.table1 == _src && is_linkable(l.table2)) {
+                v.push_back(std::make_tuple(std::string{l.table2}, std::string{l.clause}));
             }
         }
 
@@ -298,10 +790,10 @@ namespace irods::experimental::api::genquery
         //link_vector_type v{};
         std::vector<std::tuple<const std::string, const std::string>> v;
 
-        for(const auto& t : foreign_key_link_map) {
-            const auto& t2 = std::get<1>(t);
-            if(t2 == _src) {
-                v.push_back(std::make_tuple(std::get<0>(t), std::get<2>(t)));
+        for(std::size_t i = 0; i < active_schema->link_count(); ++i) {
+            const auto l = active_schema->link(i);
+            if(l.table2 == _src && is_linkable(l.table1)) {
+                v.push_back(std::make_tuple(std::string{l.table1}, std::string{l.clause}));
             }
         }
 
@@ -311,10 +803,8 @@ namespace irods::experimental::api::genquery
 
     auto get_table_alias(const std::string& _t) -> std::string
     {
-        const auto& tacm = table_alias_cycler_map;
-
-        if(const auto iter = tacm.find(_t); iter != std::end(tacm)) {
-            return std::get<0>(iter->second);
+        if(const auto t = active_schema->table(_t); t) {
+            return std::string{t->alias};
         }
 
         throw std::runtime_error{fmt::format("{} :: Table does not exist [{}]", __func__, _t)};
@@ -329,10 +819,8 @@ namespace irods::experimental::api::genquery
         //    return 0;
         //}
 
-        const auto& tacm = table_alias_cycler_map;
-
-        if(const auto iter = tacm.find(_t); iter != std::end(tacm)) {
-            return std::get<1>(iter->second);
+        if(const auto t = active_schema->table(_t); t) {
+            return t->cycle_flag;
         }
 
         throw std::runtime_error{fmt::format("{} :: Table does not exist [{}]", __func__, _t)};
@@ -343,50 +831,96 @@ namespace irods::experimental::api::genquery
     auto prime_from_aliases() -> void
     {
         //log::api::info("Priming From Aliases");
-        fmt::print("Priming from aliases ...\n");
+        trace("Priming from aliases ...\n");
 
         for(auto&& t : tables) {
             auto a = get_table_alias(t);
             //log::api::info("---- adding alias {}", a);
-            fmt::print("---- adding alias [{}]\n", a);
+            trace("---- adding alias [{}]\n", a);
             from_aliases.push_back(a);
         }
     } // prime_from_aliases
 
 
+    auto is_identifier_char(char _c) noexcept -> bool
+    {
+        return std::isalnum(static_cast<unsigned char>(_c)) || '_' == _c;
+    } // is_identifier_char
+
+
     auto from_table_is_aliased(const std::string& _t) -> bool
     {
         return _t.find(" ") != std::string::npos;
     } // from_table_is_aliased
 
 
-    auto annotate_where_clause(std::string& _clause, const uint32_t _counter) -> void
+    // Calls "_f" with the position of the '.' of each qualified column name (e.g.
+    // "r_data_meta_main.meta_attr_name") in a clause, last one first. Literals are skipped.
+    template <typename F>
+    auto for_each_qualified_name(const std::string& _clause, F _f) -> void
     {
-        const auto p0 = _clause.find('.');
-        if(std::string::npos == p0) {
-            return;
+        std::vector<std::size_t> dots;
+        bool in_literal = false;
+
+        for (std::size_t i = 0; i < _clause.size(); ++i) {
+            if ('\'' == _clause[i]) {
+                in_literal = !in_literal;
+            }
+            else if (!in_literal && '.' == _clause[i] && i > 0 && is_identifier_char(_clause[i - 1])) {
+                dots.push_back(i);
+            }
+        }
+
+        for (auto i = dots.rbegin(); i != dots.rend(); ++i) {
+            _f(*i);
         }
+    } // for_each_qualified_name
 
-        _clause.insert(p0, std::string{"_"}+std::to_string(_counter));
 
-        // the . moved forward after the insert
-        const auto p1 = _clause.find('.');
-        const auto p2 = _clause.find('.', p1 + 1);
+    auto annotate_where_clause(std::string& _clause, const uint32_t _counter) -> void
+    {
+        const auto suffix = fmt::format("_{}", _counter);
 
-        if(std::string::npos != p2) {
-            _clause.insert(p2, fmt::format("_{}", _counter));
-        }
+        for_each_qualified_name(_clause, [&](std::size_t _dot) {
+            _clause.insert(_dot, suffix);
+        });
     } // annotate_where_clause
 
 
+    // The first qualified column name of a clause identifies the table instance the
+    // clause belongs to.
+    auto where_clause_key(const std::string& _clause) -> std::string
+    {
+        std::size_t dot = std::string::npos;
+        for_each_qualified_name(_clause, [&dot](std::size_t _dot) { dot = _dot; });
+
+        if (std::string::npos == dot) {
+            return _clause.substr(0, _clause.find(' '));
+        }
+
+        auto b = dot;
+        while (b > 0 && is_identifier_char(_clause[b - 1])) { --b; }
+
+        auto e = dot + 1;
+        while (e < _clause.size() && is_identifier_char(_clause[e])) { ++e; }
+
+        return _clause.substr(b, e - b);
+    } // where_clause_key
+
+
     auto annotate_redundant_table_aliases() -> void
     {
         std::map<std::string, uint32_t> alias_counter;
 
+        // Only the clauses of tables with several instances are renumbered. Others may
+        // share a key too (e.g. a condition on R_COLL_MAIN.coll_id and a link clause).
+        std::set<std::string> redundant;
+
         for(auto& t : from_aliases) {
             if(from_table_is_aliased(t)) {
                 auto& ctr = alias_counter[t]; 
                 if(ctr > 0) {
+                    redundant.insert(t.substr(t.rfind(' ') + 1));
                     t += fmt::format("_{}", ctr);
                 }
                 ++ctr;
@@ -396,17 +930,12 @@ namespace irods::experimental::api::genquery
         alias_counter.clear();
 
         for(auto& c : where_clauses) {
-            std::string key;
-
-            const auto p = c.find(' ');
-            if(std::string::npos == p) {
-                key = c;
-            }
-            else {
-                key = c.substr(0, p); 
+            const auto key = where_clause_key(c);
+            if (redundant.count(key.substr(0, key.find('.'))) == 0) {
+                continue;
             }
 
-            auto& ctr = alias_counter[key]; 
+            auto& ctr = alias_counter[key];
             if(ctr > 0) {
                 annotate_where_clause(c, ctr);
             }
@@ -419,7 +948,7 @@ namespace irods::experimental::api::genquery
     auto count_aliases_in_from_tables(const std::string& _t) -> uint8_t
     {
         //log::api::info("searching for table {} alias in FROM tables", _t);
-        fmt::print("searching for table [{}] alias in FROM tables\n", _t);
+        trace("searching for table [{}] alias in FROM tables\n", _t);
 
         uint8_t ctr{};
 
@@ -430,7 +959,7 @@ namespace irods::experimental::api::genquery
         } // for aliases
 
         //log::api::info("---- found {} aliases", ctr);
-        fmt::print("---- found [{}] aliases\n", ctr);
+        trace("---- found [{}] aliases\n", ctr);
 
         return ctr;
     } // count_aliases_in_from_tables
@@ -439,18 +968,28 @@ namespace irods::experimental::api::genquery
     auto count_aliases_in_where_clauses(const std::string& _t) -> uint8_t
     {
         //log::api::info("searching for table {} alias in WHERE clauses", _t);
-        fmt::print("searching for table [{}] alias in WHERE clauses\n", _t);
+        trace("searching for table [{}] alias in WHERE clauses\n", _t);
+
+        // A condition on a table links that table to nothing. Conditions only count
+        // for the metadata tables, where each one requires its own table instance.
+        const auto t = active_schema->table(_t);
+        const auto is_instanced = t && (t->alias.rfind("R_META_MAIN ", 0) == 0 ||
+                                        t->alias.rfind("R_OBJT_METAMAP ", 0) == 0);
 
         uint8_t ctr{};
 
-        for(const auto& a : where_clauses) {
-            if(a.find(_t) != std::string::npos) {
+        for(std::size_t i = 0; i < where_clauses.size(); ++i) {
+            if(i < condition_clause_count && !is_instanced) {
+                continue;
+            }
+
+            if(where_clauses[i].find(_t) != std::string::npos) {
                 ++ctr;
             }
         } // for aliases
 
         //log::api::info("---- found {} aliases", ctr);
-        fmt::print("---- found [{}] aliases\n", ctr);
+        trace("---- found [{}] aliases\n", ctr);
 
         return ctr;
     } // count_aliases_in_where_clauses
@@ -462,7 +1001,7 @@ namespace irods::experimental::api::genquery
         const auto& lk = std::get<1>(_l);
 
         //log::api::info("processing table linkage for {} to {}", _t, t2);
-        fmt::print("processing table linkage for [{}] to [{}]\n", _t, t2);
+        trace("processing table linkage for [{}] to [{}]\n", _t, t2);
 
         // --> We are here for a reason, linkage is needed.
         //
@@ -481,11 +1020,15 @@ namespace irods::experimental::api::genquery
         auto wc_t2 = count_aliases_in_where_clauses(t2);
 
         //log::api::info("counts from t1 {} where t1 {}, from t2 {} where t2 {}", fc_t1, wc_t1, fc_t2, wc_t2);
-        fmt::print("counts from t1 [{}] where t1 [{}], from t2 [{}] where t2 [{}]\n", fc_t1, wc_t1, fc_t2, wc_t2);
+        trace("counts from t1 [{}] where t1 [{}], from t2 [{}] where t2 [{}]\n", fc_t1, wc_t1, fc_t2, wc_t2);
+
+        if (active_explanation) {
+            active_explanation->links.push_back({_t, t2, lk});
+        }
 
         if(0 == wc_t2) {
             //log::api::info("adding WHERE clause for table {} : {}", _t, t2);
-            fmt::print("adding WHERE clause for table [{}] : [{}]\n", _t, t2);
+            trace("adding WHERE clause for table [{}] : [{}]\n", _t, t2);
             ++wc_t2;
             where_clauses.push_back(lk);
         }
@@ -495,19 +1038,19 @@ namespace irods::experimental::api::genquery
         const auto cnt = std::max(fc_t2, wc_t2);
 
         //log::api::info("XXXX - t2_satisfied {}", t2_satisfied);
-        fmt::print("XXXX - t2_satisfied [{}]\n", t2_satisfied);
+        trace("XXXX - t2_satisfied [{}]\n", t2_satisfied);
 
         // fix-up the from-where disparity for table 2
         if(!t2_satisfied) {
             //log::api::info("t2 [{}] from-where is not satisfied", t2);
-            fmt::print("t2 [{}] from-where is not satisfied\n", t2);
+            trace("t2 [{}] from-where is not satisfied\n", t2);
 
             if(fc_t2 < wc_t2) {
                 const auto cnt = wc_t2 - fc_t2;
                 for(auto i = 0; i < cnt; ++i) {
                     const auto& a = get_table_alias(t2);
                     //log::api::info("fix-up :: adding from alias {} for table {}", a, t2);
-                    fmt::print("fix-up :: adding from alias [{}] for table [{}]\n", a, t2);
+                    trace("fix-up :: adding from alias [{}] for table [{}]\n", a, t2);
                     from_aliases.push_back(a);
                 }
             }
@@ -515,7 +1058,7 @@ namespace irods::experimental::api::genquery
                 const auto cnt = fc_t2 - wc_t2;
                 for(auto i = 0; i < cnt; ++i) {
                     //log::api::info("fix-up :: adding where clause for table {}", t2);
-                    fmt::print("fix-up :: adding where clause for table [{}]\n", t2);
+                    trace("fix-up :: adding where clause for table [{}]\n", t2);
                     where_clauses.push_back(lk);
                 }
             }
@@ -525,14 +1068,14 @@ namespace irods::experimental::api::genquery
             // add additional where clauses to match the from clauses
             for(auto i = 0; i < cnt-1; ++i) {
                 //log::api::info("adding WHERE clause for table {} : {}", _t, lk);
-                fmt::print("adding WHERE clause for table [{}] : [{}]\n", _t, lk);
+                trace("adding WHERE clause for table [{}] : [{}]\n", _t, lk);
                 where_clauses.push_back(lk);
             }
 
             for(auto i = 0; i < cnt; ++i) {
                 const auto& a = get_table_alias(_t);
                 //log::api::info("adding from alias for table {} : {} to list", _t, a);
-                fmt::print("adding from alias for table [{}] : [{}] to list\n", _t, a);
+                trace("adding from alias for table [{}] : [{}] to list\n", _t, a);
                 from_aliases.push_back(a);
             }
         }
@@ -551,7 +1094,7 @@ namespace irods::experimental::api::genquery
 
         if(count > 0) {
             //log::api::info("-------- found table alias {} in from tables", get_table_alias(_t));
-            fmt::print("-------- found table alias [{}] in from tables\n", get_table_alias(_t));
+            trace("-------- found table alias [{}] in from tables\n", get_table_alias(_t));
         }
 
         return count > 0;
@@ -567,11 +1110,11 @@ namespace irods::experimental::api::genquery
             const auto& lk = std::get<1>(l);
 
             //log::api::info("---- processing fklinks for table {} to {}:{}", _t, t2, lk);
-            fmt::print("---- processing fklinks for table [{}] to [{}]:[{}]\n", _t, t2, lk);
+            trace("---- processing fklinks for table [{}] to [{}]:[{}]\n", _t, t2, lk);
 
             if(compute_table_linkage(t2)) {
                 //log::api::info("---- compute_table_linkage success for table {} to {}:{}", _t, t2, lk);
-                fmt::print("---- compute_table_linkage success for table [{}] to [{}]:[{}]\n", _t, t2, lk);
+                trace("---- compute_table_linkage success for table [{}] to [{}]:[{}]\n", _t, t2, lk);
                 process_table_linkage(_t, l);
                 return true;
             }
@@ -581,10 +1124,10 @@ namespace irods::experimental::api::genquery
             // forward search use t2
             else if(_fwd) {
                 //log::api::info("---- processing forward fklinks for table {} to {}:{}", _t, t2, lk);
-                fmt::print("---- processing forward fklinks for table [{}] to [{}]:[{}]\n", _t, t2, lk);
+                trace("---- processing forward fklinks for table [{}] to [{}]:[{}]\n", _t, t2, lk);
                 if(linkage_is_applicable_for_table(t2)) {
                     //log::api::info("-------- forward linkage is applicable for table {}, return true", _t);
-                    fmt::print("-------- forward linkage is applicable for table [{}], return true\n", _t);
+                    trace("-------- forward linkage is applicable for table [{}], return true\n", _t);
                     return true;
                 }
             }
@@ -592,7 +1135,7 @@ namespace irods::experimental::api::genquery
             // reverse search use _t as to not match the table in question
             else if(linkage_is_applicable_for_table(_t)) {
                 //log::api::info("-------- reverse linkage is applicable for table {}, return true", _t);
-                fmt::print("-------- reverse linkage is applicable for table [{}], return true\n", _t);
+                trace("-------- reverse linkage is applicable for table [{}], return true\n", _t);
                 return true;
             }
 
@@ -604,25 +1147,31 @@ namespace irods::experimental::api::genquery
 
     auto compute_table_linkage(const std::string& _t) -> bool
     {
+        struct depth_scope
+        {
+            depth_scope() { max_linkage_depth = std::max(max_linkage_depth, ++linkage_depth); }
+            ~depth_scope() { --linkage_depth; }
+        } depth_scope;
+
         //log::api::info("computing table linkage for table {}", _t);
-        fmt::print("computing table linkage for table [{}]\n", _t);
+        trace("computing table linkage for table [{}]\n", _t);
 
         if(get_table_cycle_flag(_t) > 0) {
             //log::api::info("---- found cycle flag for table {}, breaking", _t);
-            fmt::print("---- found cycle flag for table [{}], breaking\n", _t);
+            trace("---- found cycle flag for table [{}], breaking\n", _t);
             return false;
         }
 
         if(table_has_been_processed(_t)) {
             //log::api::info("---- table has been processed {}", _t);
-            fmt::print("---- table has been processed [{}]\n", _t);
+            trace("---- table has been processed [{}]\n", _t);
             return false;
         }
 
         processed_tables.push_back(_t);
 
         //log::api::info("---- computing forward linkage for table {}", _t);
-        fmt::print("---- computing forward linkage for table [{}]\n", _t);
+        trace("---- computing forward linkage for table [{}]\n", _t);
 
         const auto t1l = find_fklinks_for_table1(_t);
         if(auto r = process_fklinks(_t, t1l, true); r) {
@@ -630,7 +1179,7 @@ namespace irods::experimental::api::genquery
         }
 
         //log::api::info("---- computing reverse linkage for table {}", _t);
-        fmt::print("---- computing reverse linkage for table [{}]\n", _t);
+        trace("---- computing reverse linkage for table [{}]\n", _t);
 
         const auto t2l = find_fklinks_for_table2(_t);
         if(auto r = process_fklinks(_t, t2l, false); r) {
@@ -679,17 +1228,463 @@ namespace irods::experimental::api::genquery
     } // build_where_clause
 
 
+    // =-=-=-=-=-=-=-=-=-=-
+    // Metadata (AVU) conditions
+    //
+    // Each AVU group normally costs an R_OBJT_METAMAP / R_META_MAIN pair in the FROM
+    // clause. Queries with many groups turn into many-way self-joins, so the groups
+    // can instead be hoisted into subqueries which are correlated with the object
+    // table through the foreign key links.
+
+    struct avu_group
+    {
+        std::string meta_table;                // e.g. r_data_meta_main
+        std::string metamap_table;             // e.g. r_data_metamap
+        std::string object_table;              // e.g. R_DATA_MAIN
+        std::string meta_link;                 // metamap -> meta_main link clause
+        std::string object_link;               // object -> metamap link clause
+        std::vector<const Condition*> conditions;
+    };
+
+    auto find_avu_links(avu_group& _g) -> bool
+    {
+        const auto meta_links = find_fklinks_for_table2(_g.meta_table);
+        if (meta_links.size() != 1) {
+            return false;
+        }
+
+        _g.metamap_table = std::get<0>(meta_links[0]);
+        _g.meta_link = std::get<1>(meta_links[0]);
+
+        const auto object_links = find_fklinks_for_table2(_g.metamap_table);
+        if (object_links.size() != 1) {
+            return false;
+        }
+
+        _g.object_table = std::get<0>(object_links[0]);
+        _g.object_link = std::get<1>(object_links[0]);
+
+        return true;
+    } // find_avu_links
+
+    auto is_meta_table(const std::string& _t) -> bool
+    {
+        return get_table_alias(_t).rfind("R_META_MAIN ", 0) == 0;
+    } // is_meta_table
+
+    // Groups the AVU conditions the same way annotate_redundant_table_aliases() pairs
+    // them with table instances: the Nth condition on a column belongs to group N of
+    // that column's metadata table. Group 0 of a metadata table referenced by the
+    // selections is bound to the selected columns and must remain a join.
+    auto collect_avu_groups(const Select& _s) -> std::vector<avu_group>
+    {
+        std::vector<std::string> selected_tables;
+
+        for (auto&& selection : _s.selections) {
+            if (const auto* c = boost::get<Column>(&selection); c) {
+                selected_tables.push_back(std::get<0>(resolve_column(*c)));
+            }
+            else {
+                selected_tables.push_back(std::get<0>(resolve_column(boost::get<SelectFunction>(selection).column)));
+            }
+        }
+
+        std::vector<avu_group> groups;
+        std::map<std::tuple<std::string, std::size_t>, std::size_t> group_index;
+        std::map<std::string, std::size_t> column_counter;
+
+        for (auto&& condition : _s.conditions) {
+            const auto& [tbl, col] = resolve_column(condition.column);
+
+            if (!is_meta_table(tbl)) {
+                continue;
+            }
+
+            const auto n = column_counter[condition.column.name]++;
+
+            if (0 == n && !table_is_not_present(selected_tables, tbl)) {
+                continue;
+            }
+
+            const auto key = std::make_tuple(tbl, n);
+
+            if (const auto iter = group_index.find(key); iter != std::end(group_index)) {
+                groups[iter->second].conditions.push_back(&condition);
+                continue;
+            }
+
+            avu_group g;
+            g.meta_table = tbl;
+
+            if (!find_avu_links(g)) {
+                continue;
+            }
+
+            g.conditions.push_back(&condition);
+            group_index[key] = groups.size();
+            groups.push_back(std::move(g));
+        }
+
+        return groups;
+    } // collect_avu_groups
+
+    auto choose_avu_strategy(const std::vector<avu_group>& _g, const options& _o) -> avu_strategy
+    {
+        if (_o.avu != avu_strategy::automatic) {
+            return _o.avu;
+        }
+
+        if (_g.size() >= _o.avu_intersect_threshold) {
+            return avu_strategy::intersect;
+        }
+
+        if (_g.size() >= _o.avu_exists_threshold) {
+            return avu_strategy::exists;
+        }
+
+        return avu_strategy::join;
+    } // choose_avu_strategy
+
+    // Renders the body of a subquery over the metadata tables of a group, without
+    // registering the tables with the enclosing query.
+    template <typename Dialect>
+    auto avu_group_from_where(const avu_group& _g) -> std::string
+    {
+        std::string ret = fmt::format(" FROM {}, {} WHERE {}",
+                                      get_table_alias(_g.metamap_table),
+                                      get_table_alias(_g.meta_table),
+                                      _g.meta_link);
+
+        for (auto&& c : _g.conditions) {
+            const auto col = std::get<1>(resolve_column(c->column));
+            ret += " AND ";
+            fold_case = folds_case(c->column);
+            ret += sql<Dialect>(c->expression, fmt::format("{}.{}", _g.meta_table, col));
+        }
+
+        return ret;
+    } // avu_group_from_where
+
+    // The table a FROM entry or table alias refers to (e.g. "R_META_MAIN r_data_meta_main").
+    auto physical_table(const std::string& _alias) -> std::string
+    {
+        return _alias.substr(0, _alias.find(' '));
+    } // physical_table
+
+    auto split_link_clause(const std::string& _l) -> std::tuple<std::string, std::string>
+    {
+        const auto p = _l.find(" = ");
+        return {_l.substr(0, p), _l.substr(p + 3)};
+    } // split_link_clause
+
+    template <typename Dialect>
+    auto sql_avu_exists(const std::vector<avu_group>& _g) -> std::vector<std::string>
+    {
+        std::vector<std::string> clauses;
+
+        for (auto&& g : _g) {
+            clauses.push_back(fmt::format("EXISTS (SELECT 1{} AND {})", avu_group_from_where<Dialect>(g), g.object_link));
+        }
+
+        return clauses;
+    } // sql_avu_exists
+
+    template <typename Dialect>
+    auto sql_avu_intersect(const std::vector<avu_group>& _g) -> std::vector<std::string>
+    {
+        // One INTERSECT per object table. Groups from different object types
+        // (e.g. data object and collection metadata) cannot share a set.
+        std::vector<std::string> object_tables;
+        std::map<std::string, std::vector<const avu_group*>> groups_by_object;
+
+        for (auto&& g : _g) {
+            if (table_is_not_present(object_tables, g.object_table)) {
+                object_tables.push_back(g.object_table);
+            }
+            groups_by_object[g.object_table].push_back(&g);
+        }
+
+        std::vector<std::string> clauses;
+
+        for (auto&& t : object_tables) {
+            std::string object_column;
+            std::vector<std::string> sets;
+
+            for (auto&& g : groups_by_object[t]) {
+                const auto [object_col, metamap_col] = split_link_clause(g->object_link);
+                object_column = object_col;
+                sets.push_back(fmt::format("SELECT {}{}", metamap_col, avu_group_from_where<Dialect>(*g)));
+            }
+
+            clauses.push_back(fmt::format("{} IN ({})", object_column, fmt::join(sets, " INTERSECT ")));
+        }
+
+        return clauses;
+    } // sql_avu_intersect
+
+    // Joins a numbered instance of the metadata tables per group (e.g. "r_data_meta_main_1"
+    // and "r_data_metamap_1"), linked to each other and to the object table. The
+    // instances are added after annotate_redundant_table_aliases(), which numbers only
+    // the tables the linkage computation adds.
+    template <typename Dialect>
+    auto sql_avu_join(const std::vector<avu_group>& _g, std::vector<std::string>& _from) -> std::vector<std::string>
+    {
+        std::map<std::string, std::uint32_t> instances;
+        std::vector<std::string> clauses;
+
+        for (auto&& g : _g) {
+            const auto n = ++instances[g.meta_table];
+
+            _from.push_back(fmt::format("{}_{}", get_table_alias(g.metamap_table), n));
+            _from.push_back(fmt::format("{}_{}", get_table_alias(g.meta_table), n));
+
+            auto meta_link = g.meta_link;
+            annotate_where_clause(meta_link, n);
+            clauses.push_back(std::move(meta_link));
+
+            auto [object_col, metamap_col] = split_link_clause(g.object_link);
+            annotate_where_clause(metamap_col, n);
+            clauses.push_back(fmt::format("{} = {}", object_col, metamap_col));
+
+            for (auto&& c : g.conditions) {
+                const auto col = std::get<1>(resolve_column(c->column));
+                fold_case = folds_case(c->column);
+                clauses.push_back(sql<Dialect>(c->expression, fmt::format("{}_{}.{}", g.meta_table, n, col)));
+            }
+        }
+
+        return clauses;
+    } // sql_avu_join
+
+    auto hoisted_conditions(const std::vector<avu_group>& _g) -> std::vector<const Condition*>
+    {
+        std::vector<const Condition*> ret;
+
+        for (auto&& g : _g) {
+            ret.insert(std::end(ret), std::begin(g.conditions), std::end(g.conditions));
+        }
+
+        return ret;
+    } // hoisted_conditions
+
+
+    // The AVU groups answered with the metadata indexes (see options::metadata), and
+    // the conditions on the object ids which replace them.
+    struct indexed_avu_groups
+    {
+        std::vector<avu_group> groups;
+        std::vector<std::string> clauses;
+    };
+
+    // The conditions of a group on the attribute and the value, if it has no others.
+    auto avu_conditions(const avu_group& _g) -> std::optional<std::tuple<const ConditionExpression*, const ConditionExpression*>>
+    {
+        const ConditionExpression* attribute{};
+        const ConditionExpression* value{};
+
+        for (auto&& c : _g.conditions) {
+            const auto col = std::get<1>(resolve_column(c->column));
+
+            if ("meta_attr_name" == col) {
+                attribute = &c->expression;
+            }
+            else if ("meta_attr_value" == col) {
+                value = &c->expression;
+            }
+            else {
+                return std::nullopt;
+            }
+        }
+
+        return std::make_tuple(attribute, value);
+    } // avu_conditions
+
+    // Removes the groups which the indexes answer from "_g". The groups of a metadata
+    // table are intersected into a single list of object ids, unless the list would be
+    // longer than options::max_resolved_objects.
+    auto index_avu_groups(std::vector<avu_group>& _g, const options& _o) -> indexed_avu_groups
+    {
+        indexed_avu_groups ret;
+
+        // The indexes hold the attributes and values as they are.
+        if (!_o.metadata || _o.case_insensitive) {
+            return ret;
+        }
+
+        std::vector<std::string> meta_tables;
+        std::map<std::string, std::vector<avu_group*>> groups_by_meta_table;
+
+        for (auto&& g : _g) {
+            if (_o.metadata->find(g.meta_table) == std::end(*_o.metadata) || !avu_conditions(g)) {
+                continue;
+            }
+
+            if (table_is_not_present(meta_tables, g.meta_table)) {
+                meta_tables.push_back(g.meta_table);
+            }
+            groups_by_meta_table[g.meta_table].push_back(&g);
+        }
+
+        std::set<const avu_group*> indexed;
+
+        for (auto&& t : meta_tables) {
+            const auto& index = _o.metadata->find(t)->second;
+            const auto& groups = groups_by_meta_table[t];
+
+            const auto objects_of = [&index](const avu_group& _group) {
+                const auto [attribute, value] = *avu_conditions(_group);
+                return index.objects(attribute, value);
+            };
+
+            auto objects = objects_of(*groups[0]);
+            for (std::size_t i = 1; i < groups.size() && !objects.empty(); ++i) {
+                objects &= objects_of(*groups[i]);
+            }
+
+            if (objects.size() > _o.max_resolved_objects) {
+                continue;
+            }
+
+            const auto object_column = std::get<0>(split_link_clause(groups[0]->object_link));
+            ret.clauses.push_back(objects.empty() ? std::string{"0 = 1"}
+                                                  : fmt::format("{} IN ({})", object_column, fmt::join(objects.ids(), ", ")));
+
+            indexed.insert(std::begin(groups), std::end(groups));
+        }
+
+        std::vector<avu_group> remaining;
+
+        for (auto&& g : _g) {
+            if (indexed.count(&g)) {
+                ret.groups.push_back(std::move(g));
+            }
+            else {
+                remaining.push_back(std::move(g));
+            }
+        }
+
+        _g = std::move(remaining);
+
+        return ret;
+    } // index_avu_groups
+
+    // Returns the column of a query which only counts rows (i.e. "select COUNT(X) where ...").
+    // Such a query is answered over the counted table and the tables needed by the
+    // conditions, as COUNT(*) when X never holds NULL. Counting columns of a metadata table
+    // is not a pure count because the metadata table is the one which would be fanned out.
+    auto counted_column(const Select& _s) -> const Column*
+    {
+        if (_s.selections.size() != 1 || !_s.group_by.empty()) {
+            return nullptr;
+        }
+
+        const auto* f = boost::get<SelectFunction>(&_s.selections[0]);
+
+        if (!f || to_upper(f->name) != "COUNT" || is_meta_table(std::get<0>(resolve_column(f->column)))) {
+            return nullptr;
+        }
+
+        return &f->column;
+    } // counted_column
+
+    // The tables which connect "_tables" by the shortest chains of links from the first one.
+    // Tables which cannot be reached are still part of the result.
+    auto connecting_tables(const std::vector<std::string>& _tables) -> std::vector<std::string>
+    {
+        std::map<std::string, std::string, std::less<>> parents{{_tables[0], {}}};
+        std::vector<std::string> queue{_tables[0]};
+
+        for (std::size_t i = 0; i < queue.size(); ++i) {
+            const auto current = queue[i];
+
+            for (std::size_t j = 0; j < active_schema->link_count(); ++j) {
+                const auto l = active_schema->link(j);
+                const auto next = l.table1 == current ? l.table2 : l.table2 == current ? l.table1 : std::string_view{};
+
+                if (!next.empty() && parents.find(next) == std::end(parents) && get_table_cycle_flag(std::string{next}) == 0) {
+                    parents.emplace(std::string{next}, current);
+                    queue.emplace_back(next);
+                }
+            }
+        }
+
+        std::vector<std::string> ret;
+
+        for (auto&& t : _tables) {
+            if (parents.find(t) == std::end(parents)) {
+                ret.push_back(t);
+                continue;
+            }
+
+            for (auto p = t; !p.empty(); p = parents[p]) {
+                if (table_is_not_present(ret, p)) {
+                    ret.push_back(p);
+                }
+            }
+        }
+
+        return ret;
+    } // connecting_tables
+
     std::string
     sql(const Select& select) {
-        //log::api::info("XXXX - BEGIN SQL GENERATION");
-        fmt::print("XXXX - BEGIN SQL GENERATION\n");
+        return translate(select, options{}).sql;
+    }
+
+    std::string
+    sql(const Select& select, const options& opts) {
+        return translate(select, opts).sql;
+    }
+
+    template <typename Dialect>
+    translation
+    translate(const Select& select, const options& opts) {
+        reset_generator_state();
 
-        std::string root{"SELECT "};
+        trace_enabled = opts.trace;
+
+        // Cleared on every exit, as the explanation belongs to the caller.
+        struct explanation_scope
+        {
+            explicit explanation_scope(explanation* _e)
+            {
+                if (_e) {
+                    *_e = {};
+                }
+                active_explanation = _e;
+            }
 
-        if (!select.no_distinct) {
-            root += "DISTINCT ";
+            ~explanation_scope() { active_explanation = nullptr; }
+        } explanation_scope{opts.explain};
+
+        phase_clock phases;
+
+        //log::api::info("XXXX - BEGIN SQL GENERATION");
+        trace("XXXX - BEGIN SQL GENERATION\n");
+
+        // Every lookup of this translation sees the same schema, even if a new one is
+        // published meanwhile.
+        const schema_snapshot snapshot;
+        active_schema = &snapshot.get();
+
+        parameterize_literals = opts.parameterize;
+        active_collection_paths = opts.collection_paths;
+        max_resolved_paths = opts.max_resolved_paths;
+        case_insensitive = opts.case_insensitive;
+
+        if (parameterize_literals) {
+            literal_refs = literals(select);
+            for (std::uint32_t i = 0; i < literal_refs.size(); ++i) {
+                literal_ordinals.emplace(literal_refs[i], i);
+            }
         }
 
+        std::string root;
+
+        const auto* counted = counted_column(select);
+
+        Dialect::select(root, !select.no_distinct && !counted, opts.ordered_joins);
+
         // TODO I don't think I got this comment quite right.
         // Iterating over the columns to lookup is how we know which tables
         // to include in the FROM-clause. This also adds each column to the
@@ -701,28 +1696,450 @@ namespace irods::experimental::api::genquery
             throw std::runtime_error{"no columns selected"};
         }
 
-        const auto conds = sql(select.conditions);
+        // Every row has a value of a column which is never NULL.
+        if (counted && active_schema->column(counted->name)->not_null) {
+            sel = "COUNT(*)";
+        }
+
+        phases.lap("selections", &translation_profile::resolution_us);
+
+        auto avu_groups = collect_avu_groups(select);
+        const auto indexed = index_avu_groups(avu_groups, opts);
+        auto strategy = choose_avu_strategy(avu_groups, opts);
+
+        // A join per AVU group multiplies the rows seen by COUNT(*).
+        if (counted && avu_strategy::automatic == opts.avu && avu_strategy::join == strategy) {
+            strategy = avu_strategy::exists;
+        }
+
+        auto hoisted = hoisted_conditions(avu_groups);
+        for (auto&& c : hoisted_conditions(indexed.groups)) {
+            hoisted.push_back(c);
+        }
+
+        const auto conds = sql<Dialect>(select.conditions, hoisted);
+
+        // The subqueries and object id lists reference the object table, so it must be
+        // part of the query.
+        for (auto&& groups : {std::cref(avu_groups), std::cref(indexed.groups)}) {
+            for (auto&& g : groups.get()) {
+                if (table_is_not_present(tables, g.object_table)) {
+                    add_table_if_applicable(g.object_table);
+                }
+            }
+        }
+
+        // GROUP BY and ORDER BY columns are resolved like any other column so that
+        // their tables take part in the linkage computation below.
+        const auto group_by = sql(select.group_by.empty() ? implicit_group_by(select.selections) : select.group_by);
+        const auto order_by = counted ? std::string{} : sql(select.order_by);
 
         if (tables.empty()) {
             throw std::runtime_error{"from tables is empty"};
         }
 
+        phases.lap("conditions", &translation_profile::resolution_us);
+
+        // Links to other tables would change the number of rows being counted.
+        if (counted) {
+            linkable_tables = connecting_tables(tables);
+        }
+
         prime_from_aliases();
         compute_table_linkage(tables[0].find(" ") == std::string::npos ? tables[0] : get_table_alias(tables[0]));
+
+        if (auto* profile = translation_profiler::current(); profile) {
+            profile->linkage_depth = std::max(profile->linkage_depth, max_linkage_depth);
+        }
+
+        phases.lap("linkage", &translation_profile::linkage_us);
+
         annotate_redundant_table_aliases();
 
+        phases.lap("annotation", &translation_profile::annotation_us);
+
+        // Added after the annotation, like the subqueries below.
+        std::vector<std::string> avu_clauses;
+
+        if (avu_strategy::join == strategy) {
+            avu_clauses = sql_avu_join<Dialect>(avu_groups, from_aliases);
+        }
+
+        if (active_explanation) {
+            active_explanation->tables = tables;
+            active_explanation->strategy = strategy;
+            active_explanation->avu_groups = avu_groups.size();
+            active_explanation->indexed_avu_groups = indexed.groups.size();
+            active_explanation->visited = processed_tables;
+            active_explanation->from = from_aliases;
+        }
+
+        // The subqueries carry their own table aliases.
+        if (avu_strategy::intersect == strategy) {
+            avu_clauses = sql_avu_intersect<Dialect>(avu_groups);
+        }
+        else if (avu_strategy::exists == strategy) {
+            avu_clauses = sql_avu_exists<Dialect>(avu_groups);
+        }
+
+        where_clauses.insert(std::end(where_clauses), std::begin(avu_clauses), std::end(avu_clauses));
+        where_clauses.insert(std::end(where_clauses), std::begin(indexed.clauses), std::end(indexed.clauses));
+
         root += fmt::format("{}{}", sel, build_from_clause());
 
-        if (!conds.empty()) {
+        if (!where_clauses.empty()) {
             root += fmt::format(" WHERE {}", build_where_clause());
         }
 
+        if (!group_by.empty()) {
+            root += fmt::format(" GROUP BY {}", group_by);
+        }
+
+        if (!order_by.empty()) {
+            root += fmt::format(" ORDER BY {}", order_by);
+        }
+
+        if (opts.row_limit > 0) {
+            Dialect::limit(root, opts.row_limit);
+        }
+
         //log::api::info("XXXX - sql {}", root);
-        fmt::print("XXXX - sql [{}]\n", root);
+        trace("XXXX - sql [{}]\n", root);
+
+        if (active_explanation) {
+            for (auto&& c : where_clauses) {
+                active_explanation->where.push_back(parameterize_literals ? without_literal_markers(c) : c);
+            }
+        }
+
+        translation t;
+
+        if (parameterize_literals) {
+            bind_literals<Dialect>(root, t);
+        }
+        else {
+            t.sql = std::move(root);
+        }
+
+        for (auto&& a : from_aliases) {
+            t.cost.tables.push_back(physical_table(a));
+        }
+
+        if (avu_strategy::join != strategy) {
+            for (auto&& g : avu_groups) {
+                t.cost.subquery_tables.push_back(physical_table(get_table_alias(g.metamap_table)));
+                t.cost.subquery_tables.push_back(physical_table(get_table_alias(g.meta_table)));
+            }
+        }
+
+        phases.lap("assembly", &translation_profile::emission_us);
 
-        return root;
+        estimate_cost(select, opts.costs, t.cost);
+
+        phases.lap("cost", &translation_profile::emission_us);
+
+        return t;
     }
 
+    translation
+    translate(const Select& select, const options& opts) {
+        return translate<dialect::generic>(select, opts);
+    }
+
+    namespace
+    {
+        auto validate_column(const schema& _s, const Column& _c) -> std::optional<diagnostic>
+        {
+            const auto c = _s.column(_c.name);
+
+            if (!c) {
+                return diagnostic{error_code::unknown_column, 0, 0, _c.name, {}};
+            }
+
+            if (!_s.table(c->table)) {
+                return diagnostic{error_code::unknown_table, 0, 0, _c.name, std::string{c->table}};
+            }
+
+            return std::nullopt;
+        } // validate_column
+
+        auto contains(const GroupBy& _columns, const Column& _c) -> bool
+        {
+            return std::any_of(std::begin(_columns), std::end(_columns), [&_c](auto&& _x) { return _x.name == _c.name; });
+        } // contains
+
+        auto ungrouped(const Column& _c, std::string_view _why) -> diagnostic
+        {
+            return {error_code::invalid_grouping, 0, 0, _c.name, fmt::format("column [{}] {}", _c.name, _why)};
+        } // ungrouped
+
+        // Rejects the queries whose SQL the databases refuse: a grouped query may only
+        // select and order by the columns it groups by (besides aggregates), and a
+        // DISTINCT query may only order by the columns it selects.
+        auto validate_grouping(const Select& _s) -> std::optional<diagnostic>
+        {
+            const auto aggregates = std::any_of(std::begin(_s.selections), std::end(_s.selections), [](auto&& _x) {
+                return nullptr != boost::get<SelectFunction>(&_x);
+            });
+
+            if (aggregates || !_s.group_by.empty()) {
+                // Without a GROUP BY clause, the plain columns are the grouping key (see
+                // implicit_group_by()), so only ORDER BY can refer to other columns.
+                const auto& key = _s.group_by.empty() ? implicit_group_by(_s.selections) : _s.group_by;
+
+                for (auto&& selection : _s.selections) {
+                    if (const auto* c = boost::get<Column>(&selection); c && !contains(key, *c)) {
+                        return ungrouped(*c, "is selected but not grouped by");
+                    }
+                }
+
+                for (auto&& e : _s.order_by) {
+                    if (!contains(key, e.column)) {
+                        return ungrouped(e.column, "is ordered by but neither grouped by nor selected");
+                    }
+                }
+            }
+
+            if (!_s.no_distinct) {
+                GroupBy selected;
+
+                for (auto&& selection : _s.selections) {
+                    if (const auto* c = boost::get<Column>(&selection); c) {
+                        selected.push_back(*c);
+                    }
+                }
+
+                for (auto&& e : _s.order_by) {
+                    if (!contains(selected, e.column)) {
+                        return ungrouped(e.column, "is ordered by but not selected (the query is DISTINCT)");
+                    }
+                }
+            }
+
+            return std::nullopt;
+        } // validate_grouping
+
+        // Semantic diagnostics name the offending identifier only. Its first occurrence
+        // outside of a literal is the location within the query text.
+        auto locate(std::string_view _query, diagnostic& _d) -> void
+        {
+            const std::string_view id = _d.identifier;
+
+            if (id.empty()) {
+                return;
+            }
+
+            bool in_literal = false;
+
+            for (std::size_t i = 0; i < _query.size(); ++i) {
+                if ('\'' == _query[i]) {
+                    in_literal = !in_literal;
+                    continue;
+                }
+
+                if (in_literal || _query.compare(i, id.size(), id) != 0) {
+                    continue;
+                }
+
+                const auto end = i + id.size();
+
+                if ((i == 0 || !is_identifier_char(_query[i - 1])) &&
+                    (end == _query.size() || !is_identifier_char(_query[end])))
+                {
+                    _d.offset = static_cast<std::uint32_t>(i);
+                    _d.size = static_cast<std::uint32_t>(id.size());
+                    return;
+                }
+            }
+        } // locate
+    } // anonymous namespace
+
+    std::optional<diagnostic>
+    validate(const Select& select, const query_limits& limits) {
+        if (auto d = check_limits(select, limits); d) {
+            return d;
+        }
+
+        const schema_snapshot snapshot;
+        const auto& s = snapshot.get();
+
+        if (select.selections.empty()) {
+            return diagnostic{error_code::empty_selection, 0, 0, {}, {}};
+        }
+
+        for (auto&& selection : select.selections) {
+            const Column* column = boost::get<Column>(&selection);
+
+            if (const auto* f = boost::get<SelectFunction>(&selection); f) {
+                const auto name = to_upper(f->name);
+                const auto end = std::end(aggregate_functions);
+
+                if (std::find(std::begin(aggregate_functions), end, name) == end) {
+                    return diagnostic{error_code::unsupported_function, 0, 0, f->name, {}};
+                }
+
+                column = &f->column;
+            }
+
+            if (auto d = validate_column(s, *column); d) {
+                return d;
+            }
+        }
+
+        for (auto&& c : select.conditions) {
+            if (auto d = validate_column(s, c.column); d) {
+                return d;
+            }
+        }
+
+        for (auto&& c : select.group_by) {
+            if (auto d = validate_column(s, c); d) {
+                return d;
+            }
+        }
+
+        for (auto&& e : select.order_by) {
+            if (auto d = validate_column(s, e.column); d) {
+                return d;
+            }
+        }
+
+        return validate_grouping(select);
+    } // validate
+
+    template <typename Dialect>
+    result<translation>
+    validate_and_translate(const Select& select, const options& opts) {
+        // Validation and translation see the same schema.
+        const schema_snapshot snapshot;
+
+        if (auto d = validate(select, opts.limits); d) {
+            return std::move(*d);
+        }
+
+        // A validated query only fails to translate if the schema itself is
+        // inconsistent (e.g. a link to a table which is not defined).
+        try {
+            return admit(translate<Dialect>(select, opts), opts, [&select](const options& _o) -> result<translation> {
+                return translate<Dialect>(select, _o);
+            });
+        }
+        catch (const std::bad_alloc&) {
+            throw;
+        }
+        catch (const std::exception& e) {
+            return diagnostic{error_code::internal, 0, 0, {}, e.what()};
+        }
+    } // validate_and_translate
+
+    template <typename Dialect>
+    result<translation>
+    try_translate(const Select& select, const options& opts) {
+        if (!opts.workload && !opts.slow_log) {
+            return validate_and_translate<Dialect>(select, opts);
+        }
+
+        translation_profiler profiler{opts.slow_log};
+
+        const auto start = std::chrono::steady_clock::now();
+        auto t = validate_and_translate<Dialect>(select, opts);
+
+        if (opts.workload) {
+            opts.workload->record(select, t, std::chrono::steady_clock::now() - start);
+        }
+
+        profiler.finish({}, &select, t);
+
+        return t;
+    } // try_translate
+
+    result<translation>
+    try_translate(const Select& select, const options& opts) {
+        return try_translate<dialect::generic>(select, opts);
+    }
+
+    result<translation>
+    admit(translation t, const options& opts, const std::function<result<translation>(const options&)>& retranslate) {
+        auto decision = decide_admission(t.cost.cost, opts.admission);
+
+        // A query which would be rejected is downgraded first, if the policy allows.
+        if (t.cost.cost > opts.admission.downgrade_above) {
+            // Every AVU group goes into a subquery, the cheaper one of which is
+            // chosen as usual.
+            auto o = opts;
+            o.avu = avu_strategy::automatic;
+            o.avu_exists_threshold = 1;
+            o.admission = {};
+
+            auto d = retranslate(o);
+
+            if (!d) {
+                return d;
+            }
+
+            t = std::move(*d);
+            decision = admission_decision::downgrade;
+        }
+
+        if (t.cost.cost > opts.admission.reject_above) {
+            return diagnostic{error_code::too_expensive, 0, 0, {},
+                              fmt::format("estimated cost of the query [{:.0f}] exceeds the limit of {:.0f}",
+                                          t.cost.cost, opts.admission.reject_above)};
+        }
+
+        t.admission = decision;
+
+        return t;
+    } // admit
+
+    template <typename Dialect>
+    result<translation>
+    try_translate(std::string_view query, const options& opts) {
+        translation_profiler profiler{opts.slow_log};
+
+        auto select = wrapper::try_parse(query, opts.limits, profiler.scan_time());
+        profiler.parsed();
+
+        if (!select) {
+            result<translation> t = std::move(select).error();
+            profiler.finish(query, nullptr, t);
+            return t;
+        }
+
+        auto t = try_translate<Dialect>(*select, opts);
+
+        if (!t) {
+            locate(query, t.error());
+        }
+
+        profiler.finish(query, &*select, t);
+
+        return t;
+    } // try_translate
+
+    result<translation>
+    try_translate(std::string_view query, const options& opts) {
+        return try_translate<dialect::generic>(query, opts);
+    }
+
+    template translation translate<dialect::generic>(const Select&, const options&);
+    template translation translate<dialect::postgresql>(const Select&, const options&);
+    template translation translate<dialect::mysql>(const Select&, const options&);
+    template translation translate<dialect::oracle>(const Select&, const options&);
+    template translation translate<dialect::sqlite>(const Select&, const options&);
+
+    template result<translation> try_translate<dialect::generic>(const Select&, const options&);
+    template result<translation> try_translate<dialect::postgresql>(const Select&, const options&);
+    template result<translation> try_translate<dialect::mysql>(const Select&, const options&);
+    template result<translation> try_translate<dialect::oracle>(const Select&, const options&);
+    template result<translation> try_translate<dialect::sqlite>(const Select&, const options&);
+
+    template result<translation> try_translate<dialect::generic>(std::string_view, const options&);
+    template result<translation> try_translate<dialect::postgresql>(std::string_view, const options&);
+    template result<translation> try_translate<dialect::mysql>(std::string_view, const options&);
+    template result<translation> try_translate<dialect::oracle>(std::string_view, const options&);
+    template result<translation> try_translate<dialect::sqlite>(std::string_view, const options&);
+
 #if 0
 =======================================================================================
 ORIGINAL GENQUERY
@@ -746,4 +2163,3 @@ select distinct R_DATA_MAIN.data_name
 =======================================================================================
 #endif
 } // namespace irods::experimental::api::genquery
-
@@ -2,12 +2,157 @@
 #define IRODS_GENQUERY_SQL_HPP
 
 #include "genquery_ast_types.hpp"
+#include "genquery_avu_index.hpp"
+#include "genquery_cost.hpp"
+#include "genquery_diagnostic.hpp"
+#include "genquery_dialect.hpp"
+#include "genquery_limits.hpp"
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace irods::experimental::api::genquery
 {
+    struct explanation;
+    class path_index;
+    class slow_translation_log;
+    class workload_statistics;
+
+    // Defines how conditions on metadata (AVU) columns are expressed in SQL.
+    //
+    // An AVU group is the set of conditions which apply to the same instance of a
+    // metadata table (e.g. the Nth META_DATA_ATTR_NAME condition and the Nth
+    // META_DATA_ATTR_VALUE condition).
+    enum class avu_strategy
+    {
+        automatic, // Chooses one of the strategies below based on the number of AVU groups.
+        join,      // Adds an R_OBJT_METAMAP / R_META_MAIN pair to the FROM clause per group.
+        exists,    // Emits a correlated EXISTS subquery per group.
+        intersect  // Emits an IN subquery over the INTERSECT of the object ids of each group.
+    };
+
+    struct options
+    {
+        avu_strategy avu = avu_strategy::automatic;
+
+        // Used by avu_strategy::automatic. Queries with fewer AVU groups than
+        // "avu_exists_threshold" use joins. Queries with at least
+        // "avu_intersect_threshold" AVU groups use INTERSECT.
+        std::size_t avu_exists_threshold = 2;
+        std::size_t avu_intersect_threshold = 5;
+
+        // Emits literals as placeholders and returns their values separately.
+        bool parameterize = false;
+
+        // Compares text with =, !=, IN and LIKE regardless of case, in the form the
+        // dialect can serve from an index (e.g. LOWER(column) for an index on it).
+        // Conditions on integer columns of the schema (e.g. DATA_SIZE) are unaffected.
+        bool case_insensitive = false;
+
+        // Asks the database to join the tables in the order of the FROM clause, i.e. the
+        // order of the table linkage, where the dialect has a hint for it.
+        bool ordered_joins = false;
+
+        // Returns at most this many rows, unless zero.
+        std::size_t row_limit = 0;
+
+        // Maps collection names (COLL_NAME) to collection ids (COLL_ID). When set,
+        // BEGINNING_OF and PARENT_OF conditions on COLL_NAME are resolved with it and
+        // emitted as lists of at most "max_resolved_paths" collection ids, so the SQL
+        // reflects the index at the time of the translation. Not used when
+        // "case_insensitive" is set.
+        const path_index* collection_paths = nullptr;
+        std::size_t max_resolved_paths = 1000;
+
+        // Indexes of the metadata of the catalog (see avu_index). When set, the AVU groups
+        // on the attribute and value columns of an indexed metadata table are answered
+        // with the index and emitted as a list of at most "max_resolved_objects" object
+        // ids instead of following "avu". Not used when "case_insensitive" is set.
+        const avu_indexes* metadata = nullptr;
+        std::size_t max_resolved_objects = 1000;
+
+        // Prints the decisions of the table linkage planner to stdout.
+        bool trace = false;
+
+        // Records how the query is translated when set (see explain()).
+        explanation* explain = nullptr;
+
+        // Counts the translations of try_translate() by query shape when set.
+        workload_statistics* workload = nullptr;
+
+        // Records the translations of try_translate() which take at least the threshold of
+        // the log, with the time of each phase, when set (see translation_profiler).
+        slow_translation_log* slow_log = nullptr;
+
+        // Queries beyond these limits are rejected by validate() and try_translate().
+        query_limits limits;
+
+        // Estimates the cost of each translation, which try_translate() subjects to
+        // the admission policy.
+        cost_model costs;
+        admission_policy admission;
+    };
+
+    struct translation
+    {
+        std::string sql;
+
+        // Values of the placeholders of "sql", in order. Empty unless literals are parameterized.
+        std::vector<std::string> bind_values;
+
+        // For each placeholder, the index of its literal within literals(select).
+        // The layout is the same for every query with the same normalized text.
+        std::vector<std::uint32_t> bind_layout;
+
+        // For each placeholder, the number of literals it binds, starting at its index in
+        // "bind_layout". Only dialects which bind IN lists as arrays bind more than one;
+        // empty when every placeholder binds one literal.
+        std::vector<std::uint32_t> bind_counts;
+
+        cost_estimate cost;
+
+        // The decision of the admission policy (see try_translate()).
+        admission_decision admission = admission_decision::accept;
+    };
+
     std::string sql(const Select&);
+    std::string sql(const Select&, const options&);
+
+    // Throws std::runtime_error if the query cannot be translated. The cost of the
+    // translation is estimated, but the admission policy is not applied.
+    translation translate(const Select&, const options&);
+
+    // Checks that a query is within the limits, that every column and function of it is
+    // known and that its selections and ORDER BY are covered by its GROUP BY (or DISTINCT),
+    // so that translating it does not fail and the database accepts the SQL. Returns the
+    // first problem found.
+    std::optional<diagnostic> validate(const Select&, const query_limits& = {});
+
+    // Like translate(), but returns the reason a query cannot be translated instead of
+    // throwing, and applies the admission policy. The string overload also parses the
+    // query, and the diagnostic carries the location of the offending token within it.
+    result<translation> try_translate(const Select&, const options&);
+    result<translation> try_translate(std::string_view query, const options&);
+
+    // Translate to the SQL of a dialect (see genquery_dialect.hpp). The functions above
+    // emit dialect::generic. Instantiated for each dialect of genquery_dialect.hpp.
+    template <typename Dialect>
+    translation translate(const Select&, const options&);
+
+    template <typename Dialect>
+    result<translation> try_translate(const Select&, const options&);
+
+    template <typename Dialect>
+    result<translation> try_translate(std::string_view query, const options&);
+
+    // Applies options::admission to a translation. "retranslate" translates the same
+    // query with other options and is used to downgrade it.
+    result<translation> admit(translation, const options&, const std::function<result<translation>(const options&)>& retranslate);
 } // namespace irods::experimental::api::genquery
 
 #endif // IRODS_GENQUERY_SQL_HPP
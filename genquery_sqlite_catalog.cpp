@@ -0,0 +1,748 @@
+#include "genquery_sqlite_catalog.hpp"
+
+#include "genquery_columnar.hpp"
+#include "genquery_path_index.hpp"
+#include "genquery_schema.hpp"
+
+#include <fmt/format.h>
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cctype>
+#include <functional>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+namespace irods::experimental::api::genquery::sqlite
+{
+    namespace
+    {
+        // clang-format off
+        constexpr std::int64_t token_own    = 1200;
+        constexpr std::int64_t token_modify = 1120;
+        constexpr std::int64_t token_read   = 1050;
+        constexpr std::int64_t first_ts     = 1600000000;
+        constexpr std::size_t  attr_names   = 64;
+        // clang-format on
+
+        // Indexes of the iRODS catalog which matter to the queries GenQuery generates.
+        // An index is skipped when a site schema lacks its table or columns.
+        const std::pair<std::string_view, std::vector<std::string_view>> catalog_indexes[]{
+            {"R_COLL_MAIN", {"coll_id"}},
+            {"R_COLL_MAIN", {"coll_name"}},
+            {"R_COLL_MAIN", {"parent_coll_name", "coll_name"}},
+            {"R_DATA_MAIN", {"data_id"}},
+            {"R_DATA_MAIN", {"coll_id", "data_name"}},
+            {"R_DATA_MAIN", {"data_name"}},
+            {"R_DATA_MAIN", {"resc_id"}},
+            {"R_META_MAIN", {"meta_id"}},
+            {"R_META_MAIN", {"meta_attr_name", "meta_attr_value"}},
+            {"R_META_MAIN", {"meta_attr_value"}},
+            {"R_OBJT_METAMAP", {"object_id", "meta_id"}},
+            {"R_OBJT_METAMAP", {"meta_id"}},
+            {"R_OBJT_ACCESS", {"object_id", "user_id"}},
+            {"R_OBJT_ACCESS", {"user_id"}},
+            {"R_USER_MAIN", {"user_id"}},
+            {"R_USER_MAIN", {"user_name", "zone_name"}},
+            {"R_USER_GROUP", {"group_user_id", "user_id"}},
+            {"R_USER_GROUP", {"user_id"}},
+            {"R_RESC_MAIN", {"resc_id"}},
+            {"R_RESC_MAIN", {"resc_name"}},
+            {"R_TOKN_MAIN", {"token_namespace", "token_id"}},
+        };
+
+        auto check(database& _db, int _rc, std::string_view _what) -> void
+        {
+            if (SQLITE_OK != _rc && SQLITE_ROW != _rc && SQLITE_DONE != _rc) {
+                throw std::runtime_error{fmt::format("sqlite: {}: {}", _what, sqlite3_errmsg(_db.handle()))};
+            }
+        } // check
+
+        auto mix(std::uint64_t _x) -> std::uint64_t
+        {
+            // splitmix64
+            _x += 0x9e3779b97f4a7c15ULL;
+            _x = (_x ^ (_x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            _x = (_x ^ (_x >> 27)) * 0x94d049bb133111ebULL;
+            return _x ^ (_x >> 31);
+        } // mix
+
+        auto is_integer_column(std::string_view _column) -> bool
+        {
+            const auto ends_with = [_column](std::string_view _suffix) {
+                return _column.size() >= _suffix.size() && _column.substr(_column.size() - _suffix.size()) == _suffix;
+            };
+
+            return ends_with("_id") || ends_with("_size") || ends_with("_num") || "data_is_dirty" == _column;
+        } // is_integer_column
+
+        // The physical table behind a table name of the schema, e.g. R_META_MAIN for
+        // "r_data_meta_main". Link clauses also name tables which have no definition
+        // of their own (e.g. R_QUOTA_MAIN); those are taken as physical when upper case.
+        auto physical_table(const schema& _s, std::string_view _name) -> std::string
+        {
+            if (const auto t = _s.table(_name); t) {
+                return std::string{t->alias.substr(0, t->alias.find(' '))};
+            }
+
+            const auto upper = std::all_of(std::begin(_name), std::end(_name), [](unsigned char _c) {
+                return std::isupper(_c) || std::isdigit(_c) || '_' == _c;
+            });
+
+            return upper ? std::string{_name} : std::string{};
+        } // physical_table
+
+        using table_columns = std::map<std::string, std::set<std::string>>;
+
+        auto collect_columns(const schema& _s) -> table_columns
+        {
+            table_columns tables;
+
+            for (std::size_t i = 0; i < _s.column_count(); ++i) {
+                const auto c = _s.column_at(i);
+                if (auto t = physical_table(_s, c.table); !t.empty()) {
+                    tables[std::move(t)].emplace(c.column);
+                }
+            }
+
+            // Link clauses are "alias.column = alias.column [AND ...]".
+            for (std::size_t i = 0; i < _s.link_count(); ++i) {
+                std::string_view clause = _s.link(i).clause;
+
+                while (!clause.empty()) {
+                    const auto end = std::min(clause.find_first_of(" =()"), clause.size());
+                    const auto token = clause.substr(0, end);
+                    clause.remove_prefix(std::min(end + 1, clause.size()));
+
+                    const auto dot = token.find('.');
+                    if (std::string_view::npos == dot) {
+                        continue;
+                    }
+
+                    auto column = token.substr(dot + 1);
+                    column = column.substr(0, column.find('.'));
+
+                    if (auto t = physical_table(_s, token.substr(0, dot)); !t.empty() && !column.empty()) {
+                        tables[std::move(t)].emplace(column);
+                    }
+                }
+            }
+
+            return tables;
+        } // collect_columns
+
+        // The shape of the synthetic catalog. Collections and data objects share the
+        // object id space, as they do in iRODS: collections are 1..C and data objects
+        // follow. Every object has one owner ACL and collections have one AVU each.
+        struct layout
+        {
+            explicit layout(const catalog_options& _opts)
+                : opts{_opts}
+                , users{std::max<std::size_t>(1, _opts.users)}
+                , resources{std::max<std::size_t>(1, _opts.resources)}
+                , data_objects{_opts.data_objects}
+                , collections{std::max<std::size_t>(1, _opts.data_objects / std::max<std::size_t>(1, _opts.objects_per_collection))}
+                , avu_links{_opts.data_objects * _opts.avus_per_object}
+                , avus{std::max<std::size_t>(1, avu_links / std::max<std::size_t>(1, _opts.objects_per_avu))}
+                , acls_per_object{std::max<std::size_t>(1, _opts.acls_per_object)}
+            {
+            }
+
+            auto random(std::uint64_t _stream, std::size_t _row) const -> std::uint64_t
+            {
+                return mix(opts.seed ^ mix(_stream << 40 ^ _row));
+            }
+
+            auto user_name(std::size_t _u) const -> std::string
+            {
+                return 0 == _u ? "rods" : fmt::format("user{}", _u);
+            }
+
+            auto collection_owner(std::size_t _c) const -> std::size_t { return _c % users; }
+
+            auto collection_name(std::size_t _c) const -> std::string
+            {
+                return fmt::format("/{}/home/{}/coll{}", opts.zone, user_name(collection_owner(_c)), _c);
+            }
+
+            auto data_collection(std::size_t _d) const -> std::size_t
+            {
+                return std::min(collections - 1, _d / std::max<std::size_t>(1, opts.objects_per_collection));
+            }
+
+            auto data_id(std::size_t _d) const -> std::int64_t { return static_cast<std::int64_t>(collections + 1 + _d); }
+
+            // R_OBJT_METAMAP: avus_per_object rows per data object, then one per collection.
+            auto metamap_rows() const -> std::size_t { return avu_links + collections; }
+
+            auto metamap_object(std::size_t _r) const -> std::int64_t
+            {
+                return _r < avu_links ? data_id(_r / opts.avus_per_object) : static_cast<std::int64_t>(_r - avu_links + 1);
+            }
+
+            // R_OBJT_ACCESS: acls_per_object rows per data object, the first of which is
+            // the owner's, then the owner of each collection.
+            auto access_rows() const -> std::size_t { return data_objects * acls_per_object + collections; }
+
+            auto access_object(std::size_t _r) const -> std::int64_t
+            {
+                const auto n = data_objects * acls_per_object;
+                return _r < n ? data_id(_r / acls_per_object) : static_cast<std::int64_t>(_r - n + 1);
+            }
+
+            auto access_owner(std::size_t _r) const -> std::size_t
+            {
+                const auto n = data_objects * acls_per_object;
+                return collection_owner(_r < n ? data_collection(_r / acls_per_object) : _r - n);
+            }
+
+            auto access_is_owner(std::size_t _r) const -> bool
+            {
+                const auto n = data_objects * acls_per_object;
+                return _r >= n || 0 == _r % acls_per_object;
+            }
+
+            const catalog_options& opts;
+            std::size_t users;
+            std::size_t resources;
+            std::size_t data_objects;
+            std::size_t collections;
+            std::size_t avu_links;
+            std::size_t avus;
+            std::size_t acls_per_object;
+        };
+
+        using value = std::function<void(statement&, int, std::size_t)>;
+
+        auto integer(std::function<std::int64_t(std::size_t)> _f) -> value
+        {
+            return [f = std::move(_f)](statement& _s, int _i, std::size_t _row) { _s.bind(_i, f(_row)); };
+        } // integer
+
+        auto text(std::function<std::string(std::size_t)> _f) -> value
+        {
+            return [f = std::move(_f)](statement& _s, int _i, std::size_t _row) { _s.bind(_i, f(_row)); };
+        } // text
+
+        auto constant(std::string _s) -> value
+        {
+            return [s = std::move(_s)](statement& _st, int _i, std::size_t) { _st.bind(_i, std::string_view{s}); };
+        } // constant
+
+        auto row_id() -> value
+        {
+            return integer([](std::size_t _r) { return static_cast<std::int64_t>(_r + 1); });
+        } // row_id
+
+        // The number of rows generated for a table. Zero for the tables the benchmark
+        // leaves empty.
+        auto row_count(const layout& _l, std::string_view _table) -> std::size_t
+        {
+            // clang-format off
+            if ("R_ZONE_MAIN" == _table)    { return 1; }
+            if ("R_USER_MAIN" == _table)    { return _l.users; }
+            if ("R_USER_GROUP" == _table)   { return _l.users; }
+            if ("R_RESC_MAIN" == _table)    { return _l.resources; }
+            if ("R_COLL_MAIN" == _table)    { return _l.collections; }
+            if ("R_DATA_MAIN" == _table)    { return _l.data_objects; }
+            if ("R_META_MAIN" == _table)    { return _l.avus; }
+            if ("R_OBJT_METAMAP" == _table) { return _l.metamap_rows(); }
+            if ("R_OBJT_ACCESS" == _table)  { return _l.access_rows(); }
+            if ("R_TOKN_MAIN" == _table)    { return 3; }
+            // clang-format on
+
+            return 0;
+        } // row_count
+
+        auto column_value(const layout& _l, std::string_view _table, std::string_view _column) -> value
+        {
+            if ("create_ts" == _column || "modify_ts" == _column) {
+                return text([](std::size_t _r) { return fmt::format("{:011}", first_ts + static_cast<std::int64_t>(_r)); });
+            }
+
+            if ("zone_name" == _column || "coll_owner_zone" == _column || "data_owner_zone" == _column) {
+                return constant(_l.opts.zone);
+            }
+
+            if ("R_ZONE_MAIN" == _table) {
+                if ("zone_id" == _column)        { return row_id(); }
+                if ("zone_type_name" == _column) { return constant("local"); }
+            }
+            else if ("R_USER_MAIN" == _table) {
+                if ("user_id" == _column)        { return row_id(); }
+                if ("user_name" == _column)      { return text([&_l](std::size_t _r) { return _l.user_name(_r); }); }
+                if ("user_type_name" == _column) {
+                    return text([](std::size_t _r) { return std::string{0 == _r ? "rodsadmin" : "rodsuser"}; });
+                }
+            }
+            else if ("R_USER_GROUP" == _table) {
+                // Every user is the only member of its own group.
+                if ("group_user_id" == _column || "user_id" == _column) { return row_id(); }
+            }
+            else if ("R_RESC_MAIN" == _table) {
+                if ("resc_id" == _column)        { return row_id(); }
+                if ("resc_name" == _column)      { return text([](std::size_t _r) { return fmt::format("resc{}", _r); }); }
+                if ("resc_type_name" == _column) { return constant("unixfilesystem"); }
+                if ("resc_class_name" == _column) { return constant("cache"); }
+                if ("resc_net" == _column)       { return constant("localhost"); }
+                if ("resc_status" == _column)    { return constant("up"); }
+                if ("resc_def_path" == _column) {
+                    return text([](std::size_t _r) { return fmt::format("/var/lib/irods/Vault{}", _r); });
+                }
+            }
+            else if ("R_COLL_MAIN" == _table) {
+                if ("coll_id" == _column)   { return row_id(); }
+                if ("coll_name" == _column) { return text([&_l](std::size_t _r) { return _l.collection_name(_r); }); }
+                if ("parent_coll_name" == _column) {
+                    return text([&_l](std::size_t _r) {
+                        return fmt::format("/{}/home/{}", _l.opts.zone, _l.user_name(_l.collection_owner(_r)));
+                    });
+                }
+                if ("coll_owner_name" == _column) {
+                    return text([&_l](std::size_t _r) { return _l.user_name(_l.collection_owner(_r)); });
+                }
+            }
+            else if ("R_DATA_MAIN" == _table) {
+                if ("data_id" == _column)  { return integer([&_l](std::size_t _r) { return _l.data_id(_r); }); }
+                if ("coll_id" == _column) {
+                    return integer([&_l](std::size_t _r) { return static_cast<std::int64_t>(_l.data_collection(_r) + 1); });
+                }
+                if ("data_name" == _column) { return text([](std::size_t _r) { return fmt::format("file{}.dat", _r); }); }
+                if ("data_type_name" == _column) { return constant("generic"); }
+                if ("data_size" == _column) {
+                    return integer([&_l](std::size_t _r) { return static_cast<std::int64_t>(_l.random(1, _r) % (1u << 30)); });
+                }
+                if ("resc_id" == _column) {
+                    return integer([&_l](std::size_t _r) { return static_cast<std::int64_t>(_r % _l.resources + 1); });
+                }
+                if ("resc_name" == _column || "resc_hier" == _column) {
+                    return text([&_l](std::size_t _r) { return fmt::format("resc{}", _r % _l.resources); });
+                }
+                if ("data_path" == _column) {
+                    return text([&_l](std::size_t _r) {
+                        return fmt::format("/var/lib/irods/Vault{}/home/{}/coll{}/file{}.dat",
+                                           _r % _l.resources,
+                                           _l.user_name(_l.collection_owner(_l.data_collection(_r))),
+                                           _l.data_collection(_r),
+                                           _r);
+                    });
+                }
+                if ("data_owner_name" == _column) {
+                    return text([&_l](std::size_t _r) { return _l.user_name(_l.collection_owner(_l.data_collection(_r))); });
+                }
+                if ("data_is_dirty" == _column) { return integer([](std::size_t) { return 1; }); }
+                if ("data_checksum" == _column) {
+                    return text([&_l](std::size_t _r) { return fmt::format("sha2:{:016x}", _l.random(2, _r)); });
+                }
+            }
+            else if ("R_META_MAIN" == _table) {
+                if ("meta_id" == _column)         { return row_id(); }
+                if ("meta_attr_name" == _column)  { return text([](std::size_t _r) { return fmt::format("attr{}", _r % attr_names); }); }
+                if ("meta_attr_value" == _column) { return text([](std::size_t _r) { return fmt::format("value{}", _r / attr_names); }); }
+                if ("meta_attr_unit" == _column) {
+                    return text([](std::size_t _r) { return std::string{0 == _r % 4 ? "unit" : ""}; });
+                }
+            }
+            else if ("R_OBJT_METAMAP" == _table) {
+                if ("object_id" == _column) { return integer([&_l](std::size_t _r) { return _l.metamap_object(_r); }); }
+                if ("meta_id" == _column) {
+                    return integer([&_l](std::size_t _r) { return static_cast<std::int64_t>(_l.random(3, _r) % _l.avus + 1); });
+                }
+            }
+            else if ("R_OBJT_ACCESS" == _table) {
+                if ("object_id" == _column) { return integer([&_l](std::size_t _r) { return _l.access_object(_r); }); }
+                if ("user_id" == _column) {
+                    return integer([&_l](std::size_t _r) {
+                        const auto u = _l.access_is_owner(_r) ? _l.access_owner(_r) : _l.random(4, _r) % _l.users;
+                        return static_cast<std::int64_t>(u + 1);
+                    });
+                }
+                // Both spellings appear in the link clauses.
+                if ("access_type_id" == _column || "access_typ_id" == _column) {
+                    return integer([&_l](std::size_t _r) {
+                        return _l.access_is_owner(_r) ? token_own : (0 == _r % 2 ? token_read : token_modify);
+                    });
+                }
+            }
+            else if ("R_TOKN_MAIN" == _table) {
+                if ("token_namespace" == _column) { return constant("access_type"); }
+                if ("token_id" == _column) {
+                    return integer([](std::size_t _r) { return std::array{token_read, token_modify, token_own}[_r]; });
+                }
+                if ("token_name" == _column) {
+                    return text([](std::size_t _r) { return std::string{std::array{"read_object", "modify_object", "own"}[_r]}; });
+                }
+            }
+
+            if (is_integer_column(_column)) {
+                return integer([](std::size_t) { return 0; });
+            }
+
+            return constant("");
+        } // column_value
+
+        auto fill_table(database& _db, const layout& _l, const std::string& _table, const std::set<std::string>& _columns)
+            -> std::size_t
+        {
+            const auto rows = row_count(_l, _table);
+            if (0 == rows) {
+                return 0;
+            }
+
+            std::string columns;
+            std::string placeholders;
+            std::vector<value> values;
+
+            for (auto&& c : _columns) {
+                if (!values.empty()) {
+                    columns += ", ";
+                    placeholders += ", ";
+                }
+
+                columns += c;
+                placeholders += '?';
+                values.push_back(column_value(_l, _table, c));
+            }
+
+            statement insert{_db, fmt::format("insert into {} ({}) values ({})", _table, columns, placeholders)};
+
+            for (std::size_t r = 0; r < rows; ++r) {
+                for (std::size_t i = 0; i < values.size(); ++i) {
+                    values[i](insert, static_cast<int>(i + 1), r);
+                }
+
+                insert.step();
+                insert.reset();
+            }
+
+            return rows;
+        } // fill_table
+    } // anonymous namespace
+
+    database::database(const std::string& _path)
+        : _db{}
+        , _deadline{}
+    {
+        if (const auto rc = sqlite3_open(_path.c_str(), &_db); SQLITE_OK != rc) {
+            const std::string msg = _db ? sqlite3_errmsg(_db) : sqlite3_errstr(rc);
+            sqlite3_close(_db);
+            throw std::runtime_error{fmt::format("sqlite: cannot open [{}]: {}", _path, msg)};
+        }
+    }
+
+    database::~database()
+    {
+        sqlite3_close(_db);
+    }
+
+    void database::execute(std::string_view _sql)
+    {
+        const std::string sql{_sql};
+        char* error{};
+
+        if (SQLITE_OK != sqlite3_exec(_db, sql.c_str(), nullptr, nullptr, &error)) {
+            const std::string msg = error ? error : "unknown error";
+            sqlite3_free(error);
+            throw std::runtime_error{fmt::format("sqlite: {}", msg)};
+        }
+    } // execute
+
+    void database::set_deadline(std::optional<std::chrono::steady_clock::time_point> _t)
+    {
+        _deadline = _t;
+
+        if (!_deadline) {
+            sqlite3_progress_handler(_db, 0, nullptr, nullptr);
+            return;
+        }
+
+        constexpr int instructions = 10000;
+
+        sqlite3_progress_handler(_db, instructions, [](void* _p) -> int {
+            const auto* deadline = static_cast<const std::chrono::steady_clock::time_point*>(_p);
+            return std::chrono::steady_clock::now() >= *deadline;
+        }, &*_deadline);
+    } // set_deadline
+
+    bool database::has_table(std::string_view _name)
+    {
+        statement s{*this, "select 1 from sqlite_master where type = 'table' and name = ?"};
+        s.bind(1, _name);
+        return s.step();
+    } // has_table
+
+    statement::statement(database& _db, std::string_view _sql)
+        : _db{&_db}
+        , _stmt{}
+    {
+        const auto rc = sqlite3_prepare_v2(_db.handle(), _sql.data(), static_cast<int>(_sql.size()), &_stmt, nullptr);
+        check(_db, rc, "prepare");
+    }
+
+    statement::~statement()
+    {
+        sqlite3_finalize(_stmt);
+    }
+
+    void statement::bind(int _index, std::int64_t _value)
+    {
+        check(*_db, sqlite3_bind_int64(_stmt, _index, _value), "bind");
+    } // bind
+
+    void statement::bind(int _index, std::string_view _value)
+    {
+        check(*_db, sqlite3_bind_text(_stmt, _index, _value.data(), static_cast<int>(_value.size()), SQLITE_TRANSIENT), "bind");
+    } // bind
+
+    bool statement::step()
+    {
+        const auto rc = sqlite3_step(_stmt);
+        check(*_db, rc, "step");
+        return SQLITE_ROW == rc;
+    } // step
+
+    void statement::reset()
+    {
+        sqlite3_reset(_stmt);
+        sqlite3_clear_bindings(_stmt);
+    } // reset
+
+    int statement::column_count() const
+    {
+        return sqlite3_column_count(_stmt);
+    } // column_count
+
+    std::string_view statement::column_text(int _index) const
+    {
+        const auto* p = reinterpret_cast<const char*>(sqlite3_column_text(_stmt, _index));
+        return p ? std::string_view{p, static_cast<std::size_t>(sqlite3_column_bytes(_stmt, _index))} : std::string_view{};
+    } // column_text
+
+    std::vector<table_rows> create_catalog(database& _db, const schema& _s, const catalog_options& _opts)
+    {
+        const auto tables = collect_columns(_s);
+        const layout l{_opts};
+
+        _db.execute("pragma journal_mode = off; pragma synchronous = off; begin");
+
+        std::vector<table_rows> filled;
+
+        for (auto&& [table, columns] : tables) {
+            std::string definition;
+            for (auto&& c : columns) {
+                if (!definition.empty()) { definition += ", "; }
+                definition += fmt::format("{} {}", c, is_integer_column(c) ? "integer" : "text");
+            }
+
+            _db.execute(fmt::format("create table {} ({})", table, definition));
+            filled.push_back({table, fill_table(_db, l, table, columns)});
+        }
+
+        std::size_t n = 0;
+        for (auto&& [table, columns] : catalog_indexes) {
+            const auto t = tables.find(std::string{table});
+            if (std::end(tables) == t) {
+                continue;
+            }
+
+            const auto present = std::all_of(std::begin(columns), std::end(columns), [&t](auto _c) {
+                return t->second.count(std::string{_c}) > 0;
+            });
+
+            if (present) {
+                _db.execute(fmt::format("create index idx_catalog_{} on {} ({})", n++, table, fmt::join(columns, ", ")));
+            }
+        }
+
+        // Statistics, so that SQLite plans with the row counts a production catalog
+        // would report.
+        _db.execute("commit; analyze");
+
+        return filled;
+    } // create_catalog
+
+    std::shared_ptr<const catalog_snapshot> load_snapshot(database& _db)
+    {
+        catalog_snapshot_builder builder;
+
+        std::vector<std::string> tables;
+        {
+            statement s{_db, "select name from sqlite_master where type = 'table' and name not like 'sqlite_%'"};
+            while (s.step()) {
+                tables.emplace_back(s.column_text(0));
+            }
+        }
+
+        for (auto&& t : tables) {
+            std::vector<catalog_snapshot_builder::column_spec> columns;
+            {
+                statement s{_db, fmt::format("pragma table_info({})", t)};
+                while (s.step()) {
+                    const auto integer = "integer" == s.column_text(2) || "INTEGER" == s.column_text(2);
+                    columns.push_back({std::string{s.column_text(1)}, integer ? column_type::integer : column_type::text});
+                }
+            }
+
+            if (columns.empty()) {
+                continue;
+            }
+
+            std::string names;
+            for (auto&& c : columns) {
+                if (!names.empty()) { names += ", "; }
+                names += c.name;
+            }
+
+            const auto n = columns.size();
+            builder.add_table(t, std::move(columns));
+
+            statement s{_db, fmt::format("select {} from {}", names, t)};
+            std::vector<std::string_view> values(n);
+
+            while (s.step()) {
+                for (std::size_t i = 0; i < n; ++i) {
+                    values[i] = s.column_text(static_cast<int>(i));
+                }
+                builder.add_row(t, values);
+            }
+        }
+
+        return builder.build();
+    } // load_snapshot
+
+    path_index load_collection_paths(database& _db, const schema& _s)
+    {
+        const auto name = _s.column("COLL_NAME");
+        const auto id = _s.column("COLL_ID");
+        const auto id_column = name && id ? _s.linked_column(*id, name->table) : std::nullopt;
+
+        if (!id_column) {
+            throw std::runtime_error{"sqlite: the schema does not link COLL_NAME with COLL_ID"};
+        }
+
+        path_index paths;
+
+        statement s{_db, fmt::format("select {}, {} from {}", name->column, *id_column, physical_table(_s, name->table))};
+        while (s.step()) {
+            paths.insert(s.column_text(0), std::strtoll(std::string{s.column_text(1)}.c_str(), nullptr, 10));
+        }
+
+        return paths;
+    } // load_collection_paths
+
+    avu_indexes load_metadata(database& _db, const schema& _s)
+    {
+        // The only link to a table, as the translator requires of the metadata tables.
+        const auto link_to = [&_s](std::string_view _table) -> std::optional<link_definition> {
+            std::optional<link_definition> link;
+
+            for (std::size_t i = 0; i < _s.link_count(); ++i) {
+                if (_s.link(i).table2 != _table) {
+                    continue;
+                }
+
+                if (link) {
+                    return std::nullopt;
+                }
+
+                link = _s.link(i);
+            }
+
+            return link;
+        };
+
+        avu_indexes indexes;
+
+        for (std::size_t i = 0; i < _s.table_count(); ++i) {
+            const auto meta = _s.table_at(i);
+
+            if (meta.alias.rfind("R_META_MAIN ", 0) != 0) {
+                continue;
+            }
+
+            const auto meta_link = link_to(meta.name);
+            if (!meta_link) {
+                continue;
+            }
+
+            const auto object_link = link_to(meta_link->table1);
+            if (!object_link) {
+                continue;
+            }
+
+            const auto metamap = _s.table(meta_link->table1);
+            const auto object = _s.table(object_link->table1);
+            if (!metamap || !object) {
+                continue;
+            }
+
+            const auto object_column = object_link->clause.substr(0, object_link->clause.find(" = "));
+            auto& index = indexes[std::string{meta.name}];
+
+            statement s{_db, fmt::format("select {0}, {1}.meta_attr_name, {1}.meta_attr_value from {2}, {3}, {4} where {5} and {6}",
+                                         object_column, meta.name, metamap->alias, meta.alias, object->alias,
+                                         meta_link->clause, object_link->clause)};
+            while (s.step()) {
+                index.insert(std::strtoll(std::string{s.column_text(0)}.c_str(), nullptr, 10), s.column_text(1), s.column_text(2));
+            }
+        }
+
+        return indexes;
+    } // load_metadata
+
+    std::vector<std::string> query_plan(database& _db, std::string_view _sql)
+    {
+        statement s{_db, fmt::format("explain query plan {}", _sql)};
+
+        // Rows are (id, parent, notused, detail), parents before their children.
+        std::map<std::string, std::size_t> depth;
+        std::vector<std::string> plan;
+
+        while (s.step()) {
+            const auto parent = depth.find(std::string{s.column_text(1)});
+            const auto d = std::end(depth) == parent ? 0 : parent->second + 1;
+
+            depth[std::string{s.column_text(0)}] = d;
+            plan.push_back(std::string(2 * d, ' ') + std::string{s.column_text(3)});
+        }
+
+        return plan;
+    } // query_plan
+
+    shard_executor shard_databases(std::vector<std::string> _paths)
+    {
+        return [paths = std::move(_paths)](std::size_t _shard, const translation& _t, const std::function<bool(row)>& _sink) {
+            if (_shard >= paths.size()) {
+                throw std::runtime_error{fmt::format("no database for shard {}", _shard)};
+            }
+
+            database db{paths[_shard]};
+
+            // The catalog is compared with LIKE as in PostgreSQL.
+            db.execute("pragma case_sensitive_like = on");
+
+            statement s{db, _t.sql};
+
+            for (std::size_t i = 0; i < _t.bind_values.size(); ++i) {
+                s.bind(static_cast<int>(i + 1), _t.bind_values[i]);
+            }
+
+            while (s.step()) {
+                row r;
+                r.reserve(s.column_count());
+
+                for (int i = 0; i < s.column_count(); ++i) {
+                    r.emplace_back(s.column_text(i));
+                }
+
+                if (!_sink(std::move(r))) {
+                    return;
+                }
+            }
+        };
+    } // shard_databases
+} // namespace irods::experimental::api::genquery::sqlite
@@ -0,0 +1,133 @@
+#ifndef IRODS_GENQUERY_SQLITE_CATALOG_HPP
+#define IRODS_GENQUERY_SQLITE_CATALOG_HPP
+
+#include "genquery_avu_index.hpp"
+#include "genquery_federation.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace irods::experimental::api::genquery
+{
+    class catalog_snapshot;
+    class path_index;
+    class schema;
+
+    // A stand-in for the iRODS catalog in SQLite, used to measure how the generated SQL
+    // executes. Not part of libgenquery.
+    namespace sqlite
+    {
+        class database
+        {
+        public:
+            // Opens or creates the database at "path" (":memory:" for a private one).
+            explicit database(const std::string& path);
+            ~database();
+
+            database(const database&) = delete;
+            auto operator=(const database&) -> database& = delete;
+
+            void execute(std::string_view sql);
+
+            bool has_table(std::string_view name);
+
+            // Statements still running at the deadline fail with "interrupted".
+            void set_deadline(std::optional<std::chrono::steady_clock::time_point>);
+
+            sqlite3* handle() const noexcept { return _db; }
+
+        private:
+            sqlite3* _db;
+            std::optional<std::chrono::steady_clock::time_point> _deadline;
+        };
+
+        class statement
+        {
+        public:
+            statement(database&, std::string_view sql);
+            ~statement();
+
+            statement(const statement&) = delete;
+            auto operator=(const statement&) -> statement& = delete;
+
+            // Binds parameters by position, starting at 1.
+            void bind(int index, std::int64_t value);
+            void bind(int index, std::string_view value);
+
+            // Returns true while a row is available.
+            bool step();
+            void reset();
+
+            int column_count() const;
+            std::string_view column_text(int index) const;
+
+            sqlite3_stmt* handle() const noexcept { return _stmt; }
+
+        private:
+            database* _db;
+            sqlite3_stmt* _stmt;
+        };
+
+        // Rows generated for each kind of object. AVUs are shared between objects the
+        // way identical AVUs are in a real catalog, so R_META_MAIN has fewer rows than
+        // R_OBJT_METAMAP.
+        struct catalog_options
+        {
+            std::size_t data_objects = 100000;
+            std::size_t objects_per_collection = 100;
+            std::size_t avus_per_object = 4;
+            std::size_t objects_per_avu = 4;
+            std::size_t acls_per_object = 2;
+            std::size_t users = 100;
+            std::size_t resources = 8;
+            std::uint64_t seed = 1;
+
+            // The zone of the catalog, which holds the collections under "/<zone>".
+            std::string zone = "tempZone";
+        };
+
+        struct table_rows
+        {
+            std::string table;
+            std::size_t rows;
+        };
+
+        // Creates the physical tables of the schema, with the columns named by its
+        // column definitions and link clauses, and fills the collections, data objects,
+        // AVUs, ACLs, users, resources and access tokens. The other tables are left
+        // empty. Indexes modelled on the iRODS catalog are created after the rows are
+        // inserted. Returns the number of rows inserted per table.
+        std::vector<table_rows> create_catalog(database&, const schema&, const catalog_options&);
+
+        // Copies every table of the database into a columnar snapshot. Columns declared
+        // as integer become column_type::integer.
+        std::shared_ptr<const catalog_snapshot> load_snapshot(database&);
+
+        // Indexes the collection names (COLL_NAME) of the catalog with their ids
+        // (COLL_ID), for options::collection_paths.
+        path_index load_collection_paths(database&, const schema&);
+
+        // Indexes the AVUs of each kind of object by metadata table of the schema, for
+        // options::metadata.
+        avu_indexes load_metadata(database&, const schema&);
+
+        // The lines of EXPLAIN QUERY PLAN, indented by depth.
+        std::vector<std::string> query_plan(database&, std::string_view sql);
+
+        // Runs the statements of a federated query (see run_federated()) on the databases
+        // at "paths", one per shard in the order of the shards given to federate(). Each
+        // statement opens its database on its own thread.
+        shard_executor shard_databases(std::vector<std::string> paths);
+    } // namespace sqlite
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_SQLITE_CATALOG_HPP
@@ -3,6 +3,10 @@
 
 #include "genquery_ast_types.hpp"
 
+#include <type_traits>
+#include <variant>
+#include <vector>
+
 namespace irods::experimental::api::genquery
 {
     template <typename T>
@@ -129,10 +133,54 @@ namespace irods::experimental::api::genquery
         return os << "begin_of '" << beginning_of.string_literal << "'";
     }
 
+    // Writes the expression tree with an explicit stack, so that the depth of the tree
+    // does not translate into native stack depth.
     template <typename T>
     T&
     operator<<(T& os, const Condition& condition) {
-        return os << condition.column << " " << condition.expression;
+        using item = std::variant<const ConditionExpression*, const char*>;
+
+        os << condition.column << " ";
+
+        std::vector<item> stack{&condition.expression};
+
+        while (!stack.empty()) {
+            const auto top = stack.back();
+            stack.pop_back();
+
+            if (const auto* text = std::get_if<const char*>(&top); text) {
+                os << *text;
+                continue;
+            }
+
+            const auto& e = *std::get<const ConditionExpression*>(top);
+
+            if (const auto* op = boost::get<ConditionOperator_Or>(&e); op) {
+                os << "(";
+                stack.insert(std::end(stack), {")", &op->right, " || ", &op->left});
+            }
+            else if (const auto* op = boost::get<ConditionOperator_And>(&e); op) {
+                os << "(";
+                stack.insert(std::end(stack), {")", &op->right, " && ", &op->left});
+            }
+            else if (const auto* op = boost::get<ConditionOperator_Not>(&e); op) {
+                os << "not ";
+                stack.push_back(&op->expression);
+            }
+            else {
+                boost::apply_visitor([&os](const auto& _leaf) {
+                    using U = std::decay_t<decltype(_leaf)>;
+                    if constexpr (!std::is_same_v<U, ConditionOperator_Or> &&
+                                  !std::is_same_v<U, ConditionOperator_And> &&
+                                  !std::is_same_v<U, ConditionOperator_Not>)
+                    {
+                        os << _leaf;
+                    }
+                }, e);
+            }
+        }
+
+        return os;
     }
 
     template <typename T>
@@ -147,6 +195,36 @@ namespace irods::experimental::api::genquery
         return os;
     }
 
+    template <typename T>
+    T&
+    operator<<(T& os, const GroupBy& group_by) {
+        for (auto it = group_by.cbegin(); it != group_by.cend(); ++it) {
+            os << *it;
+            if (it+1 != group_by.cend()) {
+                os << ", ";
+            }
+        }
+        return os;
+    }
+
+    template <typename T>
+    T&
+    operator<<(T& os, const SortExpression& sort_expression) {
+        return os << sort_expression.column << (sort_expression.ascending_order ? " asc" : " desc");
+    }
+
+    template <typename T>
+    T&
+    operator<<(T& os, const OrderBy& order_by) {
+        for (auto it = order_by.cbegin(); it != order_by.cend(); ++it) {
+            os << *it;
+            if (it+1 != order_by.cend()) {
+                os << ", ";
+            }
+        }
+        return os;
+    }
+
     template <typename T>
     T&
     operator<<(T& os, const Select& select) {
@@ -155,6 +233,14 @@ namespace irods::experimental::api::genquery
             os << " where ";
             os << select.conditions;
         }
+        if (select.group_by.size() > 0) {
+            os << " group by ";
+            os << select.group_by;
+        }
+        if (select.order_by.size() > 0) {
+            os << " order by ";
+            os << select.order_by;
+        }
         return os;
     }
 } // namespace irods::experimental::api::genquery
@@ -0,0 +1,445 @@
+#include "genquery_translation_cache.hpp"
+
+#include "genquery_normalize.hpp"
+#include "genquery_schema.hpp"
+#include "genquery_slow_log.hpp"
+#include "genquery_workload.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        // clang-format off
+        constexpr std::uint32_t cache_magic   = 0x43545147; // "GQTC"
+        constexpr std::uint32_t cache_version = 2;
+        constexpr std::size_t   header_size   = 8;
+        constexpr std::size_t   entry_header  = 20;
+        // clang-format on
+
+        auto put_u32(std::string& _b, std::uint32_t _v) -> void
+        {
+            for (int i = 0; i < 4; ++i) {
+                _b += static_cast<char>((_v >> (8 * i)) & 0xff);
+            }
+        } // put_u32
+
+        auto get_u32(const unsigned char* _p) -> std::uint32_t
+        {
+            return static_cast<std::uint32_t>(_p[0]) |
+                   static_cast<std::uint32_t>(_p[1]) << 8 |
+                   static_cast<std::uint32_t>(_p[2]) << 16 |
+                   static_cast<std::uint32_t>(_p[3]) << 24;
+        } // get_u32
+
+        // FNV-1a
+        auto checksum(const unsigned char* _p, std::size_t _n) -> std::uint32_t
+        {
+            std::uint32_t h = 2166136261u;
+            for (std::size_t i = 0; i < _n; ++i) {
+                h = (h ^ _p[i]) * 16777619u;
+            }
+            return h;
+        } // checksum
+
+        // The tables of a cost estimate, e.g. "R_DATA_MAIN R_COLL_MAIN|R_OBJT_METAMAP R_META_MAIN".
+        auto make_plan(const cost_estimate& _c) -> std::string
+        {
+            return fmt::format("{}|{}", fmt::join(_c.tables, " "), fmt::join(_c.subquery_tables, " "));
+        } // make_plan
+
+        auto read_plan(std::string_view _plan, cost_estimate& _c) -> void
+        {
+            const auto split = [](std::string_view _s, std::vector<std::string>& _out) {
+                while (!_s.empty()) {
+                    const auto p = std::min(_s.find(' '), _s.size());
+                    _out.emplace_back(_s.substr(0, p));
+                    _s.remove_prefix(std::min(p + 1, _s.size()));
+                }
+            };
+
+            const auto bar = std::min(_plan.find('|'), _plan.size());
+            split(_plan.substr(0, bar), _c.tables);
+            split(_plan.substr(std::min(bar + 1, _plan.size())), _c.subquery_tables);
+        } // read_plan
+
+        auto make_entry(std::string_view _key, const translation& _t, std::string_view _plan) -> std::string
+        {
+            std::string payload{_key};
+            payload += _t.sql;
+            for (auto&& l : _t.bind_layout) {
+                put_u32(payload, l);
+            }
+            payload += _plan;
+
+            std::string e;
+            e.reserve(entry_header + payload.size());
+            put_u32(e, static_cast<std::uint32_t>(_key.size()));
+            put_u32(e, static_cast<std::uint32_t>(_t.sql.size()));
+            put_u32(e, static_cast<std::uint32_t>(_t.bind_layout.size()));
+            put_u32(e, static_cast<std::uint32_t>(_plan.size()));
+            put_u32(e, checksum(reinterpret_cast<const unsigned char*>(payload.data()), payload.size()));
+            e += payload;
+
+            return e;
+        } // make_entry
+
+        auto write_all(int _fd, const std::string& _b) -> void
+        {
+            for (std::size_t n = 0; n < _b.size();) {
+                const auto r = ::write(_fd, _b.data() + n, _b.size() - n);
+                if (r < 0) {
+                    if (EINTR == errno) {
+                        continue;
+                    }
+                    throw std::system_error{errno, std::generic_category(), "translation cache: write failed"};
+                }
+                n += static_cast<std::size_t>(r);
+            }
+        } // write_all
+
+        auto header() -> std::string
+        {
+            std::string h;
+            put_u32(h, cache_magic);
+            put_u32(h, cache_version);
+            return h;
+        } // header
+
+        // Excludes the other processes which use the cache file. Appends and the repairs of
+        // load() happen under this lock, so a partial entry seen under it is torn rather
+        // than still being written.
+        class file_lock
+        {
+        public:
+            explicit file_lock(int _fd)
+                : _fd{_fd}
+            {
+                while (::flock(_fd, LOCK_EX) < 0) {
+                    if (EINTR != errno) {
+                        throw std::system_error{errno, std::generic_category(), "translation cache: flock failed"};
+                    }
+                }
+            }
+
+            ~file_lock() { ::flock(_fd, LOCK_UN); }
+
+            file_lock(const file_lock&) = delete;
+            auto operator=(const file_lock&) -> file_lock& = delete;
+
+        private:
+            int _fd;
+        };
+    } // anonymous namespace
+
+    std::string cache_key(const Select& _s, const options& _opts)
+    {
+        const schema_snapshot snapshot;
+
+        return fmt::format("{:016x}:{}:{}:{}:{:d}:{:d}:{}|{}",
+                           snapshot.get().fingerprint(),
+                           static_cast<int>(_opts.avu),
+                           _opts.avu_exists_threshold,
+                           _opts.avu_intersect_threshold,
+                           _opts.case_insensitive,
+                           _opts.ordered_joins,
+                           _opts.row_limit,
+                           normalize(_s));
+    } // cache_key
+
+    translation_cache::translation_cache(const std::string& path)
+        : _fd{::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644)}
+        , _mapping{nullptr}
+        , _mapping_size{}
+        , _hits{}
+        , _misses{}
+    {
+        if (_fd < 0) {
+            throw std::system_error{errno, std::generic_category(), fmt::format("translation cache: cannot open [{}]", path)};
+        }
+
+        try {
+            load();
+        }
+        catch (...) {
+            ::close(_fd);
+            throw;
+        }
+    }
+
+    translation_cache::~translation_cache()
+    {
+        if (_mapping) {
+            ::munmap(_mapping, _mapping_size);
+        }
+
+        ::close(_fd);
+    }
+
+    void translation_cache::load()
+    {
+        const file_lock lock{_fd};
+
+        struct stat st{};
+        if (::fstat(_fd, &st) < 0) {
+            throw std::system_error{errno, std::generic_category(), "translation cache: fstat failed"};
+        }
+
+        const auto size = static_cast<std::size_t>(st.st_size);
+
+        if (0 == size) {
+            write_all(_fd, header());
+            return;
+        }
+
+        if (size < header_size) {
+            throw std::runtime_error{"translation cache: file is too small"};
+        }
+
+        _mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, _fd, 0);
+        if (MAP_FAILED == _mapping) {
+            _mapping = nullptr;
+            throw std::system_error{errno, std::generic_category(), "translation cache: mmap failed"};
+        }
+        _mapping_size = size;
+
+        const auto* base = static_cast<const unsigned char*>(_mapping);
+
+        if (get_u32(base) != cache_magic || get_u32(base + 4) > cache_version) {
+            throw std::runtime_error{"translation cache: not a cache file or unsupported version"};
+        }
+
+        // Entries of an older version are discarded. The cache refills as queries are
+        // translated.
+        if (get_u32(base + 4) < cache_version) {
+            ::munmap(_mapping, _mapping_size);
+            _mapping = nullptr;
+            _mapping_size = 0;
+
+            if (::ftruncate(_fd, 0) < 0) {
+                throw std::system_error{errno, std::generic_category(), "translation cache: ftruncate failed"};
+            }
+
+            write_all(_fd, header());
+            return;
+        }
+
+        std::size_t pos = header_size;
+
+        while (size - pos >= entry_header) {
+            const auto* p = base + pos;
+            const std::size_t key_size = get_u32(p);
+            const std::size_t sql_size = get_u32(p + 4);
+            const std::size_t bind_count = get_u32(p + 8);
+            const std::size_t plan_size = get_u32(p + 12);
+            const auto payload_size = key_size + sql_size + 4 * bind_count + plan_size;
+
+            if (payload_size > size - pos - entry_header ||
+                checksum(p + entry_header, payload_size) != get_u32(p + 16))
+            {
+                break;
+            }
+
+            const auto* key = reinterpret_cast<const char*>(p + entry_header);
+            _index[std::string_view{key, key_size}] = entry{
+                std::string_view{key + key_size, sql_size},
+                p + entry_header + key_size + sql_size,
+                static_cast<std::uint32_t>(bind_count),
+                std::string_view{key + key_size + sql_size + 4 * bind_count, plan_size}};
+
+            pos += entry_header + payload_size;
+        }
+
+        // Drop a torn entry so that new entries are appended after the last valid one.
+        // Other processes only map the valid entries, which are kept.
+        if (pos != size && ::ftruncate(_fd, static_cast<off_t>(pos)) < 0) {
+            throw std::system_error{errno, std::generic_category(), "translation cache: ftruncate failed"};
+        }
+    } // load
+
+    void translation_cache::append(std::string_view key, const translation& t)
+    {
+        const auto plan = make_plan(t.cost);
+        auto e = make_entry(key, t, plan);
+
+        std::unique_lock lock{_mutex};
+
+        // Another thread may have translated the same shape in the meantime.
+        if (_index.count(key)) {
+            return;
+        }
+
+        {
+            const file_lock file{_fd};
+            write_all(_fd, e);
+        }
+
+        const auto& stored = _appended.emplace_back(std::move(e));
+        const auto* p = reinterpret_cast<const unsigned char*>(stored.data());
+
+        _index[std::string_view{stored.data() + entry_header, key.size()}] = entry{
+            std::string_view{stored.data() + entry_header + key.size(), t.sql.size()},
+            p + entry_header + key.size() + t.sql.size(),
+            static_cast<std::uint32_t>(t.bind_layout.size()),
+            std::string_view{stored.data() + stored.size() - plan.size(), plan.size()}};
+    } // append
+
+    translation translation_cache::translate(const Select& s, const options& opts)
+    {
+        auto t = try_translate(s, opts);
+
+        if (!t) {
+            throw std::runtime_error{describe(t.error())};
+        }
+
+        return std::move(t).value();
+    } // translate
+
+    result<translation> translation_cache::try_translate(const Select& s, const options& opts)
+    {
+        // Keeps the schema the key was computed with for the translation on a miss.
+        const schema_snapshot snapshot;
+
+        translation_profiler profiler{opts.slow_log};
+
+        const auto start = std::chrono::steady_clock::now();
+
+        auto t = lookup(s, opts);
+
+        if (t) {
+            t = admit(std::move(*t), opts, [this, &s](const options& _o) { return lookup(s, _o); });
+        }
+
+        // Hits are counted too, with the time of the lookup.
+        if (opts.workload) {
+            opts.workload->record(s, t, std::chrono::steady_clock::now() - start);
+        }
+
+        profiler.finish({}, &s, t);
+
+        return t;
+    } // try_translate
+
+    // Entries hold translations before admission, so the same entry serves every
+    // admission policy and cost model.
+    result<translation> translation_cache::lookup(const Select& s, const options& opts)
+    {
+        auto o = opts;
+        o.parameterize = true;
+        o.admission = {};
+        o.workload = nullptr;
+
+        // Conditions resolved with an index (of paths or of metadata) depend on its
+        // contents rather than on the shape of the query, so such translations are not
+        // cached.
+        if (opts.collection_paths || opts.metadata) {
+            return genquery::try_translate(s, o);
+        }
+
+        const auto key = cache_key(s, opts);
+        const auto refs = literals(s);
+
+        {
+            std::shared_lock lock{_mutex};
+
+            if (const auto iter = _index.find(key); iter != std::end(_index)) {
+                const auto& e = iter->second;
+
+                translation t;
+                t.sql = e.sql;
+                t.bind_values.reserve(e.bind_count);
+                t.bind_layout.reserve(e.bind_count);
+
+                for (std::uint32_t i = 0; i < e.bind_count; ++i) {
+                    const auto ordinal = get_u32(e.layout + 4 * i);
+                    if (ordinal >= refs.size()) {
+                        throw std::runtime_error{"translation cache: bind layout does not match the query"};
+                    }
+                    t.bind_layout.push_back(ordinal);
+                    t.bind_values.push_back(unescape_literal(*refs[ordinal]));
+                }
+
+                read_plan(e.plan, t.cost);
+                estimate_cost(s, opts.costs, t.cost);
+
+                ++_hits;
+                return t;
+            }
+        }
+
+        ++_misses;
+
+        auto t = genquery::try_translate(s, o);
+
+        if (t) {
+            append(key, *t);
+        }
+
+        return t;
+    } // lookup
+
+    std::size_t translation_cache::size() const
+    {
+        std::shared_lock lock{_mutex};
+        return _index.size();
+    }
+
+    void translation_cache::compact(const std::string& path)
+    {
+        const auto tmp = path + ".compact";
+
+        {
+            translation_cache cache{path};
+
+            const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                throw std::system_error{errno, std::generic_category(), fmt::format("translation cache: cannot open [{}]", tmp)};
+            }
+
+            try {
+                std::string b = header();
+
+                for (auto&& [key, e] : cache._index) {
+                    translation t;
+                    t.sql = e.sql;
+                    for (std::uint32_t i = 0; i < e.bind_count; ++i) {
+                        t.bind_layout.push_back(get_u32(e.layout + 4 * i));
+                    }
+                    b += make_entry(key, t, e.plan);
+                }
+
+                write_all(fd, b);
+
+                if (::fsync(fd) < 0) {
+                    throw std::system_error{errno, std::generic_category(), "translation cache: fsync failed"};
+                }
+            }
+            catch (...) {
+                ::close(fd);
+                ::unlink(tmp.c_str());
+                throw;
+            }
+
+            ::close(fd);
+        }
+
+        if (::rename(tmp.c_str(), path.c_str()) < 0) {
+            throw std::system_error{errno, std::generic_category(), "translation cache: rename failed"};
+        }
+    } // compact
+} // namespace irods::experimental::api::genquery
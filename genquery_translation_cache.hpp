@@ -0,0 +1,91 @@
+#ifndef IRODS_GENQUERY_TRANSLATION_CACHE_HPP
+#define IRODS_GENQUERY_TRANSLATION_CACHE_HPP
+
+#include "genquery_ast_types.hpp"
+#include "genquery_sql.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace irods::experimental::api::genquery
+{
+    // Returns the key under which the translation of a query is cached. Queries with
+    // the same key translate to the same parameterized SQL. The key includes the
+    // fingerprint of the current schema.
+    std::string cache_key(const Select&, const options&);
+
+    // Persistent cache of parameterized translations, keyed by cache_key().
+    //
+    // The cache file is memory-mapped when the cache is opened and new entries are
+    // appended to it, so a restarted process starts out with every query shape its
+    // predecessors translated. Appending never rewrites existing entries. compact()
+    // drops superseded entries and must only be used while no process has the file open.
+    //
+    // File layout (little-endian):
+    //   header  u32 magic, u32 version
+    //   entry   u32 key size, u32 sql size, u32 bind count, u32 plan size, u32 checksum,
+    //           key, sql, u32 bind layout[bind count], plan
+    //
+    // The plan lists the tables of the cost estimate, so that the cost of a cached
+    // translation can be estimated without translating the query again.
+    //
+    // Processes which share the file append under an exclusive flock(2). A torn entry at
+    // the end of the file (e.g. after a crash) is discarded on open, under the same lock,
+    // along with anything appended after it. A file of an older version is emptied on
+    // open, so processes of the previous version must not use it meanwhile.
+    class translation_cache
+    {
+    public:
+        explicit translation_cache(const std::string& path);
+        ~translation_cache();
+
+        translation_cache(const translation_cache&) = delete;
+        auto operator=(const translation_cache&) -> translation_cache& = delete;
+
+        // Returns the translation of a query. On a miss, the query is translated and
+        // the result is appended to the cache. Literals are always parameterized.
+        translation translate(const Select&, const options&);
+
+        // Like translate(), but reports a query which cannot be translated instead of
+        // throwing (see genquery::try_translate).
+        result<translation> try_translate(const Select&, const options&);
+
+        std::size_t size() const;
+        std::uint64_t hits() const noexcept { return _hits; }
+        std::uint64_t misses() const noexcept { return _misses; }
+
+        static void compact(const std::string& path);
+
+    private:
+        struct entry
+        {
+            std::string_view sql;
+            const unsigned char* layout;
+            std::uint32_t bind_count;
+            std::string_view plan;
+        };
+
+        void load();
+        result<translation> lookup(const Select&, const options&);
+        void append(std::string_view key, const translation&);
+
+        int _fd;
+        void* _mapping;
+        std::size_t _mapping_size;
+
+        mutable std::shared_mutex _mutex;
+        std::unordered_map<std::string_view, entry> _index;
+        std::deque<std::string> _appended; // Entries added since the file was mapped.
+
+        std::atomic<std::uint64_t> _hits;
+        std::atomic<std::uint64_t> _misses;
+    };
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_TRANSLATION_CACHE_HPP
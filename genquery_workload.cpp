@@ -0,0 +1,136 @@
+#include "genquery_workload.hpp"
+
+#include "genquery_json.hpp"
+#include "genquery_normalize.hpp"
+#include "genquery_sql.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace irods::experimental::api::genquery
+{
+    namespace
+    {
+        auto histogram_bucket(std::chrono::nanoseconds _elapsed) -> std::size_t
+        {
+            const auto us = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(_elapsed).count());
+
+            // The number of significant bits, i.e. 0 for 0 and i for [2^(i - 1), 2^i).
+            const auto bits = us ? 64 - static_cast<std::size_t>(__builtin_clzll(us)) : 0;
+
+            return std::min(bits, shape_statistics::histogram_buckets - 1);
+        } // histogram_bucket
+
+        auto add(shape_statistics& _s, const result<translation>& _t, std::chrono::nanoseconds _elapsed) -> void
+        {
+            ++_s.count;
+
+            if (!_t) {
+                ++_s.errors;
+            }
+            else if (const auto tables = _t->cost.tables.size() + _t->cost.subquery_tables.size(); tables > 1) {
+                _s.joins += tables - 1;
+            }
+
+            _s.total_us += std::chrono::duration<double, std::micro>{_elapsed}.count();
+            ++_s.time_histogram[histogram_bucket(_elapsed)];
+        } // add
+    } // anonymous namespace
+
+    workload_statistics::workload_statistics(std::size_t capacity)
+        : _shard_capacity{std::max<std::size_t>(1, (capacity + shard_count - 1) / shard_count)}
+        , _shards{}
+        , _translations{}
+    {
+    }
+
+    void workload_statistics::record(const Select& s, const result<translation>& t, std::chrono::nanoseconds elapsed)
+    {
+        _translations.fetch_add(1, std::memory_order_relaxed);
+
+        const auto fp = fingerprint(s);
+        auto& sh = _shards[fp % shard_count];
+
+        {
+            std::lock_guard lock{sh.mutex};
+
+            if (const auto iter = sh.shapes.find(fp); iter != std::end(sh.shapes)) {
+                add(iter->second, t, elapsed);
+                return;
+            }
+        }
+
+        // The text is only built for shapes entering the table, and outside of the lock.
+        shape_statistics entry;
+        entry.fingerprint = fp;
+        entry.query = normalize(s);
+
+        std::lock_guard lock{sh.mutex};
+
+        auto iter = sh.shapes.find(fp);
+
+        if (iter == std::end(sh.shapes)) {
+            if (sh.shapes.size() >= _shard_capacity) {
+                const auto victim = std::min_element(std::begin(sh.shapes), std::end(sh.shapes), [](auto&& _a, auto&& _b) {
+                    return _a.second.count < _b.second.count;
+                });
+
+                entry.count = entry.overcount = victim->second.count;
+                sh.shapes.erase(victim);
+            }
+
+            iter = sh.shapes.emplace(fp, std::move(entry)).first;
+        }
+
+        add(iter->second, t, elapsed);
+    } // record
+
+    std::vector<shape_statistics> workload_statistics::top(std::size_t n) const
+    {
+        std::vector<shape_statistics> shapes;
+
+        for (auto&& sh : _shards) {
+            std::lock_guard lock{sh.mutex};
+            for (auto&& [fp, s] : sh.shapes) {
+                shapes.push_back(s);
+            }
+        }
+
+        const auto by_count = [](auto&& _a, auto&& _b) {
+            return _a.count != _b.count ? _a.count > _b.count : _a.fingerprint < _b.fingerprint;
+        };
+
+        n = std::min(n, shapes.size());
+        std::partial_sort(std::begin(shapes), std::begin(shapes) + n, std::end(shapes), by_count);
+        shapes.resize(n);
+
+        return shapes;
+    } // top
+
+    void workload_statistics::clear()
+    {
+        for (auto&& sh : _shards) {
+            std::lock_guard lock{sh.mutex};
+            sh.shapes.clear();
+        }
+
+        _translations.store(0, std::memory_order_relaxed);
+    } // clear
+
+    std::string to_json(const shape_statistics& _s)
+    {
+        std::string out = fmt::format("{{\"fingerprint\": \"{:016x}\", \"query\": ", _s.fingerprint);
+        json::append_string(out, _s.query);
+        out += fmt::format(", \"count\": {}, \"overcount\": {}, \"errors\": {}, \"joins\": {}, \"total_us\": {:.1f}, "
+                           "\"time_histogram\": [{}]}}",
+                           _s.count,
+                           _s.overcount,
+                           _s.errors,
+                           _s.joins,
+                           _s.total_us,
+                           fmt::join(_s.time_histogram, ", "));
+        return out;
+    } // to_json
+} // namespace irods::experimental::api::genquery
@@ -0,0 +1,97 @@
+#ifndef IRODS_GENQUERY_WORKLOAD_HPP
+#define IRODS_GENQUERY_WORKLOAD_HPP
+
+#include "genquery_ast_types.hpp"
+#include "genquery_diagnostic.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace irods::experimental::api::genquery
+{
+    struct translation;
+
+    // What the translations of one query shape (see fingerprint()) had in common.
+    struct shape_statistics
+    {
+        // Translations taking less than 2^i microseconds, and at least 2^(i - 1), are
+        // counted by bucket i. The last bucket counts the slower ones too.
+        static constexpr std::size_t histogram_buckets = 16;
+
+        std::uint64_t fingerprint = 0;
+
+        // The normalized text of the first query of the shape (see normalize()).
+        std::string query;
+
+        // The number of translations, errors included. When a shape enters a full table,
+        // it takes over the count of the shape it evicts, which "overcount" records, so
+        // the true count is between "count - overcount" and "count".
+        std::uint64_t count = 0;
+        std::uint64_t overcount = 0;
+        std::uint64_t errors = 0;
+
+        // The tables joined by the SQL beyond the first, within subqueries included,
+        // summed over the translations.
+        std::uint64_t joins = 0;
+
+        double total_us = 0;
+        std::array<std::uint64_t, histogram_buckets> time_histogram{};
+    };
+
+    // Counts the translations of the most frequent query shapes within a bounded table,
+    // with the Space-Saving algorithm: a shape which is not in a full table replaces the
+    // one with the lowest count. Any shape with more than 1/capacity of the translations
+    // is in the table.
+    //
+    // The table is split into shards by fingerprint, each with its own lock and an equal
+    // part of the capacity, so concurrent translations rarely wait for each other (see
+    // options::workload). The bound above holds within each shard, and so for the table
+    // as long as the shapes spread evenly over the shards.
+    class workload_statistics
+    {
+    public:
+        explicit workload_statistics(std::size_t capacity = 1024);
+
+        workload_statistics(const workload_statistics&) = delete;
+        auto operator=(const workload_statistics&) -> workload_statistics& = delete;
+
+        // Records a translation (or the diagnostic of a query which did not translate)
+        // which took "elapsed".
+        void record(const Select&, const result<translation>&, std::chrono::nanoseconds elapsed);
+
+        // The "n" shapes with the highest counts, in decreasing order.
+        std::vector<shape_statistics> top(std::size_t n) const;
+
+        // The number of translations recorded, across all shapes.
+        std::uint64_t translations() const noexcept { return _translations.load(std::memory_order_relaxed); }
+
+        void clear();
+
+    private:
+        static constexpr std::size_t shard_count = 16;
+
+        struct shard
+        {
+            mutable std::mutex mutex;
+            std::unordered_map<std::uint64_t, shape_statistics> shapes;
+        };
+
+        std::size_t _shard_capacity;
+        std::array<shard, shard_count> _shards;
+        std::atomic<std::uint64_t> _translations;
+    };
+
+    // e.g. {"fingerprint": "9c2f...", "query": "select DATA_NAME where ...", "count": 12,
+    //       "overcount": 0, "errors": 0, "joins": 24, "total_us": 310.5,
+    //       "time_histogram": [0, 0, 0, 0, 9, 3, ...]}
+    std::string to_json(const shape_statistics&);
+} // namespace irods::experimental::api::genquery
+
+#endif // IRODS_GENQUERY_WORKLOAD_HPP
@@ -1,41 +1,130 @@
 #include "genquery_ast_types.hpp"
 #include "genquery_wrapper.hpp"
 
-#include <sstream>
+#include <algorithm>
+#include <istream>
+#include <stdexcept>
+#include <streambuf>
 #include <utility>
 
 namespace irods::experimental::api::genquery
 {
-    wrapper::wrapper(std::istream* istream)
+    namespace
+    {
+        // Lets the scanner read a query in place instead of from a copy.
+        class view_streambuf : public std::streambuf
+        {
+        public:
+            explicit view_streambuf(std::string_view _s)
+            {
+                auto* p = const_cast<char*>(_s.data());
+                setg(p, p, p + _s.size());
+            }
+
+        protected:
+            auto seekoff(off_type _off, std::ios_base::seekdir _dir, std::ios_base::openmode _which) -> pos_type override
+            {
+                if (!(_which & std::ios_base::in)) {
+                    return pos_type(off_type(-1));
+                }
+
+                const auto base = _dir == std::ios_base::beg ? eback() : _dir == std::ios_base::cur ? gptr() : egptr();
+                const auto pos = (base - eback()) + _off;
+
+                if (pos < 0 || pos > egptr() - eback()) {
+                    return pos_type(off_type(-1));
+                }
+
+                setg(eback(), eback() + pos, egptr());
+                return pos_type(pos);
+            }
+
+            auto seekpos(pos_type _pos, std::ios_base::openmode _which) -> pos_type override
+            {
+                return seekoff(off_type(_pos), std::ios_base::beg, _which);
+            }
+        };
+
+        auto value_or_throw(result<Select> _r) -> Select
+        {
+            if (!_r) {
+                throw std::runtime_error{describe(_r.error())};
+            }
+
+            return std::move(_r).value();
+        } // value_or_throw
+    } // anonymous namespace
+
+    wrapper::wrapper(std::istream* istream, const query_limits& limits, std::chrono::steady_clock::duration* scan_time)
         : _scanner(*this)
         , _parser(_scanner, *this)
         , _select{}
         , _location(0)
+        , _token_offset(0)
+        , _diagnostic{}
+        , _limits{limits}
+        , _expressions(0)
+        , _open_nots(0)
+        , _literal_bytes(0)
     {
         _scanner.switch_streams(istream, nullptr);
-        _parser.parse(); // TODO: handle error here
+        _scanner.scan_time = scan_time;
+
+        if (_parser.parse() != 0 && !_diagnostic) {
+            fail(error_code::internal, end_location(), {}, "failed to parse query");
+        }
     }
 
     Select
     wrapper::parse(std::istream& istream) {
         wrapper wrapper(&istream);
+
+        if (wrapper._diagnostic) {
+            throw std::runtime_error{describe(*wrapper._diagnostic)};
+        }
+
         return std::move(wrapper._select);
     }
 
     Select
     wrapper::parse(const char* s) {
-        std::istringstream iss(s);
-        return parse(iss);
+        return value_or_throw(try_parse(s));
     }
 
     Select
     wrapper::parse(const std::string& s) {
-        std::istringstream iss(s);
-        return parse(iss);
+        return value_or_throw(try_parse(s));
+    }
+
+    result<Select>
+    wrapper::try_parse(std::string_view s, const query_limits& limits, std::chrono::steady_clock::duration* scan_time) {
+        view_streambuf buffer{s};
+        std::istream istream{&buffer};
+        wrapper wrapper(&istream, limits, scan_time);
+
+        if (!wrapper._diagnostic) {
+            // The parser bounds the size of the query and the nesting of NOT, but not the
+            // depth of chains of AND and OR, which do not grow the parse stack.
+            if (auto d = check_limits(wrapper._select, limits); d) {
+                return std::move(*d);
+            }
+
+            return std::move(wrapper._select);
+        }
+
+        auto& d = *wrapper._diagnostic;
+
+        // The parser only knows where the offending token is.
+        if (error_code::syntax_error == d.code && d.offset < s.size()) {
+            d.identifier = s.substr(d.offset, std::min<std::size_t>(d.size, s.size() - d.offset));
+        }
+
+        return std::move(d);
     }
 
     void
     wrapper::increaseLocation(uint64_t location) {
+        _token_offset = _location;
         _location += location;
     }
 
@@ -43,4 +132,85 @@ namespace irods::experimental::api::genquery
     wrapper::location() const {
         return _location;
     }
+
+    auto
+    wrapper::token_location() const -> genquery::location {
+        genquery::location l;
+        l.begin.column = static_cast<unsigned>(_token_offset + 1);
+        l.end.column = static_cast<unsigned>(_location + 1);
+        return l;
+    }
+
+    auto
+    wrapper::end_location() const -> genquery::location {
+        genquery::location l;
+        l.begin.column = l.end.column = static_cast<unsigned>(_location + 1);
+        return l;
+    }
+
+    void
+    wrapper::fail(error_code code, const genquery::location& l, std::string_view identifier, std::string detail) {
+        if (_diagnostic) {
+            return;
+        }
+
+        auto& d = _diagnostic.emplace();
+        d.code = code;
+        d.offset = l.begin.column - 1;
+        d.size = l.end.column - l.begin.column;
+        d.identifier = identifier;
+        d.detail = std::move(detail);
+    }
+
+    bool
+    wrapper::count_expression(const genquery::location& l) {
+        if (++_expressions <= _limits.max_nodes) {
+            return true;
+        }
+
+        auto d = limit_exceeded("number of condition expressions", _limits.max_nodes);
+        fail(d.code, l, {}, std::move(d.detail));
+        return false;
+    }
+
+    bool
+    wrapper::open_not(const genquery::location& l) {
+        // The operand of n nested NOTs is at depth n + 1.
+        if (++_open_nots >= _limits.max_depth) {
+            auto d = limit_exceeded("condition nesting depth", _limits.max_depth);
+            fail(d.code, l, {}, std::move(d.detail));
+            return false;
+        }
+
+        return count_expression(l);
+    }
+
+    void
+    wrapper::close_not() {
+        --_open_nots;
+    }
+
+    bool
+    wrapper::count_literal(const genquery::location& l, std::size_t bytes) {
+        _literal_bytes += bytes;
+
+        if (_literal_bytes <= _limits.max_literal_bytes) {
+            return true;
+        }
+
+        auto d = limit_exceeded("total size of literals", _limits.max_literal_bytes);
+        fail(d.code, l, {}, std::move(d.detail));
+        return false;
+    }
+
+    bool
+    wrapper::check_list_length(const genquery::location& l, std::size_t length) {
+        if (length <= _limits.max_in_list) {
+            return true;
+        }
+
+        auto d = limit_exceeded("length of an IN list", _limits.max_in_list);
+        fail(d.code, l, {}, std::move(d.detail));
+        return false;
+    }
 } // namespace irods::experimental::api::genquery
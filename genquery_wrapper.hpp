@@ -2,24 +2,37 @@
 #define IRODS_GENQUERY_WRAPPER_HPP
 
 #include "genquery_ast_types.hpp"
+#include "genquery_diagnostic.hpp"
+#include "genquery_limits.hpp"
 #include "parser.hpp" //"genquery_parser_bison_generated.hpp"
 #include "genquery_scanner.hpp"
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 
 namespace irods::experimental::api::genquery
 {
     class wrapper
     {
     public:
-        explicit wrapper(std::istream*);
+        // Adds the time spent scanning to "scan_time" when set.
+        explicit wrapper(std::istream*, const query_limits& = {}, std::chrono::steady_clock::duration* scan_time = nullptr);
 
+        // Throw std::runtime_error if the query is malformed.
         static Select parse(std::istream&);
         static Select parse(const char*);
         static Select parse(const std::string&);
 
+        // Reports a malformed query without throwing or writing to a stream. The
+        // diagnostic identifies the offending token.
+        static result<Select> try_parse(std::string_view,
+                                        const query_limits& = {},
+                                        std::chrono::steady_clock::duration* scan_time = nullptr);
+
         friend class Parser;
         friend class scanner;
 
@@ -27,10 +40,35 @@ namespace irods::experimental::api::genquery
         void increaseLocation(std::uint64_t);
         std::uint64_t location() const;
 
+        // The span of the token scanned last, and the empty span at the end of the
+        // input consumed so far.
+        auto token_location() const -> genquery::location;
+        auto end_location() const -> genquery::location;
+
+        // Records why the query is malformed. Only the first report is kept.
+        void fail(error_code, const genquery::location&, std::string_view identifier, std::string detail = {});
+
+        // Account for the parts of the query as they are parsed. Return false, after
+        // recording a diagnostic, once a limit is exceeded.
+        bool count_expression(const genquery::location&);
+        bool count_literal(const genquery::location&, std::size_t bytes);
+        bool check_list_length(const genquery::location&, std::size_t);
+
+        // Account for a NOT whose operand has not been parsed yet, which counts as an
+        // expression and adds a level of nesting until close_not().
+        bool open_not(const genquery::location&);
+        void close_not();
+
         scanner _scanner;
         Parser _parser;
         Select _select;
         std::uint64_t _location;
+        std::uint64_t _token_offset;
+        std::optional<diagnostic> _diagnostic;
+        query_limits _limits;
+        std::size_t _expressions;
+        std::size_t _open_nots;
+        std::size_t _literal_bytes;
     };
 } // namespace irods::experimental::api::genquery
 
@@ -1,19 +1,515 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include <fmt/format.h>
+
+#include "genquery_batch.hpp"
+#include "genquery_codegen.hpp"
+#include "genquery_explain.hpp"
+#include "genquery_federation.hpp"
+#include "genquery_json.hpp"
+#include "genquery_schema.hpp"
+#include "genquery_server.hpp"
+#include "genquery_slow_log.hpp"
 #include "genquery_sql.hpp"
+#include "genquery_translation_cache.hpp"
+#include "genquery_workload.hpp"
 #include "genquery_wrapper.hpp"
 #include "genquery_stream_insertion.hpp"
 
+namespace
+{
+    namespace gq = irods::experimental::api::genquery;
+
+    gq::server* running_server{};
+
+    extern "C" void handle_signal(int _signal)
+    {
+        if (!running_server) {
+            return;
+        }
+
+        if (SIGHUP == _signal) {
+            running_server->request_reload();
+        }
+        else {
+            running_server->stop();
+        }
+    } // handle_signal
+
+    auto serve(gq::server_options _opts) -> int
+    {
+        gq::server server{std::move(_opts)};
+        running_server = &server;
+
+        struct sigaction sa{};
+        sa.sa_handler = handle_signal;
+        sigemptyset(&sa.sa_mask);
+        for (const int s : {SIGINT, SIGTERM, SIGHUP}) {
+            ::sigaction(s, &sa, nullptr);
+        }
+
+        server.run();
+        running_server = nullptr;
+
+        return 0;
+    } // serve
+
+    // Sends the queries read from stdin to a server, pipelined, and prints the
+    // responses as JSON lines.
+    auto run_client(const std::string& _socket_path) -> int
+    {
+        std::vector<std::string> queries;
+        for (std::string line; std::getline(std::cin, line);) {
+            if (!line.empty()) {
+                queries.push_back(std::move(line));
+            }
+        }
+
+        gq::client client{_socket_path};
+
+        std::thread sender{[&] {
+            for (auto&& q : queries) {
+                client.send(q);
+            }
+        }};
+
+        int status = 0;
+
+        for (auto&& q : queries) {
+            std::string line = "{\"query\": ";
+            gq::json::append_string(line, q);
+
+            try {
+                const auto t = client.receive();
+                line += ", \"sql\": ";
+                gq::json::append_string(line, t.sql);
+                line += ", \"bind_values\": [";
+                for (auto&& v : t.bind_values) {
+                    if (&v != &t.bind_values.front()) { line += ", "; }
+                    gq::json::append_string(line, v);
+                }
+                line += "], \"error\": null}\n";
+            }
+            catch (const std::exception& e) {
+                line += ", \"sql\": null, \"bind_values\": [], \"error\": ";
+                gq::json::append_string(line, e.what());
+                line += "}\n";
+                status = 2;
+            }
+
+            std::cout << line;
+        }
+
+        sender.join();
+
+        return status;
+    } // run_client
+
+    // Translates to the SQL of a dialect of genquery_dialect.hpp.
+    auto translator(const std::string& _dialect) -> std::function<gq::result<gq::translation>(const gq::Select&, const gq::options&)>
+    {
+        if ("postgresql" == _dialect) {
+            return [](const gq::Select& _s, const gq::options& _o) { return gq::try_translate<gq::dialect::postgresql>(_s, _o); };
+        }
+        if ("mysql" == _dialect) {
+            return [](const gq::Select& _s, const gq::options& _o) { return gq::try_translate<gq::dialect::mysql>(_s, _o); };
+        }
+        if ("oracle" == _dialect) {
+            return [](const gq::Select& _s, const gq::options& _o) { return gq::try_translate<gq::dialect::oracle>(_s, _o); };
+        }
+        if ("sqlite" == _dialect) {
+            return [](const gq::Select& _s, const gq::options& _o) { return gq::try_translate<gq::dialect::sqlite>(_s, _o); };
+        }
+        if ("generic" == _dialect) {
+            return [](const gq::Select& _s, const gq::options& _o) { return gq::try_translate(_s, _o); };
+        }
+
+        throw std::runtime_error{fmt::format("unknown dialect [{}]", _dialect)};
+    } // translator
+
+    // Generates the header of a template file (see genquery_codegen.hpp). The output is
+    // left untouched when it does not change, so what includes it is not rebuilt.
+    auto emit_cpp(const std::string& _templates, const std::optional<std::string>& _output, gq::codegen_options _opts) -> int
+    {
+        std::ifstream in{_templates};
+        if (!in) {
+            throw std::runtime_error{fmt::format("cannot open [{}]", _templates)};
+        }
+
+        _opts.source = _templates;
+        const auto header = gq::emit_cpp(gq::read_templates(in, _templates), _opts);
+
+        if (!_output) {
+            std::cout << header;
+            return 0;
+        }
+
+        if (std::ifstream current{*_output, std::ios::binary}; current) {
+            if (std::string{std::istreambuf_iterator<char>{current}, {}} == header) {
+                return 0;
+            }
+        }
+
+        const auto tmp = *_output + ".tmp";
+
+        {
+            std::ofstream out{tmp, std::ios::binary | std::ios::trunc};
+            out << header;
+            if (!out.flush()) {
+                throw std::runtime_error{fmt::format("cannot write [{}]", tmp)};
+            }
+        }
+
+        if (std::rename(tmp.c_str(), _output->c_str()) != 0) {
+            throw std::runtime_error{fmt::format("cannot rename [{}] to [{}]", tmp, *_output)};
+        }
+
+        return 0;
+    } // emit_cpp
+
+    auto usage(const char* _program) -> int
+    {
+        std::cerr << "usage: " << _program << " [OPTIONS] QUERY\n"
+                  << "       " << _program << " [OPTIONS] --batch FILE|- [--null] [--threads N]\n"
+                  << "       " << _program << " [OPTIONS] --serve SOCKET [--metrics SOCKET] [--workers N]\n"
+                  << "       " << _program << " --connect SOCKET < QUERIES\n"
+                  << "       " << _program << " [OPTIONS] --emit-cpp TEMPLATES [--output FILE] [--namespace NAME]\n"
+                  << "       " << _program << " --compact-cache FILE\n"
+                  << "\n"
+                  << "options:\n"
+                  << "  --schema CATALOG  resolve names with a catalog built by gql_schema_compiler\n"
+                  << "  --cache FILE      translate through a persistent translation cache\n"
+                  << "  --parameterize    emit literals as placeholders and print the bind values\n"
+                  << "  --dialect NAME    emit the SQL of generic (default), postgresql, mysql, oracle or sqlite\n"
+                  << "                    (QUERY and --emit-cpp only)\n"
+                  << "  --case-insensitive, --ordered-joins, --row-limit N\n"
+                  << "                    compare text regardless of case, keep the join order, limit the rows\n"
+                  << "  --trace           print the decisions of the table linkage planner\n"
+                  << "  --explain         print how QUERY is translated as JSON instead of the SQL\n"
+                  << "  --table-rows T=N  estimate N rows for table T in the cost model\n"
+                  << "  --throttle-above COST, --downgrade-above COST, --reject-above COST\n"
+                  << "                    admission policy by estimated cost\n"
+                  << "  --top-shapes N    count translations by query shape and print the N most frequent\n"
+                  << "                    shapes as JSON to stderr (the server adds them to its metrics)\n"
+                  << "  --shard ZONE      print the SQL of QUERY for the catalog of each zone (repeated) which\n"
+                  << "                    its conditions do not rule out (see genquery_federation.hpp)\n"
+                  << "  --slow-log US [--slow-log-size N]\n"
+                  << "                    print translations taking at least US microseconds, with the time\n"
+                  << "                    of each phase, as JSON to stderr; at most N (1024) are buffered\n"
+                  << "\n"
+                  << "batch mode writes one JSON object per query to stdout and a summary to stderr.\n"
+                  << "--emit-cpp writes a header with the SQL and bind functions of named queries (see\n"
+                  << "genquery_codegen.hpp) to FILE, or stdout.\n"
+                  << "the server stops on SIGINT or SIGTERM and reloads the --schema catalog on SIGHUP.\n";
+        return 1;
+    } // usage
+} // anonymous namespace
+
 int main(int _argc, char* _argv[])
 {
     try {
-        namespace gq = irods::experimental::api::genquery;
-        const auto sql = gq::sql(gq::wrapper::parse(_argv[1]));
-        std::cout << sql << '\n';
+        gq::options opts;
+        std::optional<std::string> schema_path;
+        std::optional<std::string> cache_path;
+        std::optional<gq::batch_options> batch;
+        std::optional<gq::server_options> server;
+        std::optional<std::string> query;
+        bool explain = false;
+        std::string dialect = "generic";
+        std::optional<std::string> templates;
+        std::optional<std::string> output;
+        gq::codegen_options codegen;
+        std::size_t top_shapes = 0;
+        std::vector<gq::shard> shards;
+        std::optional<long> slow_log_threshold;
+        std::size_t slow_log_size = 1024;
+
+        for (int i = 1; i < _argc; ++i) {
+            const std::string arg = _argv[i];
+            const auto has_value = i + 1 < _argc;
+
+            if ("--schema" == arg && has_value) {
+                schema_path = _argv[++i];
+                gq::publish_schema(gq::schema::load(*schema_path));
+            }
+            else if ("--cache" == arg && has_value) {
+                cache_path = _argv[++i];
+            }
+            else if ("--compact-cache" == arg && has_value) {
+                gq::translation_cache::compact(_argv[++i]);
+                return 0;
+            }
+            else if ("--parameterize" == arg) {
+                opts.parameterize = true;
+            }
+            else if ("--dialect" == arg && has_value) {
+                dialect = _argv[++i];
+            }
+            else if ("--case-insensitive" == arg) {
+                opts.case_insensitive = true;
+            }
+            else if ("--ordered-joins" == arg) {
+                opts.ordered_joins = true;
+            }
+            else if ("--row-limit" == arg && has_value) {
+                opts.row_limit = std::strtoul(_argv[++i], nullptr, 10);
+            }
+            else if ("--trace" == arg) {
+                opts.trace = true;
+            }
+            else if ("--explain" == arg) {
+                explain = true;
+            }
+            else if ("--table-rows" == arg && has_value) {
+                const std::string hint = _argv[++i];
+                const auto p = hint.find('=');
+                if (std::string::npos == p) {
+                    return usage(_argv[0]);
+                }
+                opts.costs.table_rows[hint.substr(0, p)] = std::strtod(hint.c_str() + p + 1, nullptr);
+            }
+            else if ("--throttle-above" == arg && has_value) {
+                opts.admission.throttle_above = std::strtod(_argv[++i], nullptr);
+            }
+            else if ("--downgrade-above" == arg && has_value) {
+                opts.admission.downgrade_above = std::strtod(_argv[++i], nullptr);
+            }
+            else if ("--reject-above" == arg && has_value) {
+                opts.admission.reject_above = std::strtod(_argv[++i], nullptr);
+            }
+            else if ("--top-shapes" == arg && has_value) {
+                top_shapes = std::strtoul(_argv[++i], nullptr, 10);
+            }
+            else if ("--shard" == arg && has_value) {
+                const std::string zone = _argv[++i];
+                shards.push_back({zone, zone, {}, {}});
+            }
+            else if ("--slow-log" == arg && has_value) {
+                slow_log_threshold = std::strtol(_argv[++i], nullptr, 10);
+            }
+            else if ("--slow-log-size" == arg && has_value) {
+                slow_log_size = std::strtoul(_argv[++i], nullptr, 10);
+            }
+            else if ("--batch" == arg && has_value) {
+                batch.emplace().input = _argv[++i];
+            }
+            else if ("--null" == arg && batch) {
+                batch->nul_delimited = true;
+            }
+            else if ("--threads" == arg && has_value && batch) {
+                batch->threads = std::strtoul(_argv[++i], nullptr, 10);
+            }
+            else if ("--serve" == arg && has_value) {
+                server.emplace().socket_path = _argv[++i];
+            }
+            else if ("--metrics" == arg && has_value && server) {
+                server->metrics_socket_path = _argv[++i];
+            }
+            else if ("--workers" == arg && has_value && server) {
+                server->workers = std::strtoul(_argv[++i], nullptr, 10);
+            }
+            else if ("--emit-cpp" == arg && has_value) {
+                templates = _argv[++i];
+            }
+            else if ("--output" == arg && has_value && templates) {
+                output = _argv[++i];
+            }
+            else if ("--namespace" == arg && has_value && templates) {
+                codegen.namespace_name = _argv[++i];
+            }
+            else if ("--connect" == arg && has_value) {
+                return run_client(_argv[++i]);
+            }
+            else if (!query && !batch && !server && !templates && (arg.empty() || arg[0] != '-')) {
+                query = arg;
+            }
+            else {
+                return usage(_argv[0]);
+            }
+        }
+
+        if ("generic" != dialect && (batch || server || cache_path || explain)) {
+            return usage(_argv[0]);
+        }
+
+        if (!shards.empty() && (batch || server || templates || cache_path || explain)) {
+            return usage(_argv[0]);
+        }
+
+        if (templates) {
+            if (query || batch || server || cache_path || explain) {
+                return usage(_argv[0]);
+            }
+
+            codegen.dialect = dialect;
+            codegen.translate = translator(dialect);
+            codegen.translation = opts;
+
+            return emit_cpp(*templates, output, std::move(codegen));
+        }
+
+        // Kept for any number of shapes, so the most frequent ones are counted exactly
+        // unless the workload has very many shapes.
+        std::unique_ptr<gq::workload_statistics> workload;
+        if (top_shapes > 0) {
+            workload = std::make_unique<gq::workload_statistics>(std::max<std::size_t>(1024, 4 * top_shapes));
+            opts.workload = workload.get();
+        }
+
+        const auto print_top_shapes = [&] {
+            if (workload) {
+                for (auto&& s : workload->top(top_shapes)) {
+                    std::cerr << gq::to_json(s) << '\n';
+                }
+            }
+        };
+
+        std::unique_ptr<gq::slow_translation_log> slow_log;
+        if (slow_log_threshold) {
+            slow_log = std::make_unique<gq::slow_translation_log>(std::chrono::microseconds{*slow_log_threshold}, slow_log_size);
+            opts.slow_log = slow_log.get();
+        }
+
+        const auto print_slow_translations = [](std::vector<gq::slow_translation> _entries) {
+            for (auto&& e : _entries) {
+                std::cerr << gq::to_json(e) << '\n';
+            }
+        };
+
+        std::unique_ptr<gq::translation_cache> cache;
+        if (cache_path) {
+            cache = std::make_unique<gq::translation_cache>(*cache_path);
+        }
+
+        if (server) {
+            server->translation = opts;
+            server->translation.trace = false;
+            server->cache = cache.get();
+            server->metrics_shapes = top_shapes;
+            server->slow_translations = print_slow_translations;
+
+            if (schema_path) {
+                server->reload = [path = *schema_path] {
+                    try {
+                        gq::publish_schema(gq::schema::load(path));
+                    }
+                    catch (const std::exception& e) {
+                        std::cerr << "ERROR: schema reload failed: " << e.what() << '\n';
+                    }
+                };
+            }
+
+            return serve(std::move(*server));
+        }
+
+        if (batch) {
+            batch->translation = opts;
+            batch->cache = cache.get();
+
+            const auto s = gq::run_batch(*batch, std::cout);
+
+            std::cerr << fmt::format("gql: translated {} queries ({} errors) in {:.3f}s on {} threads, {:.0f} queries/s\n",
+                                     s.queries,
+                                     s.errors,
+                                     s.seconds,
+                                     s.threads,
+                                     s.seconds > 0 ? s.queries / s.seconds : 0.0);
+
+            print_top_shapes();
+
+            if (slow_log) {
+                print_slow_translations(slow_log->drain());
+            }
+
+            return s.errors ? 2 : 0;
+        }
+
+        if (!query) {
+            return usage(_argv[0]);
+        }
+
+        if (explain) {
+            const auto e = gq::explain(*query, opts);
+
+            if (!e) {
+                throw std::runtime_error{gq::describe(e.error())};
+            }
+
+            std::cout << gq::to_json(*e) << '\n';
+            return 0;
+        }
+
+        if (!shards.empty()) {
+            for (auto&& s : shards) {
+                s.translate = translator(dialect);
+            }
+
+            gq::federation_options fo;
+            fo.translation = opts;
+
+            const auto q = gq::federate(gq::wrapper::parse(*query), shards, fo);
+
+            if (!q) {
+                throw std::runtime_error{gq::describe(q.error())};
+            }
+
+            for (auto&& s : q->statements) {
+                std::cout << "-- " << shards[s.shard].name << '\n' << s.sql.sql << '\n';
+                for (auto&& v : s.sql.bind_values) {
+                    std::cout << "bind: " << v << '\n';
+                }
+            }
+
+            return 0;
+        }
+
+        gq::translation_profiler profiler{opts.slow_log};
+
+        auto select = gq::wrapper::try_parse(*query, {}, profiler.scan_time());
+        profiler.parsed();
+
+        const auto t = !select ? gq::result<gq::translation>{std::move(select).error()}
+                       : cache ? cache->try_translate(*select, opts)
+                               : translator(dialect)(*select, opts);
+
+        profiler.finish(*query, select ? &*select : nullptr, t);
+
+        if (slow_log) {
+            print_slow_translations(slow_log->drain());
+        }
+
+        if (!t) {
+            throw std::runtime_error{gq::describe(t.error())};
+        }
+
+        std::cout << t->sql << '\n';
+        for (auto&& v : t->bind_values) {
+            std::cout << "bind: " << v << '\n';
+        }
+
+        if (t->admission != gq::admission_decision::accept) {
+            std::cerr << fmt::format("gql: {} (estimated cost {:.0f})\n", gq::to_string(t->admission), t->cost.cost);
+        }
+
+        print_top_shapes();
     }
     catch (const std::exception& e) {
         std::cerr << "ERROR: " << e.what() << '\n';
+        return 1;
     }
 }
-
@@ -28,6 +28,7 @@ This option causes make_* functions to be generated for each token kind.
     #include "genquery_ast_types.hpp"
 
     #include <iostream> // TODO Is this needed?
+    #include <memory>
     #include <string>
     #include <vector>
 
@@ -49,7 +50,56 @@ This option causes make_* functions to be generated for each token kind.
 
     static gq::Parser::symbol_type yylex(gq::scanner& scanner, gq::wrapper& wrapper)
     {
-        return scanner.get_next_token();
+        return scanner.next_token();
+    }
+
+    // Stops parsing once the query has more condition expressions than allowed. A NOT is
+    // counted when it is shifted (see wrapper::open_not), as its operand is reduced only
+    // after every NOT in front of it has been pushed onto the parse stack.
+    #define GENQUERY_COUNT_EXPRESSION(location) if (!wrapper.count_expression(location)) { YYABORT; }
+
+    // boost::recursive_wrapper moves by allocating a new node and moving the old one
+    // into it, so moving an operator moves its whole subtree. Assigning between variants
+    // which hold the same alternative swaps pointers instead. Condition expressions are
+    // therefore passed around by pointer and moved into their parent with transfer(),
+    // which keeps building the tree linear in its size.
+    static void transfer(gq::ConditionExpression& dst, gq::ConditionExpression& src)
+    {
+        if (boost::get<gq::ConditionOperator_And>(&src)) {
+            dst = gq::ConditionOperator_And{};
+        }
+        else if (boost::get<gq::ConditionOperator_Or>(&src)) {
+            dst = gq::ConditionOperator_Or{};
+        }
+        else if (boost::get<gq::ConditionOperator_Not>(&src)) {
+            dst = gq::ConditionOperator_Not{};
+        }
+
+        dst = std::move(src);
+    }
+
+    template <typename Operator>
+    static auto make_operator(gq::ConditionExpression& left, gq::ConditionExpression& right)
+        -> std::unique_ptr<gq::ConditionExpression>
+    {
+        auto e = std::make_unique<gq::ConditionExpression>(Operator{});
+        auto& op = boost::get<Operator>(*e);
+        transfer(op.left, left);
+        transfer(op.right, right);
+        return e;
+    }
+
+    static auto make_not(gq::ConditionExpression& operand) -> std::unique_ptr<gq::ConditionExpression>
+    {
+        auto e = std::make_unique<gq::ConditionExpression>(gq::ConditionOperator_Not{});
+        transfer(boost::get<gq::ConditionOperator_Not>(*e).expression, operand);
+        return e;
+    }
+
+    template <typename Leaf, typename... Args>
+    static auto make_leaf(Args&&... args) -> std::unique_ptr<gq::ConditionExpression>
+    {
+        return std::make_unique<gq::ConditionExpression>(Leaf(std::forward<Args>(args)...));
     }
 }
 
@@ -63,6 +113,7 @@ This option causes make_* functions to be generated for each token kind.
 
 %token <std::string> IDENTIFIER STRING_LITERAL
 %token SELECT NO_DISTINCT WHERE AND COMMA OPEN_PAREN CLOSE_PAREN
+%token ORDER_BY GROUP_BY ASC DESC
 %token BETWEEN EQUAL NOT_EQUAL BEGINNING_OF LIKE IN PARENT_OF
 %token LESS_THAN GREATER_THAN LESS_THAN_OR_EQUAL_TO GREATER_THAN_OR_EQUAL_TO
 %token CONDITION_OR CONDITION_AND CONDITION_NOT CONDITION_OR_EQUAL
@@ -91,18 +142,34 @@ rules only.
 %type<gq::Column> column;
 %type<gq::SelectFunction> select_function;
 %type<gq::Condition> condition;
-%type<gq::ConditionExpression> condition_expression;
+%type<std::unique_ptr<gq::ConditionExpression>> condition_expression;
 %type<std::vector<std::string>> list_of_string_literals;
+%type<gq::GroupBy> list_of_columns;
+%type<gq::OrderBy> list_of_sort_expressions;
+%type<gq::SortExpression> sort_expression;
 
 %start select /* Defines where grammar starts */
 
 %%
 
 select:
-    SELECT selections  { std::swap(wrapper._select.selections, $2); }
-  | SELECT selections WHERE conditions  { std::swap(wrapper._select.selections, $2); std::swap(wrapper._select.conditions, $4); }
-  | SELECT NO_DISTINCT selections  { wrapper._select.no_distinct = true; std::swap(wrapper._select.selections, $3); }
-  | SELECT NO_DISTINCT selections WHERE conditions  { wrapper._select.no_distinct = true; std::swap(wrapper._select.selections, $3); std::swap(wrapper._select.conditions, $5); }
+    SELECT selections select_clauses  { std::swap(wrapper._select.selections, $2); }
+  | SELECT NO_DISTINCT selections select_clauses  { wrapper._select.no_distinct = true; std::swap(wrapper._select.selections, $3); }
+
+select_clauses:
+    where_clause group_by_clause order_by_clause
+
+where_clause:
+    %empty
+  | WHERE conditions  { std::swap(wrapper._select.conditions, $2); }
+
+group_by_clause:
+    %empty
+  | GROUP_BY list_of_columns  { std::swap(wrapper._select.group_by, $2); }
+
+order_by_clause:
+    %empty
+  | ORDER_BY list_of_sort_expressions  { std::swap(wrapper._select.order_by, $2); }
 
 selections:
     selection  { $$ = gq::Selections{std::move($1)}; }
@@ -123,31 +190,43 @@ conditions:
   | conditions AND condition  { $1.push_back(std::move($3)); std::swap($$, $1); }
 
 condition:
-    column condition_expression  { $$ = gq::Condition(std::move($1), std::move($2)); }
+    column condition_expression  { $$ = gq::Condition(std::move($1), gq::ConditionExpression{}); transfer($$.expression, *$2); }
 
 condition_expression:
-    LIKE STRING_LITERAL  { $$ = gq::ConditionLike(std::move($2)); }
-  | IN OPEN_PAREN list_of_string_literals CLOSE_PAREN  { $$ = gq::ConditionIn(std::move($3)); }
-  | BETWEEN STRING_LITERAL STRING_LITERAL { $$ = gq::ConditionBetween(std::move($2), std::move($3)); }
-  | EQUAL STRING_LITERAL  { $$ = gq::ConditionEqual(std::move($2)); }
-  | NOT_EQUAL STRING_LITERAL  { $$ = gq::ConditionNotEqual(std::move($2)); }
-  | LESS_THAN STRING_LITERAL  { $$ = gq::ConditionLessThan(std::move($2)); }
-  | LESS_THAN_OR_EQUAL_TO STRING_LITERAL  { $$ = gq::ConditionLessThanOrEqualTo(std::move($2)); }
-  | GREATER_THAN STRING_LITERAL  { $$ = gq::ConditionGreaterThan(std::move($2)); }
-  | GREATER_THAN_OR_EQUAL_TO STRING_LITERAL  { $$ = gq::ConditionGreaterThanOrEqualTo(std::move($2)); }
-  | PARENT_OF STRING_LITERAL  { $$ = gq::ConditionParentOf(std::move($2)); }
-  | BEGINNING_OF STRING_LITERAL  { $$ = gq::ConditionBeginningOf(std::move($2)); }
-  | condition_expression CONDITION_AND condition_expression  { $$ = gq::ConditionOperator_And(std::move($1), std::move($3)); }
-  | condition_expression CONDITION_OR  condition_expression  { $$ = gq::ConditionOperator_Or (std::move($1), std::move($3)); }
-  | CONDITION_NOT condition_expression  { $$ = gq::ConditionOperator_Not(std::move($2)); }
+    LIKE STRING_LITERAL  { GENQUERY_COUNT_EXPRESSION(@$) $$ = make_leaf<gq::ConditionLike>(std::move($2)); }
+  | IN OPEN_PAREN list_of_string_literals CLOSE_PAREN  { GENQUERY_COUNT_EXPRESSION(@$) $$ = make_leaf<gq::ConditionIn>(std::move($3)); }
+  | BETWEEN STRING_LITERAL STRING_LITERAL { GENQUERY_COUNT_EXPRESSION(@$) $$ = make_leaf<gq::ConditionBetween>(std::move($2), std::move($3)); }
+  | EQUAL STRING_LITERAL  { GENQUERY_COUNT_EXPRESSION(@$) $$ = make_leaf<gq::ConditionEqual>(std::move($2)); }
+  | NOT_EQUAL STRING_LITERAL  { GENQUERY_COUNT_EXPRESSION(@$) $$ = make_leaf<gq::ConditionNotEqual>(std::move($2)); }
+  | LESS_THAN STRING_LITERAL  { GENQUERY_COUNT_EXPRESSION(@$) $$ = make_leaf<gq::ConditionLessThan>(std::move($2)); }
+  | LESS_THAN_OR_EQUAL_TO STRING_LITERAL  { GENQUERY_COUNT_EXPRESSION(@$) $$ = make_leaf<gq::ConditionLessThanOrEqualTo>(std::move($2)); }
+  | GREATER_THAN STRING_LITERAL  { GENQUERY_COUNT_EXPRESSION(@$) $$ = make_leaf<gq::ConditionGreaterThan>(std::move($2)); }
+  | GREATER_THAN_OR_EQUAL_TO STRING_LITERAL  { GENQUERY_COUNT_EXPRESSION(@$) $$ = make_leaf<gq::ConditionGreaterThanOrEqualTo>(std::move($2)); }
+  | PARENT_OF STRING_LITERAL  { GENQUERY_COUNT_EXPRESSION(@$) $$ = make_leaf<gq::ConditionParentOf>(std::move($2)); }
+  | BEGINNING_OF STRING_LITERAL  { GENQUERY_COUNT_EXPRESSION(@$) $$ = make_leaf<gq::ConditionBeginningOf>(std::move($2)); }
+  | condition_expression CONDITION_AND condition_expression  { GENQUERY_COUNT_EXPRESSION(@$) $$ = make_operator<gq::ConditionOperator_And>(*$1, *$3); }
+  | condition_expression CONDITION_OR  condition_expression  { GENQUERY_COUNT_EXPRESSION(@$) $$ = make_operator<gq::ConditionOperator_Or>(*$1, *$3); }
+  | CONDITION_NOT { if (!wrapper.open_not(@1)) { YYABORT; } } condition_expression  { wrapper.close_not(); $$ = make_not(*$3); }
+
+list_of_columns:
+    column  { $$ = gq::GroupBy{std::move($1)}; }
+  | list_of_columns COMMA column  { $1.push_back(std::move($3)); std::swap($$, $1); }
+
+list_of_sort_expressions:
+    sort_expression  { $$ = gq::OrderBy{std::move($1)}; }
+  | list_of_sort_expressions COMMA sort_expression  { $1.push_back(std::move($3)); std::swap($$, $1); }
+
+sort_expression:
+    column  { $$ = gq::SortExpression{std::move($1), true}; }
+  | column ASC  { $$ = gq::SortExpression{std::move($1), true}; }
+  | column DESC  { $$ = gq::SortExpression{std::move($1), false}; }
 
 list_of_string_literals:
     STRING_LITERAL  { $$ = std::vector<std::string>{std::move($1)}; }
-  | list_of_string_literals COMMA STRING_LITERAL  { $1.push_back(std::move($3)); std::swap($$, $1); }
+  | list_of_string_literals COMMA STRING_LITERAL  { if (!wrapper.check_list_length(@3, $1.size() + 1)) { YYABORT; } $1.push_back(std::move($3)); std::swap($$, $1); }
 
 %%
 
 void gq::Parser::error(const location& location, const std::string& message) {
-    // TODO: improve error handling
-    std::cerr << "Error: " << message << std::endl << "Error location: " << wrapper.location() << std::endl;
+    wrapper.fail(gq::error_code::syntax_error, location, {}, message);
 }
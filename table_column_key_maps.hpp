@@ -1,14 +1,13 @@
 #ifndef IRODS_TABLE_COLUMN_KEY_MAPS_HPP
 #define IRODS_TABLE_COLUMN_KEY_MAPS_HPP
 
-#include <map>
+#include <string_view>
 #include <tuple>
-#include <string>
-#include <vector>
+#include <utility>
 
 namespace irods::experimental::api::genquery
 {
-    const std::map<std::string, std::tuple<std::string, int>> table_alias_cycler_map{
+    constexpr std::pair<std::string_view, std::tuple<std::string_view, int>> table_alias_cycler_map[]{
         {"R_USER_PASSWORD", {"R_USER_PASSWORD", 0 }},
         {"R_USER_SESSION_KEY", {"R_USER_SESSION_KEY", 0 }},
         {"R_TOKN_MAIN", {"R_TOKN_MAIN", 0 }},
@@ -156,7 +155,7 @@ namespace irods::experimental::api::genquery
 
     /* Map the #define values to tables and columns */
 
-    const std::map<std::string, std::tuple<std::string, std::string>> column_table_alias_map{
+    constexpr std::pair<std::string_view, std::tuple<std::string_view, std::string_view>> column_table_alias_map[]{
         {"ZONE_ID", {"R_ZONE_MAIN", "zone_id" }},
         {"ZONE_NAME", {"R_ZONE_MAIN", "zone_name" }},
         {"ZONE_TYPE", {"R_ZONE_MAIN", "zone_type_name" }},
@@ -538,9 +537,98 @@ namespace irods::experimental::api::genquery
         {"TICKET_DATA_COLL_NAME", {"r_ticket_data_coll_main", "coll_name" }}
     }; // column_table_alias_map
 
+    /* Columns which never hold NULL: the primary keys of the main tables */
+
+    constexpr std::string_view not_null_columns[]{
+        "ZONE_ID",
+        "USER_ID",
+        "RESC_ID",
+        "DATA_ID",
+        "COLL_ID",
+        "RULE_EXEC_ID",
+        "TOKEN_ID",
+        "RULE_ID",
+        "MSRVC_ID",
+        "TICKET_ID"
+    }; // not_null_columns
+
+    /* Columns which hold integers (bigint or integer in the catalog). The others hold text, including the timestamps */
+
+    constexpr std::string_view integer_columns[]{
+        "ZONE_ID",
+        "USER_ID",
+        "USER_AUTH_ID",
+        "RESC_ID",
+        "DATA_ID",
+        "COLL_ID",
+        "DATA_REPL_NUM",
+        "DATA_SIZE",
+        "DATA_REPL_STATUS",
+        "MAP_ID",
+        "DATA_RESC_ID",
+        "DATA_ACCESS_TYPE",
+        "DATA_ACCESS_USER_ID",
+        "DATA_ACCESS_DATA_ID",
+        "COLL_ACCESS_TYPE",
+        "COLL_ACCESS_USER_ID",
+        "COLL_ACCESS_COLL_ID",
+        "COLL_MAP_ID",
+        "META_DATA_ATTR_ID",
+        "META_COLL_ATTR_ID",
+        "META_RESC_ATTR_ID",
+        "META_RESC_GROUP_ATTR_ID",
+        "META_USER_ATTR_ID",
+        "META_RULE_ATTR_ID",
+        "META_MSRVC_ATTR_ID",
+        "RULE_EXEC_ID",
+        "TOKEN_ID",
+        "AUDIT_OBJ_ID",
+        "AUDIT_USER_ID",
+        "AUDIT_ACTION_ID",
+        "RULE_ID",
+        "RULE_STATUS",
+        "DVM_ID",
+        "DVM_STATUS",
+        "FNM_ID",
+        "FNM_STATUS",
+        "QUOTA_USER_ID",
+        "QUOTA_RESC_ID",
+        "QUOTA_LIMIT",
+        "QUOTA_OVER",
+        "QUOTA_USAGE_USER_ID",
+        "QUOTA_USAGE_RESC_ID",
+        "QUOTA_USAGE",
+        "MSRVC_ID",
+        "MSRVC_STATUS",
+        "META_ACCESS_TYPE",
+        "META_ACCESS_USER_ID",
+        "META_ACCESS_META_ID",
+        "RESC_ACCESS_TYPE",
+        "RESC_ACCESS_USER_ID",
+        "RESC_ACCESS_RESC_ID",
+        "RULE_ACCESS_TYPE",
+        "RULE_ACCESS_USER_ID",
+        "RULE_ACCESS_RULE_ID",
+        "MSRVC_ACCESS_TYPE",
+        "MSRVC_ACCESS_USER_ID",
+        "MSRVC_ACCESS_MSRVC_ID",
+        "TICKET_ID",
+        "TICKET_USER_ID",
+        "TICKET_OBJECT_ID",
+        "TICKET_USES_LIMIT",
+        "TICKET_USES_COUNT",
+        "TICKET_WRITE_FILE_LIMIT",
+        "TICKET_WRITE_FILE_COUNT",
+        "TICKET_WRITE_BYTE_LIMIT",
+        "TICKET_WRITE_BYTE_COUNT",
+        "TICKET_ALLOWED_HOST_TICKET_ID",
+        "TICKET_ALLOWED_USER_TICKET_ID",
+        "TICKET_ALLOWED_GROUP_TICKET_ID"
+    }; // integer_columns
+
     /* Define the Foreign Key links between tables */
 
-    const std::vector<std::tuple<std::string, std::string, std::string>> foreign_key_link_map{
+    constexpr std::tuple<std::string_view, std::string_view, std::string_view> foreign_key_link_map[]{
         {"R_COLL_MAIN", "R_DATA_MAIN", "R_COLL_MAIN.coll_id = R_DATA_MAIN.coll_id" },
         {"R_RESC_GROUP", "R_RESC_MAIN", "R_RESC_GROUP.resc_id = R_RESC_MAIN.resc_id" },
         {"R_RESC_MAIN", "r_resc_metamap", "R_RESC_MAIN.resc_id = r_resc_metamap.object_id" },
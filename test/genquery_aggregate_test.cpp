@@ -0,0 +1,113 @@
+#include "genquery_test.hpp"
+
+#include "genquery_schema.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_sqlite_catalog.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    auto rows_of(gq::sqlite::database& _db, const std::string& _sql) -> std::vector<gq::row>
+    {
+        gq::sqlite::statement s{_db, _sql};
+        std::vector<gq::row> ret;
+
+        while (s.step()) {
+            auto& row = ret.emplace_back();
+            for (int i = 0; i < s.column_count(); ++i) {
+                row.emplace_back(s.column_text(i));
+            }
+        }
+
+        return ret;
+    }
+
+    auto sql_of(const std::string& _query) -> std::string
+    {
+        return gq::sql(gq::wrapper::parse(_query), gq::options{});
+    }
+} // anonymous namespace
+
+// Aggregate selections are computed by the database, grouped by the other selections,
+// and return the rows of a plain loop over the rows they aggregate.
+int main()
+{
+    // The argument is resolved like a selected column, and the other selections are
+    // grouped.
+    GENQUERY_CHECK_EQUAL(sql_of("select COLL_NAME, COUNT(DATA_ID), SUM(DATA_SIZE), MIN(DATA_NAME), MAX(DATA_SIZE)"),
+                         std::string{"SELECT DISTINCT R_COLL_MAIN.coll_name, COUNT(R_DATA_MAIN.data_id), SUM(R_DATA_MAIN.data_size), "
+                                     "MIN(R_DATA_MAIN.data_name), MAX(R_DATA_MAIN.data_size) FROM R_COLL_MAIN, R_DATA_MAIN "
+                                     "WHERE R_COLL_MAIN.coll_id = R_DATA_MAIN.coll_id GROUP BY R_COLL_MAIN.coll_name"});
+    GENQUERY_CHECK(sql_of("select AVG(DATA_SIZE) where DATA_NAME = 'x'").find("SELECT DISTINCT AVG(R_DATA_MAIN.data_size) FROM ") == 0);
+
+    // Functions outside the list are rejected.
+    GENQUERY_CHECK(!gq::try_translate("select LENGTH(DATA_NAME)", gq::options{}));
+
+    gq::sqlite::database db{":memory:"};
+
+    gq::sqlite::catalog_options catalog;
+    catalog.data_objects = 2000;
+    catalog.objects_per_collection = 50;
+    catalog.users = 20;
+
+    {
+        const gq::schema_snapshot schema;
+        gq::sqlite::create_catalog(db, schema.get(), catalog);
+    }
+
+    struct aggregate
+    {
+        std::int64_t count = 0;
+        std::int64_t sum = 0;
+        std::string min_name;
+        std::int64_t max_size = 0;
+    };
+
+    std::map<std::string, aggregate> expected;
+
+    for (auto&& r : rows_of(db, sql_of("select no-distinct COLL_NAME, DATA_ID, DATA_SIZE, DATA_NAME"))) {
+        auto& a = expected[r[0]];
+        const std::int64_t size = std::stoll(r[2]);
+
+        a.min_name = 0 == a.count ? r[3] : std::min(a.min_name, r[3]);
+        a.max_size = 0 == a.count ? size : std::max(a.max_size, size);
+        a.sum += size;
+        ++a.count;
+    }
+
+    GENQUERY_CHECK(expected.size() > 1);
+
+    const auto rows = rows_of(db, sql_of("select COLL_NAME, COUNT(DATA_ID), SUM(DATA_SIZE), MIN(DATA_NAME), MAX(DATA_SIZE)"));
+    GENQUERY_CHECK_EQUAL(rows.size(), expected.size());
+
+    for (auto&& r : rows) {
+        const auto iter = expected.find(r[0]);
+        if (iter == std::end(expected)) {
+            genquery_test::fail(__FILE__, __LINE__, fmt::format("unexpected collection [{}]", r[0]));
+            continue;
+        }
+
+        const auto& a = iter->second;
+        GENQUERY_CHECK_EQUAL(r[1], std::to_string(a.count));
+        GENQUERY_CHECK_EQUAL(r[2], std::to_string(a.sum));
+        GENQUERY_CHECK_EQUAL(r[3], a.min_name);
+        GENQUERY_CHECK_EQUAL(r[4], std::to_string(a.max_size));
+    }
+
+    // Counting every object returns a single row.
+    const auto count = rows_of(db, sql_of("select COUNT(DATA_ID)"));
+    GENQUERY_CHECK_EQUAL(count.size(), std::size_t{1});
+    GENQUERY_CHECK_EQUAL(count.empty() ? std::string{} : count[0][0], std::to_string(catalog.data_objects));
+
+    return genquery_test::exit_status();
+}
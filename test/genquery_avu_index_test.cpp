@@ -0,0 +1,176 @@
+#include "genquery_test.hpp"
+
+#include "genquery_avu_index.hpp"
+#include "genquery_schema.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_sqlite_catalog.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    auto rows_of(gq::sqlite::database& _db, const std::string& _sql) -> std::vector<gq::row>
+    {
+        gq::sqlite::statement s{_db, _sql};
+        std::vector<gq::row> ret;
+
+        while (s.step()) {
+            auto& row = ret.emplace_back();
+            for (int i = 0; i < s.column_count(); ++i) {
+                row.emplace_back(s.column_text(i));
+            }
+        }
+
+        std::sort(std::begin(ret), std::end(ret));
+        return ret;
+    }
+
+    auto same(const gq::posting_list& _l, const std::set<std::int64_t>& _s) -> bool
+    {
+        return _l.size() == _s.size() && _l.ids() == std::vector<std::int64_t>(std::begin(_s), std::end(_s));
+    }
+
+    // Ids in a few chunks, dense enough in the first one for it to become a bitmap.
+    auto random_id(std::mt19937& _rng) -> std::int64_t
+    {
+        return 0 == _rng() % 2 ? _rng() % 8192 : static_cast<std::int64_t>(_rng() % 4) * 65536 + _rng() % 300;
+    }
+
+    auto random_list(std::mt19937& _rng, std::size_t _n) -> std::pair<gq::posting_list, std::set<std::int64_t>>
+    {
+        std::pair<gq::posting_list, std::set<std::int64_t>> ret;
+        for (std::size_t i = 0; i < _n; ++i) {
+            const auto id = random_id(_rng);
+            ret.first.insert(id);
+            ret.second.insert(id);
+        }
+        return ret;
+    }
+} // anonymous namespace
+
+int main()
+{
+    // Posting lists hold the ids a std::set holds, as arrays and as bitmaps.
+    {
+        std::mt19937 rng{11};
+        gq::posting_list list;
+        std::set<std::int64_t> ids;
+
+        for (int i = 0; i < 40000; ++i) {
+            const auto id = random_id(rng);
+
+            // Mostly insertions at first and mostly erasures later, so the first chunk
+            // grows past max_array_size and shrinks back.
+            if (rng() % 40000 < static_cast<unsigned>(i)) {
+                GENQUERY_CHECK_EQUAL(list.erase(id), ids.erase(id) > 0);
+            }
+            else {
+                GENQUERY_CHECK_EQUAL(list.insert(id), ids.insert(id).second);
+            }
+
+            GENQUERY_CHECK_EQUAL(list.contains(id), ids.count(id) > 0);
+
+            if (0 == i % 1000 && !same(list, ids)) {
+                genquery_test::fail(__FILE__, __LINE__, fmt::format("the list differs after {} updates", i + 1));
+            }
+        }
+
+        GENQUERY_CHECK(same(list, ids));
+    }
+
+    // Intersections and unions combine the chunks as the sets do.
+    {
+        std::mt19937 rng{13};
+
+        for (const std::size_t n : {std::size_t{10}, std::size_t{1000}, std::size_t{12000}}) {
+            const auto [a, a_ids] = random_list(rng, n);
+            const auto [b, b_ids] = random_list(rng, n / 2 + 1);
+
+            std::set<std::int64_t> both;
+            std::set_intersection(std::begin(a_ids), std::end(a_ids), std::begin(b_ids), std::end(b_ids), std::inserter(both, both.end()));
+
+            std::set<std::int64_t> either = a_ids;
+            either.insert(std::begin(b_ids), std::end(b_ids));
+
+            auto i = a;
+            i &= b;
+            GENQUERY_CHECK(same(i, both));
+
+            auto u = a;
+            u |= b;
+            GENQUERY_CHECK(same(u, either));
+        }
+    }
+
+    // Groups answered by the index return the rows of the groups the database evaluates.
+    gq::sqlite::database db{":memory:"};
+
+    gq::sqlite::catalog_options catalog;
+    catalog.data_objects = 2000;
+    catalog.objects_per_collection = 50;
+    catalog.users = 8;
+
+    const gq::schema_snapshot schema;
+    gq::sqlite::create_catalog(db, schema.get(), catalog);
+    const auto metadata = gq::sqlite::load_metadata(db, schema.get());
+    GENQUERY_CHECK(metadata.count("r_data_meta_main") > 0);
+
+    // Two AVUs of the same object, so the groups below have rows in common.
+    const auto avus = rows_of(db, "select m.meta_attr_name, m.meta_attr_value from R_OBJT_METAMAP o, R_META_MAIN m "
+                                  "where o.meta_id = m.meta_id and o.object_id = (select min(data_id) from R_DATA_MAIN)");
+    GENQUERY_CHECK(avus.size() >= 2);
+
+    const std::vector<std::string> conditions{
+        fmt::format("META_DATA_ATTR_NAME = '{}'", avus[0][0]),
+        fmt::format("META_DATA_ATTR_NAME = '{}' and META_DATA_ATTR_VALUE = '{}'", avus[0][0], avus[0][1]),
+        fmt::format("META_DATA_ATTR_VALUE = '{}'", avus[0][1]),
+        "META_DATA_ATTR_NAME like 'attr1%' and META_DATA_ATTR_VALUE > 'value5'",
+        "META_DATA_ATTR_NAME in ('attr1', 'attr2') and META_DATA_ATTR_VALUE != 'value3'",
+        fmt::format("META_DATA_ATTR_NAME = '{}' and META_DATA_ATTR_VALUE = '{}' and META_DATA_ATTR_NAME = '{}' and META_DATA_ATTR_VALUE = '{}'",
+                    avus[0][0], avus[0][1], avus[1][0], avus[1][1]),
+        fmt::format("META_DATA_ATTR_NAME = '{}' and META_DATA_ATTR_NAME = 'no such attribute'", avus[0][0]),
+        fmt::format("META_DATA_ATTR_NAME = '{}' and DATA_SIZE > '1000'", avus[0][0]),
+        "META_COLL_ATTR_NAME like 'attr%'",
+    };
+
+    for (auto&& c : conditions) {
+        const auto query = gq::wrapper::parse(fmt::format("select COLL_NAME, DATA_NAME where {}", c));
+        const auto expected = rows_of(db, gq::sql(query, gq::options{}));
+
+        for (const std::size_t limit : {std::size_t{1000}, std::size_t{5}}) {
+            gq::options opts;
+            opts.metadata = &metadata;
+            opts.max_resolved_objects = limit;
+
+            if (rows_of(db, gq::sql(query, opts)) != expected) {
+                genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}] with at most {} resolved objects", c, limit));
+            }
+        }
+    }
+
+    // Resolved groups leave the metadata tables out, and groups without objects match
+    // nothing.
+    gq::options opts;
+    opts.metadata = &metadata;
+
+    const auto resolved = gq::sql(gq::wrapper::parse(fmt::format("select DATA_NAME where META_DATA_ATTR_NAME = '{}' and META_DATA_ATTR_VALUE = '{}'",
+                                                                 avus[0][0], avus[0][1])),
+                                  opts);
+    GENQUERY_CHECK(resolved.find("R_DATA_MAIN.data_id IN (") != std::string::npos);
+    GENQUERY_CHECK(resolved.find("r_data_meta_main") == std::string::npos);
+    GENQUERY_CHECK(gq::sql(gq::wrapper::parse("select DATA_NAME where META_DATA_ATTR_NAME = 'no such attribute'"), opts).find("0 = 1") !=
+                   std::string::npos);
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,164 @@
+#include "genquery_test.hpp"
+
+#include "genquery_schema.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_sqlite_catalog.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    // An AVU group: an attribute name, and a value unless empty.
+    using avu = std::pair<std::string, std::string>;
+
+    auto query_of(const std::vector<avu>& _groups) -> std::string
+    {
+        std::string ret = "select DATA_NAME";
+        const char* separator = " where ";
+
+        for (auto&& [attribute, value] : _groups) {
+            ret += fmt::format("{}META_DATA_ATTR_NAME = '{}'", separator, attribute);
+            separator = " and ";
+
+            if (!value.empty()) {
+                ret += fmt::format(" and META_DATA_ATTR_VALUE = '{}'", value);
+            }
+        }
+
+        return ret;
+    }
+
+    auto names_of(gq::sqlite::database& _db, const std::string& _sql) -> std::set<std::string>
+    {
+        gq::sqlite::statement s{_db, _sql};
+        std::set<std::string> ret;
+
+        while (s.step()) {
+            ret.emplace(s.column_text(0));
+        }
+
+        return ret;
+    }
+
+    auto contains(const std::string& _s, std::string_view _part) -> bool
+    {
+        return _s.find(_part) != std::string::npos;
+    }
+} // anonymous namespace
+
+// Every AVU strategy returns the data objects which have an AVU matching each group.
+int main()
+{
+    gq::sqlite::database db{":memory:"};
+
+    gq::sqlite::catalog_options catalog;
+    catalog.data_objects = 2000;
+    catalog.objects_per_collection = 50;
+    catalog.users = 20;
+
+    {
+        const gq::schema_snapshot schema;
+        gq::sqlite::create_catalog(db, schema.get(), catalog);
+    }
+
+    // The AVUs of each data object.
+    std::map<std::string, std::set<avu>> avus;
+
+    {
+        gq::sqlite::statement s{db, "select d.data_name, m.meta_attr_name, m.meta_attr_value "
+                                    "from R_DATA_MAIN d, R_OBJT_METAMAP o, R_META_MAIN m "
+                                    "where d.data_id = o.object_id and o.meta_id = m.meta_id"};
+        while (s.step()) {
+            avus[std::string{s.column_text(0)}].emplace(s.column_text(1), s.column_text(2));
+        }
+    }
+
+    // Groups which some object satisfies together: the AVUs of the first object with
+    // at least three.
+    std::vector<avu> sample;
+    for (auto&& [name, object_avus] : avus) {
+        if (object_avus.size() >= 3) {
+            sample.assign(std::begin(object_avus), std::end(object_avus));
+            break;
+        }
+    }
+    GENQUERY_CHECK(sample.size() >= 3);
+
+    const std::vector<std::vector<avu>> cases{
+        {{sample[0].first, ""}},
+        {sample[0]},
+        {{sample[0].first, ""}, {sample[1].first, ""}},
+        {sample[0], sample[1]},
+        {sample[0], sample[1], {sample[2].first, ""}},
+        {sample[0], {"attr1", ""}, {"attr2", ""}, {"attr3", ""}, {"attr4", ""}},
+        {{"attr0", "no such value"}},
+    };
+
+    for (auto&& groups : cases) {
+        // The plain loop.
+        std::set<std::string> expected;
+        for (auto&& [name, object_avus] : avus) {
+            bool matches = true;
+
+            for (auto&& [attribute, value] : groups) {
+                bool found = false;
+                for (auto&& a : object_avus) {
+                    found = found || (a.first == attribute && (value.empty() || a.second == value));
+                }
+                matches = matches && found;
+            }
+
+            if (matches) {
+                expected.insert(name);
+            }
+        }
+
+        const auto query = query_of(groups);
+        const auto select = gq::wrapper::parse(query);
+
+        for (auto strategy : {gq::avu_strategy::automatic, gq::avu_strategy::join, gq::avu_strategy::exists, gq::avu_strategy::intersect}) {
+            gq::options opts;
+            opts.avu = strategy;
+
+            const auto sql = gq::sql(select, opts);
+            const auto actual = names_of(db, sql);
+
+            if (actual != expected) {
+                genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}] [{}]: {} rows, expected {}", query, sql, actual.size(), expected.size()));
+            }
+        }
+    }
+
+    // The automatic strategy joins fewer than avu_exists_threshold groups, and uses
+    // INTERSECT from avu_intersect_threshold groups on.
+    const auto automatic = [](const std::vector<avu>& _groups) { return gq::sql(gq::wrapper::parse(query_of(_groups)), gq::options{}); };
+
+    const auto one = automatic({{"a", "b"}});
+    GENQUERY_CHECK(contains(one, "r_data_metamap_1.meta_id = r_data_meta_main_1.meta_id"));
+    GENQUERY_CHECK(contains(one, "R_DATA_MAIN.data_id = r_data_metamap_1.object_id"));
+    GENQUERY_CHECK(contains(one, "r_data_meta_main_1.meta_attr_name = 'a' AND r_data_meta_main_1.meta_attr_value = 'b'"));
+    GENQUERY_CHECK(!contains(one, "EXISTS") && !contains(one, "INTERSECT"));
+
+    const auto two = automatic({{"a", ""}, {"b", ""}});
+    GENQUERY_CHECK(contains(two, "EXISTS (SELECT 1 FROM R_OBJT_METAMAP r_data_metamap, R_META_MAIN r_data_meta_main "
+                                 "WHERE r_data_metamap.meta_id = r_data_meta_main.meta_id AND r_data_meta_main.meta_attr_name = 'b' "
+                                 "AND R_DATA_MAIN.data_id = r_data_metamap.object_id)"));
+    GENQUERY_CHECK(!contains(two, "INTERSECT"));
+
+    const auto five = automatic({{"a", ""}, {"b", ""}, {"c", ""}, {"d", ""}, {"e", ""}});
+    GENQUERY_CHECK(contains(five, "R_DATA_MAIN.data_id IN (SELECT r_data_metamap.object_id FROM"));
+    GENQUERY_CHECK(contains(five, "r_data_meta_main.meta_attr_name = 'd' INTERSECT SELECT r_data_metamap.object_id"));
+    GENQUERY_CHECK(!contains(five, "EXISTS"));
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,124 @@
+#include "genquery_test.hpp"
+
+#include "genquery_batch.hpp"
+#include "genquery_json.hpp"
+#include "genquery_sql.hpp"
+
+#include <fmt/format.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    auto queries() -> std::vector<std::string>
+    {
+        std::vector<std::string> ret;
+
+        for (int i = 0; i < 400; ++i) {
+            switch (i % 5) {
+                case 0: ret.push_back(fmt::format("select DATA_NAME where DATA_ID = '{}'", i)); break;
+                case 1: ret.push_back(fmt::format("select COLL_NAME, COUNT(DATA_ID) where COLL_NAME like '/tempZone/{}/%'", i)); break;
+                case 2: ret.push_back(fmt::format("select DATA_NAME where META_DATA_ATTR_NAME = 'a{}' and META_DATA_ATTR_VALUE = 'b'", i)); break;
+                case 3: ret.push_back(fmt::format("select NO_SUCH_COLUMN_{}", i)); break;
+                case 4: ret.push_back(fmt::format("select DATA_NAME where DATA_NAME = '{}' order by", i)); break;
+            }
+        }
+
+        return ret;
+    }
+
+    // The start of the line of a query, up to its bind values.
+    auto expected_line(const std::string& _query, const gq::options& _opts) -> std::string
+    {
+        const auto t = gq::try_translate(_query, _opts);
+        auto line = fmt::format("{{\"query\": {}, \"sql\": {}, \"bind_values\": [", gq::json::quote(_query), t ? gq::json::quote(t->sql) : "null");
+
+        if (t) {
+            for (std::size_t i = 0; i < t->bind_values.size(); ++i) {
+                line += (i > 0 ? ", " : "") + gq::json::quote(t->bind_values[i]);
+            }
+        }
+
+        return line + "]";
+    }
+
+    auto run(const std::string& _input, bool _nul_delimited, const std::vector<std::string>& _queries, const gq::options& _opts) -> void
+    {
+        const auto path = fmt::format("/tmp/genquery_batch_test.{}", ::getpid());
+        {
+            std::ofstream out{path, std::ios::binary};
+            out << _input;
+        }
+
+        gq::batch_options opts;
+        opts.input = path;
+        opts.nul_delimited = _nul_delimited;
+        opts.threads = 4;
+        opts.translation = _opts;
+
+        std::ostringstream out;
+        const auto summary = gq::run_batch(opts, out);
+        std::remove(path.c_str());
+
+        GENQUERY_CHECK_EQUAL(summary.queries, _queries.size());
+
+        std::istringstream lines{out.str()};
+        std::string line;
+        std::size_t n = 0;
+        std::size_t errors = 0;
+
+        // In input order.
+        while (std::getline(lines, line)) {
+            if (n >= _queries.size()) {
+                genquery_test::fail(__FILE__, __LINE__, "more lines than queries");
+                break;
+            }
+
+            const auto expected = expected_line(_queries[n], _opts);
+            if (line.compare(0, expected.size(), expected) != 0) {
+                genquery_test::fail(__FILE__, __LINE__, fmt::format("line {} is [{}], expected [{}...]", n, line, expected));
+            }
+
+            errors += line.find("\"error\": null") == std::string::npos;
+            ++n;
+        }
+
+        GENQUERY_CHECK_EQUAL(n, _queries.size());
+        GENQUERY_CHECK_EQUAL(summary.errors, errors);
+    }
+} // anonymous namespace
+
+// Batch mode writes the translation of each query, in the order of the input, whatever
+// the number of threads.
+int main()
+{
+    const auto q = queries();
+
+    std::string lines;
+    std::string nuls;
+    for (auto&& s : q) {
+        lines += s + "\n\n";
+        nuls += s + '\0';
+    }
+
+    run(lines, false, q, gq::options{});
+
+    gq::options parameterized;
+    parameterized.parameterize = true;
+    run(nuls, true, q, parameterized);
+
+    // The last query needs no delimiter.
+    lines.pop_back();
+    lines.pop_back();
+    run(lines, false, q, gq::options{});
+
+    return genquery_test::exit_status();
+}
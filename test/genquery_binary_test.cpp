@@ -0,0 +1,62 @@
+#include "genquery_test.hpp"
+
+#include "genquery_binary.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    template <typename F>
+    auto throws(F _f) -> bool
+    {
+        try {
+            _f();
+        }
+        catch (const std::exception&) {
+            return true;
+        }
+
+        return false;
+    }
+} // anonymous namespace
+
+// An encoded query decodes into a Select which translates as the parsed query does.
+int main()
+{
+    const std::vector<std::string> queries{
+        "select DATA_NAME",
+        "select no-distinct DATA_NAME, COUNT(DATA_ID) where COLL_NAME like '/z/%' group by DATA_NAME order by DATA_NAME desc",
+        "select DATA_ID where DATA_NAME in ('a', 'b', 'c') and DATA_SIZE between '1' '10'",
+        "select DATA_NAME where DATA_NAME not = 'a' || = 'b' && not like 'c%' and COLL_NAME begin_of '/z'",
+        "select DATA_NAME where META_DATA_ATTR_NAME = 'a' and META_DATA_ATTR_VALUE > '5'",
+    };
+
+    for (auto&& q : queries) {
+        const auto parsed = gq::wrapper::parse(q);
+        const auto buffer = gq::encode(parsed);
+        const auto decoded = gq::decode(gq::binary_select_view{buffer});
+
+        GENQUERY_CHECK_EQUAL(gq::sql(decoded, gq::options{}), gq::sql(parsed, gq::options{}));
+        GENQUERY_CHECK_EQUAL(gq::encode(decoded), buffer);
+    }
+
+    const auto buffer = gq::encode(gq::wrapper::parse("select DATA_NAME where DATA_NAME not not = 'a'"));
+
+    // Decoding applies the limits of a parse.
+    gq::query_limits limits;
+    limits.max_depth = 2;
+    GENQUERY_CHECK(throws([&] { gq::decode(gq::binary_select_view{buffer}, limits); }));
+
+    // Malformed buffers are rejected.
+    GENQUERY_CHECK(throws([&] { gq::decode(gq::binary_select_view{std::string_view{buffer}.substr(0, buffer.size() - 1)}); }));
+    GENQUERY_CHECK(throws([&] { gq::decode(gq::binary_select_view{std::string(buffer.size(), 'x')}); }));
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,72 @@
+#include "genquery_test.hpp"
+
+#include "genquery.h"
+
+#include <cstring>
+#include <string>
+
+namespace
+{
+    auto translate(genquery_context* _ctx, const char* _query, std::string& _sql) -> int
+    {
+        char buffer[4096];
+        std::size_t size = 0;
+        const auto status = genquery_translate(_ctx, _query, std::strlen(_query), buffer, sizeof(buffer), &size);
+        _sql.assign(buffer, GENQUERY_OK == status ? size : 0);
+        return status;
+    }
+
+    auto bind_value(genquery_context* _ctx, std::size_t _index) -> std::string
+    {
+        const char* value = nullptr;
+        std::size_t size = 0;
+
+        if (genquery_bind_value(_ctx, _index, &value, &size) != GENQUERY_OK) {
+            return "<none>";
+        }
+
+        return {value, size};
+    }
+} // anonymous namespace
+
+int main()
+{
+    auto* ctx = genquery_context_create(GENQUERY_PARAMETERIZE);
+    GENQUERY_CHECK(ctx != nullptr);
+
+    std::string sql;
+
+    // The required size is reported when the buffer is too small.
+    const char* query = "select COLL_NAME where DATA_NAME = 'foo' and COLL_NAME like '/a/%'";
+    char small[8];
+    std::size_t size = 0;
+    GENQUERY_CHECK_EQUAL(genquery_translate(ctx, query, std::strlen(query), small, sizeof(small), &size),
+                         GENQUERY_ERROR_BUFFER_TOO_SMALL);
+    GENQUERY_CHECK(size > sizeof(small));
+
+    GENQUERY_CHECK_EQUAL(translate(ctx, query, sql), GENQUERY_OK);
+    GENQUERY_CHECK_EQUAL(sql.size(), size);
+    GENQUERY_CHECK_EQUAL(static_cast<int>(genquery_bind_count(ctx)), 2);
+    GENQUERY_CHECK_EQUAL(bind_value(ctx, 0), std::string{"foo"});
+    GENQUERY_CHECK_EQUAL(bind_value(ctx, 1), std::string{"/a/%"});
+
+    // A translation with fewer bind values does not expose those of the previous one.
+    GENQUERY_CHECK_EQUAL(translate(ctx, "select DATA_NAME where DATA_SIZE > '10'", sql), GENQUERY_OK);
+    GENQUERY_CHECK_EQUAL(static_cast<int>(genquery_bind_count(ctx)), 1);
+    GENQUERY_CHECK_EQUAL(bind_value(ctx, 0), std::string{"10"});
+    GENQUERY_CHECK_EQUAL(bind_value(ctx, 1), std::string{"<none>"});
+
+    // Nor does a failed one.
+    GENQUERY_CHECK_EQUAL(translate(ctx, "select NOPE", sql), GENQUERY_ERROR_QUERY);
+    GENQUERY_CHECK_EQUAL(static_cast<int>(genquery_bind_count(ctx)), 0);
+    GENQUERY_CHECK(std::strlen(genquery_last_error(ctx)) > 0);
+
+    GENQUERY_CHECK_EQUAL(translate(ctx, query, sql), GENQUERY_OK);
+    GENQUERY_CHECK_EQUAL(static_cast<int>(genquery_bind_count(ctx)), 2);
+    GENQUERY_CHECK_EQUAL(bind_value(ctx, 1), std::string{"/a/%"});
+    GENQUERY_CHECK_EQUAL(std::string{genquery_last_error(ctx)}, std::string{});
+
+    genquery_context_destroy(ctx);
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,95 @@
+#include "genquery_test.hpp"
+
+#include "genquery_avu_index.hpp"
+#include "genquery_path_index.hpp"
+#include "genquery_schema.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    auto sql_of(std::string_view _query, gq::options _opts) -> std::string
+    {
+        const auto t = gq::try_translate(_query, _opts);
+        return t ? t->sql : gq::describe(t.error());
+    }
+
+    auto folded_sql_of(std::string_view _query) -> std::string
+    {
+        gq::options opts;
+        opts.case_insensitive = true;
+
+        const auto t = gq::try_translate(_query, opts);
+        return t ? t->sql : gq::describe(t.error());
+    }
+
+    auto contains(const std::string& _s, std::string_view _part) -> bool
+    {
+        return _s.find(_part) != std::string::npos;
+    }
+} // anonymous namespace
+
+int main()
+{
+    // Text columns are folded, integer columns compared as they are.
+    const auto sql = folded_sql_of("select DATA_NAME where DATA_SIZE = '10' and DATA_ID in ('1', '2') and DATA_NAME like 'A%'");
+    GENQUERY_CHECK(contains(sql, "R_DATA_MAIN.data_size = '10'"));
+    GENQUERY_CHECK(contains(sql, "R_DATA_MAIN.data_id IN ('1', '2')"));
+    GENQUERY_CHECK(contains(sql, "LOWER(R_DATA_MAIN.data_name) LIKE LOWER('A%')"));
+    GENQUERY_CHECK(!contains(sql, "LOWER(R_DATA_MAIN.data_size)"));
+    GENQUERY_CHECK(!contains(sql, "LOWER(R_DATA_MAIN.data_id)"));
+    GENQUERY_CHECK(!contains(sql, "LOWER('1')"));
+
+    // Including the conditions of metadata tables.
+    const auto meta = folded_sql_of("select DATA_NAME where META_DATA_ATTR_ID = '5' and META_DATA_ATTR_NAME = 'A'");
+    GENQUERY_CHECK(contains(meta, "r_data_meta_main_1.meta_id = '5'"));
+    GENQUERY_CHECK(contains(meta, "LOWER(r_data_meta_main_1.meta_attr_name) = LOWER('A')"));
+
+    // The indexes hold names as they are, so they answer only conditions which respect case.
+    gq::avu_indexes metadata;
+    metadata["r_data_meta_main"].insert(1, "Color", "Red");
+
+    gq::path_index paths;
+    paths.insert("/tempZone/Home", 7);
+
+    gq::options indexed;
+    indexed.metadata = &metadata;
+    indexed.collection_paths = &paths;
+
+    const auto avu_query = "select DATA_NAME where META_DATA_ATTR_NAME = 'color' and META_DATA_ATTR_VALUE = 'red'";
+    const auto path_query = "select COLL_ID where COLL_NAME begin_of '/tempzone/home'";
+    GENQUERY_CHECK(contains(sql_of(avu_query, indexed), "0 = 1"));
+    GENQUERY_CHECK(contains(sql_of(path_query, indexed), "0 = 1"));
+
+    indexed.case_insensitive = true;
+    const auto folded_avu = sql_of(avu_query, indexed);
+    GENQUERY_CHECK(!contains(folded_avu, "0 = 1"));
+    GENQUERY_CHECK(contains(folded_avu, "LOWER(r_data_meta_main_1.meta_attr_name) = LOWER('color')"));
+    GENQUERY_CHECK(contains(folded_avu, "LOWER(r_data_meta_main_1.meta_attr_value) = LOWER('red')"));
+    const auto folded_path = sql_of(path_query, indexed);
+    GENQUERY_CHECK(!contains(folded_path, "0 = 1"));
+    GENQUERY_CHECK(contains(folded_path, "R_COLL_MAIN.coll_name"));
+
+    // The type comes from the catalog.
+    gq::schema_compiler compiler;
+    compiler.add_builtin();
+    std::istringstream definitions{"column|DATA_CHECKSUM|R_DATA_MAIN|data_checksum|integer|not_null\n"};
+    compiler.add_definitions(definitions);
+    const auto catalog = gq::schema::from_buffer(compiler.compile());
+    GENQUERY_CHECK(gq::column_type::integer == catalog->column("DATA_CHECKSUM")->type);
+    GENQUERY_CHECK(catalog->column("DATA_CHECKSUM")->not_null);
+    GENQUERY_CHECK(gq::column_type::integer == catalog->column("DATA_SIZE")->type);
+    GENQUERY_CHECK(gq::column_type::text == catalog->column("DATA_NAME")->type);
+    GENQUERY_CHECK(gq::column_type::text == catalog->column("DATA_MODIFY_TIME")->type);
+
+    gq::publish_schema(catalog);
+    GENQUERY_CHECK(contains(folded_sql_of("select DATA_NAME where DATA_CHECKSUM = 'x'"), "R_DATA_MAIN.data_checksum = 'x'"));
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,106 @@
+#include "genquery_test.hpp"
+
+#include "genquery_coalesce.hpp"
+#include "genquery_schema.hpp"
+#include "genquery_sqlite_catalog.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    auto rows_of(gq::sqlite::database& _db, const std::string& _sql) -> std::vector<gq::row>
+    {
+        gq::sqlite::statement s{_db, _sql};
+        std::vector<gq::row> ret;
+
+        while (s.step()) {
+            auto& row = ret.emplace_back();
+            for (int i = 0; i < s.column_count(); ++i) {
+                row.emplace_back(s.column_text(i));
+            }
+        }
+
+        return ret;
+    }
+
+    // Checks that every request of a batch receives the rows it returns on its own.
+    // Returns the number of rows of all the requests.
+    auto check_batch(gq::sqlite::database& _db, const std::vector<std::string>& _queries) -> std::size_t
+    {
+        std::vector<gq::Select> batch;
+        for (auto&& q : _queries) {
+            batch.push_back(gq::wrapper::parse(q));
+        }
+
+        std::vector<std::vector<gq::row>> actual(batch.size());
+
+        for (auto&& stmt : gq::coalesce(batch)) {
+            for (auto&& [request, rows] : gq::demultiplex(stmt, rows_of(_db, stmt.sql))) {
+                actual[request] = std::move(rows);
+            }
+        }
+
+        std::size_t total = 0;
+
+        for (std::size_t r = 0; r < batch.size(); ++r) {
+            auto expected = rows_of(_db, gq::sql(batch[r], gq::options{}));
+            total += expected.size();
+
+            std::sort(std::begin(expected), std::end(expected));
+            std::sort(std::begin(actual[r]), std::end(actual[r]));
+
+            if (expected != actual[r]) {
+                genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}]: {} rows, expected {}", _queries[r], actual[r].size(), expected.size()));
+            }
+        }
+
+        return total;
+    }
+} // anonymous namespace
+
+// The requests of a coalesced batch receive the rows of the same requests translated
+// on their own.
+int main()
+{
+    gq::sqlite::database db{":memory:"};
+
+    gq::sqlite::catalog_options catalog;
+    catalog.data_objects = 2000;
+    catalog.objects_per_collection = 50;
+    catalog.users = 20;
+
+    {
+        const gq::schema_snapshot schema;
+        gq::sqlite::create_catalog(db, schema.get(), catalog);
+    }
+
+    // Fused on the collection, which is appended to the selections.
+    GENQUERY_CHECK(check_batch(db, {"select DATA_NAME, DATA_SIZE where COLL_ID = '1'",
+                                    "select DATA_NAME, DATA_SIZE where COLL_ID = '2'",
+                                    "select DATA_NAME, DATA_SIZE where COLL_ID = '02'",
+                                    "select DATA_NAME, DATA_SIZE where COLL_ID = '100000'"}) > 0);
+
+    // Each condition on a metadata column has its own table instance, which the
+    // discriminator is not bound to.
+    GENQUERY_CHECK(check_batch(db, {"select DATA_NAME where META_DATA_ATTR_NAME = 'attr0'",
+                                    "select DATA_NAME where META_DATA_ATTR_NAME = 'attr1'",
+                                    "select DATA_NAME where META_DATA_ATTR_NAME = 'attr2'"}) > 0);
+
+    GENQUERY_CHECK(check_batch(db, {"select DATA_NAME where META_DATA_ATTR_NAME = 'attr0' and META_DATA_ATTR_NAME = 'attr1'",
+                                    "select DATA_NAME where META_DATA_ATTR_NAME = 'attr0' and META_DATA_ATTR_NAME = 'attr2'",
+                                    "select DATA_NAME where META_DATA_ATTR_NAME = 'attr0' and META_DATA_ATTR_NAME = 'attr3'"}) > 0);
+
+    // Neither is a column with several conditions, whose rows do not tell which of
+    // them they matched.
+    GENQUERY_CHECK(check_batch(db, {"select DATA_ID where DATA_NAME = 'file1.dat' and DATA_NAME = 'file1.dat'",
+                                    "select DATA_ID where DATA_NAME = 'file1.dat' and DATA_NAME = 'file2.dat'"}) > 0);
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,106 @@
+#include "genquery_test.hpp"
+
+#include "genquery_coalesce.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <string>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    auto batch_of(const std::vector<std::string>& _queries) -> std::vector<gq::Select>
+    {
+        std::vector<gq::Select> batch;
+
+        for (auto&& q : _queries) {
+            batch.push_back(gq::wrapper::parse(q));
+        }
+
+        return batch;
+    }
+
+    auto count_rows(const std::map<std::size_t, std::vector<gq::row>>& _rows, std::size_t _request) -> int
+    {
+        const auto iter = _rows.find(_request);
+        return iter == std::end(_rows) ? -1 : static_cast<int>(iter->second.size());
+    }
+} // anonymous namespace
+
+int main()
+{
+    // Requests which differ in one literal share a statement, and each gets back its
+    // own rows without the discriminator.
+    {
+        const auto batch = batch_of({"select DATA_SIZE where DATA_NAME = 'a' and COLL_NAME = '/z'",
+                                     "select DATA_SIZE where DATA_NAME = 'o''b' and COLL_NAME = '/z'",
+                                     "select DATA_SIZE where DATA_NAME = 'a' and COLL_NAME = '/z'",
+                                     "select USER_NAME"});
+        const auto statements = gq::coalesce(batch);
+
+        GENQUERY_CHECK_EQUAL(static_cast<int>(statements.size()), 2);
+        GENQUERY_CHECK_EQUAL(static_cast<int>(statements[0].requests.size()), 3);
+        GENQUERY_CHECK(statements[0].discriminator_added);
+        GENQUERY_CHECK(statements[0].sql.find(" IN (") != std::string::npos);
+
+        const auto rows = gq::demultiplex(statements[0], {{"1", "a"}, {"2", "o'b"}, {"3", "a"}, {"4", "c"}});
+
+        GENQUERY_CHECK_EQUAL(count_rows(rows, 0), 2);
+        GENQUERY_CHECK_EQUAL(count_rows(rows, 1), 1);
+        GENQUERY_CHECK_EQUAL(count_rows(rows, 2), 2);
+        GENQUERY_CHECK(rows.at(1).front() == gq::row{"2"});
+
+        const auto single = gq::demultiplex(statements[1], {{"rods"}});
+        GENQUERY_CHECK_EQUAL(count_rows(single, 3), 1);
+    }
+
+    // A selected discriminator stays in the rows. Integer columns return the canonical
+    // form of the literal.
+    {
+        const auto batch = batch_of({"select DATA_ID, DATA_NAME where DATA_ID = '010'",
+                                     "select DATA_ID, DATA_NAME where DATA_ID = '11'"});
+        const auto statements = gq::coalesce(batch);
+
+        GENQUERY_CHECK_EQUAL(static_cast<int>(statements.size()), 1);
+        GENQUERY_CHECK(!statements[0].discriminator_added);
+
+        const auto rows = gq::demultiplex(statements[0], {{"10", "x"}, {"11", "y"}});
+        GENQUERY_CHECK_EQUAL(count_rows(rows, 0), 1);
+        GENQUERY_CHECK_EQUAL(count_rows(rows, 1), 1);
+        GENQUERY_CHECK(rows.at(0).front() == (gq::row{"10", "x"}));
+    }
+
+    // Aggregates return a row even for a literal without matches, which a fused
+    // statement grouped by the discriminator would not.
+    {
+        const auto batch = batch_of({"select COUNT(DATA_ID) where DATA_NAME = 'x'",
+                                     "select COUNT(DATA_ID) where DATA_NAME = 'y'",
+                                     "select COLL_NAME, COUNT(DATA_ID) where DATA_NAME = 'x'",
+                                     "select COLL_NAME, COUNT(DATA_ID) where DATA_NAME = 'y'"});
+        const auto statements = gq::coalesce(batch);
+
+        GENQUERY_CHECK_EQUAL(static_cast<int>(statements.size()), 4);
+        for (auto&& s : statements) {
+            GENQUERY_CHECK(s.discriminator == gq::coalesced_statement::no_discriminator);
+        }
+    }
+
+    // A case-insensitive match does not tell which literal a row belongs to, and a row
+    // limit applies to each request.
+    {
+        const auto batch = batch_of({"select DATA_SIZE where DATA_NAME = 'a'", "select DATA_SIZE where DATA_NAME = 'A'"});
+
+        gq::options folded;
+        folded.case_insensitive = true;
+        GENQUERY_CHECK_EQUAL(static_cast<int>(gq::coalesce(batch, folded).size()), 2);
+
+        gq::options limited;
+        limited.row_limit = 10;
+        GENQUERY_CHECK_EQUAL(static_cast<int>(gq::coalesce(batch, limited).size()), 2);
+
+        GENQUERY_CHECK_EQUAL(static_cast<int>(gq::coalesce(batch).size()), 1);
+    }
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,95 @@
+#include "genquery_test.hpp"
+
+#include "genquery_codegen.hpp"
+#include "genquery_sql.hpp"
+
+// Generated from genquery_codegen_test.gq by genquery_compile_queries().
+#include "genquery_codegen_test_queries.hpp"
+
+#include <fmt/format.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+namespace queries = genquery_codegen_test::queries;
+
+namespace
+{
+    // The SQL and bind values of a generated query must be those of the query with
+    // the arguments written as literals.
+    template <typename Query, typename... Args>
+    auto check(int _line, const std::string& _query, Args... _args) -> void
+    {
+        gq::options opts;
+        opts.parameterize = true;
+
+        const auto t = gq::try_translate(_query, opts);
+        if (!t) {
+            genquery_test::fail(__FILE__, _line, fmt::format("[{}] was not translated", _query));
+            return;
+        }
+
+        if (Query::sql != t->sql) {
+            genquery_test::fail(__FILE__, _line, fmt::format("[{}]: generated [{}], translated [{}]", _query, Query::sql, t->sql));
+        }
+
+        const auto values = Query::bind(_args...);
+        if (std::vector<std::string>(std::begin(values), std::end(values)) != t->bind_values) {
+            genquery_test::fail(__FILE__, _line, fmt::format("[{}]: generated [{}], translated [{}]", _query,
+                                                             fmt::join(values, ", "), fmt::join(t->bind_values, ", ")));
+        }
+    }
+
+    auto generated(const std::string& _templates) -> std::string
+    {
+        std::istringstream in{_templates};
+        gq::codegen_options opts;
+        opts.source = "inline.gq";
+        return gq::emit_cpp(gq::read_templates(in, opts.source), opts);
+    }
+
+    // The message of the exception thrown while generating "_templates".
+    auto failure(const std::string& _templates) -> std::string
+    {
+        try {
+            generated(_templates);
+        }
+        catch (const std::runtime_error& e) {
+            return e.what();
+        }
+
+        return "(no exception)";
+    }
+} // anonymous namespace
+
+int main()
+{
+    check<queries::large_data_objects>(__LINE__, "select DATA_NAME, DATA_SIZE where COLL_NAME = '/tempZone/home' and DATA_SIZE > '42'",
+                                       "/tempZone/home", 42);
+    check<queries::named>(__LINE__, "select DATA_NAME where DATA_NAME = 'a%' || like 'a%' and COLL_NAME = '/tempZone/it''s'", "a%");
+    check<queries::by_id>(__LINE__, "select DATA_NAME where DATA_ID in ('-3', '7', '10000000000')", -3, 10000000000);
+    check<queries::tagged>(__LINE__, "select DATA_NAME where META_DATA_ATTR_NAME = 'it''s' and META_DATA_ATTR_VALUE = ''", "it's", "");
+    check<queries::count_all>(__LINE__, "select COUNT(DATA_ID)");
+
+    // The header holds a struct per query within the namespace and include guard.
+    const auto header = generated("# A comment.\nq = select DATA_NAME\n  where DATA_ID = :id:int\n");
+    GENQUERY_CHECK(header.find("#ifndef GENQUERY_QUERIES_INLINE_GQ_HPP\n") != std::string::npos);
+    GENQUERY_CHECK(header.find("namespace genquery_queries\n{\n") != std::string::npos);
+    GENQUERY_CHECK(header.find("    struct q\n") != std::string::npos);
+    GENQUERY_CHECK(header.find("bind(std::int64_t id)") != std::string::npos);
+
+    // Malformed templates and queries which do not translate fail the generation,
+    // naming the line.
+    GENQUERY_CHECK(failure("q select DATA_NAME\n").find("inline.gq:1: expected NAME = QUERY") == 0);
+    GENQUERY_CHECK(failure("  where DATA_ID = '1'\n").find("inline.gq:1: continuation line") == 0);
+    GENQUERY_CHECK(failure("q = select DATA_NAME\nq = select COLL_NAME\n").find("inline.gq:2: query [q] is defined more than once") == 0);
+    GENQUERY_CHECK(failure("q = select DATA_NAME where DATA_ID = :id:float\n").find("unknown type [float]") != std::string::npos);
+    GENQUERY_CHECK(failure("q = select DATA_NAME where DATA_ID = :id:int and DATA_SIZE = :id:text\n").find("different types") !=
+                   std::string::npos);
+    GENQUERY_CHECK(failure("\nq = select NO_SUCH_COLUMN\n").find("inline.gq:2: query [q]: ") == 0);
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,115 @@
+#include "genquery_test.hpp"
+
+#include "genquery_columnar.hpp"
+#include "genquery_schema.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_sqlite_catalog.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    using rows = std::vector<std::vector<std::string>>;
+
+    auto sql_rows(gq::sqlite::database& _db, const std::string& _query) -> rows
+    {
+        // evaluate() restricts the objects by their AVUs as this strategy does.
+        gq::options opts;
+        opts.avu = gq::avu_strategy::exists;
+
+        const auto t = gq::try_translate(_query, opts);
+        if (!t) {
+            return {{"translation failed: " + gq::describe(t.error())}};
+        }
+
+        gq::sqlite::statement s{_db, t->sql};
+        rows ret;
+
+        while (s.step()) {
+            auto& row = ret.emplace_back();
+            for (int i = 0; i < s.column_count(); ++i) {
+                row.emplace_back(s.column_text(i));
+            }
+        }
+
+        std::sort(std::begin(ret), std::end(ret));
+        return ret;
+    }
+
+    auto columnar_rows(const gq::catalog_snapshot& _snapshot, const std::string& _query) -> rows
+    {
+        auto r = gq::evaluate(gq::wrapper::parse(_query), _snapshot);
+        if (!r) {
+            return {{"evaluation failed: " + gq::describe(r.error())}};
+        }
+
+        std::sort(std::begin(r->rows), std::end(r->rows));
+        return r->rows;
+    }
+} // anonymous namespace
+
+// The columnar engine answers queries with the rows the database returns for their SQL.
+int main()
+{
+    gq::sqlite::database db{":memory:"};
+
+    gq::sqlite::catalog_options catalog;
+    catalog.data_objects = 2000;
+    catalog.objects_per_collection = 50;
+    catalog.users = 20;
+
+    {
+        const gq::schema_snapshot schema;
+        gq::sqlite::create_catalog(db, schema.get(), catalog);
+    }
+
+    // Aggregates skip NULLs, which the snapshot stores as empty strings.
+    db.execute("UPDATE R_DATA_MAIN SET data_checksum = NULL WHERE data_id % 3 = 0");
+
+    const auto snapshot = gq::sqlite::load_snapshot(db);
+
+    const std::vector<std::string> queries{
+        "select DATA_NAME, DATA_SIZE where DATA_SIZE > '500000000' and DATA_SIZE < '520000000'",
+        "select COLL_NAME where COLL_NAME like '/tempZone/home/%' and COLL_NAME not like '%1%'",
+        "select DATA_NAME, COLL_NAME where COLL_NAME = '/tempZone/home/rods/coll20'",
+        "select DATA_ID where DATA_NAME in ('file1.dat', 'file2.dat', 'file3.dat')",
+        "select DATA_ID, DATA_SIZE where DATA_SIZE between '0' '5000000' || > '1070000000'",
+        "select COUNT(DATA_ID)",
+        "select COUNT(DATA_CHECKSUM)",
+        "select COUNT(DATA_CHECKSUM), MIN(DATA_CHECKSUM), MAX(DATA_SIZE), SUM(DATA_SIZE)",
+        "select COLL_NAME, COUNT(DATA_CHECKSUM), AVG(DATA_SIZE) where COLL_NAME like '%/coll1%'",
+        "select COUNT(DATA_ID) where DATA_NAME = 'no such object'",
+        "select DATA_NAME where META_DATA_ATTR_NAME = 'attr0' and META_DATA_ATTR_VALUE = 'value1'",
+        "select COUNT(DATA_ID) where META_DATA_ATTR_NAME = 'attr1' and META_DATA_ATTR_NAME = 'attr2'",
+        "select no-distinct COLL_ID where DATA_SIZE < '100000000'",
+        "select USER_NAME order by USER_NAME desc",
+    };
+
+    for (auto&& q : queries) {
+        const auto expected = sql_rows(db, q);
+        const auto actual = columnar_rows(*snapshot, q);
+
+        if (expected == actual) {
+            continue;
+        }
+
+        const auto [e, a] = std::mismatch(std::begin(expected), std::end(expected), std::begin(actual), std::end(actual));
+        genquery_test::fail(__FILE__,
+                            __LINE__,
+                            fmt::format("[{}]: {} rows, expected {}; first difference [{}], expected [{}]",
+                                        q,
+                                        actual.size(),
+                                        expected.size(),
+                                        a == std::end(actual) ? "" : fmt::format("{}", fmt::join(*a, ", ")),
+                                        e == std::end(expected) ? "" : fmt::format("{}", fmt::join(*e, ", "))));
+    }
+
+    return genquery_test::exit_status();
+}
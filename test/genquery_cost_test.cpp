@@ -0,0 +1,135 @@
+#include "genquery_test.hpp"
+
+#include "genquery_cost.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    auto model() -> gq::cost_model
+    {
+        gq::cost_model m;
+        m.table_rows = {{"R_DATA_MAIN", 1e6}, {"R_COLL_MAIN", 1e4}, {"R_META_MAIN", 1e5}, {"R_OBJT_METAMAP", 4e5}};
+        return m;
+    }
+
+    auto lookup(const std::string& _table) -> double
+    {
+        return std::log2(2 + model().rows(_table));
+    }
+
+    auto translated(const std::string& _query, gq::avu_strategy _avu = gq::avu_strategy::automatic) -> gq::translation
+    {
+        gq::options opts;
+        opts.costs = model();
+        opts.avu = _avu;
+        return gq::translate(gq::wrapper::parse(_query), opts);
+    }
+
+    // The cost of the joins of a translation, following the formula of cost_model.
+    auto join_cost(const gq::cost_estimate& _e) -> double
+    {
+        double sum = 0;
+        for (auto&& t : _e.tables) {
+            sum += lookup(t);
+        }
+
+        double subqueries = 0;
+        for (auto&& t : _e.subquery_tables) {
+            subqueries += lookup(t);
+        }
+
+        const auto avu_joins = std::count(std::begin(_e.tables), std::end(_e.tables), "R_META_MAIN");
+        return std::pow(model().avu_fanout, static_cast<double>(avu_joins)) * sum + subqueries;
+    }
+
+    auto near(double _a, double _b) -> bool
+    {
+        return std::fabs(_a - _b) < 1e-9 * std::max(1.0, std::fabs(_b));
+    }
+
+    auto admitted(const std::string& _query, const gq::admission_policy& _policy) -> gq::result<gq::translation>
+    {
+        gq::options opts;
+        opts.costs = model();
+        opts.admission = _policy;
+        return gq::try_translate(_query, opts);
+    }
+} // anonymous namespace
+
+int main()
+{
+    // One lookup per table of the FROM clause.
+    const auto plain = translated("select DATA_NAME where DATA_NAME = 'a'");
+    auto tables = plain.cost.tables;
+    std::sort(std::begin(tables), std::end(tables));
+    GENQUERY_CHECK(std::vector<std::string>({"R_COLL_MAIN", "R_DATA_MAIN"}) == tables);
+    GENQUERY_CHECK(near(plain.cost.cost, lookup("R_DATA_MAIN") + lookup("R_COLL_MAIN")));
+    GENQUERY_CHECK_EQUAL(plain.cost.joins, 1u);
+    GENQUERY_CHECK_EQUAL(plain.cost.non_sargable, 0u);
+
+    // Non-sargable predicates scan their table.
+    for (auto&& q : {"select DATA_NAME where DATA_NAME like '%a'", "select DATA_NAME where DATA_NAME != 'a'",
+                     "select DATA_NAME where DATA_NAME not like 'a%'"}) {
+        const auto t = translated(q);
+        GENQUERY_CHECK_EQUAL(t.cost.non_sargable, 1u);
+        if (!near(t.cost.cost, join_cost(t.cost) + model().rows("R_DATA_MAIN"))) {
+            genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}] costs {}", q, t.cost.cost));
+        }
+    }
+
+    // Each literal of an IN list beyond the first is another lookup.
+    const auto in = translated("select DATA_NAME where COLL_NAME in ('a', 'b', 'c')");
+    GENQUERY_CHECK_EQUAL(in.cost.in_list_literals, 3u);
+    GENQUERY_CHECK(near(in.cost.cost, join_cost(in.cost) + 2 * lookup("R_COLL_MAIN")));
+
+    // A metadata join multiplies the cost of the joins by the fan-out, while a subquery
+    // adds the lookups of its tables.
+    const auto avu = "select DATA_NAME where META_DATA_ATTR_NAME = 'a' and META_DATA_ATTR_VALUE = 'b'";
+    const auto joined = translated(avu, gq::avu_strategy::join);
+    const auto exists = translated(avu, gq::avu_strategy::exists);
+    GENQUERY_CHECK_EQUAL(joined.cost.avu_joins, 1u);
+    GENQUERY_CHECK_EQUAL(exists.cost.avu_joins, 0u);
+    GENQUERY_CHECK(near(joined.cost.cost, join_cost(joined.cost)));
+    GENQUERY_CHECK(near(exists.cost.cost, join_cost(exists.cost)));
+    GENQUERY_CHECK(exists.cost.cost < joined.cost.cost);
+
+    // Admission by cost.
+    const auto cheap = "select DATA_NAME where DATA_NAME = 'a'";
+    const auto scan = "select DATA_NAME where DATA_NAME like '%a'";
+
+    gq::admission_policy throttle;
+    throttle.throttle_above = plain.cost.cost + 1;
+    GENQUERY_CHECK(gq::admission_decision::accept == admitted(cheap, throttle)->admission);
+    GENQUERY_CHECK(gq::admission_decision::throttle == admitted(scan, throttle)->admission);
+
+    gq::admission_policy reject;
+    reject.reject_above = plain.cost.cost + 1;
+    GENQUERY_CHECK(admitted(cheap, reject));
+    const auto rejected = admitted(scan, reject);
+    GENQUERY_CHECK(!rejected && gq::error_code::too_expensive == rejected.error().code);
+
+    // A query above the downgrade threshold moves its AVU groups into subqueries, and
+    // is rejected only if it is still too expensive.
+    gq::admission_policy downgrade;
+    downgrade.downgrade_above = exists.cost.cost + 1;
+    downgrade.reject_above = joined.cost.cost - 1;
+    const auto downgraded = admitted(avu, downgrade);
+    GENQUERY_CHECK(downgraded && gq::admission_decision::downgrade == downgraded->admission);
+    GENQUERY_CHECK(downgraded && downgraded->sql == exists.sql);
+
+    downgrade.reject_above = exists.cost.cost - 1;
+    const auto still_rejected = admitted(avu, downgrade);
+    GENQUERY_CHECK(!still_rejected && gq::error_code::too_expensive == still_rejected.error().code);
+
+    return genquery_test::exit_status();
+}
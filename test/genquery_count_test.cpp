@@ -0,0 +1,66 @@
+#include "genquery_test.hpp"
+
+#include "genquery_schema.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    auto sql_of(std::string_view _query, const gq::options& _opts = {}) -> std::string
+    {
+        const auto t = gq::try_translate(_query, _opts);
+        return t ? t->sql : gq::describe(t.error());
+    }
+} // anonymous namespace
+
+int main()
+{
+    // Keys never hold NULL, so every row counts.
+    GENQUERY_CHECK_EQUAL(sql_of("select COUNT(DATA_ID)"), std::string{"SELECT COUNT(*) FROM R_DATA_MAIN"});
+    GENQUERY_CHECK_EQUAL(sql_of("select COUNT(DATA_ID) where DATA_NAME = 'x'"),
+                         std::string{"SELECT COUNT(*) FROM R_DATA_MAIN WHERE R_DATA_MAIN.data_name = 'x'"});
+
+    // Other columns only count the rows where they are not NULL.
+    GENQUERY_CHECK_EQUAL(sql_of("select COUNT(RESC_NAME)"),
+                         std::string{"SELECT COUNT(R_RESC_MAIN.resc_name) FROM R_RESC_MAIN"});
+    GENQUERY_CHECK_EQUAL(sql_of("select COUNT(DATA_CHECKSUM) where COLL_NAME = 'x'"),
+                         std::string{"SELECT COUNT(R_DATA_MAIN.data_checksum) FROM R_DATA_MAIN, R_COLL_MAIN "
+                                     "WHERE R_COLL_MAIN.coll_name = 'x' AND R_COLL_MAIN.coll_id = R_DATA_MAIN.coll_id"});
+
+    // Metadata joins go through the map table, and no other table is added.
+    gq::options join;
+    join.avu = gq::avu_strategy::join;
+    const auto meta = sql_of("select COUNT(DATA_ID) where META_DATA_ATTR_NAME = 'a'", join);
+    GENQUERY_CHECK(meta.find("COUNT(*)") != std::string::npos);
+    GENQUERY_CHECK(meta.find("R_DATA_MAIN.data_id = r_data_metamap_1.object_id") != std::string::npos);
+    GENQUERY_CHECK(meta.find("r_data_metamap_1.meta_id = r_data_meta_main_1.meta_id") != std::string::npos);
+    GENQUERY_CHECK(meta.find("R_COLL_MAIN") == std::string::npos);
+
+    // The flag comes from the catalog.
+    gq::schema_compiler compiler;
+    compiler.add_builtin();
+    std::istringstream definitions{"column|DATA_CHECKSUM|R_DATA_MAIN|data_checksum|not_null\n"};
+    compiler.add_definitions(definitions);
+    const auto catalog = gq::schema::from_buffer(compiler.compile());
+    GENQUERY_CHECK(catalog->column("DATA_CHECKSUM")->not_null);
+    GENQUERY_CHECK(catalog->column("DATA_ID")->not_null);
+    GENQUERY_CHECK(!catalog->column("DATA_NAME")->not_null);
+
+    std::istringstream unknown{"column|DATA_NAME|R_DATA_MAIN|data_name|unique\n"};
+    bool rejected = false;
+    try {
+        compiler.add_definitions(unknown);
+    }
+    catch (const std::exception&) {
+        rejected = true;
+    }
+    GENQUERY_CHECK(rejected);
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,110 @@
+#include "genquery_test.hpp"
+
+#include "genquery_sql.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    struct expectation
+    {
+        std::string query;
+        gq::error_code code;
+        std::string token; // The text between offset and offset + size.
+        std::string identifier;
+    };
+
+    auto check(const expectation& _e) -> void
+    {
+        const auto t = gq::try_translate(_e.query, gq::options{});
+
+        if (t) {
+            genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}] was translated", _e.query));
+            return;
+        }
+
+        const auto& d = t.error();
+        const auto token = d.offset <= _e.query.size() ? _e.query.substr(d.offset, d.size) : std::string{"(out of range)"};
+
+        if (d.code != _e.code || token != _e.token || d.identifier != _e.identifier) {
+            genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}]: code {}, token [{}], identifier [{}]; expected code {}, token [{}], identifier [{}]",
+                                                                _e.query, static_cast<int>(d.code), token, d.identifier,
+                                                                static_cast<int>(_e.code), _e.token, _e.identifier));
+        }
+
+        // The message names the offending token.
+        if (gq::describe(d).find(_e.identifier) == std::string::npos) {
+            genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}]: message [{}]", _e.query, gq::describe(d)));
+        }
+    }
+
+    template <typename F>
+    auto throws(F _f) -> bool
+    {
+        try {
+            _f();
+        }
+        catch (const std::runtime_error&) {
+            return true;
+        }
+
+        return false;
+    }
+} // anonymous namespace
+
+// Rejected queries are reported with the kind of problem and the location of the
+// offending token, instead of an exception.
+int main()
+{
+    using gq::error_code;
+
+    const std::vector<expectation> expectations{
+        {"select DATA_NAME where DATA_NAME = 'a' @", error_code::unknown_character, "@", "@"},
+        {"select DATA_NAME where = 'a'", error_code::syntax_error, "=", "="},
+        {"select DATA_NAME where DATA_NAME = 'a' and", error_code::syntax_error, "", ""},
+        {"select", error_code::syntax_error, "", ""},
+        {"select DATA_NAME, NO_SUCH_COLUMN", error_code::unknown_column, "NO_SUCH_COLUMN", "NO_SUCH_COLUMN"},
+        {"select DATA_NAME where NO_SUCH_COLUMN = 'x'", error_code::unknown_column, "NO_SUCH_COLUMN", "NO_SUCH_COLUMN"},
+        {"select DATA_NAME order by NO_SUCH_COLUMN", error_code::unknown_column, "NO_SUCH_COLUMN", "NO_SUCH_COLUMN"},
+        {"select LENGTH(DATA_NAME)", error_code::unsupported_function, "LENGTH", "LENGTH"},
+        {"select DATA_NAME order by DATA_SIZE", error_code::invalid_grouping, "DATA_SIZE", "DATA_SIZE"},
+    };
+
+    for (auto&& e : expectations) {
+        check(e);
+    }
+
+    // The detail of a syntax error lists the expected tokens.
+    const auto syntax = gq::try_translate("select DATA_NAME where = 'a'", gq::options{});
+    GENQUERY_CHECK(!syntax && syntax.error().detail.find("expecting IDENTIFIER") != std::string::npos);
+
+    // Queries which were not parsed from text have no location.
+    auto select = gq::wrapper::parse("select DATA_NAME where DATA_NAME = 'a'");
+    select.conditions[0].column.name = "NO_SUCH_COLUMN";
+
+    const auto t = gq::try_translate(select, gq::options{});
+    GENQUERY_CHECK(!t && error_code::unknown_column == t.error().code);
+    GENQUERY_CHECK(!t && 0 == t.error().offset && 0 == t.error().size);
+    GENQUERY_CHECK(!t && "NO_SUCH_COLUMN" == t.error().identifier);
+
+    // translate() reports the same problems as exceptions.
+    GENQUERY_CHECK(throws([&select] { gq::translate(select, gq::options{}); }));
+
+    select = gq::wrapper::parse("select DATA_NAME");
+    select.selections.clear();
+    const auto empty = gq::try_translate(select, gq::options{});
+    GENQUERY_CHECK(!empty && error_code::empty_selection == empty.error().code);
+
+    // Valid queries translate as they do with translate().
+    const auto valid = gq::try_translate("select DATA_NAME where DATA_SIZE > '10'", gq::options{});
+    GENQUERY_CHECK(valid && gq::sql(gq::wrapper::parse("select DATA_NAME where DATA_SIZE > '10'"), gq::options{}) == valid->sql);
+
+    return genquery_test::exit_status();
+}
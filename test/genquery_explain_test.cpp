@@ -0,0 +1,90 @@
+#include "genquery_test.hpp"
+
+#include "genquery_explain.hpp"
+#include "genquery_json.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    auto has_phase(const gq::explanation& _e, const std::string& _name) -> bool
+    {
+        return std::any_of(std::begin(_e.phases), std::end(_e.phases), [&_name](auto&& _p) { return _p.name == _name; });
+    }
+} // anonymous namespace
+
+// An explanation describes the translation try_translate() returns for the same query.
+int main()
+{
+    const std::vector<std::string> queries{
+        "select DATA_NAME where DATA_SIZE > '5'",
+        "select COLL_NAME, COUNT(DATA_ID) where COLL_NAME like '/tempZone/%' order by COLL_NAME",
+        "select DATA_NAME where META_DATA_ATTR_NAME = 'a' and META_DATA_ATTR_VALUE = 'b'",
+        "select DATA_NAME where META_DATA_ATTR_NAME = 'a' and META_DATA_ATTR_NAME = 'b'",
+        "select USER_NAME, DATA_NAME where DATA_ACCESS_TYPE = '1200'",
+    };
+
+    for (auto&& q : queries) {
+        for (const bool parameterize : {false, true}) {
+            gq::options opts;
+            opts.parameterize = parameterize;
+
+            const auto e = gq::explain(q, opts);
+            const auto t = gq::try_translate(q, opts);
+
+            if (!e || !t) {
+                genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}] was not translated", q));
+                continue;
+            }
+
+            GENQUERY_CHECK_EQUAL(e->result.sql, t->sql);
+            GENQUERY_CHECK(e->result.bind_values == t->bind_values);
+            GENQUERY_CHECK_EQUAL(e->result.cost.cost, t->cost.cost);
+
+            // The FROM entries and WHERE clauses are those of the SQL, without the
+            // placeholders.
+            if (!parameterize) {
+                GENQUERY_CHECK(t->sql.find(fmt::format(" FROM {} WHERE ", fmt::join(e->from, ", "))) != std::string::npos);
+                GENQUERY_CHECK(t->sql.find(fmt::format(" WHERE {}", fmt::join(e->where, " AND "))) != std::string::npos);
+            }
+
+            GENQUERY_CHECK(has_phase(*e, "parse"));
+            GENQUERY_CHECK(has_phase(*e, "linkage"));
+
+            // The JSON holds the same SQL.
+            const auto json = gq::to_json(*e);
+            GENQUERY_CHECK(json.rfind(fmt::format("{{\"sql\": {}, ", gq::json::quote(t->sql)), 0) == 0);
+        }
+    }
+
+    // The decisions of the translator.
+    const auto e = gq::explain("select DATA_NAME where META_DATA_ATTR_NAME = 'a' and META_DATA_ATTR_NAME = 'b'", gq::options{});
+    GENQUERY_CHECK(e && gq::avu_strategy::exists == e->strategy && 2 == e->avu_groups);
+    GENQUERY_CHECK(e && std::vector<std::string>{"R_DATA_MAIN"} == e->tables);
+
+    // Each column is resolved once.
+    GENQUERY_CHECK(e && 2 == e->columns.size() && "META_DATA_ATTR_NAME" == e->columns[1].name &&
+                   "r_data_meta_main" == e->columns[1].table && "meta_attr_name" == e->columns[1].column);
+    GENQUERY_CHECK(e && gq::to_json(*e).find("\"avu_strategy\": \"exists\", \"avu_groups\": 2") != std::string::npos);
+
+    const auto linked = gq::explain("select DATA_NAME, COLL_NAME", gq::options{});
+    GENQUERY_CHECK(linked && 1 == linked->links.size() && "R_COLL_MAIN.coll_id = R_DATA_MAIN.coll_id" == linked->links[0].clause);
+
+    // A parsed query has no parse phase.
+    const auto parsed = gq::explain(gq::wrapper::parse("select DATA_NAME"), gq::options{});
+    GENQUERY_CHECK(parsed && !has_phase(*parsed, "parse"));
+
+    // Rejected queries are explained by their diagnostic.
+    const auto rejected = gq::explain("select NO_SUCH_COLUMN", gq::options{});
+    GENQUERY_CHECK(!rejected && gq::error_code::unknown_column == rejected.error().code);
+
+    return genquery_test::exit_status();
+}
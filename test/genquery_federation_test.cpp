@@ -0,0 +1,74 @@
+#include "genquery_test.hpp"
+
+#include "genquery_federation.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    // Merges the rows each shard returns for the query, in the order the databases return
+    // them, into a single column.
+    auto merged(const std::string& _query, const std::vector<std::vector<gq::row>>& _shard_rows, const gq::federation_options& _opts = {})
+        -> std::string
+    {
+        std::vector<gq::shard> shards;
+        for (std::size_t i = 0; i < _shard_rows.size(); ++i) {
+            shards.push_back({fmt::format("shard{}", i), fmt::format("zone{}", i), {}, {}});
+        }
+
+        const auto q = gq::federate(gq::wrapper::parse(_query), shards, _opts);
+        if (!q) {
+            return gq::describe(q.error());
+        }
+
+        std::vector<std::string> values;
+
+        gq::run_federated(
+            *q,
+            [&_shard_rows](std::size_t _shard, const gq::translation&, const std::function<bool(gq::row)>& _sink) {
+                for (auto&& r : _shard_rows[_shard]) {
+                    if (!_sink(r)) {
+                        return;
+                    }
+                }
+            },
+            [&values](gq::row _r) {
+                values.push_back(fmt::format("{}", fmt::join(_r, ",")));
+                return true;
+            });
+
+        return fmt::format("{}", fmt::join(values, " "));
+    }
+} // anonymous namespace
+
+int main()
+{
+    // Text columns merge in the order of the text, whatever it looks like.
+    GENQUERY_CHECK_EQUAL(merged("select DATA_NAME order by DATA_NAME", {{{"10"}, {"9"}, {"a"}}, {{"2"}, {"b"}}}),
+                         std::string{"10 2 9 a b"});
+    GENQUERY_CHECK_EQUAL(merged("select DATA_NAME order by DATA_NAME desc", {{{"a"}, {"9"}, {"10"}}, {{"b"}, {"2"}}}),
+                         std::string{"b a 9 2 10"});
+
+    // Integer columns of the schema merge numerically.
+    GENQUERY_CHECK_EQUAL(merged("select DATA_SIZE order by DATA_SIZE", {{{"2"}, {"10"}}, {{"9"}, {"100"}}}),
+                         std::string{"2 9 10 100"});
+
+    // So do MIN and MAX.
+    GENQUERY_CHECK_EQUAL(merged("select MAX(DATA_NAME), MAX(DATA_SIZE)", {{{"9", "9"}}, {{"10", "10"}}}),
+                         std::string{"9,10"});
+
+    // The options override the schema.
+    gq::federation_options numeric;
+    numeric.column_types.emplace("DATA_NAME", gq::column_type::integer);
+    GENQUERY_CHECK_EQUAL(merged("select DATA_NAME order by DATA_NAME", {{{"9"}, {"10"}}, {{"2"}}}, numeric),
+                         std::string{"2 9 10"});
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,134 @@
+#include "genquery_test.hpp"
+
+#include "genquery_kernels.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+// The batch kernels select the same positions as plain loops over the values. Built with
+// -mavx2, this checks the AVX2 paths, and otherwise the scalar ones.
+namespace
+{
+    template <typename Predicate>
+    auto expected_positions(std::size_t _size, Predicate _p) -> std::vector<std::uint32_t>
+    {
+        std::vector<std::uint32_t> positions;
+
+        for (std::size_t i = 0; i < _size; ++i) {
+            if (_p(i)) {
+                positions.push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+
+        return positions;
+    }
+
+    auto satisfies(std::int64_t _v, gq::comparison _op, std::int64_t _literal) -> bool
+    {
+        switch (_op) {
+            case gq::comparison::equal:            return _v == _literal;
+            case gq::comparison::not_equal:        return _v != _literal;
+            case gq::comparison::less:             return _v < _literal;
+            case gq::comparison::less_or_equal:    return _v <= _literal;
+            case gq::comparison::greater:          return _v > _literal;
+            case gq::comparison::greater_or_equal: return _v >= _literal;
+        }
+
+        return false;
+    }
+
+    constexpr gq::comparison comparisons[]{gq::comparison::equal,
+                                           gq::comparison::not_equal,
+                                           gq::comparison::less,
+                                           gq::comparison::less_or_equal,
+                                           gq::comparison::greater,
+                                           gq::comparison::greater_or_equal};
+} // anonymous namespace
+
+int main()
+{
+    std::mt19937_64 random{42};
+
+    constexpr auto min = std::numeric_limits<std::int64_t>::min();
+    constexpr auto max = std::numeric_limits<std::int64_t>::max();
+
+    // Sizes around the width of the vectors and of the bitmap words.
+    std::vector<std::size_t> sizes;
+    for (std::size_t n = 0; n <= 70; ++n) {
+        sizes.push_back(n);
+    }
+    sizes.insert(std::end(sizes), {127, 128, 129, 1000});
+
+    for (const auto size : sizes) {
+        // Few distinct values, so that equality matches, plus the extremes.
+        std::vector<std::int64_t> values(size);
+        for (auto& v : values) {
+            const auto r = random() % 12;
+            v = 0 == r ? min : 1 == r ? max : static_cast<std::int64_t>(r) - 6;
+        }
+
+        for (const std::int64_t literal : {min, std::int64_t{-3}, std::int64_t{0}, std::int64_t{2}, max}) {
+            for (const auto op : comparisons) {
+                const auto actual = gq::select_compare(values.data(), size, op, literal).positions();
+                const auto expected = expected_positions(size, [&](auto i) { return satisfies(values[i], op, literal); });
+
+                if (actual != expected) {
+                    genquery_test::fail(__FILE__, __LINE__, fmt::format("select_compare: size {}, op {}, literal {}", size, static_cast<int>(op), literal));
+                }
+            }
+        }
+
+        for (const auto& [low, high] : {std::pair<std::int64_t, std::int64_t>{-2, 3}, {min, 0}, {1, max}, {4, -4}, {min, max}}) {
+            const auto actual = gq::select_between(values.data(), size, low, high).positions();
+            const auto expected = expected_positions(size, [&, low = low, high = high](auto i) { return low <= values[i] && values[i] <= high; });
+
+            if (actual != expected) {
+                genquery_test::fail(__FILE__, __LINE__, fmt::format("select_between: size {}, [{}, {}]", size, low, high));
+            }
+        }
+
+        // Short lists take the linear path, long ones the hash set.
+        for (const auto& literals : {std::vector<std::int64_t>{}, {0}, {min, 5, max}, {-6, -5, -4, -3, -2, -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34}}) {
+            const auto actual = gq::select_in(values.data(), size, literals).positions();
+            const auto expected = expected_positions(size, [&](auto i) {
+                return std::find(std::begin(literals), std::end(literals), values[i]) != std::end(literals);
+            });
+
+            if (actual != expected) {
+                genquery_test::fail(__FILE__, __LINE__, fmt::format("select_in: size {}, {} literals", size, literals.size()));
+            }
+        }
+
+        // Codes into dictionaries of various sizes, with every other or no code selected.
+        for (const std::size_t dictionary : {1, 31, 32, 33, 64, 65, 300}) {
+            std::vector<std::uint32_t> codes(size);
+            for (auto& c : codes) {
+                c = static_cast<std::uint32_t>(random() % dictionary);
+            }
+
+            for (const bool none : {false, true}) {
+                gq::selection selected{dictionary};
+                for (std::size_t c = 0; c < dictionary && !none; c += 2) {
+                    selected.set(c);
+                }
+
+                const auto actual = gq::select_codes(codes, selected).positions();
+                const auto expected = expected_positions(size, [&](auto i) { return selected.test(codes[i]); });
+
+                if (actual != expected) {
+                    genquery_test::fail(__FILE__, __LINE__, fmt::format("select_codes: size {}, dictionary {}", size, dictionary));
+                }
+            }
+        }
+    }
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,71 @@
+#include "genquery_test.hpp"
+
+#include "genquery_limits.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <string>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    constexpr auto none = static_cast<int>(gq::error_code::none);
+    constexpr auto limit_exceeded = static_cast<int>(gq::error_code::limit_exceeded);
+
+    auto code_of(const std::string& _query, const gq::query_limits& _limits) -> int
+    {
+        const auto s = gq::wrapper::try_parse(_query, _limits);
+        return static_cast<int>(s ? gq::error_code::none : s.error().code);
+    }
+
+    auto nots(std::size_t _n) -> std::string
+    {
+        std::string ret;
+        for (std::size_t i = 0; i < _n; ++i) {
+            ret += "not ";
+        }
+        return ret;
+    }
+
+    auto chain(std::size_t _n) -> std::string
+    {
+        std::string ret = "= 'a'";
+        for (std::size_t i = 1; i < _n; ++i) {
+            ret += " || = 'a'";
+        }
+        return ret;
+    }
+} // anonymous namespace
+
+int main()
+{
+    gq::query_limits limits;
+    limits.max_depth = 8;
+    limits.max_nodes = 20;
+
+    // "not" nests one level per NOT.
+    GENQUERY_CHECK_EQUAL(code_of("select DATA_NAME where DATA_NAME " + nots(7) + "= 'a'", limits), none);
+    GENQUERY_CHECK_EQUAL(code_of("select DATA_NAME where DATA_NAME " + nots(8) + "= 'a'", limits), limit_exceeded);
+
+    // A long run of NOTs stops at the limit, before the operand is reached, and the
+    // diagnostic points at the first NOT beyond it.
+    const auto query = "select DATA_NAME where DATA_NAME " + nots(1000000) + "= 'a'";
+    const auto s = gq::wrapper::try_parse(query, limits);
+    GENQUERY_CHECK(!s && limit_exceeded == static_cast<int>(s.error().code));
+    GENQUERY_CHECK_EQUAL(static_cast<int>(s ? 0 : s.error().offset), static_cast<int>(std::string{"select DATA_NAME where DATA_NAME "}.size() + 7 * 4));
+
+    // NOTs count as expressions as they are read, across conditions.
+    limits.max_depth = 256;
+    GENQUERY_CHECK_EQUAL(code_of("select DATA_NAME where DATA_NAME " + nots(19) + "= 'a'", limits), none);
+    GENQUERY_CHECK_EQUAL(code_of("select DATA_NAME where DATA_NAME " + nots(20) + "= 'a'", limits), limit_exceeded);
+    GENQUERY_CHECK_EQUAL(code_of("select DATA_NAME where DATA_NAME " + nots(10) + "= 'a' and COLL_NAME " + nots(10) + "= 'b'", limits), limit_exceeded);
+
+    // Chains of operators do not grow the parse stack. Their depth is checked once
+    // they are parsed.
+    limits.max_depth = 8;
+    GENQUERY_CHECK_EQUAL(code_of("select DATA_NAME where DATA_NAME " + chain(8), limits), none);
+    GENQUERY_CHECK_EQUAL(code_of("select DATA_NAME where DATA_NAME " + chain(9), limits), limit_exceeded);
+    GENQUERY_CHECK_EQUAL(code_of("select DATA_NAME where DATA_NAME " + chain(11), limits), limit_exceeded);
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,175 @@
+#include "genquery_test.hpp"
+
+#include "genquery_path_index.hpp"
+#include "genquery_schema.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_sqlite_catalog.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    auto rows_of(gq::sqlite::database& _db, const std::string& _sql) -> std::vector<gq::row>
+    {
+        gq::sqlite::statement s{_db, _sql};
+        std::vector<gq::row> ret;
+
+        while (s.step()) {
+            auto& row = ret.emplace_back();
+            for (int i = 0; i < s.column_count(); ++i) {
+                row.emplace_back(s.column_text(i));
+            }
+        }
+
+        std::sort(std::begin(ret), std::end(ret));
+        return ret;
+    }
+
+    // Paths made of a few short segments, so that they often share prefixes, with and
+    // without a trailing '/'.
+    auto random_path(std::mt19937& _rng) -> std::string
+    {
+        static const std::vector<std::string> segments{"a", "b", "ab", "a b", "ba"};
+
+        std::string ret;
+        const auto n = _rng() % 4;
+        for (std::size_t i = 0; i < n; ++i) {
+            ret += '/' + segments[_rng() % segments.size()];
+        }
+
+        if (ret.empty() || 0 == _rng() % 5) {
+            ret += '/';
+        }
+
+        return ret;
+    }
+
+    // The answers of a path_index, computed by comparing every path. Paths in a
+    // std::map are in path order, and the paths above another one are its prefixes.
+    auto beginning_of(const std::map<std::string, std::int64_t>& _paths, const std::string& _root) -> std::vector<std::int64_t>
+    {
+        std::vector<std::int64_t> ids;
+        for (auto&& [p, id] : _paths) {
+            if (gq::is_within(p, _root)) {
+                ids.push_back(id);
+            }
+        }
+        return ids;
+    }
+
+    auto parent_of(const std::map<std::string, std::int64_t>& _paths, const std::string& _path) -> std::vector<std::int64_t>
+    {
+        std::vector<std::int64_t> ids;
+        for (auto&& [p, id] : _paths) {
+            if (gq::is_within(_path, p)) {
+                ids.push_back(id);
+            }
+        }
+        return ids;
+    }
+} // anonymous namespace
+
+int main()
+{
+    GENQUERY_CHECK(gq::is_within("/a/b", "/a"));
+    GENQUERY_CHECK(gq::is_within("/a", "/a"));
+    GENQUERY_CHECK(gq::is_within("/a", "/"));
+    GENQUERY_CHECK(!gq::is_within("/ab", "/a"));
+    GENQUERY_CHECK(!gq::is_within("/a", "/a/b"));
+    GENQUERY_CHECK(!gq::is_within("/a", ""));
+
+    // The index answers as a loop over every path, while paths come and go.
+    {
+        std::mt19937 rng{7};
+        gq::path_index index;
+        std::map<std::string, std::int64_t> paths;
+
+        for (std::int64_t i = 0; i < 5000; ++i) {
+            const auto p = random_path(rng);
+
+            if (0 == rng() % 3) {
+                GENQUERY_CHECK_EQUAL(index.erase(p), paths.erase(p) > 0);
+            }
+            else {
+                index.insert(p, i);
+                paths[p] = i;
+            }
+
+            GENQUERY_CHECK_EQUAL(index.size(), paths.size());
+
+            const auto q = random_path(rng);
+            const auto found = paths.find(q);
+            GENQUERY_CHECK(index.find(q) == (std::end(paths) == found ? std::nullopt : std::optional<std::int64_t>{found->second}));
+
+            if (index.beginning_of(q) != beginning_of(paths, q)) {
+                genquery_test::fail(__FILE__, __LINE__, fmt::format("beginning_of [{}] differs after {} updates", q, i + 1));
+            }
+
+            if (index.parent_of(q) != parent_of(paths, q)) {
+                genquery_test::fail(__FILE__, __LINE__, fmt::format("parent_of [{}] differs after {} updates", q, i + 1));
+            }
+        }
+    }
+
+    // Conditions resolved through the index return the rows of the conditions the
+    // database evaluates.
+    gq::sqlite::database db{":memory:"};
+
+    gq::sqlite::catalog_options catalog;
+    catalog.data_objects = 2000;
+    catalog.objects_per_collection = 50;
+    catalog.users = 8;
+
+    const gq::schema_snapshot schema;
+    gq::sqlite::create_catalog(db, schema.get(), catalog);
+    const auto paths = gq::sqlite::load_collection_paths(db, schema.get());
+    GENQUERY_CHECK_EQUAL(paths.size(), catalog.data_objects / catalog.objects_per_collection);
+
+    const std::vector<std::string> conditions{
+        "COLL_NAME begin_of '/tempZone/home/user1'",
+        "COLL_NAME begin_of '/tempZone/home/'",
+        "COLL_NAME begin_of '/tempZone/home/user'",
+        "COLL_NAME begin_of '/tempZone/home/rods/coll0'",
+        "COLL_NAME begin_of '/elsewhere'",
+        "COLL_NAME parent_of '/tempZone/home/rods/coll8/sub'",
+        "COLL_NAME parent_of '/tempZone/home/rods/coll8'",
+        "COLL_NAME parent_of '/tempZone/home'",
+        "COLL_NAME begin_of '/tempZone/home/user1' and DATA_SIZE > '1000'",
+    };
+
+    for (auto&& c : conditions) {
+        const auto query = gq::wrapper::parse(fmt::format("select COLL_NAME, DATA_NAME where {}", c));
+        const auto expected = rows_of(db, gq::sql(query, gq::options{}));
+
+        for (const std::size_t limit : {std::size_t{1000}, std::size_t{2}}) {
+            gq::options opts;
+            opts.collection_paths = &paths;
+            opts.max_resolved_paths = limit;
+
+            if (rows_of(db, gq::sql(query, opts)) != expected) {
+                genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}] with at most {} resolved paths", c, limit));
+            }
+        }
+    }
+
+    // Resolved conditions compare the ids, and unknown paths match nothing.
+    gq::options opts;
+    opts.collection_paths = &paths;
+    GENQUERY_CHECK(gq::sql(gq::wrapper::parse("select DATA_NAME where COLL_NAME begin_of '/tempZone/home/rods/coll0'"), opts)
+                       .find("R_COLL_MAIN.coll_id IN (1)") != std::string::npos);
+    GENQUERY_CHECK(gq::sql(gq::wrapper::parse("select DATA_NAME where COLL_NAME begin_of '/elsewhere'"), opts).find("0 = 1") !=
+                   std::string::npos);
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,148 @@
+#include "genquery_test.hpp"
+
+#include "genquery_schema.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    auto sql_of(const std::string& _query) -> std::string
+    {
+        return gq::sql(gq::wrapper::parse(_query), gq::options{});
+    }
+
+    // The built-in schema, with DATA_NAME stored in "_column".
+    auto renamed(const std::string& _column) -> std::shared_ptr<const gq::schema>
+    {
+        gq::schema_compiler compiler;
+        compiler.add_builtin();
+        std::istringstream definitions{fmt::format("# DATA_NAME moved\n\ncolumn|DATA_NAME|R_DATA_MAIN|{}\n", _column)};
+        compiler.add_definitions(definitions);
+        return gq::schema::from_buffer(compiler.compile());
+    }
+} // anonymous namespace
+
+int main()
+{
+    const auto builtin = gq::schema::builtin();
+
+    // The built-in catalog holds the tables, columns and links of table_column_key_maps.hpp.
+    const auto data_name = builtin->column("DATA_NAME");
+    GENQUERY_CHECK(data_name && "R_DATA_MAIN" == data_name->table && "data_name" == data_name->column);
+    GENQUERY_CHECK(builtin->table("r_data_meta_main") && "R_META_MAIN r_data_meta_main" == builtin->table("r_data_meta_main")->alias);
+    GENQUERY_CHECK(!builtin->column("NO_SUCH_COLUMN"));
+    GENQUERY_CHECK(builtin->link_count() > 0);
+
+    const auto coll_id = builtin->column("COLL_ID");
+    GENQUERY_CHECK(coll_id && builtin->linked_column(*coll_id, "R_COLL_MAIN") == std::optional<std::string>{"coll_id"});
+
+    // A catalog loads from a file as from memory.
+    const auto path = fmt::format("/tmp/genquery_schema_test.{}.gqsc", ::getpid());
+    {
+        std::ofstream out{path, std::ios::binary};
+        out << builtin->buffer();
+    }
+    const auto loaded = gq::schema::load(path);
+    std::remove(path.c_str());
+    GENQUERY_CHECK_EQUAL(loaded->fingerprint(), builtin->fingerprint());
+    GENQUERY_CHECK_EQUAL(loaded->column_count(), builtin->column_count());
+
+    // Damaged catalogs are rejected.
+    bool rejected = false;
+    try {
+        gq::schema::from_buffer(std::string{builtin->buffer().substr(0, builtin->buffer().size() / 2)});
+    }
+    catch (const std::exception&) {
+        rejected = true;
+    }
+    GENQUERY_CHECK(rejected);
+
+    // Later definitions replace earlier ones, and change the fingerprint.
+    const auto moved = renamed("data_path_name");
+    GENQUERY_CHECK(moved->fingerprint() != builtin->fingerprint());
+    GENQUERY_CHECK_EQUAL(moved->column_count(), builtin->column_count());
+
+    // Translations use the published schema.
+    const auto query = "select DATA_NAME where DATA_NAME = 'a'";
+    const auto original = sql_of(query);
+    GENQUERY_CHECK(original.find("R_DATA_MAIN.data_name") != std::string::npos);
+
+    gq::publish_schema(moved);
+    const auto changed = sql_of(query);
+    GENQUERY_CHECK(changed.find("R_DATA_MAIN.data_path_name") != std::string::npos);
+
+    gq::publish_schema(builtin);
+    GENQUERY_CHECK_EQUAL(sql_of(query), original);
+
+    // A translation sees the schema of its snapshot, and publishing waits for it.
+    {
+        std::atomic<bool> holding{false};
+        std::string seen;
+
+        std::thread reader{[&] {
+            const gq::schema_snapshot snapshot;
+            holding = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds{100});
+            seen = sql_of(query);
+        }};
+
+        while (!holding) {
+            std::this_thread::yield();
+        }
+
+        gq::publish_schema(moved);
+        reader.join();
+
+        GENQUERY_CHECK_EQUAL(seen, original);
+        GENQUERY_CHECK_EQUAL(sql_of(query), changed);
+    }
+
+    // Translations running while schemas are published see one or the other.
+    {
+        std::atomic<bool> done{false};
+        std::atomic<int> mixed{0};
+        std::vector<std::thread> readers;
+
+        for (int i = 0; i < 4; ++i) {
+            readers.emplace_back([&] {
+                while (!done) {
+                    const auto s = sql_of(query);
+                    if (s != original && s != changed) {
+                        ++mixed;
+                    }
+                }
+            });
+        }
+
+        for (int i = 0; i < 200; ++i) {
+            gq::publish_schema(0 == i % 2 ? builtin : moved);
+        }
+
+        done = true;
+        for (auto&& r : readers) {
+            r.join();
+        }
+
+        GENQUERY_CHECK_EQUAL(mixed.load(), 0);
+    }
+
+    return genquery_test::exit_status();
+}
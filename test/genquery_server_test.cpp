@@ -0,0 +1,135 @@
+#include "genquery_test.hpp"
+
+#include "genquery_server.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    // The server creates its sockets once it runs, so the first connections are retried.
+    auto connect_to(const std::string& _path) -> gq::client
+    {
+        for (int attempt = 0;; ++attempt) {
+            try {
+                return gq::client{_path};
+            }
+            catch (const std::exception&) {
+                if (attempt == 500) {
+                    throw;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds{10});
+            }
+        }
+    }
+
+    // Reads the metrics snapshot until the server closes the connection.
+    auto read_metrics(const std::string& _path) -> std::string
+    {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, _path.c_str(), sizeof(addr.sun_path) - 1);
+
+        std::string ret;
+
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0) {
+            char buffer[4096];
+            for (ssize_t n; (n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0;) {
+                ret.append(buffer, static_cast<std::size_t>(n));
+            }
+        }
+
+        ::close(fd);
+
+        return ret;
+    }
+
+    auto contains(const std::string& _s, const std::string& _part) -> bool
+    {
+        return _s.find(_part) != std::string::npos;
+    }
+} // anonymous namespace
+
+// Queries sent over a socket are answered with the translation of the library, in the
+// order they were sent, and the metrics endpoint counts them.
+int main()
+{
+    const auto prefix = fmt::format("/tmp/genquery_server_test.{}", ::getpid());
+
+    gq::server_options opts;
+    opts.socket_path = prefix + ".sock";
+    opts.metrics_socket_path = prefix + ".metrics";
+    opts.workers = 4;
+    opts.translation.parameterize = true;
+
+    gq::server server{opts};
+    std::thread loop{[&server] { server.run(); }};
+
+    const std::vector<std::string> queries{
+        "select DATA_NAME where COLL_NAME = '/tempZone/home'",
+        "select COUNT(DATA_ID) where DATA_SIZE > '10' group by DATA_NAME",
+        "select DATA_NAME where META_DATA_ATTR_NAME = 'a' and META_DATA_ATTR_VALUE in ('1', '2')",
+        "select COLL_NAME where COLL_NAME begin_of '/tempZone'",
+    };
+
+    {
+        auto client = connect_to(opts.socket_path);
+
+        // Pipelined.
+        for (int round = 0; round < 25; ++round) {
+            for (auto&& q : queries) {
+                client.send(q);
+            }
+        }
+
+        for (int round = 0; round < 25; ++round) {
+            for (auto&& q : queries) {
+                const auto expected = gq::translate(gq::wrapper::parse(q), opts.translation);
+                const auto actual = client.receive();
+                GENQUERY_CHECK_EQUAL(actual.sql, expected.sql);
+                GENQUERY_CHECK(actual.bind_values == expected.bind_values);
+            }
+        }
+
+        // Errors are reported on the request, and the connection remains usable.
+        bool rejected = false;
+        try {
+            client.translate("select NO_SUCH_COLUMN");
+        }
+        catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        GENQUERY_CHECK(rejected);
+        GENQUERY_CHECK_EQUAL(client.translate(queries[0]).sql, gq::translate(gq::wrapper::parse(queries[0]), opts.translation).sql);
+    }
+
+    const auto metrics = read_metrics(opts.metrics_socket_path);
+    GENQUERY_CHECK(contains(metrics, "\nrequests 102\n"));
+    GENQUERY_CHECK(contains(metrics, "\nrequest_errors 1\n"));
+    GENQUERY_CHECK(contains(metrics, "connections_accepted 1\n"));
+
+    // Metrics connections are not counted as connections.
+    GENQUERY_CHECK(contains(read_metrics(opts.metrics_socket_path), "connections_accepted 1\n"));
+
+    server.stop();
+    loop.join();
+
+    return genquery_test::exit_status();
+}
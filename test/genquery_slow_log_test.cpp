@@ -0,0 +1,171 @@
+#include "genquery_test.hpp"
+
+#include "genquery_normalize.hpp"
+#include "genquery_slow_log.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    auto entry(const std::string& _query) -> gq::slow_translation
+    {
+        gq::slow_translation e;
+        e.query = _query;
+        return e;
+    }
+} // anonymous namespace
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    // The buffer holds "capacity" entries rounded up to a power of two, drops the others
+    // and returns the entries it holds oldest first.
+    {
+        gq::slow_translation_log log{0us, 5};
+
+        for (int i = 0; i < 10; ++i) {
+            GENQUERY_CHECK_EQUAL(log.push(entry(std::to_string(i))), i < 8);
+        }
+        GENQUERY_CHECK_EQUAL(log.dropped(), 2u);
+
+        auto drained = log.drain();
+        GENQUERY_CHECK_EQUAL(drained.size(), 8u);
+        for (std::size_t i = 0; i < drained.size(); ++i) {
+            GENQUERY_CHECK_EQUAL(drained[i].query, std::to_string(i));
+        }
+
+        // The slots are reused once drained.
+        GENQUERY_CHECK(log.drain().empty());
+        for (int i = 0; i < 3; ++i) {
+            GENQUERY_CHECK(log.push(entry(std::to_string(100 + i))));
+        }
+        drained = log.drain();
+        GENQUERY_CHECK(3 == drained.size() && "100" == drained[0].query && "102" == drained[2].query);
+    }
+
+    // Concurrent producers lose no entry which was accepted, and the entries of each
+    // producer are drained in the order it pushed them.
+    {
+        gq::slow_translation_log log{0us, 64};
+        constexpr int producers = 4;
+        constexpr int per_producer = 20000;
+
+        std::atomic<int> accepted{0};
+        std::atomic<int> running{producers};
+        std::vector<std::thread> threads;
+
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p] {
+                for (int i = 0; i < per_producer; ++i) {
+                    accepted += log.push(entry(fmt::format("{} {}", p, i)));
+                }
+                --running;
+            });
+        }
+
+        std::vector<int> last(producers, -1);
+        int received = 0;
+
+        const auto consume = [&] {
+            for (auto&& e : log.drain()) {
+                const auto space = e.query.find(' ');
+                const auto p = std::stoi(e.query.substr(0, space));
+                const auto i = std::stoi(e.query.substr(space + 1));
+
+                if (i <= last[p]) {
+                    genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}] drained after {} {}", e.query, p, last[p]));
+                }
+
+                last[p] = i;
+                ++received;
+            }
+        };
+
+        while (running > 0) {
+            consume();
+        }
+
+        for (auto&& t : threads) {
+            t.join();
+        }
+        consume();
+
+        GENQUERY_CHECK_EQUAL(received, accepted.load());
+        GENQUERY_CHECK_EQUAL(static_cast<std::uint64_t>(received) + log.dropped(), static_cast<std::uint64_t>(producers * per_producer));
+    }
+
+    // try_translate() records every translation which takes at least the threshold,
+    // with the outcome of the translation.
+    {
+        gq::slow_translation_log log{0us};
+        gq::options opts;
+        opts.slow_log = &log;
+        opts.parameterize = true;
+
+        const std::string joined = "select USER_NAME, DATA_NAME, COLL_NAME where DATA_ACCESS_TYPE = '1200' and DATA_SIZE > '10'";
+        const std::string invalid = "select NO_SUCH_COLUMN";
+
+        const auto t = gq::try_translate(joined, opts);
+        const auto rejected = gq::try_translate(invalid, opts);
+        const auto parsed = gq::try_translate(gq::wrapper::parse("select no-distinct DATA_NAME"), opts);
+        GENQUERY_CHECK(t && !rejected && parsed);
+
+        const auto entries = log.drain();
+        GENQUERY_CHECK_EQUAL(entries.size(), 3u);
+
+        if (3 == entries.size()) {
+            const auto& e = entries[0];
+            GENQUERY_CHECK_EQUAL(e.query, joined);
+            GENQUERY_CHECK_EQUAL(e.fingerprint, gq::fingerprint(gq::wrapper::parse(joined)));
+            GENQUERY_CHECK_EQUAL(e.sql_size, t->sql.size());
+            GENQUERY_CHECK_EQUAL(e.bind_count, t->bind_values.size());
+            GENQUERY_CHECK(e.error.empty());
+
+            // The phases are part of the whole, and the joins were searched for.
+            const auto& p = e.profile;
+            GENQUERY_CHECK(p.scan_us >= 0 && p.parse_us >= 0 && p.resolution_us >= 0 && p.linkage_us >= 0 && p.annotation_us >= 0 &&
+                           p.emission_us >= 0);
+            GENQUERY_CHECK(p.scan_us + p.parse_us + p.resolution_us + p.linkage_us + p.annotation_us + p.emission_us <= p.total_us + 1);
+            GENQUERY_CHECK(p.linkage_depth > 0);
+
+            GENQUERY_CHECK_EQUAL(entries[1].query, invalid);
+            GENQUERY_CHECK_EQUAL(entries[1].error, gq::describe(rejected.error()));
+            GENQUERY_CHECK_EQUAL(entries[1].sql_size, 0u);
+
+            // Queries which were not parsed from text are written from their syntax tree.
+            GENQUERY_CHECK(entries[2].query.rfind("no-distinct ", 0) == 0 && entries[2].query.find("DATA_NAME") != std::string::npos);
+            GENQUERY_CHECK_EQUAL(entries[2].profile.scan_us, 0.0);
+            GENQUERY_CHECK_EQUAL(entries[2].profile.parse_us, 0.0);
+
+            const auto json = gq::to_json(e);
+            GENQUERY_CHECK(json.rfind("{\"time\": \"", 0) == 0);
+            GENQUERY_CHECK(json.find(fmt::format("\"fingerprint\": \"{:016x}\"", e.fingerprint)) != std::string::npos);
+            GENQUERY_CHECK(json.find(fmt::format("\"sql_size\": {}, \"bind_count\": {}, \"error\": null}}", e.sql_size, e.bind_count)) !=
+                           std::string::npos);
+        }
+    }
+
+    // Translations below the threshold are not recorded.
+    {
+        gq::slow_translation_log log{std::chrono::duration_cast<std::chrono::microseconds>(1h)};
+        gq::options opts;
+        opts.slow_log = &log;
+
+        GENQUERY_CHECK(gq::try_translate("select DATA_NAME", opts));
+        GENQUERY_CHECK(log.drain().empty());
+        GENQUERY_CHECK_EQUAL(log.dropped(), 0u);
+    }
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,161 @@
+#include "genquery_test.hpp"
+
+#include "genquery_schema.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_sqlite_catalog.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <exception>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    auto rows_of(gq::sqlite::database& _db, const std::string& _sql) -> std::vector<gq::row>
+    {
+        gq::sqlite::statement s{_db, _sql};
+        std::vector<gq::row> ret;
+
+        while (s.step()) {
+            auto& row = ret.emplace_back();
+            for (int i = 0; i < s.column_count(); ++i) {
+                row.emplace_back(s.column_text(i));
+            }
+        }
+
+        return ret;
+    }
+
+    auto count_of(gq::sqlite::database& _db, const std::string& _sql) -> std::size_t
+    {
+        return std::stoull(rows_of(_db, _sql).at(0).at(0));
+    }
+
+    auto sql_of(const std::string& _query) -> std::string
+    {
+        return gq::sql(gq::wrapper::parse(_query), gq::options{});
+    }
+
+    auto plan_of(gq::sqlite::database& _db, const std::string& _query) -> std::string
+    {
+        std::string ret;
+        for (auto&& line : gq::sqlite::query_plan(_db, sql_of(_query))) {
+            ret += line + '\n';
+        }
+        return ret;
+    }
+
+    auto create(gq::sqlite::database& _db, const gq::sqlite::catalog_options& _opts) -> std::map<std::string, std::size_t>
+    {
+        const gq::schema_snapshot schema;
+
+        std::map<std::string, std::size_t> ret;
+        for (auto&& [table, rows] : gq::sqlite::create_catalog(_db, schema.get(), _opts)) {
+            ret[table] = rows;
+        }
+
+        return ret;
+    }
+} // anonymous namespace
+
+// The catalog the benchmark measures against has the shape its options describe, is
+// the same for the same seed, and is indexed like the iRODS catalog.
+int main()
+{
+    gq::sqlite::catalog_options opts;
+    opts.data_objects = 2000;
+    opts.objects_per_collection = 50;
+    opts.avus_per_object = 4;
+    opts.objects_per_avu = 4;
+    opts.acls_per_object = 2;
+    opts.users = 20;
+    opts.resources = 4;
+
+    gq::sqlite::database db{":memory:"};
+    const auto filled = create(db, opts);
+
+    const std::size_t collections = opts.data_objects / opts.objects_per_collection;
+    const std::map<std::string, std::size_t> expected{
+        {"R_COLL_MAIN", collections},
+        {"R_DATA_MAIN", opts.data_objects},
+        {"R_META_MAIN", opts.data_objects * opts.avus_per_object / opts.objects_per_avu},
+        {"R_OBJT_METAMAP", opts.data_objects * opts.avus_per_object + collections},
+        {"R_OBJT_ACCESS", opts.data_objects * opts.acls_per_object + collections},
+        {"R_USER_MAIN", opts.users},
+        {"R_RESC_MAIN", opts.resources},
+    };
+
+    for (auto&& [table, rows] : expected) {
+        const auto f = filled.find(table);
+        if (std::end(filled) == f || f->second != rows) {
+            genquery_test::fail(__FILE__, __LINE__, fmt::format("{} was filled with {} rows, expected {}", table,
+                                                                std::end(filled) == f ? 0 : f->second, rows));
+        }
+    }
+
+    // The counts returned are the rows of the tables.
+    for (auto&& [table, rows] : filled) {
+        GENQUERY_CHECK(db.has_table(table));
+        GENQUERY_CHECK_EQUAL(count_of(db, fmt::format("select count(*) from {}", table)), rows);
+    }
+
+    // Every object belongs to a collection, and every AVU link to an AVU.
+    GENQUERY_CHECK_EQUAL(count_of(db, "select count(*) from R_DATA_MAIN d join R_COLL_MAIN c on c.coll_id = d.coll_id"),
+                         opts.data_objects);
+    GENQUERY_CHECK_EQUAL(count_of(db, "select count(*) from R_OBJT_METAMAP m join R_META_MAIN a on a.meta_id = m.meta_id"),
+                         expected.at("R_OBJT_METAMAP"));
+
+    // The same seed gives the same catalog, and another seed another one.
+    const auto digest = "select group_concat(v, ',') from (select data_name || ':' || data_size as v from R_DATA_MAIN order by data_id)";
+    {
+        gq::sqlite::database same{":memory:"};
+        create(same, opts);
+        GENQUERY_CHECK(rows_of(db, digest) == rows_of(same, digest));
+
+        auto reseeded = opts;
+        reseeded.seed = opts.seed + 1;
+        gq::sqlite::database other{":memory:"};
+        create(other, reseeded);
+        GENQUERY_CHECK(rows_of(db, digest) != rows_of(other, digest));
+    }
+
+    // Sargable predicates are answered by the catalog indexes, the others by a scan.
+    const auto by_name = plan_of(db, "select DATA_NAME where DATA_NAME = 'x'");
+    GENQUERY_CHECK(by_name.find("SEARCH R_DATA_MAIN USING ") != std::string::npos);
+    GENQUERY_CHECK(by_name.find("INDEX idx_catalog_") != std::string::npos);
+
+    const auto by_avu = plan_of(db, "select DATA_NAME where META_DATA_ATTR_NAME = 'attr1'");
+    GENQUERY_CHECK(by_avu.find("INDEX idx_catalog_") != std::string::npos);
+
+    const auto scanned = plan_of(db, "select DATA_NAME where DATA_NAME like '%x'");
+    GENQUERY_CHECK(scanned.find("SCAN ") != std::string::npos);
+
+    // The generated SQL runs on the catalog, and finds the rows it was generated with.
+    const auto attribute = rows_of(db, "select meta_attr_name, meta_attr_value from R_META_MAIN where meta_id = 1").at(0);
+    const std::vector<std::string> queries{
+        "select DATA_NAME, COLL_NAME where COLL_NAME like '/tempZone/home/%'",
+        "select COLL_NAME, COUNT(DATA_ID) where DATA_SIZE > '100'",
+        "select USER_NAME, DATA_NAME where DATA_ACCESS_TYPE = '1200'",
+        "select RESC_NAME, SUM(DATA_SIZE)",
+        fmt::format("select DATA_NAME where META_DATA_ATTR_NAME = '{}' and META_DATA_ATTR_VALUE = '{}'", attribute[0], attribute[1]),
+    };
+
+    for (auto&& q : queries) {
+        try {
+            if (rows_of(db, sql_of(q)).empty()) {
+                genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}] returned no rows", q));
+            }
+        }
+        catch (const std::exception& e) {
+            genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}] failed: {}", q, e.what()));
+        }
+    }
+
+    return genquery_test::exit_status();
+}
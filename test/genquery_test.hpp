@@ -0,0 +1,54 @@
+#ifndef IRODS_GENQUERY_TEST_HPP
+#define IRODS_GENQUERY_TEST_HPP
+
+#include <fmt/format.h>
+
+#include <cstdio>
+#include <string>
+
+// A minimal harness for the tests run by ctest. Each test is a program whose checks
+// report their failures and whose exit status is non-zero if any failed:
+//
+//   int main()
+//   {
+//       GENQUERY_CHECK(1 + 1 == 2);
+//       GENQUERY_CHECK_EQUAL(std::string{"a"}, "a");
+//       return genquery_test::exit_status();
+//   }
+namespace genquery_test
+{
+    inline int failures = 0;
+
+    inline void fail(const char* _file, int _line, const std::string& _message)
+    {
+        ++failures;
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", _file, _line, _message.c_str());
+    }
+
+    inline int exit_status()
+    {
+        if (failures > 0) {
+            std::fprintf(stderr, "%d check(s) failed\n", failures);
+        }
+
+        return failures > 0 ? 1 : 0;
+    }
+} // namespace genquery_test
+
+#define GENQUERY_CHECK(expr)                                      \
+    do {                                                          \
+        if (!(expr)) {                                            \
+            genquery_test::fail(__FILE__, __LINE__, #expr);       \
+        }                                                         \
+    } while (false)
+
+#define GENQUERY_CHECK_EQUAL(actual, expected)                                                                   \
+    do {                                                                                                         \
+        const auto& a_ = (actual);                                                                               \
+        const auto& e_ = (expected);                                                                             \
+        if (!(a_ == e_)) {                                                                                       \
+            genquery_test::fail(__FILE__, __LINE__, fmt::format("{} is [{}], expected [{}]", #actual, a_, e_)); \
+        }                                                                                                        \
+    } while (false)
+
+#endif // IRODS_GENQUERY_TEST_HPP
@@ -0,0 +1,75 @@
+#include "genquery_test.hpp"
+
+#include "genquery_translation_cache.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    auto file_size(const std::string& _path) -> long
+    {
+        struct stat st{};
+        return ::stat(_path.c_str(), &st) == 0 ? static_cast<long>(st.st_size) : -1;
+    }
+
+    auto translate(gq::translation_cache& _cache, const char* _query) -> std::string
+    {
+        return _cache.translate(gq::wrapper::parse(_query), gq::options{}).sql;
+    }
+} // anonymous namespace
+
+int main()
+{
+    const auto path = "/tmp/genquery_translation_cache_test." + std::to_string(::getpid());
+    std::remove(path.c_str());
+
+    std::string first;
+
+    {
+        gq::translation_cache cache{path};
+        first = translate(cache, "select DATA_NAME where COLL_NAME = '/z'");
+        translate(cache, "select COLL_NAME where DATA_SIZE > '0'");
+        GENQUERY_CHECK_EQUAL(static_cast<int>(cache.size()), 2);
+    }
+
+    const auto intact = file_size(path);
+
+    // A crash in the middle of an append leaves part of an entry behind.
+    {
+        std::ofstream out{path, std::ios::binary | std::ios::app};
+        out.write("\x10\x00\x00\x00\x20\x00\x00\x00garbage", 15);
+    }
+
+    GENQUERY_CHECK(file_size(path) > intact);
+
+    {
+        gq::translation_cache cache{path};
+
+        // The valid entries survive and the torn one is gone.
+        GENQUERY_CHECK_EQUAL(static_cast<int>(cache.size()), 2);
+        GENQUERY_CHECK_EQUAL(file_size(path), intact);
+
+        GENQUERY_CHECK_EQUAL(translate(cache, "select DATA_NAME where COLL_NAME = '/y'"), first);
+        GENQUERY_CHECK_EQUAL(static_cast<int>(cache.hits()), 1);
+
+        translate(cache, "select USER_NAME");
+    }
+
+    // Entries appended after the repair are found again.
+    {
+        gq::translation_cache cache{path};
+        GENQUERY_CHECK_EQUAL(static_cast<int>(cache.size()), 3);
+    }
+
+    std::remove(path.c_str());
+
+    return genquery_test::exit_status();
+}
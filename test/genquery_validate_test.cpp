@@ -0,0 +1,47 @@
+#include "genquery_test.hpp"
+
+#include "genquery_sql.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <string_view>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    // The code of the diagnostic of try_translate(), or error_code::none.
+    auto code_of(std::string_view _query) -> int
+    {
+        const auto t = gq::try_translate(_query, gq::options{});
+        return static_cast<int>(t ? gq::error_code::none : t.error().code);
+    }
+
+    constexpr auto none = static_cast<int>(gq::error_code::none);
+    constexpr auto invalid_grouping = static_cast<int>(gq::error_code::invalid_grouping);
+} // anonymous namespace
+
+int main()
+{
+    // DISTINCT is the default, and PostgreSQL refuses to order it by a column which is
+    // not selected.
+    GENQUERY_CHECK_EQUAL(code_of("select DATA_NAME order by DATA_SIZE"), invalid_grouping);
+    GENQUERY_CHECK_EQUAL(code_of("select DATA_NAME, DATA_SIZE order by DATA_SIZE desc"), none);
+    GENQUERY_CHECK_EQUAL(code_of("select no-distinct DATA_NAME order by DATA_SIZE"), none);
+
+    // GROUP BY must cover the plain selections.
+    GENQUERY_CHECK_EQUAL(code_of("select DATA_NAME, COLL_NAME group by DATA_NAME"), invalid_grouping);
+    GENQUERY_CHECK_EQUAL(code_of("select DATA_NAME, COLL_NAME group by DATA_NAME, COLL_NAME"), none);
+    GENQUERY_CHECK_EQUAL(code_of("select no-distinct DATA_NAME group by DATA_NAME, COLL_NAME"), none);
+
+    // A grouped query may only be ordered by its groups.
+    GENQUERY_CHECK_EQUAL(code_of("select COLL_NAME, COUNT(DATA_ID) order by DATA_NAME"), invalid_grouping);
+    GENQUERY_CHECK_EQUAL(code_of("select COLL_NAME, COUNT(DATA_ID) order by COLL_NAME"), none);
+    GENQUERY_CHECK_EQUAL(code_of("select no-distinct COUNT(DATA_ID) group by COLL_NAME order by COLL_NAME"), none);
+    GENQUERY_CHECK_EQUAL(code_of("select COUNT(DATA_ID) group by COLL_NAME order by COLL_NAME"), invalid_grouping);
+
+    const auto t = gq::try_translate("select COLL_NAME, COUNT(DATA_ID) order by DATA_NAME", gq::options{});
+    GENQUERY_CHECK(!t && "DATA_NAME" == t.error().identifier);
+    GENQUERY_CHECK(!t && !gq::describe(t.error()).empty());
+
+    return genquery_test::exit_status();
+}
@@ -0,0 +1,183 @@
+#include "genquery_test.hpp"
+
+#include "genquery_json.hpp"
+#include "genquery_normalize.hpp"
+#include "genquery_sql.hpp"
+#include "genquery_workload.hpp"
+#include "genquery_wrapper.hpp"
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gq = irods::experimental::api::genquery;
+
+namespace
+{
+    const std::vector<std::string> columns{"DATA_NAME", "DATA_SIZE", "DATA_ID", "COLL_NAME", "COLL_ID", "USER_NAME",
+                                           "RESC_NAME", "DATA_OWNER_NAME", "DATA_CHECKSUM", "DATA_REPL_NUM"};
+
+    // A query of one of 2^10 - 1 shapes, selecting the columns of the bits of "_shape".
+    auto query_of(std::size_t _shape, int _literal) -> std::string
+    {
+        std::string selected;
+        for (std::size_t i = 0; i < columns.size(); ++i) {
+            if (_shape & (std::size_t{1} << i)) {
+                selected += (selected.empty() ? "" : ", ") + columns[i];
+            }
+        }
+
+        return fmt::format("select {} where DATA_SIZE > '{}'", selected, _literal);
+    }
+
+    struct expected_shape
+    {
+        std::uint64_t count = 0;
+        std::uint64_t errors = 0;
+        std::uint64_t joins = 0;
+    };
+} // anonymous namespace
+
+int main()
+{
+    // A workload of a few shapes, with literals varying within each shape and queries
+    // which do not translate, recorded from several threads.
+    std::vector<std::string> queries;
+    {
+        std::mt19937 rng{3};
+        for (int i = 0; i < 4000; ++i) {
+            const auto shape = 1 + rng() % 40;
+            queries.push_back(0 == i % 25 ? fmt::format("select NO_SUCH_COLUMN_{} where DATA_SIZE > '{}'", shape, i)
+                                          : query_of(shape, i));
+        }
+    }
+
+    // The counts of a plain loop over the normalized queries.
+    std::map<std::uint64_t, expected_shape> expected;
+    for (auto&& q : queries) {
+        const auto select = gq::wrapper::parse(q);
+        const auto t = gq::try_translate(select, gq::options{});
+        auto& e = expected[gq::fingerprint(select)];
+
+        ++e.count;
+        e.errors += !t;
+        if (t) {
+            e.joins += t->cost.tables.size() + t->cost.subquery_tables.size() - 1;
+        }
+    }
+
+    gq::workload_statistics workload{4096};
+    {
+        std::vector<std::thread> threads;
+        for (std::size_t k = 0; k < 4; ++k) {
+            threads.emplace_back([&queries, &workload, k] {
+                gq::options opts;
+                opts.workload = &workload;
+                for (std::size_t i = k; i < queries.size(); i += 4) {
+                    gq::try_translate(gq::wrapper::parse(queries[i]), opts);
+                }
+            });
+        }
+
+        for (auto&& t : threads) {
+            t.join();
+        }
+    }
+
+    GENQUERY_CHECK_EQUAL(workload.translations(), queries.size());
+
+    // Every shape fits in the table, so the counts are exact.
+    const auto top = workload.top(expected.size() + 10);
+    GENQUERY_CHECK_EQUAL(top.size(), expected.size());
+
+    for (std::size_t i = 0; i < top.size(); ++i) {
+        const auto& s = top[i];
+        const auto e = expected.find(s.fingerprint);
+
+        if (std::end(expected) == e) {
+            genquery_test::fail(__FILE__, __LINE__, fmt::format("unexpected shape [{}]", s.query));
+            continue;
+        }
+
+        if (s.count != e->second.count || s.errors != e->second.errors || s.joins != e->second.joins || 0 != s.overcount) {
+            genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}]: count {}, errors {}, joins {}; expected {}, {}, {}", s.query, s.count,
+                                                                s.errors, s.joins, e->second.count, e->second.errors, e->second.joins));
+        }
+
+        GENQUERY_CHECK_EQUAL(std::accumulate(std::begin(s.time_histogram), std::end(s.time_histogram), std::uint64_t{0}), s.count);
+        GENQUERY_CHECK(s.total_us >= 0);
+        GENQUERY_CHECK(i == 0 || top[i - 1].count >= s.count);
+    }
+
+    // The shapes are named by their normalized text, without the literals.
+    const auto one = gq::wrapper::parse(query_of(1, 42));
+    GENQUERY_CHECK(std::end(expected) != expected.find(gq::fingerprint(one)));
+    for (auto&& s : top) {
+        if (s.fingerprint == gq::fingerprint(one)) {
+            GENQUERY_CHECK_EQUAL(s.query, gq::normalize(one));
+            GENQUERY_CHECK(s.query.find("42") == std::string::npos);
+        }
+    }
+
+    // Frequent shapes stay in a table too small for every shape, with counts which
+    // bound their true counts.
+    {
+        gq::workload_statistics small{64};
+        std::map<std::uint64_t, std::uint64_t> counts;
+        std::mt19937 rng{5};
+
+        for (int i = 0; i < 20000; ++i) {
+            // Three shapes take 60% of the translations, and the others 1023 at most.
+            const auto shape = rng() % 10 < 6 ? 1 + rng() % 3 : 4 + rng() % 1020;
+            const auto select = gq::wrapper::parse(query_of(shape, i));
+            const auto t = gq::try_translate(select, gq::options{});
+
+            small.record(select, t, std::chrono::microseconds{5});
+            ++counts[gq::fingerprint(select)];
+        }
+
+        const auto frequent = small.top(3);
+        GENQUERY_CHECK_EQUAL(frequent.size(), 3u);
+
+        for (auto&& s : frequent) {
+            const auto n = counts[s.fingerprint];
+            if (s.count < n || s.count - s.overcount > n) {
+                genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}]: count {}, overcount {}, true count {}", s.query, s.count, s.overcount, n));
+            }
+
+            const auto shape = gq::normalize(gq::wrapper::parse(query_of(1, 0))) == s.query ||
+                               gq::normalize(gq::wrapper::parse(query_of(2, 0))) == s.query ||
+                               gq::normalize(gq::wrapper::parse(query_of(3, 0))) == s.query;
+            if (!shape) {
+                genquery_test::fail(__FILE__, __LINE__, fmt::format("[{}] is not a frequent shape", s.query));
+            }
+
+            // 5 microseconds fall in bucket 3, i.e. [4, 8).
+            GENQUERY_CHECK_EQUAL(s.time_histogram[3], s.count - s.overcount);
+        }
+
+        GENQUERY_CHECK(small.top(1000).size() <= 64);
+    }
+
+    // The JSON of a shape.
+    gq::workload_statistics single{1};
+    const auto select = gq::wrapper::parse("select DATA_NAME where DATA_NAME = 'a'");
+    single.record(select, gq::try_translate(select, gq::options{}), std::chrono::microseconds{3});
+    GENQUERY_CHECK_EQUAL(gq::to_json(single.top(1).at(0)),
+                         fmt::format("{{\"fingerprint\": \"{:016x}\", \"query\": {}, \"count\": 1, \"overcount\": 0, \"errors\": 0, "
+                                     "\"joins\": 1, \"total_us\": 3.0, \"time_histogram\": [0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0]}}",
+                                     gq::fingerprint(select), gq::json::quote(gq::normalize(select))));
+
+    single.clear();
+    GENQUERY_CHECK(single.top(1).empty());
+    GENQUERY_CHECK_EQUAL(single.translations(), 0u);
+
+    return genquery_test::exit_status();
+}